@@ -43,6 +43,13 @@
 #include "precomp.hpp"
 #include <climits>
 
+#if defined _MSC_VER && defined _M_X64
+#  include <intrin.h>
+#endif
+#if defined __x86_64__ || defined _M_X64
+#  include <immintrin.h>
+#endif
+
 namespace cv
 {
 
@@ -1298,9 +1305,138 @@ static const uchar popCountTable4[] =
     1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2
 };
 
+#if (defined __GNUC__ || defined _MSC_VER) && (defined __x86_64__ || defined _M_X64)
+// POPCNT is not part of the baseline instruction set, so the kernels using it
+// are compiled for it separately and selected at runtime
+#  define CV_POPCNT_DISPATCH 1
+#  ifdef _MSC_VER
+#    define CV_POPCNT_TARGET
+#    define CV_POPCOUNT_U64(x) (int)__popcnt64(x)
+#  else
+#    define CV_POPCNT_TARGET __attribute__((target("popcnt")))
+#    define CV_POPCOUNT_U64(x) __builtin_popcountll(x)
+#  endif
+#else
+#  define CV_POPCNT_DISPATCH 0
+#endif
+
+#if !CV_AVX && ((defined __GNUC__ && defined __x86_64__ && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined __clang__)) || \
+    (defined _MSC_VER && _MSC_VER >= 1600 && defined _M_X64))
+// the same for the AVX kernels, unless the whole build already targets AVX
+#  define CV_AVX_DISPATCH 1
+#  ifdef _MSC_VER
+#    define CV_AVX_TARGET
+#  else
+#    define CV_AVX_TARGET __attribute__((target("avx")))
+#  endif
+#else
+#  define CV_AVX_DISPATCH 0
+#endif
+
+#if CV_POPCNT_DISPATCH
+
+static inline uint64 loadU64(const uchar* p)
+{
+    uint64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// b == 0 computes the bit count of a itself
+CV_POPCNT_TARGET static int normHamming_POPCNT(const uchar* a, const uchar* b, int n)
+{
+    int i = 0, result = 0;
+    if( b )
+    {
+        // the common binary descriptor sizes (ORB, BRISK, FREAK, BRIEF-32/64) get the unrolled code
+        if( n == 32 )
+            return CV_POPCOUNT_U64(loadU64(a) ^ loadU64(b)) + CV_POPCOUNT_U64(loadU64(a + 8) ^ loadU64(b + 8)) +
+                   CV_POPCOUNT_U64(loadU64(a + 16) ^ loadU64(b + 16)) + CV_POPCOUNT_U64(loadU64(a + 24) ^ loadU64(b + 24));
+        if( n == 64 )
+        {
+            for( ; i < 64; i += 32 )
+                result += CV_POPCOUNT_U64(loadU64(a + i) ^ loadU64(b + i)) + CV_POPCOUNT_U64(loadU64(a + i + 8) ^ loadU64(b + i + 8)) +
+                          CV_POPCOUNT_U64(loadU64(a + i + 16) ^ loadU64(b + i + 16)) + CV_POPCOUNT_U64(loadU64(a + i + 24) ^ loadU64(b + i + 24));
+            return result;
+        }
+        for( ; i <= n - 8; i += 8 )
+            result += CV_POPCOUNT_U64(loadU64(a + i) ^ loadU64(b + i));
+        for( ; i < n; i++ )
+            result += popCountTable[a[i] ^ b[i]];
+    }
+    else
+    {
+        for( ; i <= n - 8; i += 8 )
+            result += CV_POPCOUNT_U64(loadU64(a + i));
+        for( ; i < n; i++ )
+            result += popCountTable[a[i]];
+    }
+    return result;
+}
+
+#endif
+
+#if CV_SSE2
+
+// bit count of 16-byte vectors: the bits are summed within each byte, then the bytes
+// are summed by _mm_sad_epu8 into the two 64-bit lanes
+static inline __m128i _mm_popcnt_epi64(__m128i v)
+{
+    const __m128i m1 = _mm_set1_epi8(0x55), m2 = _mm_set1_epi8(0x33), m4 = _mm_set1_epi8(0x0f);
+    v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi16(v, 1), m1));
+    v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+    v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+    return _mm_sad_epu8(v, _mm_setzero_si128());
+}
+
+// b == 0 computes the bit count of a itself
+static int normHamming_SSE2(const uchar* a, const uchar* b, int n)
+{
+    int i = 0, result = 0;
+    __m128i sum = _mm_setzero_si128();
+    for( ; i <= n - 16; i += 16 )
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(a + i));
+        if( b )
+            v = _mm_xor_si128(v, _mm_loadu_si128((const __m128i*)(b + i)));
+        sum = _mm_add_epi64(sum, _mm_popcnt_epi64(v));
+    }
+    result = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum));
+    if( b )
+        for( ; i < n; i++ )
+            result += popCountTable[a[i] ^ b[i]];
+    else
+        for( ; i < n; i++ )
+            result += popCountTable[a[i]];
+    return result;
+}
+
+#endif
+
+typedef int (*NormHammingFunc)(const uchar* a, const uchar* b, int n);
+
+// the fastest available bit count kernel; 0 means the generic code below
+static NormHammingFunc getNormHammingFunc(int n)
+{
+#if CV_POPCNT_DISPATCH
+    if( n >= 8 && checkHardwareSupport(CV_CPU_POPCNT) )
+        return normHamming_POPCNT;
+#endif
+#if CV_SSE2
+    if( n >= 16 && checkHardwareSupport(CV_CPU_SSE2) )
+        return normHamming_SSE2;
+#endif
+    (void)n;
+    return 0;
+}
+
 static int normHamming(const uchar* a, int n)
 {
     int i = 0, result = 0;
+    NormHammingFunc func = getNormHammingFunc(n);
+    if( func )
+        return func(a, 0, n);
 #if CV_NEON
     uint32x4_t bits = vmovq_n_u32(0);
     for (; i <= n - 16; i += 16) {
@@ -1326,6 +1462,9 @@ static int normHamming(const uchar* a, int n)
 int normHamming(const uchar* a, const uchar* b, int n)
 {
     int i = 0, result = 0;
+    NormHammingFunc func = getNormHammingFunc(n);
+    if( func )
+        return func(a, b, n);
 #if CV_NEON
     uint32x4_t bits = vmovq_n_u32(0);
     for (; i <= n - 16; i += 16) {
@@ -2314,16 +2453,19 @@ static void batchDistHamming(const uchar* src1, const uchar* src2, size_t step2,
                              int nvecs, int len, int* dist, const uchar* mask)
 {
     step2 /= sizeof(src2[0]);
+    NormHammingFunc func = getNormHammingFunc(len);
+    if( !func )
+        func = normHamming;
     if( !mask )
     {
         for( int i = 0; i < nvecs; i++ )
-            dist[i] = normHamming(src1, src2 + step2*i, len);
+            dist[i] = func(src1, src2 + step2*i, len);
     }
     else
     {
         int val0 = INT_MAX;
         for( int i = 0; i < nvecs; i++ )
-            dist[i] = mask[i] ? normHamming(src1, src2 + step2*i, len) : val0;
+            dist[i] = mask[i] ? func(src1, src2 + step2*i, len) : val0;
     }
 }
 
@@ -2395,6 +2537,22 @@ static void batchDistL2_32f(const float* src1, const float* src2, size_t step2,
 typedef void (*BatchDistFunc)(const uchar* src1, const uchar* src2, size_t step2,
                               int nvecs, int len, uchar* dist, const uchar* mask);
 
+// inserts (d, j) into the sorted K-element list, keeping the earlier elements on ties
+template<typename T> static inline void insertNearest(T d, int j, T* dists, int* idx, int K)
+{
+    if( d < dists[K-1] )
+    {
+        int k;
+        for( k = K-2; k >= 0 && dists[k] > d; k-- )
+        {
+            idx[k+1] = idx[k];
+            dists[k+1] = dists[k];
+        }
+        idx[k+1] = j;
+        dists[k+1] = d;
+    }
+}
+
 
 struct BatchDistInvoker : public ParallelLoopBody
 {
@@ -2430,24 +2588,216 @@ struct BatchDistInvoker : public ParallelLoopBody
                 // we handle both CV_32S and CV_32F cases with a single branch
                 int* distptr = (int*)dist->ptr(i);
 
-                int j, k;
+                for( int j = 0; j < src2->rows; j++ )
+                    insertNearest(bufptr[j], j + update, distptr, nidxptr, K);
+            }
+        }
+    }
+
+    const Mat *src1;
+    const Mat *src2;
+    Mat *dist;
+    Mat *nidx;
+    const Mat *mask;
+    int K;
+    int update;
+    BatchDistFunc func;
+};
+
+#if CV_SSE2
+
+// dot products of 4 query vectors with 8 train vectors; both are packed so that
+// the d-th components of a group are adjacent: a[d*4 + i], b[d*8 + j]. s[i*16 + j] receives the results
+static void dotProd4x8_32f(const float* a, const float* b, int len, float* s)
+{
+    __m128 s00 = _mm_setzero_ps(), s01 = s00, s10 = s00, s11 = s00;
+    __m128 s20 = s00, s21 = s00, s30 = s00, s31 = s00;
+    for( int d = 0; d < len; d++, a += 4, b += 8 )
+    {
+        __m128 a4 = _mm_loadu_ps(a), b0 = _mm_loadu_ps(b), b1 = _mm_loadu_ps(b + 4);
+        __m128 t = _mm_shuffle_ps(a4, a4, _MM_SHUFFLE(0,0,0,0));
+        s00 = _mm_add_ps(s00, _mm_mul_ps(t, b0)); s01 = _mm_add_ps(s01, _mm_mul_ps(t, b1));
+        t = _mm_shuffle_ps(a4, a4, _MM_SHUFFLE(1,1,1,1));
+        s10 = _mm_add_ps(s10, _mm_mul_ps(t, b0)); s11 = _mm_add_ps(s11, _mm_mul_ps(t, b1));
+        t = _mm_shuffle_ps(a4, a4, _MM_SHUFFLE(2,2,2,2));
+        s20 = _mm_add_ps(s20, _mm_mul_ps(t, b0)); s21 = _mm_add_ps(s21, _mm_mul_ps(t, b1));
+        t = _mm_shuffle_ps(a4, a4, _MM_SHUFFLE(3,3,3,3));
+        s30 = _mm_add_ps(s30, _mm_mul_ps(t, b0)); s31 = _mm_add_ps(s31, _mm_mul_ps(t, b1));
+    }
+    _mm_storeu_ps(s, s00); _mm_storeu_ps(s + 4, s01);
+    _mm_storeu_ps(s + 16, s10); _mm_storeu_ps(s + 20, s11);
+    _mm_storeu_ps(s + 32, s20); _mm_storeu_ps(s + 36, s21);
+    _mm_storeu_ps(s + 48, s30); _mm_storeu_ps(s + 52, s31);
+}
+
+#endif
+
+#if CV_AVX_DISPATCH
+
+// the same for two groups of 8 train vectors, b0 and b1, with 8-wide registers;
+// the products are summed in the same order, so the results are identical
+CV_AVX_TARGET static void dotProd4x16_32f_AVX(const float* a, const float* b0, const float* b1, int len, float* s)
+{
+    __m256 s00 = _mm256_setzero_ps(), s01 = s00, s10 = s00, s11 = s00;
+    __m256 s20 = s00, s21 = s00, s30 = s00, s31 = s00;
+    for( int d = 0; d < len; d++, a += 4, b0 += 8, b1 += 8 )
+    {
+        __m256 v0 = _mm256_loadu_ps(b0), v1 = _mm256_loadu_ps(b1);
+        __m256 t = _mm256_broadcast_ss(a);
+        s00 = _mm256_add_ps(s00, _mm256_mul_ps(t, v0)); s01 = _mm256_add_ps(s01, _mm256_mul_ps(t, v1));
+        t = _mm256_broadcast_ss(a + 1);
+        s10 = _mm256_add_ps(s10, _mm256_mul_ps(t, v0)); s11 = _mm256_add_ps(s11, _mm256_mul_ps(t, v1));
+        t = _mm256_broadcast_ss(a + 2);
+        s20 = _mm256_add_ps(s20, _mm256_mul_ps(t, v0)); s21 = _mm256_add_ps(s21, _mm256_mul_ps(t, v1));
+        t = _mm256_broadcast_ss(a + 3);
+        s30 = _mm256_add_ps(s30, _mm256_mul_ps(t, v0)); s31 = _mm256_add_ps(s31, _mm256_mul_ps(t, v1));
+    }
+    _mm256_storeu_ps(s, s00); _mm256_storeu_ps(s + 8, s01);
+    _mm256_storeu_ps(s + 16, s10); _mm256_storeu_ps(s + 24, s11);
+    _mm256_storeu_ps(s + 32, s20); _mm256_storeu_ps(s + 40, s21);
+    _mm256_storeu_ps(s + 48, s30); _mm256_storeu_ps(s + 56, s31);
+    _mm256_zeroupper();
+}
+
+#endif
 
-                for( j = 0; j < src2->rows; j++ )
+// K nearest neighbours of 32f vectors in L2. The train vectors are ranked by |b|^2 - 2*(a, b),
+// the query-independent part of |a - b|^2, which is computed for blocks of queries and train vectors
+// at once by dotProd4x8_32f; so neither the distance matrix nor even a full row of it is formed.
+// The distances of the best candidates (with a few extra ones to absorb the rounding errors of
+// the expansion) are then computed directly. The ranking key is only rounded, so if a vector outside
+// of the candidate list could still be among the K nearest ones within the error bound of the key,
+// the query is rescanned with the direct distances. Thus the output is the same as the one of
+// BatchDistInvoker.
+struct BatchDistL2KnnInvoker : public ParallelLoopBody
+{
+    enum { QBLOCK = 128, TBLOCK = 256, EXTRA_CANDIDATES = 4 };
+
+    BatchDistL2KnnInvoker( const Mat& _src1, const Mat& _src2, Mat& _dist, Mat& _nidx,
+                           int _K, const Mat& _mask, int _update, bool _sqrt, const float* _tnorm,
+                           float _tnormMax )
+        : src1(&_src1), src2(&_src2), dist(&_dist), nidx(&_nidx), mask(&_mask),
+          K(_K), update(_update), takeSqrt(_sqrt), tnorm(_tnorm), tnormMax(_tnormMax) {}
+
+    void operator()(const Range& range) const
+    {
+    #if CV_SSE2
+        int len = src1->cols, ntrain = src2->rows;
+        int q0 = range.start*QBLOCK, q1 = std::min(range.end*QBLOCK, src1->rows);
+        int Kc = std::min(K + EXTRA_CANDIDATES, ntrain);
+
+        AutoBuffer<float> _qbuf(QBLOCK*len), _tbuf(TBLOCK*len), _cdist(QBLOCK*Kc), _exact(Kc*2);
+        AutoBuffer<int> _cidx(QBLOCK*Kc);
+        float *qbuf = _qbuf, *tbuf = _tbuf, *cdist = _cdist, *exact = _exact;
+        int* cidx = _cidx;
+        float s[64];
+    #if CV_AVX_DISPATCH
+        bool useAVX = checkHardwareSupport(CV_CPU_AVX);
+    #endif
+
+        for( int qb = q0; qb < q1; qb += QBLOCK )
+        {
+            int nq = std::min((int)QBLOCK, q1 - qb), ngroups = (nq + 3)/4;
+            for( int i = 0; i < ngroups*4; i++ )
+            {
+                const float* a = i < nq ? src1->ptr<float>(qb + i) : 0;
+                float* dst = qbuf + (i/4)*len*4 + (i%4);
+                for( int d = 0; d < len; d++ )
+                    dst[d*4] = a ? a[d] : 0.f;
+            }
+            for( int i = 0; i < nq*Kc; i++ )
+            {
+                cdist[i] = FLT_MAX;
+                cidx[i] = -1;
+            }
+
+            for( int tb = 0; tb < ntrain; tb += TBLOCK )
+            {
+                int nt = std::min((int)TBLOCK, ntrain - tb), tgroups = (nt + 7)/8;
+                for( int j = 0; j < tgroups*8; j++ )
                 {
-                    int d = bufptr[j];
-                    if( d < distptr[K-1] )
+                    const float* b = j < nt ? src2->ptr<float>(tb + j) : 0;
+                    float* dst = tbuf + (j/8)*len*8 + (j%8);
+                    for( int d = 0; d < len; d++ )
+                        dst[d*8] = b ? b[d] : 0.f;
+                }
+
+                for( int g = 0; g < ngroups; g++ )
+                    for( int h = 0; h < tgroups; )
                     {
-                        for( k = K-2; k >= 0 && distptr[k] > d; k-- )
+                        const float* a = qbuf + g*len*4;
+                        int hn = 1;
+                    #if CV_AVX_DISPATCH
+                        if( useAVX && h + 1 < tgroups )
                         {
-                            nidxptr[k+1] = nidxptr[k];
-                            distptr[k+1] = distptr[k];
+                            dotProd4x16_32f_AVX(a, tbuf + h*len*8, tbuf + (h+1)*len*8, len, s);
+                            hn = 2;
                         }
-                        nidxptr[k+1] = j + update;
-                        distptr[k+1] = d;
+                        else
+                    #endif
+                            dotProd4x8_32f(a, tbuf + h*len*8, len, s);
+
+                        int jn = std::min(hn*8, nt - h*8), j0 = tb + h*8;
+                        for( int i = 0; i < 4 && g*4 + i < nq; i++ )
+                        {
+                            int qi = g*4 + i;
+                            const uchar* mptr = mask->data ? mask->ptr(qb + qi) : 0;
+                            for( int jj = 0; jj < jn; jj++ )
+                                if( !mptr || mptr[j0 + jj] )
+                                    insertNearest(tnorm[j0 + jj] - 2*s[i*16 + jj], j0 + jj,
+                                                  cdist + qi*Kc, cidx + qi*Kc, Kc);
+                        }
+                        h += hn;
+                    }
+            }
+
+            for( int qi = 0; qi < nq; qi++ )
+            {
+                const float* a = src1->ptr<float>(qb + qi);
+                const uchar* mptr = mask->data ? mask->ptr(qb + qi) : 0;
+                float* distptr = (float*)dist->ptr(qb + qi);
+                int* nidxptr = nidx->ptr<int>(qb + qi);
+                int* c = cidx + qi*Kc;
+                // the largest key of the candidates; if the list is not full, all the vectors are there
+                float maxKey = c[Kc-1] >= 0 ? cdist[qi*Kc + Kc-1] : FLT_MAX;
+
+                // insert the candidates in the order of their indices, as BatchDistInvoker does
+                std::sort(c, c + Kc);
+                int k, k0 = 0;
+                while( k0 < Kc && c[k0] < 0 )
+                    k0++;
+                for( k = k0; k < Kc; k++ )
+                    exact[k] = exact[Kc + k] = normL2Sqr<float, float>(a, src2->ptr<float>(c[k]), len);
+
+                if( maxKey < FLT_MAX )
+                {
+                    // the rounding errors of the key, of |a|^2 and of the direct distances are all
+                    // below (len + 2)*FLT_EPSILON*(|a| + |b|)^2; the other vectors are farther than
+                    // the K-th candidate unless the gap is within the sum of them
+                    float anorm = normL2Sqr<float, float>(a, len);
+                    double r = std::sqrt((double)anorm) + std::sqrt((double)tnormMax);
+                    double eps = 4.*(len + 2)*FLT_EPSILON*r*r;
+                    std::nth_element(exact + Kc, exact + Kc + K - 1, exact + Kc*2);
+                    if( (double)maxKey + anorm - eps <= exact[Kc + K - 1] )
+                    {
+                        for( int j = 0; j < ntrain; j++ )
+                            if( !mptr || mptr[j] )
+                            {
+                                float d = normL2Sqr<float, float>(a, src2->ptr<float>(j), len);
+                                insertNearest(takeSqrt ? std::sqrt(d) : d, j + update, distptr, nidxptr, K);
+                            }
+                        continue;
                     }
                 }
+
+                for( k = k0; k < Kc; k++ )
+                    insertNearest(takeSqrt ? std::sqrt(exact[k]) : exact[k], c[k] + update,
+                                  distptr, nidxptr, K);
             }
         }
+    #else
+        (void)range;
+    #endif
     }
 
     const Mat *src1;
@@ -2457,7 +2807,9 @@ struct BatchDistInvoker : public ParallelLoopBody
     const Mat *mask;
     int K;
     int update;
-    BatchDistFunc func;
+    bool takeSqrt;
+    const float* tnorm;
+    float tnormMax;
 };
 
 }
@@ -2569,6 +2921,26 @@ void cv::batchDistance( InputArray _src1, InputArray _src2,
                   ("The combination of type=%d, dtype=%d and normType=%d is not supported",
                    type, dtype, normType));
 
+#if CV_SSE2
+    if( type == CV_32F && (normType == NORM_L2 || normType == NORM_L2SQR) && K > 0 &&
+        src2.rows >= BatchDistL2KnnInvoker::TBLOCK/4 && checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        AutoBuffer<float> _tnorm(src2.rows);
+        float* tnorm = _tnorm, tnormMax = 0;
+        for( int j = 0; j < src2.rows; j++ )
+        {
+            tnorm[j] = normL2Sqr<float, float>(src2.ptr<float>(j), src2.cols);
+            tnormMax = std::max(tnormMax, tnorm[j]);
+        }
+
+        int nblocks = (src1.rows + BatchDistL2KnnInvoker::QBLOCK - 1)/BatchDistL2KnnInvoker::QBLOCK;
+        parallel_for_(Range(0, nblocks),
+                      BatchDistL2KnnInvoker(src1, src2, dist, nidx, K, mask, update,
+                                            normType == NORM_L2, tnorm, tnormMax));
+        return;
+    }
+#endif
+
     parallel_for_(Range(0, src1.rows),
                   BatchDistInvoker(src1, src2, dist, nidx, K, mask, update, func));
 }
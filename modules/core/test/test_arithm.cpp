@@ -1598,3 +1598,100 @@ TEST(Subtract, EmptyOutputMat)
     ASSERT_EQ(0, cv::countNonZero(dst2));
     ASSERT_EQ(0, cv::countNonZero(dst3));
 }
+
+TEST(Core_Hamming, accuracy)
+{
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+    bool useOptimized = cv::useOptimized();
+
+    for( int opt = 0; opt < 2; opt++ )
+    {
+        cv::setUseOptimized(opt != 0);
+        for( int n = 1; n <= 130; n++ )
+        {
+            Mat a(5, n, CV_8U), b(1, n, CV_8U), dist;
+            rng.fill(a, RNG::UNIFORM, 0, 256);
+            rng.fill(b, RNG::UNIFORM, 0, 256);
+            batchDistance(b, a, dist, CV_32S, noArray(), NORM_HAMMING);
+
+            for( int i = 0; i < a.rows; i++ )
+            {
+                int ref = 0, ref1 = 0;
+                for( int j = 0; j < n; j++ )
+                    for( int k = 0; k < 8; k++ )
+                    {
+                        ref += ((a.at<uchar>(i, j) ^ b.at<uchar>(0, j)) >> k) & 1;
+                        ref1 += (a.at<uchar>(i, j) >> k) & 1;
+                    }
+                ASSERT_EQ(ref, normHamming(a.ptr(i), b.ptr(), n)) << "n = " << n;
+                ASSERT_EQ(ref, dist.at<int>(i)) << "n = " << n;
+                ASSERT_EQ(ref1, (int)norm(a.row(i), NORM_HAMMING)) << "n = " << n;
+            }
+        }
+    }
+
+    cv::setUseOptimized(useOptimized);
+}
+
+TEST(Core_BatchDistance, knnL2)
+{
+    // the K nearest neighbours in L2 are searched without forming the distance matrix;
+    // they have to be the same as the ones picked from the full matrix, also when a large
+    // common offset of the vectors makes the ranking by |b|^2 - 2*(a, b) inexact
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+    const int dims[] = { 128, 64, 37, 3 };
+
+    for( int di = 0; di < 8; di++ )
+        for( int K = 1; K <= 5; K += 2 )
+            for( int useMask = 0; useMask < 2; useMask++ )
+            {
+                int normType = (di + K + useMask) % 2 ? NORM_L2 : NORM_L2SQR;
+                int nq = 150, nt = 700, half = nt/2, dim = dims[di % 4];
+                double offset = di < 4 ? 0. : 30000.;
+                Mat query(nq, dim, CV_32F), train(nt, dim, CV_32F), mask;
+                rng.fill(query, RNG::UNIFORM, offset, offset + 255);
+                rng.fill(train, RNG::UNIFORM, offset, offset + 255);
+                for( int i = 0; i < nq; i += 3 )
+                {
+                    train.row(i*4 % nt).copyTo(query.row(i));
+                    query.at<float>(i, 0) += 1.f;
+                }
+                if( useMask )
+                {
+                    mask.create(nq, nt, CV_8U);
+                    rng.fill(mask, RNG::UNIFORM, 0, 2);
+                }
+
+                Mat full, refDist(nq, K, CV_32F, Scalar::all(FLT_MAX)), refIdx(nq, K, CV_32S, Scalar::all(-1));
+                batchDistance(query, train, full, CV_32F, noArray(), normType, 0, mask);
+                for( int i = 0; i < nq; i++ )
+                {
+                    float* dptr = refDist.ptr<float>(i);
+                    int* iptr = refIdx.ptr<int>(i);
+                    for( int j = 0; j < nt; j++ )
+                    {
+                        float d = full.at<float>(i, j);
+                        int k = K - 1;
+                        if( d >= dptr[k] )
+                            continue;
+                        for( ; k > 0 && dptr[k-1] > d; k-- )
+                        {
+                            dptr[k] = dptr[k-1];
+                            iptr[k] = iptr[k-1];
+                        }
+                        dptr[k] = d;
+                        iptr[k] = j;
+                    }
+                }
+
+                // two train sets, merged through the 'update' parameter, as BFMatcher does
+                Mat dist, idx;
+                batchDistance(query, train.rowRange(0, half), dist, CV_32F, idx, normType, K,
+                              useMask ? mask.colRange(0, half) : Mat(), 0);
+                batchDistance(query, train.rowRange(half, nt), dist, CV_32F, idx, normType, K,
+                              useMask ? mask.colRange(half, nt) : Mat(), half);
+
+                ASSERT_EQ(0, norm(refDist, dist, NORM_INF)) << "dim = " << dim << ", K = " << K;
+                ASSERT_EQ(0, norm(refIdx, idx, NORM_INF)) << "dim = " << dim << ", K = " << K;
+            }
+}
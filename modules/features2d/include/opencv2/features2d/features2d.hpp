@@ -145,6 +145,11 @@ public:
      * Retain the specified number of the best keypoints (according to the response)
      */
     static void retainBest( vector<KeyPoint>& keypoints, int npoints );
+    /*
+     * Remove keypoints that have a keypoint with a bigger response closer than radius
+     * (of two keypoints with equal responses the first one is retained)
+     */
+    static void removeNonMaxima( vector<KeyPoint>& keypoints, float radius );
 };
 
 
@@ -314,6 +319,8 @@ protected:
                                        OutputArray descriptors, bool doDescriptors, bool doOrientation,
                                        bool useProvidedKeypoints) const;
 
+    friend class BRISKDescriptorInvoker;
+
     // Feature parameters
     CV_PROP_RW int threshold;
     CV_PROP_RW int octaves;
@@ -1208,6 +1215,19 @@ public:
 
     virtual Ptr<DescriptorMatcher> clone( bool emptyTrainData=false ) const;
 
+    /*
+     * Finds the k best matches of each query descriptor and stores them in the flat array
+     * matches[queryIdx*k + i], i = 0..k-1, sorted by distance; unused slots are DMatch().
+     * If maxRatio < 1 (requires k > 1), the ratio test is applied on the fly: the slots of
+     * a query are all left unused unless its best distance is less than maxRatio times the
+     * second best one. A query with a single candidate is rejected as well.
+     */
+    CV_WRAP void knnMatchFlat( const Mat& queryDescriptors, const Mat& trainDescriptors,
+                               CV_OUT vector<DMatch>& matches, int k, float maxRatio=1.f,
+                               const Mat& mask=Mat() ) const;
+    CV_WRAP void knnMatchFlat( const Mat& queryDescriptors, CV_OUT vector<DMatch>& matches, int k,
+                               float maxRatio=1.f, const vector<Mat>& masks=vector<Mat>() ) const;
+
     AlgorithmInfo* info() const;
 protected:
     virtual void knnMatchImpl( const Mat& queryDescriptors, vector<vector<DMatch> >& matches, int k,
@@ -1261,6 +1281,64 @@ protected:
     int addedDescCount;
 };
 
+/*
+ * Multi-index hashing matcher for binary descriptors:
+ * M. Norouzi, A. Punjani, D. J. Fleet. Fast Search in Hamming Space with Multi-Index Hashing. CVPR 2012.
+ *
+ * The train descriptors are split into m disjoint substrings, each indexed by its own hash table.
+ * Two descriptors within the Hamming distance r differ by at most r/m bits in one of the substrings
+ * at least, so only the train descriptors falling into the buckets near the query are compared with it.
+ * The search is exact: knnMatch() and radiusMatch() return the same matches as BFMatcher(NORM_HAMMING).
+ */
+class CV_EXPORTS_W MIHMatcher : public DescriptorMatcher
+{
+public:
+    // substringBits is the length of the hashed substrings; 0 means log2 of the train descriptor count
+    CV_WRAP MIHMatcher( int substringBits=0 );
+    virtual ~MIHMatcher() {}
+
+    virtual void add( const vector<Mat>& descriptors );
+    virtual void clear();
+
+    virtual void train();
+    virtual bool isMaskSupported() const { return true; }
+
+    // Reads matcher object from a file node
+    virtual void read( const FileNode& );
+    // Writes matcher object to a file storage
+    virtual void write( FileStorage& ) const;
+
+    // Saves the train descriptors together with the built index to a binary file
+    CV_WRAP void save( const string& filename ) const;
+    // Loads the train descriptors and the index saved by save(); the train collection is replaced
+    CV_WRAP void load( const string& filename );
+
+    virtual Ptr<DescriptorMatcher> clone( bool emptyTrainData=false ) const;
+
+    AlgorithmInfo* info() const;
+protected:
+    virtual void knnMatchImpl( const Mat& queryDescriptors, vector<vector<DMatch> >& matches, int k,
+           const vector<Mat>& masks=vector<Mat>(), bool compactResult=false );
+    virtual void radiusMatchImpl( const Mat& queryDescriptors, vector<vector<DMatch> >& matches, float maxDistance,
+           const vector<Mat>& masks=vector<Mat>(), bool compactResult=false );
+
+    int substringBits;
+
+    // all the train descriptors in one matrix and the first row of every image in it
+    Mat mergedDescriptors;
+    vector<int> startIdxs;
+    int addedDescCount;
+
+    // bit offsets of the m substrings (m+1 elements); for every substring, the train descriptor
+    // indices sorted by the substring value (tableIds), the distinct values (tableKeys) with the
+    // starts of their runs in tableIds (tableOfs), and the open addressing hash table mapping
+    // a value to its position in tableKeys (tableSlots). When the number of possible values is
+    // comparable to the train set size, tableKeys and tableSlots are empty and tableOfs is
+    // indexed by the value itself.
+    vector<int> substrOfs;
+    vector<Mat> tableKeys, tableOfs, tableIds, tableSlots;
+};
+
 /****************************************************************************************\
 *                                GenericDescriptorMatcher                                *
 \****************************************************************************************/
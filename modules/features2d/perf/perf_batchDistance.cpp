@@ -131,6 +131,169 @@ PERF_TEST_P(Norm_CrossCheck, batchDistance_32F,
     if (isCrossCheck) SANITY_CHECK(ndix);
 }
 
+typedef std::tr1::tuple<int, int> Dim_K_t;
+typedef perf::TestBaseWithParam<Dim_K_t> Dim_K;
+
+// k nearest neighbours of SURF (64) and SIFT (128) descriptors, as in BFMatcher::knnMatch
+PERF_TEST_P(Dim_K, batchDistance_knnL2,
+            testing::Combine(testing::Values(64, 128),
+                             testing::Values(1, 2)
+                             )
+            )
+{
+    int dim = get<0>(GetParam());
+    int K = get<1>(GetParam());
+
+    Mat queryDescriptors(2000, dim, CV_32F);
+    Mat trainDescriptors(10000, dim, CV_32F);
+    Mat dist, nidx;
+
+    declare.in(queryDescriptors, trainDescriptors, WARMUP_RNG).time(100);
+
+    TEST_CYCLE() batchDistance(queryDescriptors, trainDescriptors, dist, CV_32F, nidx, NORM_L2, K);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef std::tr1::tuple<int, bool> DescriptorSize_Optimized_t;
+typedef perf::TestBaseWithParam<DescriptorSize_Optimized_t> DescriptorSize_Optimized;
+
+// binary descriptors of ORB/BRIEF-32/FREAK (32, 64 bytes) and BRISK (64 bytes);
+// useOptimized = false measures the table-based bit count
+PERF_TEST_P(DescriptorSize_Optimized, batchDistance_Hamming,
+            testing::Combine(testing::Values(32, 64),
+                             testing::Bool()
+                             )
+            )
+{
+    int descSize = get<0>(GetParam());
+    bool optimized = get<1>(GetParam());
+
+    Mat queryDescriptors(1000, descSize, CV_8U);
+    Mat trainDescriptors(5000, descSize, CV_8U);
+    Mat dist;
+
+    declare.in(queryDescriptors, trainDescriptors, WARMUP_RNG).time(100);
+
+    bool prevOptimized = useOptimized();
+    setUseOptimized(optimized);
+    TEST_CYCLE() batchDistance(queryDescriptors, trainDescriptors, dist, CV_32S, noArray(), NORM_HAMMING);
+    setUseOptimized(prevOptimized);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef std::tr1::tuple<NormType, bool> Norm_Flat_t;
+typedef perf::TestBaseWithParam<Norm_Flat_t> Norm_Flat;
+
+// 2-NN matching with the ratio test: knnMatch() + filtering vs. knnMatchFlat()
+PERF_TEST_P(Norm_Flat, BFMatcher_knnMatch_ratio,
+            testing::Combine(testing::Values((int)NORM_HAMMING, (int)NORM_L2),
+                             testing::Bool()
+                             )
+            )
+{
+    int normType = get<0>(GetParam());
+    bool flat = get<1>(GetParam());
+    bool binary = normType == NORM_HAMMING;
+    const float maxRatio = 0.8f;
+
+    Mat queryDescriptors(1000, binary ? 32 : 128, binary ? CV_8U : CV_32F);
+    Mat trainDescriptors(binary ? 50000 : 10000, queryDescriptors.cols, queryDescriptors.type());
+    BFMatcher matcher(normType);
+    vector<DMatch> matches;
+    vector<vector<DMatch> > knnMatches;
+
+    declare.in(queryDescriptors, trainDescriptors, WARMUP_RNG).time(100);
+
+    TEST_CYCLE()
+    {
+        if( flat )
+            matcher.knnMatchFlat(queryDescriptors, trainDescriptors, matches, 2, maxRatio);
+        else
+        {
+            matcher.knnMatch(queryDescriptors, trainDescriptors, knnMatches, 2);
+            matches.clear();
+            for( size_t i = 0; i < knnMatches.size(); i++ )
+                if( knnMatches[i].size() == 2 && knnMatches[i][0].distance < maxRatio*knnMatches[i][1].distance )
+                    matches.push_back(knnMatches[i][0]);
+        }
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(Norm_CrossCheck, BFMatcher_radiusMatch_crossCheck,
+            testing::Combine(testing::Values((int)NORM_HAMMING, (int)NORM_L2),
+                             testing::Bool()
+                             )
+            )
+{
+    int normType = get<0>(GetParam());
+    bool isCrossCheck = get<1>(GetParam());
+    bool binary = normType == NORM_HAMMING;
+
+    Mat queryDescriptors(1000, binary ? 32 : 128, binary ? CV_8U : CV_32F);
+    Mat trainDescriptors(binary ? 50000 : 10000, queryDescriptors.cols, queryDescriptors.type());
+    BFMatcher matcher(normType, isCrossCheck);
+    vector<DMatch> matches;
+    vector<vector<DMatch> > radiusMatches;
+
+    declare.in(queryDescriptors, trainDescriptors, WARMUP_RNG).time(100);
+
+    TEST_CYCLE()
+    {
+        if( isCrossCheck )
+            matcher.match(queryDescriptors, trainDescriptors, matches);
+        else
+            matcher.radiusMatch(queryDescriptors, trainDescriptors, radiusMatches, binary ? 80.f : 1500.f);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef std::tr1::tuple<int, bool> FlippedBits_MIH_t;
+typedef perf::TestBaseWithParam<FlippedBits_MIH_t> FlippedBits_MIH;
+
+// nearest neighbors of 32-byte descriptors that differ from a train one in a few bits:
+// MIHMatcher vs. BFMatcher with NORM_HAMMING
+PERF_TEST_P(FlippedBits_MIH, MIHMatcher_knnMatch,
+            testing::Combine(testing::Values(8, 30),
+                             testing::Bool()
+                             )
+            )
+{
+    int flippedBits = get<0>(GetParam());
+    bool mih = get<1>(GetParam());
+
+    Mat trainDescriptors(100000, 32, CV_8U);
+    Mat queryDescriptors(1000, 32, CV_8U);
+    RNG& rng = theRNG();
+    rng.fill(trainDescriptors, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+    for( int i = 0; i < queryDescriptors.rows; i++ )
+    {
+        Mat q = queryDescriptors.row(i);
+        trainDescriptors.row(rng.uniform(0, trainDescriptors.rows)).copyTo(q);
+        for( int k = 0; k < flippedBits; k++ )
+        {
+            int bit = rng.uniform(0, q.cols*8);
+            q.at<uchar>(bit/8) ^= (uchar)(1 << (bit%8));
+        }
+    }
+
+    Ptr<DescriptorMatcher> matcher = mih ? Ptr<DescriptorMatcher>(new MIHMatcher()) :
+                                           Ptr<DescriptorMatcher>(new BFMatcher(NORM_HAMMING));
+    matcher->add(vector<Mat>(1, trainDescriptors));
+    matcher->train();
+    vector<vector<DMatch> > matches;
+
+    declare.time(100);
+
+    TEST_CYCLE() matcher->knnMatch(queryDescriptors, matches, 1);
+
+    SANITY_CHECK_NOTHING();
+}
+
 void generateData( Mat& query, Mat& train, const int sourceType )
 {
     const int dim = 500;
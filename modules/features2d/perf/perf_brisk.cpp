@@ -0,0 +1,78 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+typedef perf::TestBaseWithParam<std::string> brisk;
+
+#define BRISK_IMAGES \
+    "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png",\
+    "stitching/a3.png"
+
+PERF_TEST_P(brisk, detect, testing::Values(BRISK_IMAGES))
+{
+    String filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+
+    if (frame.empty())
+        FAIL() << "Unable to load source image " << filename;
+
+    Mat mask;
+    declare.in(frame);
+    BRISK detector(30, 3);
+    vector<KeyPoint> points;
+
+    TEST_CYCLE() detector(frame, mask, points);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(brisk, extract, testing::Values(BRISK_IMAGES))
+{
+    String filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+
+    if (frame.empty())
+        FAIL() << "Unable to load source image " << filename;
+
+    Mat mask;
+    declare.in(frame);
+
+    BRISK detector(30, 3);
+    vector<KeyPoint> points;
+    detector(frame, mask, points);
+    sort(points.begin(), points.end(), comparators::KeypointGreater());
+
+    Mat descriptors;
+
+    TEST_CYCLE()
+    {
+        vector<KeyPoint> kpts = points;
+        detector(frame, mask, kpts, descriptors, true);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(brisk, full, testing::Values(BRISK_IMAGES))
+{
+    String filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+
+    if (frame.empty())
+        FAIL() << "Unable to load source image " << filename;
+
+    Mat mask;
+    declare.in(frame);
+    BRISK detector(30, 3);
+
+    vector<KeyPoint> points;
+    Mat descriptors;
+
+    TEST_CYCLE() detector(frame, mask, points, descriptors, false);
+
+    SANITY_CHECK_NOTHING();
+}
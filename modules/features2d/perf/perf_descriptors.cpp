@@ -0,0 +1,90 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+typedef perf::TestBaseWithParam<bool> Optimized;
+
+// 10000 keypoints spread over a 1600x1200 image
+static void generateDescriptorData( Mat& image, vector<KeyPoint>& keypoints )
+{
+    RNG& rng = theRNG();
+    image.create(1200, 1600, CV_8UC1);
+    rng.fill(image, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+    GaussianBlur(image, image, Size(0, 0), 2);
+
+    keypoints.clear();
+    for( int i = 0; i < 10000; i++ )
+        keypoints.push_back(KeyPoint(rng.uniform(40.f, image.cols - 40.f), rng.uniform(40.f, image.rows - 40.f),
+                                     31.f, rng.uniform(0.f, 360.f), 0.f, 0));
+}
+
+// useOptimized = false measures the scalar bit tests
+PERF_TEST_P(Optimized, ORB_compute_10k, testing::Bool())
+{
+    bool optimized = GetParam();
+    Mat image, descriptors;
+    vector<KeyPoint> keypoints;
+    generateDescriptorData(image, keypoints);
+
+    ORB orb;
+    declare.in(image);
+
+    bool prevOptimized = useOptimized();
+    setUseOptimized(optimized);
+    TEST_CYCLE()
+    {
+        vector<KeyPoint> points = keypoints;
+        orb(image, noArray(), points, descriptors, true);
+    }
+    setUseOptimized(prevOptimized);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(Optimized, BRIEF_compute_10k, testing::Bool())
+{
+    bool optimized = GetParam();
+    Mat image, descriptors;
+    vector<KeyPoint> keypoints;
+    generateDescriptorData(image, keypoints);
+
+    BriefDescriptorExtractor brief(32);
+    declare.in(image);
+
+    bool prevOptimized = useOptimized();
+    setUseOptimized(optimized);
+    TEST_CYCLE()
+    {
+        vector<KeyPoint> points = keypoints;
+        brief.compute(image, points, descriptors);
+    }
+    setUseOptimized(prevOptimized);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(Optimized, BRISK_compute_10k, testing::Bool())
+{
+    bool optimized = GetParam();
+    Mat image, descriptors;
+    vector<KeyPoint> keypoints;
+    generateDescriptorData(image, keypoints);
+
+    BRISK brisk;
+    declare.in(image);
+
+    bool prevOptimized = useOptimized();
+    setUseOptimized(optimized);
+    TEST_CYCLE()
+    {
+        vector<KeyPoint> points = keypoints;
+        brisk.compute(image, points, descriptors);
+    }
+    setUseOptimized(prevOptimized);
+
+    SANITY_CHECK_NOTHING();
+}
@@ -0,0 +1,78 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+
+typedef perf::TestBaseWithParam<Size> keypoints_size;
+
+PERF_TEST_P(keypoints_size, Dense_detect, testing::Values(sz1080p, sz2160p))
+{
+    Size sz = GetParam();
+    Mat image(sz, CV_8UC1, Scalar(0));
+    Mat mask(sz, CV_8UC1, Scalar(255));
+    rectangle(mask, Point(sz.width/4, sz.height/4), Point(sz.width/2, sz.height/2), Scalar(0), -1);
+
+    DenseFeatureDetector detector(1.f, 3, 2.f, 4, 8, true, true);
+    vector<KeyPoint> points;
+    declare.in(image, mask);
+
+    TEST_CYCLE() detector.detect(image, points, mask);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(keypoints_size, PyramidFAST_detect, testing::Values(sz1080p, sz2160p))
+{
+    Mat image(GetParam(), CV_8UC1);
+    declare.in(image, WARMUP_RNG);
+    GaussianBlur(image, image, Size(0, 0), 2);
+
+    PyramidAdaptedFeatureDetector detector(new FastFeatureDetector(10), 3);
+    vector<KeyPoint> points;
+
+    TEST_CYCLE() detector.detect(image, points);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef perf::TestBaseWithParam<int> keypoints_filter;
+
+// a dense set of FAST-like candidates of a 4K frame
+static void generateKeypoints( int n, vector<KeyPoint>& keypoints )
+{
+    RNG& rng = theRNG();
+    keypoints.resize(n);
+    for( int i = 0; i < n; i++ )
+        keypoints[i] = KeyPoint((float)rng.uniform(0, sz2160p.width), (float)rng.uniform(0, sz2160p.height),
+                                7.f, -1, (float)rng.uniform(0, 256));
+}
+
+PERF_TEST_P(keypoints_filter, removeDuplicated, testing::Values(100000, 1000000))
+{
+    vector<KeyPoint> keypoints, points;
+    generateKeypoints(GetParam(), keypoints);
+    declare.time(30);
+
+    TEST_CYCLE()
+    {
+        points = keypoints;
+        KeyPointsFilter::removeDuplicated(points);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(keypoints_filter, removeNonMaxima, testing::Values(100000, 1000000))
+{
+    vector<KeyPoint> keypoints, points;
+    generateKeypoints(GetParam(), keypoints);
+
+    TEST_CYCLE()
+    {
+        points = keypoints;
+        KeyPointsFilter::removeNonMaxima(points, 5.f);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
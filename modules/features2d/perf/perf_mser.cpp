@@ -0,0 +1,43 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+typedef perf::TestBaseWithParam<MatType> mser;
+
+// blurred noise with a few hundred flat blobs, so that there are regions at all scales
+static void generateMserImage( Size sz, int type, Mat& image )
+{
+    RNG& rng = theRNG();
+    image.create(sz, type);
+    rng.fill(image, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+    GaussianBlur(image, image, Size(0, 0), 3);
+    for( int i = 0; i < 300; i++ )
+    {
+        Point p(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        if( i % 2 )
+            rectangle(image, p, p + Point(rng.uniform(5, 80), rng.uniform(5, 80)), color, -1);
+        else
+            circle(image, p, rng.uniform(3, 50), color, -1);
+    }
+    GaussianBlur(image, image, Size(0, 0), 1);
+}
+
+PERF_TEST_P(mser, detect_1080p, testing::Values(CV_8UC1, CV_8UC3))
+{
+    int type = GetParam();
+    Mat image;
+    generateMserImage(sz1080p, type, image);
+
+    MSER detector;
+    vector<vector<Point> > regions;
+    declare.in(image).time(30);
+
+    TEST_CYCLE() detector(image, regions);
+
+    SANITY_CHECK_NOTHING();
+}
@@ -93,6 +93,196 @@ static void pixelTests64(const Mat& sum, const std::vector<KeyPoint>& keypoints,
     }
 }
 
+#if CV_SSE2
+// The test pairs of generated_64.i as (y1, x1, y2, x2), the pair gives the bit SMOOTHED(y1, x1) < SMOOTHED(y2, x2).
+// The 16 and 32 byte descriptors use the first 128 and 256 pairs
+static const int briefPairs[512*4] =
+{
+    -2,-1, 7,-1, -14,-1, -3,3, 1,-2, 11,2, 1,6, -10,-7,
+    13,2, -1,0, -14,5, 5,-3, -2,8, 2,4, -11,8, -15,5,
+    -6,-23, 8,-9, -12,6, -10,8, -3,-1, 8,1, 3,6, 5,6,
+    -7,-6, 5,-5, 22,-2, -11,-8, 14,7, 8,5, -1,14, -5,-14,
+    -14,9, 2,0, 7,-3, 22,6, -6,6, -8,-5, -5,9, 7,-1,
+    -3,-7, -10,-18, 4,-5, 0,11, 2,3, 9,10, -10,3, 4,9,
+    0,12, -3,19, 1,15, -11,-5, 14,-1, 7,8, 7,-23, -5,5,
+    0,-6, -10,17, 13,-4, -3,-4, -12,1, -12,2, 0,8, 3,22,
+    -13,13, 3,-1, -16,17, 6,10, 7,15, -5,0, 2,-12, 19,-2,
+    3,-6, -4,-15, 8,3, 0,14, 4,-11, 5,5, 11,-7, 7,1,
+    6,12, 21,3, -3,2, 14,1, 5,1, -5,11, 3,-17, -6,2,
+    6,8, 5,-10, -14,-2, 0,4, 5,-7, -6,5, 10,4, 4,-7,
+    22,0, 7,-18, -1,-3, 0,18, -4,22, -5,3, 1,-7, 2,-3,
+    19,-20, 17,-2, 3,-10, -8,24, -5,-14, 7,5, -2,12, -4,-15,
+    4,12, 0,-19, 20,13, 3,5, -8,-12, 5,0, -5,6, -7,-11,
+    6,-11, -3,-22, 15,4, 10,1, -7,-4, 15,-6, 5,10, 0,24,
+    3,6, 22,-2, -13,14, 4,-4, -13,8, -18,-22, -1,-1, -7,3,
+    -19,-12, 4,3, 8,10, 13,-2, -6,-1, -6,-5, 2,-21, -3,2,
+    4,-7, 0,16, -6,-5, -12,-1, 1,-1, 9,18, -7,10, -11,6,
+    4,3, 19,-7, -18,5, -4,5, 4,0, -20,4, 7,-11, 18,12,
+    -20,17, -18,7, 2,15, 19,-11, -18,6, -7,3, -4,1, -14,13,
+    17,3, 2,-8, -7,2, 1,6, 17,-9, -2,8, -8,-6, -1,12,
+    -2,4, -1,6, -2,7, 6,8, -8,-1, -7,-9, 8,-9, 15,0,
+    0,22, -4,-15, -14,-1, 3,-2, -7,-4, 17,-7, -8,-2, 9,-4,
+    5,-7, 7,7, -5,13, -8,11, 11,-4, 0,8, 5,-11, -9,-6,
+    2,-6, 3,-20, -6,2, 6,10, -6,-6, -15,7, -6,-3, 2,1,
+    11,0, -3,2, 7,-12, 14,5, 0,-7, -1,-1, -16,0, 6,8,
+    22,11, 0,-3, 19,0, 5,-17, -23,-14, -13,-19, -8,10, -11,-2,
+    -11,6, -10,13, 1,-7, 14,0, -12,1, -5,-5, 4,7, 8,-1,
+    -1,-5, 15,2, -3,-1, 7,-10, 3,-6, 10,-18, -7,-13, -13,10,
+    1,-1, 13,-10, -19,14, 8,-14, -4,-13, 7,1, 1,-2, 12,-7,
+    3,-5, 1,-5, -2,-2, 8,-10, 2,14, 8,7, 3,9, 8,2,
+    -9,1, -18,0, 4,0, 1,12, 0,9, -14,-10, -13,-9, -2,6,
+    1,5, 10,10, -3,-6, -16,-5, 11,6, -5,0, -23,10, 1,2,
+    13,-5, -3,9, -4,-1, -13,-5, 10,13, -11,8, 19,20, -9,2,
+    4,-8, 0,-9, -14,10, 15,19, -14,-12, -10,-3, -23,-3, 17,-2,
+    -3,-11, 6,-14, 19,-2, -4,2, -5,5, 3,-13, 2,-2, -5,4,
+    17,4, 17,-11, -7,-2, 1,23, 8,13, 1,-16, -13,-5, 1,-17,
+    4,6, -8,-3, -5,-9, -2,-10, -9,0, -7,-2, 5,0, 5,2,
+    -4,-16, 6,3, 2,-15, -2,12, 4,-1, 6,2, 1,1, -2,-8,
+    -2,12, -5,-2, -8,8, -9,9, 2,-10, 3,1, -4,10, -9,4,
+    6,12, 2,5, -3,-8, 0,5, -13,1, -7,2, -1,-10, 7,-18,
+    -1,8, -9,-10, -23,-1, 6,2, -5,-3, 3,2, 0,11, -4,-7,
+    15,2, -10,-3, -20,-8, -13,3, -19,-12, 5,-11, -17,-13, -3,2,
+    7,4, -12,0, 5,-1, -14,-6, -4,11, 0,-4, 3,10, 7,-3,
+    13,21, -11,6, -12,24, -7,-4, 4,16, 3,-14, -3,5, -7,-12,
+    0,-4, 7,-5, -17,-9, 13,-7, 22,-6, -11,5, 2,-8, 23,-11,
+    7,-10, -1,14, -3,-10, 8,3, -13,1, -6,0, -7,-21, 6,-14,
+    18,19, -4,-6, 10,7, -1,-4, -1,21, 1,-5, -10,6, -11,-2,
+    18,-3, -1,7, -3,-9, -5,10, -13,14, 17,-3, 11,-19, -1,-18,
+    8,-2, -18,-23, 0,-5, -2,-9, -4,-11, 2,-8, 14,6, -3,-6,
+    -3,0, -15,0, -9,4, -15,-9, -1,11, 3,11, -10,-16, -7,7,
+    -2,-10, -10,-2, -5,-3, 5,-23, 13,-8, -15,-11, -15,11, 6,-6,
+    -16,-3, -2,2, 6,12, -16,24, -10,0, 8,11, -7,7, -19,-7,
+    5,16, 9,-3, 9,7, -7,-16, 3,2, -10,9, 21,1, 8,7,
+    7,0, 1,17, -8,12, 9,6, 11,-7, -8,-6, 19,0, 9,3,
+    1,-7, -5,-11, 0,8, -2,14, 12,-2, -15,-6, 4,12, 0,-21,
+    17,-4, -6,-7, -10,-9, -14,-7, -15,-10, -15,-14, -7,-5, 5,-12,
+    -4,0, 15,-4, 5,2, -6,-23, -4,-21, -6,4, -10,5, -15,6,
+    4,-3, -1,5, -4,19, -23,-4, -4,17, 13,-11, 1,12, 4,-14,
+    -11,-6, -20,10, 4,5, 3,20, -8,-20, 3,1, -19,9, 9,-3,
+    18,15, 11,-4, 12,16, 8,7, -14,-8, -3,9, -6,0, 2,-4,
+    1,-10, -1,2, 8,-7, -6,18, 9,12, -7,-23, 8,-6, 5,2,
+    -9,6, -12,-7, -1,-2, -7,2, 9,9, 7,15, 6,2, -6,6,
+    16,12, 0,19, 4,3, 6,0, -2,-1, 2,17, 8,1, 3,1,
+    -12,-1, -11,0, -11,2, 7,9, -1,3, -19,4, -1,-11, -1,3,
+    1,-10, -10,-4, -2,3, 6,11, 3,7, -9,-8, 24,-14, -2,-10,
+    -3,-3, -18,-6, -13,-10, -7,-1, 2,-7, 9,-6, 2,-4, 6,-13,
+    4,-4, -2,3, -4,2, 9,13, -11,5, -6,-11, 4,-2, 11,-9,
+    -19,0, -23,-5, -5,-7, -3,-6, -6,-4, 12,14, 12,-11, -8,-16,
+    -21,15, -12,6, -2,-1, -8,16, 6,-1, -8,-2, 1,-1, -9,8,
+    3,-4, -2,-2, -7,0, 4,-8, 11,-11, -12,2, 2,3, 11,7,
+    -7,-4, -9,-6, 3,-7, -5,0, 3,-7, -10,-5, -3,-1, 8,-10,
+    0,8, 5,1, 9,0, 1,16, 8,4, -11,-3, -15,9, 8,17,
+    0,2, -9,17, -6,-11, -10,-3, 1,1, 15,-8, -12,-13, -2,4,
+    -6,4, -6,-10, 5,-7, 7,-5, 10,6, 8,9, -5,7, -18,-3,
+    -6,3, 5,4, -10,-13, -5,-3, -11,2, -16,0, 7,-21, -5,-13,
+    -14,-14, -4,-4, 4,9, 7,-3, 4,11, 10,-4, 6,17, 9,17,
+    -10,8, 0,-11, -6,-16, -6,8, -13,5, 10,-5, 3,2, 12,16,
+    13,-8, 0,-6, 10,0, 4,-11, 8,5, 10,-2, 11,-7, -13,3,
+    2,4, -7,-3, -14,-2, -11,16, 11,-6, 7,6, -3,15, 8,-10,
+    -3,8, 12,-12, -13,6, -14,7, -11,-5, -8,-6, 7,-6, 6,3,
+    -4,10, 5,1, 9,16, 10,13, -17,10, 2,8, -5,1, 4,-4,
+    -14,8, -5,2, 4,-9, -6,-3, 3,-7, -10,0, -2,-8, -10,4,
+    -8,5, -9,24, 2,-8, 8,-9, -4,17, -5,2, 14,0, -9,9,
+    11,15, -6,5, -8,1, -3,4, 9,-21, 10,2, 2,-1, 4,11,
+    24,3, 2,-2, -8,17, -14,-10, 6,5, -13,7, 11,10, 0,-1,
+    4,6, -10,6, -12,-2, 5,6, 3,-1, 8,-15, 1,-4, -7,11,
+    1,11, 5,0, 6,-12, 10,1, -3,-2, -1,4, -2,-11, -1,12,
+    7,-8, -20,-18, 2,0, -9,2, -13,-1, -16,2, 3,-1, -5,-17,
+    15,8, 3,-14, -13,-12, 6,15, 2,-8, 2,6, 6,22, -3,-23,
+    -2,-7, -6,0, 13,-10, -6,6, 6,7, -10,12, -6,7, -2,11,
+    0,-22, -2,-17, -4,-1, -11,-14, -2,-8, 7,12, 12,-5, 7,-13,
+    2,-2, -7,6, 0,8, -3,23, 6,12, 13,-11, -21,-10, 10,8,
+    -3,0, 7,15, 7,-6, -5,-12, -21,-10, 12,-11, -5,-11, 8,-11,
+    5,0, -11,-1, 8,-9, 7,-1, 11,-23, 21,-5, 0,-5, -8,6,
+    -6,8, 8,12, -7,5, 3,-2, -5,-20, -12,9, -6,12, -11,3,
+    4,5, 13,11, 2,12, 13,-12, -4,-13, 4,7, 0,15, -3,-16,
+    -3,2, -2,14, 4,-14, 16,-11, -13,3, 23,10, 9,-19, 2,5,
+    5,3, 14,-7, 19,-13, -11,15, 14,0, -2,-5, 11,-4, 0,-6,
+    -2,5, -13,-8, -11,-15, -7,-17, 1,3, -10,-8, -13,-10, 7,-12,
+    0,-13, 23,-6, 2,-17, -7,-3, 1,3, 4,-10, 13,4, 14,-6,
+    -19,-2, -1,5, 9,-8, 10,-5, 7,-1, 5,7, 9,-10, 19,0,
+    7,5, -4,-7, -11,1, -1,-11, 2,-1, -4,11, -1,7, 2,-2,
+    1,-20, -9,-6, -4,-18, 8,-18, -16,-2, 7,-6, -3,-6, -1,-4,
+    0,-16, 24,-5, -4,-2, -1,9, -8,2, -6,15, 11,4, 0,-3,
+    7,6, 2,-10, -7,-9, 12,-6, 24,15, -8,-1, 15,-9, -3,-15,
+    17,-5, 11,-10, -2,13, -15,4, -2,-1, 4,-23, -16,3, -7,-14,
+    -3,-5, -10,-9, -5,3, -2,-1, -1,4, 1,8, 12,9, 9,-14,
+    -9,17, -3,0, 5,4, 13,-6, -1,-8, 19,10, 8,-5, -15,2,
+    -12,-9, -4,-5, 12,0, 24,4, 8,-2, 14,4, 8,-4, -7,16,
+    5,-1, -8,-4, -2,18, -5,17, 8,-2, -9,-2, 3,-7, 1,-6,
+    -5,-22, -5,-2, -8,-10, 14,1, -3,-13, 3,9, -4,-1, -1,0,
+    -7,-21, 12,-19, -8,8, 24,8, 12,-6, -2,3, -5,-11, -22,-4,
+    -3,5, -4,4, -16,24, 7,-9, -10,23, -9,18, 1,12, 17,21,
+    24,-6, -3,-11, -7,17, 1,-6, 4,4, 2,-7, 14,6, -12,3,
+    -6,0, -16,13, -10,5, 7,12, 5,2, 6,-3, 7,0, -23,1,
+    15,-5, 1,14, -3,-1, 6,6, 6,-9, -9,12, 4,-2, -4,7,
+    -4,-5, 4,4, -13,0, 6,-10, 2,-12, -6,-3, 16,0, -3,3,
+    5,-14, 6,11, 5,11, 0,-13, 7,5, -1,-5, 12,4, 6,10,
+    -10,4, -1,-11, 4,10, -14,5, 11,-14, -13,0, 2,8, 12,24,
+    -1,3, -1,2, 9,-14, -23,3, -8,-6, 0,9, -15,14, 10,-10,
+    -10,-6, -7,-5, 11,5, -3,-15, 1,0, 1,8, -11,-6, -4,-18,
+    9,0, 22,-4, -5,-1, -9,4, -20,2, 1,6, 1,2, -9,-12,
+    5,15, 4,-6, 19,4, 4,11, 17,-4, -8,-1, -8,-12, 7,-3,
+    11,9, 8,1, 9,22, -15,15, -7,-7, 1,-23, -5,13, -8,2,
+    3,-5, 11,-11, 3,-18, 14,-5, -20,7, -10,-23, -2,-5, 6,0,
+    -17,-13, -3,2, -6,-1, 14,-2, -12,-16, 15,6, -12,-2, 3,-19
+};
+
+// Computes the box sums of all the pairs of a keypoint and compares them 16 pairs at a time
+static void pixelTests_SSE2(const Mat& sum, const std::vector<KeyPoint>& keypoints, Mat& descriptors)
+{
+    static const int KERNEL_SIZE = BriefDescriptorExtractor::KERNEL_SIZE;
+    static const int HALF_KERNEL = KERNEL_SIZE / 2;
+
+    int npairs = descriptors.cols*8;
+    int step = (int)(sum.step/sizeof(int));
+    int dx = KERNEL_SIZE, dy = KERNEL_SIZE*step, dxy = dx + dy;
+
+    AutoBuffer<int> buf(npairs*4);
+    int *ofs1 = buf, *ofs2 = ofs1 + npairs, *vals1 = ofs2 + npairs, *vals2 = vals1 + npairs;
+
+    // offsets of the top left corners of the smoothing windows; the pairs are reversed within every byte,
+    // because the first pair of a byte goes to its most significant bit
+    for( int i = 0; i < npairs; i++ )
+    {
+        const int* pair = briefPairs + i*4;
+        int j = (i & ~7) + 7 - (i & 7);
+        ofs1[j] = (pair[0] - HALF_KERNEL)*step + pair[1] - HALF_KERNEL;
+        ofs2[j] = (pair[2] - HALF_KERNEL)*step + pair[3] - HALF_KERNEL;
+    }
+
+    for( int k = 0; k < (int)keypoints.size(); k++ )
+    {
+        uchar* desc = descriptors.ptr(k);
+        const KeyPoint& pt = keypoints[k];
+        const int* center = sum.ptr<int>((int)(pt.pt.y + 0.5)) + (int)(pt.pt.x + 0.5);
+
+        for( int i = 0; i < npairs; i++ )
+        {
+            const int* p1 = center + ofs1[i];
+            const int* p2 = center + ofs2[i];
+            vals1[i] = p1[dxy] - p1[dy] - p1[dx] + p1[0];
+            vals2[i] = p2[dxy] - p2[dy] - p2[dx] + p2[0];
+        }
+
+        for( int i = 0; i < npairs; i += 16 )
+        {
+            __m128i lt0 = _mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)(vals1 + i)),
+                                          _mm_loadu_si128((const __m128i*)(vals2 + i)));
+            __m128i lt1 = _mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)(vals1 + i + 4)),
+                                          _mm_loadu_si128((const __m128i*)(vals2 + i + 4)));
+            __m128i lt2 = _mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)(vals1 + i + 8)),
+                                          _mm_loadu_si128((const __m128i*)(vals2 + i + 8)));
+            __m128i lt3 = _mm_cmplt_epi32(_mm_loadu_si128((const __m128i*)(vals1 + i + 12)),
+                                          _mm_loadu_si128((const __m128i*)(vals2 + i + 12)));
+            int bits = _mm_movemask_epi8(_mm_packs_epi16(_mm_packs_epi32(lt0, lt1), _mm_packs_epi32(lt2, lt3)));
+            desc[i/8] = (uchar)bits;
+            desc[i/8 + 1] = (uchar)(bits >> 8);
+        }
+    }
+}
+#endif
+
 namespace cv
 {
 
@@ -169,7 +359,12 @@ void BriefDescriptorExtractor::computeImpl(const Mat& image, std::vector<KeyPoin
     KeyPointsFilter::runByImageBorder(keypoints, image.size(), PATCH_SIZE/2 + KERNEL_SIZE/2);
 
     descriptors = Mat::zeros((int)keypoints.size(), bytes_, CV_8U);
-    test_fn_(sum, keypoints, descriptors);
+#if CV_SSE2
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+        pixelTests_SSE2(sum, keypoints, descriptors);
+    else
+#endif
+        test_fn_(sum, keypoints, descriptors);
 }
 
 } // namespace cv
@@ -45,6 +45,7 @@
 #include <opencv2/features2d/features2d.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/core/internal.hpp>
 #include <fstream>
 #include <stdlib.h>
 
@@ -517,6 +518,297 @@ RoiPredicate(const float minX, const float minY, const float maxX, const float m
   return (pt.x < minX) || (pt.x >= maxX) || (pt.y < minY) || (pt.y >= maxY);
 }
 
+#if CV_SSE2
+static inline __m128i
+mul32_SSE2(const __m128i& a, const __m128i& b)
+{
+  // low 32 bits of the lane-wise product (there is no _mm_mullo_epi32 before SSE4.1)
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i
+div32_SSE2(const __m128i& a, const __m128i& b)
+{
+  // truncating integer division; exact, since both operands are representable as doubles
+  __m128i lo = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(a), _mm_cvtepi32_pd(b)));
+  __m128i hi = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(_mm_srli_si128(a, 8)),
+                                           _mm_cvtepi32_pd(_mm_srli_si128(b, 8))));
+  return _mm_unpacklo_epi64(lo, hi);
+}
+
+// Computes BRISK::smoothedIntensity() for 4 consecutive pattern points given as (x, y, sigma) triplets,
+// bit-exactly, for the points that are sampled through the integral image. Returns the mask of the points
+// with a small smoothing area (sigma < 0.5 or at most 2 inner pixels) that are left to the scalar version.
+static int
+smoothedIntensity4_SSE2(const Mat& image, const Mat& integral, float key_x, float key_y,
+                        const float* pattern, int* values)
+{
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 xf = _mm_add_ps(_mm_setr_ps(pattern[0], pattern[3], pattern[6], pattern[9]), _mm_set1_ps(key_x));
+  const __m128 yf = _mm_add_ps(_mm_setr_ps(pattern[1], pattern[4], pattern[7], pattern[10]), _mm_set1_ps(key_y));
+  const __m128 sigma_half = _mm_setr_ps(pattern[2], pattern[5], pattern[8], pattern[11]);
+
+  int scalarMask = _mm_movemask_ps(_mm_cmplt_ps(sigma_half, half));
+  if (scalarMask == 15)
+    return scalarMask;
+
+  const __m128 area = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(4.0f), sigma_half), sigma_half);
+
+  // scaling: (int)(4194304.0 / area) in double precision, as the scalar code does
+  const __m128d k = _mm_set1_pd(4194304.0);
+  const __m128i scaling = _mm_unpacklo_epi64(_mm_cvttpd_epi32(_mm_div_pd(k, _mm_cvtps_pd(area))),
+                                             _mm_cvttpd_epi32(_mm_div_pd(k, _mm_cvtps_pd(_mm_movehl_ps(area, area)))));
+  const __m128 fscaling = _mm_cvtepi32_ps(scaling);
+  const __m128i scaling2 = _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(fscaling, area), _mm_set1_ps(1.f / 1024)));
+
+  // calculate borders
+  const __m128 x_1 = _mm_sub_ps(xf, sigma_half);
+  const __m128 x1 = _mm_add_ps(xf, sigma_half);
+  const __m128 y_1 = _mm_sub_ps(yf, sigma_half);
+  const __m128 y1 = _mm_add_ps(yf, sigma_half);
+
+  const __m128i x_left = _mm_cvttps_epi32(_mm_add_ps(x_1, half));
+  const __m128i y_top = _mm_cvttps_epi32(_mm_add_ps(y_1, half));
+  const __m128i x_right = _mm_cvttps_epi32(_mm_add_ps(x1, half));
+  const __m128i y_bottom = _mm_cvttps_epi32(_mm_add_ps(y1, half));
+
+  // overlap area - multiplication factors:
+  const __m128 r_x_1 = _mm_add_ps(_mm_sub_ps(_mm_cvtepi32_ps(x_left), x_1), half);
+  const __m128 r_y_1 = _mm_add_ps(_mm_sub_ps(_mm_cvtepi32_ps(y_top), y_1), half);
+  const __m128 r_x1 = _mm_add_ps(_mm_sub_ps(x1, _mm_cvtepi32_ps(x_right)), half);
+  const __m128 r_y1 = _mm_add_ps(_mm_sub_ps(y1, _mm_cvtepi32_ps(y_bottom)), half);
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i dx = _mm_sub_epi32(_mm_sub_epi32(x_right, x_left), one);
+  const __m128i dy = _mm_sub_epi32(_mm_sub_epi32(y_bottom, y_top), one);
+  const __m128i A = _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(r_x_1, r_y_1), fscaling));
+  const __m128i B = _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(r_x1, r_y_1), fscaling));
+  const __m128i C = _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(r_x1, r_y1), fscaling));
+  const __m128i D = _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(r_x_1, r_y1), fscaling));
+  const __m128i r_x_1_i = _mm_cvttps_epi32(_mm_mul_ps(r_x_1, fscaling));
+  const __m128i r_y_1_i = _mm_cvttps_epi32(_mm_mul_ps(r_y_1, fscaling));
+  const __m128i r_x1_i = _mm_cvttps_epi32(_mm_mul_ps(r_x1, fscaling));
+  const __m128i r_y1_i = _mm_cvttps_epi32(_mm_mul_ps(r_y1, fscaling));
+
+  scalarMask |= ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(_mm_add_epi32(dx, dy), _mm_set1_epi32(2)))) & 15;
+  if (scalarMask == 15)
+    return scalarMask;
+
+  // gather the corner pixels and the integral image samples of the inner area and the edges
+  int CV_DECL_ALIGNED(16) buf[4*4];
+  int CV_DECL_ALIGNED(16) s[16*4];
+  _mm_store_si128((__m128i*)buf, x_left);
+  _mm_store_si128((__m128i*)(buf + 4), y_top);
+  _mm_store_si128((__m128i*)(buf + 8), dx);
+  _mm_store_si128((__m128i*)(buf + 12), dy);
+
+  const int imagecols = image.cols;
+  const int integralcols = imagecols + 1;
+  for (int j = 0; j < 4; j++)
+  {
+    if (scalarMask & (1 << j))
+    {
+      for (int i = 0; i < 16; i++)
+        s[i*4 + j] = 0;
+      continue;
+    }
+    const int xl = buf[j], yt = buf[4 + j], ddx = buf[8 + j], ddy = buf[12 + j];
+    const uchar* ptr = image.data + xl + imagecols * yt;
+    s[0*4 + j] = ptr[0];
+    s[1*4 + j] = ptr[ddx + 1];
+    s[2*4 + j] = ptr[ddx + 2 + ddy * imagecols];
+    s[3*4 + j] = ptr[1 + ddy * imagecols];
+
+    const int* ptr_integral = (const int*) integral.data + xl + integralcols * yt + 1;
+    const int dyi = ddy * integralcols;
+    s[4*4 + j] = ptr_integral[0];                                  // tmp1
+    s[5*4 + j] = ptr_integral[ddx];                                // tmp2
+    s[6*4 + j] = ptr_integral[ddx + integralcols];                 // tmp3
+    s[7*4 + j] = ptr_integral[ddx + integralcols + 1];             // tmp4
+    s[8*4 + j] = ptr_integral[ddx + integralcols + 1 + dyi];       // tmp5
+    s[9*4 + j] = ptr_integral[ddx + integralcols + dyi];           // tmp6
+    s[10*4 + j] = ptr_integral[ddx + 2 * integralcols + dyi];      // tmp7
+    s[11*4 + j] = ptr_integral[2 * integralcols + dyi];            // tmp8
+    s[12*4 + j] = ptr_integral[integralcols + dyi];                // tmp9
+    s[13*4 + j] = ptr_integral[integralcols + dyi - 1];            // tmp10
+    s[14*4 + j] = ptr_integral[integralcols - 1];                  // tmp11
+    s[15*4 + j] = ptr_integral[integralcols];                      // tmp12
+  }
+
+  const __m128i* v = (const __m128i*)s;
+  __m128i ret_val = _mm_add_epi32(_mm_add_epi32(mul32_SSE2(A, v[0]), mul32_SSE2(B, v[1])),
+                                  _mm_add_epi32(mul32_SSE2(C, v[2]), mul32_SSE2(D, v[3])));
+  const __m128i tmp1 = v[4], tmp2 = v[5], tmp3 = v[6], tmp4 = v[7], tmp5 = v[8], tmp6 = v[9];
+  const __m128i tmp7 = v[10], tmp8 = v[11], tmp9 = v[12], tmp10 = v[13], tmp11 = v[14], tmp12 = v[15];
+
+  // assign the weighted surface integrals:
+  const __m128i upper = mul32_SSE2(_mm_sub_epi32(_mm_add_epi32(_mm_sub_epi32(tmp3, tmp2), tmp1), tmp12), r_y_1_i);
+  const __m128i middle = mul32_SSE2(_mm_sub_epi32(_mm_add_epi32(_mm_sub_epi32(tmp6, tmp3), tmp12), tmp9), scaling);
+  const __m128i left = mul32_SSE2(_mm_sub_epi32(_mm_add_epi32(_mm_sub_epi32(tmp9, tmp12), tmp11), tmp10), r_x_1_i);
+  const __m128i right = mul32_SSE2(_mm_sub_epi32(_mm_add_epi32(_mm_sub_epi32(tmp5, tmp4), tmp3), tmp6), r_x1_i);
+  const __m128i bottom = mul32_SSE2(_mm_sub_epi32(_mm_add_epi32(_mm_sub_epi32(tmp7, tmp6), tmp9), tmp8), r_y1_i);
+
+  ret_val = _mm_add_epi32(ret_val, _mm_add_epi32(_mm_add_epi32(upper, middle), _mm_add_epi32(left, right)));
+  ret_val = _mm_add_epi32(ret_val, _mm_add_epi32(bottom, _mm_srai_epi32(scaling2, 1)));
+
+  // lanes left to the scalar code may hold garbage; divide by 1 there
+  const __m128i laneMask = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(scalarMask), _mm_setr_epi32(1, 2, 4, 8)),
+                                           _mm_setzero_si128());
+  const __m128i divisor = _mm_or_si128(_mm_and_si128(laneMask, scaling2), _mm_andnot_si128(laneMask, one));
+  _mm_storeu_si128((__m128i*)values, div32_SSE2(ret_val, divisor));
+  return scalarMask;
+}
+#endif
+
+// computes orientation and/or descriptors of a range of keypoints
+class BRISKDescriptorInvoker : public ParallelLoopBody
+{
+public:
+  BRISKDescriptorInvoker(const BRISK& _brisk, const Mat& _image, const Mat& _integral, vector<KeyPoint>& _keypoints,
+                         const vector<int>& _kscales, Mat& _descriptors, bool _doDescriptors, bool _doOrientation)
+  {
+    brisk = &_brisk;
+    image = _image;
+    integral = _integral;
+    keypoints = &_keypoints;
+    kscales = &_kscales;
+    descriptors = &_descriptors;
+    doDescriptors = _doDescriptors;
+    doOrientation = _doOrientation;
+    useSIMD = false;
+#if CV_SSE2
+    useSIMD = checkHardwareSupport(CV_CPU_SSE2);
+#endif
+  }
+
+  // get the gray values of all the pattern points at the given scale and rotation
+  void smoothedIntensities(float x, float y, int scale, int rot, int* values) const
+  {
+    const unsigned int points = brisk->points_;
+    const unsigned int offset = scale * BRISK::n_rot_ * points + rot * points;
+    unsigned int i = 0;
+#if CV_SSE2
+    if (useSIMD)
+    {
+      const float* pattern = (const float*)(brisk->patternPoints_ + offset);
+      for (; i + 4 <= points; i += 4)
+      {
+        int scalarMask = smoothedIntensity4_SSE2(image, integral, x, y, pattern + i * 3, values + i);
+        for (int j = 0; scalarMask != 0; j++, scalarMask >>= 1)
+          if (scalarMask & 1)
+            values[i + j] = brisk->smoothedIntensity(image, integral, x, y, scale, rot, i + j);
+      }
+    }
+#endif
+    for (; i < points; i++)
+      values[i] = brisk->smoothedIntensity(image, integral, x, y, scale, rot, i);
+  }
+
+  void operator()(const Range& range) const
+  {
+    AutoBuffer<int> buf(brisk->points_); // for temporary use
+    int* _values = buf;
+
+    // temporary variables containing gray values at sample points:
+    int t1;
+    int t2;
+
+    for (int k = range.start; k < range.end; k++)
+    {
+      cv::KeyPoint& kp = (*keypoints)[k];
+      const int& scale = (*kscales)[k];
+      const float& x = kp.pt.x;
+      const float& y = kp.pt.y;
+
+      if (doOrientation)
+      {
+          // get the gray values in the unrotated pattern
+          smoothedIntensities(x, y, scale, 0, _values);
+
+          int direction0 = 0;
+          int direction1 = 0;
+          // now iterate through the long pairings
+          const BRISK::BriskLongPair* max = brisk->longPairs_ + brisk->noLongPairs_;
+          for (const BRISK::BriskLongPair* iter = brisk->longPairs_; iter < max; ++iter)
+          {
+            t1 = *(_values + iter->i);
+            t2 = *(_values + iter->j);
+            const int delta_t = (t1 - t2);
+            // update the direction:
+            const int tmp0 = delta_t * (iter->weighted_dx) / 1024;
+            const int tmp1 = delta_t * (iter->weighted_dy) / 1024;
+            direction0 += tmp0;
+            direction1 += tmp1;
+          }
+          kp.angle = (float)(atan2((float) direction1, (float) direction0) / CV_PI * 180.0);
+          if (kp.angle < 0)
+            kp.angle += 360.f;
+      }
+
+      if (!doDescriptors)
+        continue;
+
+      int theta;
+      if (kp.angle==-1)
+      {
+          // don't compute the gradient direction, just assign a rotation of 0°
+          theta = 0;
+      }
+      else
+      {
+          theta = (int) (BRISK::n_rot_ * (kp.angle / (360.0)) + 0.5);
+          if (theta < 0)
+            theta += BRISK::n_rot_;
+          if (theta >= int(BRISK::n_rot_))
+            theta -= BRISK::n_rot_;
+      }
+
+      // now also extract the stuff for the actual direction:
+      // let us compute the smoothed values
+      int shifter = 0;
+
+      // get the gray values in the rotated pattern
+      smoothedIntensities(x, y, scale, theta, _values);
+
+      // now iterate through all the pairings
+      unsigned int* ptr2 = (unsigned int*) descriptors->ptr(k);
+      const BRISK::BriskShortPair* max = brisk->shortPairs_ + brisk->noShortPairs_;
+      for (const BRISK::BriskShortPair* iter = brisk->shortPairs_; iter < max; ++iter)
+      {
+        t1 = *(_values + iter->i);
+        t2 = *(_values + iter->j);
+        if (t1 > t2)
+        {
+          *ptr2 |= ((1) << shifter);
+
+        } // else already initialized with zero
+        // take care of the iterators:
+        ++shifter;
+        if (shifter == 32)
+        {
+          shifter = 0;
+          ++ptr2;
+        }
+      }
+    }
+  }
+
+private:
+  BRISKDescriptorInvoker& operator=(const BRISKDescriptorInvoker&);
+
+  const BRISK* brisk;
+  Mat image;
+  Mat integral;
+  vector<KeyPoint>* keypoints;
+  const vector<int>* kscales;
+  Mat* descriptors;
+  bool doDescriptors;
+  bool doOrientation;
+  bool useSIMD;
+};
+
 // computes the descriptor
 void
 BRISK::operator()( InputArray _image, InputArray _mask, vector<KeyPoint>& keypoints,
@@ -554,9 +846,8 @@ BRISK::computeDescriptorsAndOrOrientation(InputArray _image, InputArray _mask, v
   kscales.resize(ksize);
   static const float log2 = 0.693147180559945f;
   static const float lb_scalerange = (float)(log(scalerange_) / (log2));
-  std::vector<cv::KeyPoint>::iterator beginning = keypoints.begin();
-  std::vector<int>::iterator beginningkscales = kscales.begin();
   static const float basicSize06 = basicSize_ * 0.6f;
+  size_t kept = 0;
   for (size_t k = 0; k < ksize; k++)
   {
     unsigned int scale;
@@ -564,31 +855,26 @@ BRISK::computeDescriptorsAndOrOrientation(InputArray _image, InputArray _mask, v
       // saturate
       if (scale >= scales_)
         scale = scales_ - 1;
-      kscales[k] = scale;
     const int border = sizeList_[scale];
     const int border_x = image.cols - border;
     const int border_y = image.rows - border;
-    if (RoiPredicate((float)border, (float)border, (float)border_x, (float)border_y, keypoints[k]))
+    if (!RoiPredicate((float)border, (float)border, (float)border_x, (float)border_y, keypoints[k]))
     {
-      keypoints.erase(beginning + k);
-      kscales.erase(beginningkscales + k);
-      if (k == 0)
-      {
-        beginning = keypoints.begin();
-        beginningkscales = kscales.begin();
-      }
-      ksize--;
-      k--;
+      // compact the survivors in place, keeping their order
+      if (kept != k)
+        keypoints[kept] = keypoints[k];
+      kscales[kept++] = scale;
     }
   }
+  keypoints.resize(kept);
+  kscales.resize(kept);
+  ksize = kept;
 
   // first, calculate the integral image over the whole image:
   // current integral image
   cv::Mat _integral; // the integral image
   cv::integral(image, _integral);
 
-  int* _values = new int[points_]; // for temporary use
-
   // resize the descriptors:
   cv::Mat descriptors;
   if (doDescriptors)
@@ -598,106 +884,10 @@ BRISK::computeDescriptorsAndOrOrientation(InputArray _image, InputArray _mask, v
     descriptors.setTo(0);
   }
 
-  // now do the extraction for all keypoints:
-
-  // temporary variables containing gray values at sample points:
-  int t1;
-  int t2;
-
-  // the feature orientation
-  uchar* ptr = descriptors.data;
-  for (size_t k = 0; k < ksize; k++)
-  {
-    cv::KeyPoint& kp = keypoints[k];
-    const int& scale = kscales[k];
-    int* pvalues = _values;
-    const float& x = kp.pt.x;
-    const float& y = kp.pt.y;
-
-    if (doOrientation)
-    {
-        // get the gray values in the unrotated pattern
-        for (unsigned int i = 0; i < points_; i++)
-        {
-          *(pvalues++) = smoothedIntensity(image, _integral, x, y, scale, 0, i);
-        }
-
-        int direction0 = 0;
-        int direction1 = 0;
-        // now iterate through the long pairings
-        const BriskLongPair* max = longPairs_ + noLongPairs_;
-        for (BriskLongPair* iter = longPairs_; iter < max; ++iter)
-        {
-          t1 = *(_values + iter->i);
-          t2 = *(_values + iter->j);
-          const int delta_t = (t1 - t2);
-          // update the direction:
-          const int tmp0 = delta_t * (iter->weighted_dx) / 1024;
-          const int tmp1 = delta_t * (iter->weighted_dy) / 1024;
-          direction0 += tmp0;
-          direction1 += tmp1;
-        }
-        kp.angle = (float)(atan2((float) direction1, (float) direction0) / CV_PI * 180.0);
-        if (kp.angle < 0)
-          kp.angle += 360.f;
-    }
-
-    if (!doDescriptors)
-      continue;
-
-    int theta;
-    if (kp.angle==-1)
-    {
-        // don't compute the gradient direction, just assign a rotation of 0°
-        theta = 0;
-    }
-    else
-    {
-        theta = (int) (n_rot_ * (kp.angle / (360.0)) + 0.5);
-        if (theta < 0)
-          theta += n_rot_;
-        if (theta >= int(n_rot_))
-          theta -= n_rot_;
-    }
-
-    // now also extract the stuff for the actual direction:
-    // let us compute the smoothed values
-    int shifter = 0;
-
-    //unsigned int mean=0;
-    pvalues = _values;
-    // get the gray values in the rotated pattern
-    for (unsigned int i = 0; i < points_; i++)
-    {
-      *(pvalues++) = smoothedIntensity(image, _integral, x, y, scale, theta, i);
-    }
-
-    // now iterate through all the pairings
-    unsigned int* ptr2 = (unsigned int*) ptr;
-    const BriskShortPair* max = shortPairs_ + noShortPairs_;
-    for (BriskShortPair* iter = shortPairs_; iter < max; ++iter)
-    {
-      t1 = *(_values + iter->i);
-      t2 = *(_values + iter->j);
-      if (t1 > t2)
-      {
-        *ptr2 |= ((1) << shifter);
-
-      } // else already initialized with zero
-      // take care of the iterators:
-      ++shifter;
-      if (shifter == 32)
-      {
-        shifter = 0;
-        ++ptr2;
-      }
-    }
-
-    ptr += strings_;
-  }
-
-  // clean-up
-  delete[] _values;
+  // now do the extraction for all keypoints; each of them is independent of the others
+  parallel_for_(Range(0, (int)ksize),
+                BRISKDescriptorInvoker(*this, image, _integral, keypoints, kscales, descriptors,
+                                       doDescriptors, doOrientation));
 }
 
 int
@@ -768,6 +958,65 @@ BriskScaleSpace::~BriskScaleSpace()
 {
 
 }
+// builds the octave chain (chain 0) or the intra-octave chain (chain 1) of the pyramid
+class BriskPyramidInvoker : public ParallelLoopBody
+{
+public:
+  BriskPyramidInvoker(const BriskLayer& _base, int _layers, std::vector<BriskLayer>* _chains) :
+    base(&_base), layers(_layers), chains(_chains)
+  {
+  }
+
+  void operator()(const Range& range) const
+  {
+    for (int c = range.start; c < range.end; c++)
+    {
+      std::vector<BriskLayer>& chain = chains[c];
+      if (c == 0)
+      {
+        if (layers > 2)
+          chain.push_back(BriskLayer(*base, BriskLayer::CommonParams::HALFSAMPLE));
+        for (int i = 4; i < layers; i += 2)
+          chain.push_back(BriskLayer(chain.back(), BriskLayer::CommonParams::HALFSAMPLE));
+      }
+      else
+      {
+        chain.push_back(BriskLayer(*base, BriskLayer::CommonParams::TWOTHIRDSAMPLE));
+        for (int i = 3; i < layers; i += 2)
+          chain.push_back(BriskLayer(chain.back(), BriskLayer::CommonParams::HALFSAMPLE));
+      }
+    }
+  }
+
+private:
+  const BriskLayer* base;
+  int layers;
+  std::vector<BriskLayer>* chains;
+};
+
+// runs the Agast detector on a range of pyramid layers
+class BriskAgastInvoker : public ParallelLoopBody
+{
+public:
+  BriskAgastInvoker(std::vector<BriskLayer>& _pyramid, int _threshold,
+                    std::vector<std::vector<cv::KeyPoint> >& _agastPoints) :
+    pyramid(&_pyramid), threshold(_threshold), agastPoints(&_agastPoints)
+  {
+  }
+
+  void operator()(const Range& range) const
+  {
+    // call OAST16_9 without nms
+    for (int i = range.start; i < range.end; i++)
+      (*pyramid)[i].getAgastPoints(threshold, (*agastPoints)[i]);
+  }
+
+private:
+  std::vector<BriskLayer>* pyramid;
+  int threshold;
+  std::vector<std::vector<cv::KeyPoint> >* agastPoints;
+};
+
 // construct the image pyramids
 void
 BriskScaleSpace::constructPyramid(const cv::Mat& image)
@@ -778,17 +1027,16 @@ BriskScaleSpace::constructPyramid(const cv::Mat& image)
 
   // fill the pyramid:
   pyramid_.push_back(BriskLayer(image.clone()));
-  if (layers_ > 1)
-  {
-    pyramid_.push_back(BriskLayer(pyramid_.back(), BriskLayer::CommonParams::TWOTHIRDSAMPLE));
-  }
-  const int octaves2 = layers_;
+  if (layers_ == 1)
+    return;
 
-  for (uchar i = 2; i < octaves2; i += 2)
-  {
-    pyramid_.push_back(BriskLayer(pyramid_[i - 2], BriskLayer::CommonParams::HALFSAMPLE));
-    pyramid_.push_back(BriskLayer(pyramid_[i - 1], BriskLayer::CommonParams::HALFSAMPLE));
-  }
+  // the octaves and the intra-octaves are two independent chains of half-sampled layers,
+  // so build them concurrently and interleave them afterwards
+  std::vector<BriskLayer> chains[2];
+  parallel_for_(Range(0, 2), BriskPyramidInvoker(pyramid_[0], layers_, chains));
+
+  for (int i = 1; i < layers_; i++)
+    pyramid_.push_back(chains[i % 2][(i - 1) / 2]);
 }
 
 void
@@ -804,12 +1052,10 @@ BriskScaleSpace::getKeypoints(const int threshold_, std::vector<cv::KeyPoint>& k
   agastPoints.resize(layers_);
 
   // go through the octaves and intra layers and calculate fast corner scores:
-  for (int i = 0; i < layers_; i++)
-  {
-    // call OAST16_9 without nms
-    BriskLayer& l = pyramid_[i];
-    l.getAgastPoints(safeThreshold_, agastPoints[i]);
-  }
+  parallel_for_(Range(0, layers_), BriskAgastInvoker(pyramid_, safeThreshold_, agastPoints));
+
+  // The refinement below stays serial: the scores of the layers are cached lazily,
+  // and the cached values depend on the threshold of the first query of each pixel.
 
   if (layers_ == 1)
   {
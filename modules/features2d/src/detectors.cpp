@@ -159,19 +159,79 @@ DenseFeatureDetector::DenseFeatureDetector( float _initFeatureScale, int _featur
 {}
 
 
+namespace {
+struct DenseLevel
+{
+    float scale;
+    int step, bound;
+    int cols, rows;  // number of the grid columns and rows
+    int firstCol;    // index of the first grid column of the level among all the columns
+    size_t ofs;      // index of the first keypoint of the level
+};
+
+// fills the keypoints of the grid columns in the same order as the serial loop
+// (level by level, x by x and y by y), each column goes to its precomputed place
+class DenseFeatureDetectorInvoker : public ParallelLoopBody
+{
+public:
+    DenseFeatureDetectorInvoker( const vector<DenseLevel>& _levels, KeyPoint* _keypoints )
+        : levels(&_levels), keypoints(_keypoints)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        size_t l = 0;
+        for( int c = range.start; c < range.end; c++ )
+        {
+            while( c >= (*levels)[l].firstCol + (*levels)[l].cols )
+                l++;
+            const DenseLevel& level = (*levels)[l];
+            int i = c - level.firstCol;
+            int x = level.bound + i*level.step;
+            KeyPoint* kp = keypoints + level.ofs + (size_t)i*level.rows;
+            for( int j = 0, y = level.bound; j < level.rows; j++, y += level.step )
+                kp[j] = KeyPoint(static_cast<float>(x), static_cast<float>(y), level.scale);
+        }
+    }
+
+private:
+    const vector<DenseLevel>* levels;
+    KeyPoint* keypoints;
+};
+} // namespace
+
+static int denseGridSize( int size, int bound, int step )
+{
+    if( size - bound <= bound )
+        return 0;
+    CV_Assert( step > 0 );
+    return (size - 2*bound + step - 1)/step;
+}
+
 void DenseFeatureDetector::detectImpl( const Mat& image, vector<KeyPoint>& keypoints, const Mat& mask ) const
 {
     float curScale = static_cast<float>(initFeatureScale);
     int curStep = initXyStep;
     int curBound = initImgBound;
+    vector<DenseLevel> levels;
+    int ncols = 0;
+    size_t first = keypoints.size(), total = first;
     for( int curLevel = 0; curLevel < featureScaleLevels; curLevel++ )
     {
-        for( int x = curBound; x < image.cols - curBound; x += curStep )
+        DenseLevel level;
+        level.scale = curScale;
+        level.step = curStep;
+        level.bound = curBound;
+        level.cols = denseGridSize( image.cols, curBound, curStep );
+        level.rows = denseGridSize( image.rows, curBound, curStep );
+        level.firstCol = ncols;
+        level.ofs = total;
+        if( level.cols > 0 && level.rows > 0 )
         {
-            for( int y = curBound; y < image.rows - curBound; y += curStep )
-            {
-                keypoints.push_back( KeyPoint(static_cast<float>(x), static_cast<float>(y), curScale) );
-            }
+            levels.push_back( level );
+            ncols += level.cols;
+            total += (size_t)level.cols*level.rows;
         }
 
         curScale = static_cast<float>(curScale * featureScaleMul);
@@ -179,6 +239,11 @@ void DenseFeatureDetector::detectImpl( const Mat& image, vector<KeyPoint>& keypo
         if( varyImgBoundWithScale ) curBound = static_cast<int>( curBound * featureScaleMul + 0.5f );
     }
 
+    keypoints.resize( total );
+    if( total > first )
+        parallel_for_( Range(0, ncols), DenseFeatureDetectorInvoker(levels, &keypoints[0]),
+                       (double)(total - first)/(1 << 16) );
+
     KeyPointsFilter::runByPixelsMask( keypoints, mask );
 }
 
@@ -219,22 +284,19 @@ class GridAdaptedFeatureDetectorInvoker : public ParallelLoopBody
 private:
     int gridRows_, gridCols_;
     int maxPerCell_;
-    vector<KeyPoint>& keypoints_;
+    vector<vector<KeyPoint> >& cellKeypoints_;
     const Mat& image_;
     const Mat& mask_;
     const Ptr<FeatureDetector>& detector_;
-    Mutex* kptLock_;
 
     GridAdaptedFeatureDetectorInvoker& operator=(const GridAdaptedFeatureDetectorInvoker&); // to quiet MSVC
 
 public:
 
     GridAdaptedFeatureDetectorInvoker(const Ptr<FeatureDetector>& detector, const Mat& image, const Mat& mask,
-                                      vector<KeyPoint>& keypoints, int maxPerCell, int gridRows, int gridCols,
-                                      cv::Mutex* kptLock)
+                                      vector<vector<KeyPoint> >& cellKeypoints, int maxPerCell, int gridRows, int gridCols)
         : gridRows_(gridRows), gridCols_(gridCols), maxPerCell_(maxPerCell),
-          keypoints_(keypoints), image_(image), mask_(mask), detector_(detector),
-          kptLock_(kptLock)
+          cellKeypoints_(cellKeypoints), image_(image), mask_(mask), detector_(detector)
     {
     }
 
@@ -252,7 +314,7 @@ public:
             Mat sub_mask;
             if (!mask_.empty()) sub_mask = mask_(row_range, col_range);
 
-            vector<KeyPoint> sub_keypoints;
+            vector<KeyPoint>& sub_keypoints = cellKeypoints_[i];
             sub_keypoints.reserve(maxPerCell_);
 
             detector_->detect( sub_image, sub_keypoints, sub_mask );
@@ -265,9 +327,6 @@ public:
                 it->pt.x += col_range.start;
                 it->pt.y += row_range.start;
             }
-
-            cv::AutoLock join_keypoints(*kptLock_);
-            keypoints_.insert( keypoints_.end(), sub_keypoints.begin(), sub_keypoints.end() );
         }
     }
 };
@@ -283,9 +342,13 @@ void GridAdaptedFeatureDetector::detectImpl( const Mat& image, vector<KeyPoint>&
     keypoints.reserve(maxTotalKeypoints);
     int maxPerCell = maxTotalKeypoints / (gridRows * gridCols);
 
-    cv::Mutex kptLock;
+    // every cell has its own output, so the result does not depend on the order the cells are processed in
+    vector<vector<KeyPoint> > cellKeypoints(gridRows * gridCols);
     cv::parallel_for_(cv::Range(0, gridRows * gridCols),
-        GridAdaptedFeatureDetectorInvoker(detector, image, mask, keypoints, maxPerCell, gridRows, gridCols, &kptLock));
+        GridAdaptedFeatureDetectorInvoker(detector, image, mask, cellKeypoints, maxPerCell, gridRows, gridCols));
+
+    for( size_t i = 0; i < cellKeypoints.size(); i++ )
+        keypoints.insert( keypoints.end(), cellKeypoints[i].begin(), cellKeypoints[i].end() );
 }
 
 /*
@@ -300,10 +363,52 @@ bool PyramidAdaptedFeatureDetector::empty() const
     return detector.empty() || (FeatureDetector*)detector->empty();
 }
 
+namespace {
+class PyramidAdaptedFeatureDetectorInvoker : public ParallelLoopBody
+{
+public:
+    PyramidAdaptedFeatureDetectorInvoker( const Ptr<FeatureDetector>& _detector, const vector<Mat>& _pyr,
+                                          const vector<Mat>& _masks, vector<vector<KeyPoint> >& _levelKeypoints )
+        : detector(&_detector), pyr(&_pyr), masks(&_masks), levelKeypoints(&_levelKeypoints)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        for( int l = range.start; l < range.end; l++ )
+        {
+            vector<KeyPoint>& new_pts = (*levelKeypoints)[l];
+            (*detector)->detect( (*pyr)[l], new_pts, (*masks)[l] );
+
+            float multiplier = (float)(1 << l);
+            vector<KeyPoint>::iterator it = new_pts.begin(),
+                                       end = new_pts.end();
+            for( ; it != end; ++it)
+            {
+                it->pt.x *= multiplier;
+                it->pt.y *= multiplier;
+                it->size *= multiplier;
+                it->octave = l;
+            }
+        }
+    }
+
+private:
+    const Ptr<FeatureDetector>* detector;
+    const vector<Mat>* pyr;
+    const vector<Mat>* masks;
+    vector<vector<KeyPoint> >* levelKeypoints;
+};
+} // namespace
+
 void PyramidAdaptedFeatureDetector::detectImpl( const Mat& image, vector<KeyPoint>& keypoints, const Mat& mask ) const
 {
-    Mat src = image;
-    Mat src_mask = mask;
+    if( maxLevel < 0 )
+        return;
+
+    vector<Mat> pyr(maxLevel + 1), masks(maxLevel + 1);
+    pyr[0] = image;
+    masks[0] = mask;
 
     Mat dilated_mask;
     if( !mask.empty() )
@@ -314,33 +419,21 @@ void PyramidAdaptedFeatureDetector::detectImpl( const Mat& image, vector<KeyPoin
         dilated_mask = mask255;
     }
 
-    for( int l = 0, multiplier = 1; l <= maxLevel; ++l, multiplier *= 2 )
+    // Downsample
+    for( int l = 1; l <= maxLevel; ++l )
     {
-        // Detect on current level of the pyramid
-        vector<KeyPoint> new_pts;
-        detector->detect( src, new_pts, src_mask );
-        vector<KeyPoint>::iterator it = new_pts.begin(),
-                                   end = new_pts.end();
-        for( ; it != end; ++it)
-        {
-            it->pt.x *= multiplier;
-            it->pt.y *= multiplier;
-            it->size *= multiplier;
-            it->octave = l;
-        }
-        keypoints.insert( keypoints.end(), new_pts.begin(), new_pts.end() );
+        pyrDown( pyr[l-1], pyr[l] );
+        if( !mask.empty() )
+            resize( dilated_mask, masks[l], pyr[l].size(), 0, 0, CV_INTER_AREA );
+    }
 
-        // Downsample
-        if( l < maxLevel )
-        {
-            Mat dst;
-            pyrDown( src, dst );
-            src = dst;
+    // Detect on all the levels of the pyramid; the detector is shared by the levels
+    // the same way GridAdaptedFeatureDetector shares it by the cells
+    vector<vector<KeyPoint> > levelKeypoints(maxLevel + 1);
+    parallel_for_( Range(0, maxLevel + 1), PyramidAdaptedFeatureDetectorInvoker(detector, pyr, masks, levelKeypoints) );
 
-            if( !mask.empty() )
-                resize( dilated_mask, src_mask, src.size(), 0, 0, CV_INTER_AREA );
-        }
-    }
+    for( int l = 0; l <= maxLevel; ++l )
+        keypoints.insert( keypoints.end(), levelKeypoints[l].begin(), levelKeypoints[l].end() );
 
     if( !mask.empty() )
         KeyPointsFilter::runByPixelsMask( keypoints, mask );
@@ -194,6 +194,9 @@ CV_INIT_ALGORITHM(BFMatcher, "DescriptorMatcher.BFMatcher",
 
 CV_INIT_ALGORITHM(FlannBasedMatcher, "DescriptorMatcher.FlannBasedMatcher",)
 
+CV_INIT_ALGORITHM(MIHMatcher, "DescriptorMatcher.MIHMatcher",
+                  obj.info()->addParam(obj, "substringBits", obj.substringBits))
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool cv::initModule_features2d(void)
@@ -213,6 +216,7 @@ bool cv::initModule_features2d(void)
     all &= !GridAdaptedFeatureDetector_info_auto.name().empty();
     all &= !BFMatcher_info_auto.name().empty();
     all &= !FlannBasedMatcher_info_auto.name().empty();
+    all &= !MIHMatcher_info_auto.name().empty();
 
     return all;
 }
@@ -212,6 +212,79 @@ void KeyPointsFilter::retainBest(vector<KeyPoint>& keypoints, int n_points)
     }
 }
 
+// the filters below keep the order of the surviving keypoints (like std::remove_if);
+// long vectors are compacted in parallel: every block of keypoints is compacted in place,
+// and then the blocks are shifted to their final positions
+static const int KEYPOINTS_FILTER_BLOCK_SIZE = 1 << 14;
+
+template<typename Predicate> static int compactKeyPoints( KeyPoint* kp, int n, const Predicate& pred )
+{
+    // the predicate sees every keypoint before it can be overwritten
+    int j = 0;
+    for( int i = 0; i < n; i++ )
+    {
+        if( !pred(kp[i]) )
+        {
+            if( i != j )
+                kp[j] = kp[i];
+            j++;
+        }
+    }
+    return j;
+}
+
+template<typename Predicate> class KeyPointsCompactInvoker : public ParallelLoopBody
+{
+public:
+    KeyPointsCompactInvoker( vector<KeyPoint>& _keypoints, const Predicate& _pred, int* _counts )
+        : keypoints(&_keypoints), pred(_pred), counts(_counts)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int n = (int)keypoints->size();
+        for( int b = range.start; b < range.end; b++ )
+        {
+            int i = b*KEYPOINTS_FILTER_BLOCK_SIZE;
+            counts[b] = compactKeyPoints(&(*keypoints)[i], std::min(KEYPOINTS_FILTER_BLOCK_SIZE, n - i), pred);
+        }
+    }
+
+private:
+    vector<KeyPoint>* keypoints;
+    const Predicate& pred;
+    int* counts;
+
+    KeyPointsCompactInvoker& operator=(const KeyPointsCompactInvoker&); // to quiet MSVC
+};
+
+// removes the keypoints for which pred is true
+template<typename Predicate> static void removeKeyPointsIf( vector<KeyPoint>& keypoints, const Predicate& pred )
+{
+    int n = (int)keypoints.size();
+    if( n <= KEYPOINTS_FILTER_BLOCK_SIZE || getNumThreads() <= 1 )
+    {
+        if( n > 0 )
+            keypoints.resize(compactKeyPoints(&keypoints[0], n, pred));
+        return;
+    }
+
+    int nblocks = (n + KEYPOINTS_FILTER_BLOCK_SIZE - 1)/KEYPOINTS_FILTER_BLOCK_SIZE;
+    vector<int> counts(nblocks);
+    parallel_for_(Range(0, nblocks), KeyPointsCompactInvoker<Predicate>(keypoints, pred, &counts[0]));
+
+    int total = counts[0];
+    for( int b = 1; b < nblocks; b++ )
+    {
+        vector<KeyPoint>::iterator first = keypoints.begin() + b*KEYPOINTS_FILTER_BLOCK_SIZE;
+        if( total != b*KEYPOINTS_FILTER_BLOCK_SIZE )
+            std::copy(first, first + counts[b], keypoints.begin() + total);
+        total += counts[b];
+    }
+    keypoints.resize(total);
+}
+
 struct RoiPredicate
 {
     RoiPredicate( const Rect& _r ) : r(_r)
@@ -232,10 +305,8 @@ void KeyPointsFilter::runByImageBorder( vector<KeyPoint>& keypoints, Size imageS
         if (imageSize.height <= borderSize * 2 || imageSize.width <= borderSize * 2)
             keypoints.clear();
         else
-            keypoints.erase( std::remove_if(keypoints.begin(), keypoints.end(),
-                                       RoiPredicate(Rect(Point(borderSize, borderSize),
-                                                         Point(imageSize.width - borderSize, imageSize.height - borderSize)))),
-                             keypoints.end() );
+            removeKeyPointsIf( keypoints, RoiPredicate(Rect(Point(borderSize, borderSize),
+                                                            Point(imageSize.width - borderSize, imageSize.height - borderSize))) );
     }
 }
 
@@ -259,8 +330,7 @@ void KeyPointsFilter::runByKeypointSize( vector<KeyPoint>& keypoints, float minS
     CV_Assert( maxSize >= 0);
     CV_Assert( minSize <= maxSize );
 
-    keypoints.erase( std::remove_if(keypoints.begin(), keypoints.end(), SizePredicate(minSize, maxSize)),
-                     keypoints.end() );
+    removeKeyPointsIf( keypoints, SizePredicate(minSize, maxSize) );
 }
 
 class MaskPredicate
@@ -282,7 +352,7 @@ void KeyPointsFilter::runByPixelsMask( vector<KeyPoint>& keypoints, const Mat& m
     if( mask.empty() )
         return;
 
-    keypoints.erase(std::remove_if(keypoints.begin(), keypoints.end(), MaskPredicate(mask)), keypoints.end());
+    removeKeyPointsIf( keypoints, MaskPredicate(mask) );
 }
 
 struct KeyPoint_LessThan
@@ -312,6 +382,37 @@ struct KeyPoint_LessThan
     const vector<KeyPoint>* kp;
 };
 
+// sorts blocks of keypoint indices of the given width (merge == false),
+// or merges pairs of adjacent sorted blocks (merge == true)
+class KeyPointIndexSortInvoker : public ParallelLoopBody
+{
+public:
+    KeyPointIndexSortInvoker( const vector<KeyPoint>& _keypoints, vector<int>& _kpidx, int _width, bool _merge )
+        : keypoints(&_keypoints), kpidx(&_kpidx), width(_width), merge(_merge)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        vector<int>::iterator begin = kpidx->begin();
+        int n = (int)kpidx->size();
+        for( int b = range.start; b < range.end; b++ )
+        {
+            if( !merge )
+                std::sort(begin + b*width, begin + std::min((b + 1)*width, n), KeyPoint_LessThan(*keypoints));
+            else
+                std::inplace_merge(begin + 2*b*width, begin + (2*b + 1)*width, begin + std::min((2*b + 2)*width, n),
+                                   KeyPoint_LessThan(*keypoints));
+        }
+    }
+
+private:
+    const vector<KeyPoint>* keypoints;
+    vector<int>* kpidx;
+    int width;
+    bool merge;
+};
+
 void KeyPointsFilter::removeDuplicated( vector<KeyPoint>& keypoints )
 {
     int i, j, n = (int)keypoints.size();
@@ -320,7 +421,13 @@ void KeyPointsFilter::removeDuplicated( vector<KeyPoint>& keypoints )
 
     for( i = 0; i < n; i++ )
         kpidx[i] = i;
-    std::sort(kpidx.begin(), kpidx.end(), KeyPoint_LessThan(keypoints));
+    // KeyPoint_LessThan is a total order (the ties are broken by the index),
+    // so sorting the blocks in parallel and merging them gives the same permutation as a single sort
+    int width = KEYPOINTS_FILTER_BLOCK_SIZE;
+    parallel_for_(Range(0, (n + width - 1)/width), KeyPointIndexSortInvoker(keypoints, kpidx, width, false));
+    for( ; width < n; width *= 2 )
+        parallel_for_(Range(0, (n + width - 1)/(2*width)),
+                      KeyPointIndexSortInvoker(keypoints, kpidx, width, true));
     for( i = 1, j = 0; i < n; i++ )
     {
         KeyPoint& kp1 = keypoints[kpidx[i]];
@@ -344,4 +451,130 @@ void KeyPointsFilter::removeDuplicated( vector<KeyPoint>& keypoints )
     keypoints.resize(j);
 }
 
+struct KeyPointCandidate
+{
+    float x, y, response;
+    int idx;
+};
+
+// marks the keypoints that have no stronger neighbour closer than the radius;
+// the keypoints are bucketed into a grid with the cells not smaller than the radius,
+// so only the 3x3 neighbouring cells need to be visited. The candidates are stored cell by cell,
+// hence the neighbouring cells of a grid row make a single contiguous segment
+class KeyPointNonMaximaInvoker : public ParallelLoopBody
+{
+public:
+    KeyPointNonMaximaInvoker( const vector<KeyPointCandidate>& _candidates, const vector<int>& _cellOfs,
+                              int _gridWidth, int _gridHeight, float _radius, uchar* _keep )
+        : candidates(&_candidates), cellOfs(&_cellOfs),
+          gridWidth(_gridWidth), gridHeight(_gridHeight), radius2(_radius*_radius), keep(_keep)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        const KeyPointCandidate* cand = &(*candidates)[0];
+        const int* ofs = &(*cellOfs)[0];
+        for( int cy = range.start; cy < range.end; cy++ )
+            for( int cx = 0; cx < gridWidth; cx++ )
+            {
+                int c = cy*gridWidth + cx;
+                int x0 = std::max(cx - 1, 0), x1 = std::min(cx + 1, gridWidth - 1);
+                for( int k = ofs[c]; k < ofs[c + 1]; k++ )
+                {
+                    const KeyPointCandidate& kpt = cand[k];
+                    bool isMax = true;
+                    for( int y = std::max(cy - 1, 0); isMax && y <= std::min(cy + 1, gridHeight - 1); y++ )
+                    {
+                        for( int j = ofs[y*gridWidth + x0], jend = ofs[y*gridWidth + x1 + 1]; j < jend; j++ )
+                        {
+                            const KeyPointCandidate& other = cand[j];
+                            // equal responses are resolved in favour of the earlier keypoint
+                            if( other.response < kpt.response ||
+                                (other.response == kpt.response && other.idx >= kpt.idx) )
+                                continue;
+                            float dx = other.x - kpt.x, dy = other.y - kpt.y;
+                            if( dx*dx + dy*dy < radius2 )
+                            {
+                                isMax = false;
+                                break;
+                            }
+                        }
+                    }
+                    keep[kpt.idx] = (uchar)isMax;
+                }
+            }
+    }
+
+private:
+    const vector<KeyPointCandidate>* candidates;
+    const vector<int>* cellOfs;
+    int gridWidth, gridHeight;
+    float radius2;
+    uchar* keep;
+};
+
+struct KeyPointMaskPredicate
+{
+    KeyPointMaskPredicate( const KeyPoint* _base, const uchar* _keep ) : base(_base), keep(_keep) {}
+    bool operator() (const KeyPoint& key_pt) const
+    {
+        return !keep[&key_pt - base];
+    }
+
+    const KeyPoint* base;
+    const uchar* keep;
+};
+
+void KeyPointsFilter::removeNonMaxima( vector<KeyPoint>& keypoints, float radius )
+{
+    int i, n = (int)keypoints.size();
+    if( n < 2 || !(radius > 0) )
+        return;
+
+    float xmin = FLT_MAX, ymin = FLT_MAX, xmax = -FLT_MAX, ymax = -FLT_MAX;
+    for( i = 0; i < n; i++ )
+    {
+        const Point2f& pt = keypoints[i].pt;
+        xmin = std::min(xmin, pt.x); xmax = std::max(xmax, pt.x);
+        ymin = std::min(ymin, pt.y); ymax = std::max(ymax, pt.y);
+    }
+
+    // a small radius on a sparse set of keypoints would produce a huge almost empty grid,
+    // so the cells are enlarged to hold about one keypoint each on average
+    double w = (double)xmax - xmin, h = (double)ymax - ymin;
+    double cellSize = std::max(std::max((double)radius, std::sqrt(w*h/n)), std::max(w, h)/n);
+    int gridWidth = cvFloor((xmax - xmin)/cellSize) + 1;
+    int gridHeight = cvFloor((ymax - ymin)/cellSize) + 1;
+    double scale = 1./cellSize;
+
+    vector<int> kpCell(n), cellOfs(gridWidth*gridHeight + 1, 0);
+    for( i = 0; i < n; i++ )
+    {
+        int cx = std::min(cvFloor((keypoints[i].pt.x - xmin)*scale), gridWidth - 1);
+        int cy = std::min(cvFloor((keypoints[i].pt.y - ymin)*scale), gridHeight - 1);
+        kpCell[i] = cy*gridWidth + cx;
+        cellOfs[kpCell[i] + 1]++;
+    }
+    for( i = 0; i < gridWidth*gridHeight; i++ )
+        cellOfs[i + 1] += cellOfs[i];
+
+    vector<KeyPointCandidate> candidates(n);
+    {
+        vector<int> cellPos(cellOfs.begin(), cellOfs.end() - 1);
+        for( i = 0; i < n; i++ )
+        {
+            const KeyPoint& kp = keypoints[i];
+            KeyPointCandidate& c = candidates[cellPos[kpCell[i]]++];
+            c.x = kp.pt.x; c.y = kp.pt.y; c.response = kp.response; c.idx = i;
+        }
+    }
+
+    vector<uchar> keep(n);
+    parallel_for_(Range(0, gridHeight), KeyPointNonMaximaInvoker(candidates, cellOfs, gridWidth, gridHeight,
+                                                                 radius, &keep[0]),
+                  n/(double)KEYPOINTS_FILTER_BLOCK_SIZE);
+    removeKeyPointsIf(keypoints, KeyPointMaskPredicate(&keypoints[0], &keep[0]));
+}
+
 }
@@ -337,117 +337,526 @@ Ptr<DescriptorMatcher> BFMatcher::clone( bool emptyTrainData ) const
 }
 
 
-void BFMatcher::knnMatchImpl( const Mat& queryDescriptors, vector<vector<DMatch> >& matches, int knn,
-                              const vector<Mat>& masks, bool compactResult )
+static const int BF_IMGIDX_SHIFT = 18;
+static const int BF_IMGIDX_ONE = (1 << BF_IMGIDX_SHIFT);
+
+static inline int bfDistType( int normType, int type )
 {
-    const int IMGIDX_SHIFT = 18;
-    const int IMGIDX_ONE = (1 << IMGIDX_SHIFT);
+    return normType == NORM_HAMMING || normType == NORM_HAMMING2 ||
+        (normType == NORM_L1 && type == CV_8U) ? CV_32S : CV_32F;
+}
 
-    if( queryDescriptors.empty() || trainDescCollection.empty() )
+// merges the sorted k-best lists of a train block (bdist, bidx) into the running
+// k-best lists of all the queries (dist, nidx); on ties the earlier train descriptor wins
+template<typename _Tp> static void
+mergeNearest( const Mat& bdist, const Mat& bidx, int offset, Mat& dist, Mat& nidx )
+{
+    int i, K = dist.cols, bK = bdist.cols;
+    AutoBuffer<_Tp> _tdist(K);
+    AutoBuffer<int> _tidx(K);
+    _Tp* tdist = _tdist;
+    int* tidx = _tidx;
+
+    for( i = 0; i < dist.rows; i++ )
     {
-        matches.clear();
-        return;
+        const _Tp* bd = bdist.ptr<_Tp>(i);
+        const int* bi = bidx.ptr<int>(i);
+        _Tp* d = dist.ptr<_Tp>(i);
+        int* ni = nidx.ptr<int>(i);
+        int j = 0, k = 0, l = 0;
+
+        if( bK == 0 || bi[0] < 0 || (ni[K-1] >= 0 && d[K-1] <= bd[0]) )
+            continue;
+
+        for( ; l < K; l++ )
+        {
+            bool takeOld = j < K && ni[j] >= 0;
+            bool takeNew = k < bK && bi[k] >= 0;
+            if( takeOld && takeNew )
+                takeOld = d[j] <= bd[k];
+            else if( !takeOld && !takeNew )
+                break;
+            if( takeOld )
+                tdist[l] = d[j], tidx[l] = ni[j], j++;
+            else
+                tdist[l] = bd[k], tidx[l] = bi[k] + offset, k++;
+        }
+        for( j = 0; j < l; j++ )
+            d[j] = tdist[j], ni[j] = tidx[j];
     }
-    CV_Assert( queryDescriptors.type() == trainDescCollection[0].type() );
+}
 
-    matches.reserve(queryDescriptors.rows);
+// Distances from the query descriptor a to the train descriptors [j0, j1),
+// computed exactly as batchDistance() does; masked out pairs get FLT_MAX
+static void bfDistBlock( int normType, const Mat& train, const uchar* a, int j0, int j1,
+                         const uchar* mask, float* dist )
+{
+    int j, n = j1 - j0, len = train.cols;
+    size_t step = train.step;
+    const uchar* b = train.ptr(j0);
 
-    Mat dist, nidx;
+    if( train.depth() == CV_32F )
+    {
+        const float* fa = (const float*)a;
+        if( normType == NORM_L1 )
+            for( j = 0; j < n; j++ )
+                dist[j] = normL1<float, float>(fa, (const float*)(b + step*j), len);
+        else if( normType == NORM_L2SQR )
+            for( j = 0; j < n; j++ )
+                dist[j] = normL2Sqr<float, float>(fa, (const float*)(b + step*j), len);
+        else
+            for( j = 0; j < n; j++ )
+                dist[j] = std::sqrt(normL2Sqr<float, float>(fa, (const float*)(b + step*j), len));
+    }
+    else
+    {
+        if( normType == NORM_HAMMING )
+            for( j = 0; j < n; j++ )
+                dist[j] = (float)normHamming(a, b + step*j, len);
+        else if( normType == NORM_HAMMING2 )
+            for( j = 0; j < n; j++ )
+                dist[j] = (float)normHamming(a, b + step*j, len, 2);
+        else if( normType == NORM_L1 )
+            for( j = 0; j < n; j++ )
+                dist[j] = (float)normL1<uchar, int>(a, b + step*j, len);
+        else if( normType == NORM_L2SQR )
+            for( j = 0; j < n; j++ )
+                dist[j] = normL2Sqr<uchar, float>(a, b + step*j, len);
+        else
+            for( j = 0; j < n; j++ )
+                dist[j] = std::sqrt(normL2Sqr<uchar, float>(a, b + step*j, len));
+    }
 
-    int iIdx, imgCount = (int)trainDescCollection.size(), update = 0;
-    int dtype = normType == NORM_HAMMING || normType == NORM_HAMMING2 ||
-        (normType == NORM_L1 && queryDescriptors.type() == CV_8U) ? CV_32S : CV_32F;
+    if( mask )
+        for( j = 0; j < n; j++ )
+            if( !mask[j] )
+                dist[j] = FLT_MAX;
+}
 
-    CV_Assert( (int64)imgCount*IMGIDX_ONE < INT_MAX );
+static int bfTrainBlockRows( const Mat& query )
+{
+    const int BLOCK_BYTES = 1 << 18;
+    const int MIN_BLOCK_ROWS = 64;
+    int rowBytes = std::max((int)(query.cols*query.elemSize()), 1);
+    return std::max(BLOCK_BYTES/rowBytes, MIN_BLOCK_ROWS);
+}
 
-    for( iIdx = 0; iIdx < imgCount; iIdx++ )
+// The query set is split into stripes processed in parallel. Every stripe scans the train
+// collection block by block, and each block is matched against all the queries of the stripe
+// while it is still in cache. Every query belongs to exactly one stripe, so the stripes fill
+// their own part of the output without any synchronization.
+class BFRadiusMatchInvoker : public ParallelLoopBody
+{
+public:
+    BFRadiusMatchInvoker( const Mat& _query, const vector<Mat>& _trainCollection,
+                          const vector<Mat>& _masks, int _normType, float _maxDistance,
+                          int _nstripes, vector<vector<DMatch> >& _matches )
+        : query(&_query), trainCollection(&_trainCollection), masks(&_masks),
+          normType(_normType), maxDistance(_maxDistance), nstripes(_nstripes), matches(&_matches)
     {
-        CV_Assert( trainDescCollection[iIdx].rows < IMGIDX_ONE );
-        batchDistance(queryDescriptors, trainDescCollection[iIdx], dist, dtype, nidx,
-                      normType, knn, masks.empty() ? Mat() : masks[iIdx], update, crossCheck);
-        update += IMGIDX_ONE;
     }
 
-    if( dtype == CV_32S )
+    void operator()( const Range& range ) const
     {
-        Mat temp;
-        dist.convertTo(temp, CV_32F);
-        dist = temp;
+        int blockRows = bfTrainBlockRows(*query);
+        AutoBuffer<float> _buf(blockRows);
+        float* buf = _buf;
+
+        for( int s = range.start; s < range.end; s++ )
+        {
+            int q0 = (int)((int64)query->rows*s/nstripes);
+            int q1 = (int)((int64)query->rows*(s + 1)/nstripes);
+
+            for( int iIdx = 0; iIdx < (int)trainCollection->size(); iIdx++ )
+            {
+                const Mat& train = (*trainCollection)[iIdx];
+                const Mat* mask = masks->empty() || (*masks)[iIdx].empty() ? 0 : &(*masks)[iIdx];
+
+                for( int j0 = 0; j0 < train.rows; j0 += blockRows )
+                {
+                    int j1 = std::min(j0 + blockRows, train.rows);
+                    for( int qIdx = q0; qIdx < q1; qIdx++ )
+                    {
+                        bfDistBlock(normType, train, query->ptr(qIdx), j0, j1,
+                                    mask ? mask->ptr(qIdx) + j0 : 0, buf);
+                        vector<DMatch>& mq = (*matches)[qIdx];
+                        for( int j = 0; j < j1 - j0; j++ )
+                            if( buf[j] <= maxDistance )
+                                mq.push_back(DMatch(qIdx, j0 + j, iIdx, buf[j]));
+                    }
+                }
+            }
+
+            for( int qIdx = q0; qIdx < q1; qIdx++ )
+                std::sort((*matches)[qIdx].begin(), (*matches)[qIdx].end());
+        }
     }
 
-    for( int qIdx = 0; qIdx < queryDescriptors.rows; qIdx++ )
+private:
+    const Mat* query;
+    const vector<Mat>* trainCollection;
+    const vector<Mat>* masks;
+    int normType;
+    float maxDistance;
+    int nstripes;
+    vector<vector<DMatch> >* matches;
+};
+
+// Scans a block of the query x train distance matrix for the cross check. Every stripe of
+// queries updates the nearest train descriptor of its queries (rowDist, rowIdx) and the
+// nearest of its queries for every train descriptor of the block, which is kept in the
+// stripe's own buffers (colDist, colIdx) + s*dist.cols and reduced afterwards.
+template<typename _Tp> class BFCrossCheckInvoker : public ParallelLoopBody
+{
+public:
+    BFCrossCheckInvoker( const Mat& _dist, int _idxOfs, int _nstripes, _Tp* _rowDist, int* _rowIdx,
+                         _Tp* _colDist, int* _colIdx )
+        : dist(&_dist), idxOfs(_idxOfs), nstripes(_nstripes), rowDist(_rowDist), rowIdx(_rowIdx),
+          colDist(_colDist), colIdx(_colIdx)
     {
-        const float* distptr = dist.ptr<float>(qIdx);
-        const int* nidxptr = nidx.ptr<int>(qIdx);
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int n = dist->cols;
+        for( int s = range.start; s < range.end; s++ )
+        {
+            int q0 = (int)((int64)dist->rows*s/nstripes);
+            int q1 = (int)((int64)dist->rows*(s + 1)/nstripes);
+            _Tp* cd = colDist + (size_t)s*n;
+            int* ci = colIdx + (size_t)s*n;
+
+            for( int j = 0; j < n; j++ )
+                cd[j] = std::numeric_limits<_Tp>::max(), ci[j] = -1;
 
-        matches.push_back( vector<DMatch>() );
-        vector<DMatch>& mq = matches.back();
-        mq.reserve(knn);
+            for( int qIdx = q0; qIdx < q1; qIdx++ )
+            {
+                const _Tp* d = dist->ptr<_Tp>(qIdx);
+                _Tp rd = rowDist[qIdx];
+                int ri = rowIdx[qIdx];
+                for( int j = 0; j < n; j++ )
+                {
+                    if( d[j] < rd )
+                        rd = d[j], ri = idxOfs + j;
+                    if( d[j] < cd[j] )
+                        cd[j] = d[j], ci[j] = qIdx;
+                }
+                rowDist[qIdx] = rd;
+                rowIdx[qIdx] = ri;
+            }
+        }
+    }
+
+private:
+    const Mat* dist;
+    int idxOfs;
+    int nstripes;
+    _Tp* rowDist;
+    int* rowIdx;
+    _Tp* colDist;
+    int* colIdx;
+};
+
+// Finds the pairs (query, train) such that each one is the nearest neighbour of the other
+// in the whole train collection, in one pass over the blocks of the distance matrix.
+// Queries without such a pair get nidx = -1. On ties the smaller index wins.
+template<typename _Tp> static void
+bfCrossCheckSearch_( const Mat& query, const vector<Mat>& trainCollection, const vector<Mat>& masks,
+                     int normType, int dtype, Mat& dist, Mat& nidx )
+{
+    const int BLOCK_BYTES = 1 << 20;
+    const int MIN_BLOCK_ROWS = 64;
+
+    int iIdx, imgCount = (int)trainCollection.size(), trainCount = 0;
+    int blockRows = std::max(BLOCK_BYTES/(std::max(query.rows, 1)*(int)sizeof(_Tp)), MIN_BLOCK_ROWS);
+    int nstripes = std::max(std::min(getNumThreads(), query.rows/16), 1);
+
+    AutoBuffer<int> _trainOfs(imgCount + 1);
+    int* trainOfs = _trainOfs;
+    for( iIdx = 0; iIdx < imgCount; iIdx++ )
+    {
+        CV_Assert( trainCollection[iIdx].rows < BF_IMGIDX_ONE );
+        trainOfs[iIdx] = trainCount;
+        trainCount += trainCollection[iIdx].rows;
+    }
+    trainOfs[imgCount] = trainCount;
+
+    AutoBuffer<_Tp> _rowDist(query.rows), _colDist((size_t)nstripes*blockRows);
+    AutoBuffer<int> _colIdx((size_t)nstripes*blockRows), _bestQuery(trainCount + 1);
+    _Tp *rowDist = _rowDist, *colDist = _colDist;
+    int *colIdx = _colIdx, *bestQuery = _bestQuery;
+
+    nidx.create(query.rows, 1, CV_32S);
+    int* rowIdx = nidx.ptr<int>();
+    for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+        rowDist[qIdx] = std::numeric_limits<_Tp>::max(), rowIdx[qIdx] = -1;
+
+    Mat bdist;
+    for( iIdx = 0; iIdx < imgCount; iIdx++ )
+    {
+        const Mat& train = trainCollection[iIdx];
+        Mat mask = masks.empty() ? Mat() : masks[iIdx];
 
-        for( int k = 0; k < nidx.cols; k++ )
+        for( int j0 = 0; j0 < train.rows; j0 += blockRows )
         {
-            if( nidxptr[k] < 0 )
-                break;
-            mq.push_back( DMatch(qIdx, nidxptr[k] & (IMGIDX_ONE - 1),
-                          nidxptr[k] >> IMGIDX_SHIFT, distptr[k]) );
+            int j1 = std::min(j0 + blockRows, train.rows), n = j1 - j0;
+            batchDistance(query, train.rowRange(j0, j1), bdist, dtype, noArray(), normType, 0,
+                          mask.empty() ? Mat() : mask.colRange(j0, j1), 0, false);
+            parallel_for_(Range(0, nstripes),
+                          BFCrossCheckInvoker<_Tp>(bdist, (iIdx << BF_IMGIDX_SHIFT) + j0, nstripes,
+                                                   rowDist, rowIdx, colDist, colIdx));
+
+            // the stripes go in the query order, so on ties the first query wins as within a stripe
+            int* bq = bestQuery + trainOfs[iIdx] + j0;
+            for( int j = 0; j < n; j++ )
+            {
+                _Tp d = colDist[j];
+                int q = colIdx[j];
+                for( int s = 1; s < nstripes; s++ )
+                    if( colDist[s*n + j] < d )
+                        d = colDist[s*n + j], q = colIdx[s*n + j];
+                bq[j] = q;
+            }
         }
+    }
 
-        if( mq.empty() && compactResult )
-            matches.pop_back();
+    dist.create(query.rows, 1, CV_32F);
+    float* fdist = dist.ptr<float>();
+    for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+    {
+        int idx = rowIdx[qIdx];
+        if( idx >= 0 && bestQuery[trainOfs[idx >> BF_IMGIDX_SHIFT] + (idx & (BF_IMGIDX_ONE - 1))] == qIdx )
+            fdist[qIdx] = (float)rowDist[qIdx];
+        else
+            fdist[qIdx] = FLT_MAX, rowIdx[qIdx] = -1;
     }
 }
 
-
-void BFMatcher::radiusMatchImpl( const Mat& queryDescriptors, vector<vector<DMatch> >& matches,
-                                 float maxDistance, const vector<Mat>& masks, bool compactResult )
+static void bfCrossCheckSearch( const Mat& query, const vector<Mat>& trainCollection,
+                                const vector<Mat>& masks, int normType, Mat& dist, Mat& nidx )
 {
-    if( queryDescriptors.empty() || trainDescCollection.empty() )
+    int dtype = bfDistType(normType, query.type());
+    if( dtype == CV_32S )
+        bfCrossCheckSearch_<int>(query, trainCollection, masks, normType, dtype, dist, nidx);
+    else
+        bfCrossCheckSearch_<float>(query, trainCollection, masks, normType, dtype, dist, nidx);
+}
+
+// Finds the knn nearest train descriptors of every query one. The train collection is
+// scanned in blocks small enough to stay in cache, and the per-query k-best lists of the
+// blocks are merged on the fly, so neither the full distance matrix nor a distance row
+// of the whole train set is ever materialized. The output has the batchDistance layout:
+// dist is CV_32S or CV_32F, nidx holds (imgIdx << BF_IMGIDX_SHIFT) + trainIdx or -1.
+// In the cross check mode (knn == 1) only the mutual nearest neighbours are kept.
+static void bfKnnSearch( const Mat& query, const vector<Mat>& trainCollection,
+                         const vector<Mat>& masks, int normType, bool crossCheck,
+                         int knn, Mat& dist, Mat& nidx )
+{
+    const int BLOCK_BYTES = 1 << 22;
+    const int MIN_BLOCK_ROWS = 256;
+
+    // batchDistance() has a blocked dot product kernel for the 32f L2 k-NN search; running it
+    // in both directions is still faster than one pass of the exact query x train distances
+    bool knnCrossCheck = query.type() == CV_32F && (normType == NORM_L2 || normType == NORM_L2SQR) &&
+        checkHardwareSupport(CV_CPU_SSE2);
+    if( crossCheck )
     {
-        matches.clear();
-        return;
+        CV_Assert( knn == 1 );
+        if( !knnCrossCheck )
+        {
+            bfCrossCheckSearch(query, trainCollection, masks, normType, dist, nidx);
+            return;
+        }
     }
-    CV_Assert( queryDescriptors.type() == trainDescCollection[0].type() );
 
-    matches.resize(queryDescriptors.rows);
-    Mat dist, distf;
+    int iIdx, imgCount = (int)trainCollection.size();
+    int dtype = bfDistType(normType, query.type());
+    int rowBytes = std::max((int)(query.cols*query.elemSize()), 1);
+    int blockRows = std::max(BLOCK_BYTES/rowBytes, MIN_BLOCK_ROWS);
+    Mat bdist, bidx;
 
-    int iIdx, imgCount = (int)trainDescCollection.size();
-    int dtype = normType == NORM_HAMMING ||
-        (normType == NORM_L1 && queryDescriptors.type() == CV_8U) ? CV_32S : CV_32F;
+    CV_Assert( (int64)imgCount*BF_IMGIDX_ONE < INT_MAX );
+
+    dist.create(query.rows, knn, dtype);
+    nidx.create(query.rows, knn, CV_32S);
+    dist = Scalar::all(dtype == CV_32S ? (double)INT_MAX : (double)FLT_MAX);
+    nidx = Scalar::all(-1);
 
     for( iIdx = 0; iIdx < imgCount; iIdx++ )
     {
-        batchDistance(queryDescriptors, trainDescCollection[iIdx], dist, dtype, noArray(),
-                      normType, 0, masks.empty() ? Mat() : masks[iIdx], 0, false);
-        if( dtype == CV_32S )
-            dist.convertTo(distf, CV_32F);
-        else
-            distf = dist;
+        const Mat& train = trainCollection[iIdx];
+        Mat mask = masks.empty() ? Mat() : masks[iIdx];
+        CV_Assert( train.rows < BF_IMGIDX_ONE );
 
-        for( int qIdx = 0; qIdx < queryDescriptors.rows; qIdx++ )
+        for( int j0 = 0; j0 < train.rows; j0 += blockRows )
         {
-            const float* distptr = distf.ptr<float>(qIdx);
+            int j1 = std::min(j0 + blockRows, train.rows);
+            batchDistance(query, train.rowRange(j0, j1), bdist, dtype, bidx, normType, knn,
+                          mask.empty() ? Mat() : mask.colRange(j0, j1), 0, false);
+            if( dtype == CV_32S )
+                mergeNearest<int>(bdist, bidx, (iIdx << BF_IMGIDX_SHIFT) + j0, dist, nidx);
+            else
+                mergeNearest<float>(bdist, bidx, (iIdx << BF_IMGIDX_SHIFT) + j0, dist, nidx);
+        }
+    }
 
-            vector<DMatch>& mq = matches[qIdx];
-            for( int k = 0; k < distf.cols; k++ )
+    if( crossCheck )
+    {
+        // keep the pairs where the query is also the nearest one to the train descriptor
+        vector<Mat> tidx(imgCount);
+        for( iIdx = 0; iIdx < imgCount; iIdx++ )
+        {
+            const Mat& train = trainCollection[iIdx];
+            Mat mask = masks.empty() || masks[iIdx].empty() ? Mat() : Mat(masks[iIdx].t());
+            if( !train.empty() )
+                batchDistance(train, query, bdist, dtype, tidx[iIdx], normType, 1, mask, 0, false);
+        }
+        for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+        {
+            int idx = nidx.at<int>(qIdx);
+            if( idx >= 0 && tidx[idx >> BF_IMGIDX_SHIFT].at<int>(idx & (BF_IMGIDX_ONE - 1)) != qIdx )
             {
-                if( distptr[k] <= maxDistance )
-                    mq.push_back( DMatch(qIdx, k, iIdx, distptr[k]) );
+                dist.at<float>(qIdx) = FLT_MAX;
+                nidx.at<int>(qIdx) = -1;
             }
         }
     }
+}
 
+// Writes the knn nearest neighbours of every query into matches[qIdx*knn + k].
+// With maxRatio < 1 a query is rejected (all its slots are left as DMatch())
+// unless its best distance is less than maxRatio times the second best one;
+// a query with less than two neighbours is rejected as well.
+static void bfFlattenMatches( const Mat& dist, const Mat& nidx, int knn, float maxRatio,
+                              DMatch* matches )
+{
+    bool isInt = dist.type() == CV_32S;
+
+    for( int qIdx = 0; qIdx < dist.rows; qIdx++ )
+    {
+        const int* idistptr = dist.ptr<int>(qIdx);
+        const float* fdistptr = dist.ptr<float>(qIdx);
+        const int* nidxptr = nidx.ptr<int>(qIdx);
+        DMatch* mq = matches + (size_t)qIdx*knn;
+        int k = 0;
+
+        if( maxRatio < 1.f && knn > 1 )
+        {
+            float d0 = isInt ? (float)idistptr[0] : fdistptr[0];
+            float d1 = isInt ? (float)idistptr[1] : fdistptr[1];
+            if( nidxptr[1] < 0 || !(d0 < maxRatio*d1) )
+                k = knn;
+        }
+
+        for( ; k < knn && nidxptr[k] >= 0; k++ )
+            mq[k] = DMatch(qIdx, nidxptr[k] & (BF_IMGIDX_ONE - 1), nidxptr[k] >> BF_IMGIDX_SHIFT,
+                           isInt ? (float)idistptr[k] : fdistptr[k]);
+        for( ; k < knn; k++ )
+            mq[k] = DMatch();
+    }
+}
+
+void BFMatcher::knnMatchImpl( const Mat& queryDescriptors, vector<vector<DMatch> >& matches, int knn,
+                              const vector<Mat>& masks, bool compactResult )
+{
+    if( queryDescriptors.empty() || trainDescCollection.empty() )
+    {
+        matches.clear();
+        return;
+    }
+    CV_Assert( queryDescriptors.type() == trainDescCollection[0].type() );
+
+    Mat dist, nidx;
+    bfKnnSearch(queryDescriptors, trainDescCollection, masks, normType, crossCheck, knn, dist, nidx);
+
+    vector<DMatch> flat((size_t)queryDescriptors.rows*knn);
+    bfFlattenMatches(dist, nidx, knn, 1.f, &flat[0]);
+
+    matches.resize(queryDescriptors.rows);
     int qIdx0 = 0;
     for( int qIdx = 0; qIdx < queryDescriptors.rows; qIdx++ )
     {
-        if( matches[qIdx].empty() && compactResult )
+        const DMatch* mq = &flat[(size_t)qIdx*knn];
+        int k = 0;
+        while( k < knn && mq[k].queryIdx >= 0 )
+            k++;
+        if( k == 0 && compactResult )
             continue;
+        matches[qIdx0++].assign(mq, mq + k);
+    }
+    matches.resize(qIdx0);
+}
 
-        if( qIdx0 < qIdx )
-            std::swap(matches[qIdx], matches[qIdx0]);
+void BFMatcher::knnMatchFlat( const Mat& queryDescriptors, const Mat& trainDescriptors,
+                              vector<DMatch>& matches, int knn, float maxRatio, const Mat& mask ) const
+{
+    matches.clear();
+    if( queryDescriptors.empty() || trainDescriptors.empty() )
+        return;
+
+    CV_Assert( knn > 0 && (maxRatio >= 1.f || knn > 1) );
+    CV_Assert( queryDescriptors.type() == trainDescriptors.type() );
+    CV_Assert( mask.empty() || (mask.type() == CV_8UC1 && mask.rows == queryDescriptors.rows &&
+                                mask.cols == trainDescriptors.rows) );
+
+    Mat dist, nidx;
+    bfKnnSearch(queryDescriptors, vector<Mat>(1, trainDescriptors),
+                mask.empty() ? vector<Mat>() : vector<Mat>(1, mask),
+                normType, crossCheck, knn, dist, nidx);
+
+    matches.resize((size_t)queryDescriptors.rows*knn);
+    bfFlattenMatches(dist, nidx, knn, maxRatio, &matches[0]);
+}
+
+void BFMatcher::knnMatchFlat( const Mat& queryDescriptors, vector<DMatch>& matches, int knn,
+                              float maxRatio, const vector<Mat>& masks ) const
+{
+    matches.clear();
+    if( queryDescriptors.empty() || empty() )
+        return;
+
+    CV_Assert( knn > 0 && (maxRatio >= 1.f || knn > 1) );
+    CV_Assert( queryDescriptors.type() == trainDescCollection[0].type() );
+    checkMasks( masks, queryDescriptors.rows );
+
+    Mat dist, nidx;
+    bfKnnSearch(queryDescriptors, trainDescCollection, masks, normType, crossCheck, knn, dist, nidx);
+
+    matches.resize((size_t)queryDescriptors.rows*knn);
+    bfFlattenMatches(dist, nidx, knn, maxRatio, &matches[0]);
+}
+
+
+void BFMatcher::radiusMatchImpl( const Mat& queryDescriptors, vector<vector<DMatch> >& matches,
+                                 float maxDistance, const vector<Mat>& masks, bool compactResult )
+{
+    if( queryDescriptors.empty() || trainDescCollection.empty() )
+    {
+        matches.clear();
+        return;
+    }
+    CV_Assert( queryDescriptors.type() == trainDescCollection[0].type() );
 
-        std::sort( matches[qIdx0].begin(), matches[qIdx0].end() );
-        qIdx0++;
+    matches.clear();
+    matches.resize(queryDescriptors.rows);
+
+    int nstripes = std::max(std::min(getNumThreads()*4, queryDescriptors.rows/16), 1);
+    parallel_for_(Range(0, nstripes),
+                  BFRadiusMatchInvoker(queryDescriptors, trainDescCollection, masks, normType,
+                                       maxDistance, nstripes, matches));
+
+    if( compactResult )
+    {
+        int qIdx0 = 0;
+        for( int qIdx = 0; qIdx < queryDescriptors.rows; qIdx++ )
+        {
+            if( matches[qIdx].empty() )
+                continue;
+            if( qIdx0 < qIdx )
+                std::swap(matches[qIdx], matches[qIdx0]);
+            qIdx0++;
+        }
+        matches.resize(qIdx0);
     }
 }
 
@@ -484,6 +893,10 @@ Ptr<DescriptorMatcher> DescriptorMatcher::create( const string& descriptorMatche
     {
         dm = new BFMatcher(NORM_HAMMING2);
     }
+    else if( !descriptorMatcherType.compare("MultiIndexHashing") )
+    {
+        dm = new MIHMatcher();
+    }
     else
         CV_Error( CV_StsBadArg, "Unknown matcher name" );
 
@@ -0,0 +1,768 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                        Intel License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000, Intel Corporation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of Intel Corporation may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+
+#include "precomp.hpp"
+#include <cstdio>
+
+namespace cv
+{
+
+// bits [ofs, ofs + nbits) of a binary descriptor, nbits <= 32; bit i is bit (i & 7) of byte (i >> 3)
+static inline unsigned mihSubstring( const uchar* desc, int ofs, int nbits )
+{
+    const uchar* p = desc + (ofs >> 3);
+    int shift = ofs & 7, nbytes = (shift + nbits + 7) >> 3;
+    uint64 v = 0;
+    for( int i = 0; i < nbytes; i++ )
+        v |= (uint64)p[i] << (i*8);
+    return (unsigned)((v >> shift) & ((CV_BIG_UINT(1) << nbits) - 1));
+}
+
+static inline unsigned mihHash( unsigned key, int shift )
+{
+    return (key*2654435761U) >> shift;
+}
+
+static inline int mihHashShift( const Mat& slots )
+{
+    int bits = 0;
+    while( (1 << bits) < slots.cols )
+        bits++;
+    return 32 - bits;
+}
+
+// the position of key in keys or -1
+static inline int mihLookup( const int* keys, const int* slots, int mask, int shift, unsigned key )
+{
+    for( unsigned h = mihHash(key, shift); ; h = (h + 1) & mask )
+    {
+        int k = slots[h];
+        if( k < 0 || (unsigned)keys[k] == key )
+            return k;
+    }
+}
+
+// orders the matches by distance, then by the train descriptor index as brute force does
+static bool mihLessMatch( const DMatch& a, const DMatch& b )
+{
+    return a.distance < b.distance || (a.distance == b.distance &&
+           (a.imgIdx < b.imgIdx || (a.imgIdx == b.imgIdx && a.trainIdx < b.trainIdx)));
+}
+
+// A substring table indexed by the value itself is used when it is not much larger than the train set
+static inline bool mihIsDirect( int len, int N )
+{
+    return len <= 30 && (CV_BIG_INT(1) << len) <= (int64)N*2;
+}
+
+class MIHTableBuilder : public ParallelLoopBody
+{
+public:
+    MIHTableBuilder( const Mat& _descriptors, const vector<int>& _substrOfs,
+                     vector<Mat>& _keys, vector<Mat>& _ofs, vector<Mat>& _ids, vector<Mat>& _slots )
+        : descriptors(&_descriptors), substrOfs(&_substrOfs),
+          keys(&_keys), ofs(&_ofs), ids(&_ids), slots(&_slots)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int n, N = descriptors->rows;
+        vector<uint64> buf;
+        vector<unsigned> values(N);
+
+        for( int i = range.start; i < range.end; i++ )
+        {
+            int sofs = (*substrOfs)[i], len = (*substrOfs)[i+1] - sofs;
+            Mat& tkeys = (*keys)[i];
+            Mat& tofs = (*ofs)[i];
+            Mat& tids = (*ids)[i];
+            Mat& tslots = (*slots)[i];
+            tids.create(1, N, CV_32S);
+            int* iptr = tids.ptr<int>();
+
+            for( n = 0; n < N; n++ )
+                values[n] = mihSubstring(descriptors->ptr(n), sofs, len);
+
+            if( mihIsDirect(len, N) )
+            {
+                // counting sort; tofs is indexed by the substring value itself
+                int nvalues = 1 << len;
+                tkeys.release();
+                tslots.release();
+                tofs.create(1, nvalues + 1, CV_32S);
+                tofs = Scalar::all(0);
+                int* optr = tofs.ptr<int>();
+                for( n = 0; n < N; n++ )
+                    optr[values[n] + 1]++;
+                for( int k = 0; k < nvalues; k++ )
+                    optr[k + 1] += optr[k];
+                for( n = 0; n < N; n++ )
+                    iptr[optr[values[n]]++] = n;
+                for( int k = nvalues; k > 0; k-- )
+                    optr[k] = optr[k - 1];
+                optr[0] = 0;
+                continue;
+            }
+
+            buf.resize(N);
+            for( n = 0; n < N; n++ )
+                buf[n] = ((uint64)values[n] << 32) | (unsigned)n;
+            std::sort(buf.begin(), buf.end());
+
+            int nkeys = 0;
+            for( n = 0; n < N; n++ )
+                nkeys += n == 0 || (buf[n] >> 32) != (buf[n-1] >> 32);
+
+            tkeys.create(1, nkeys, CV_32S);
+            tofs.create(1, nkeys + 1, CV_32S);
+            int* kptr = tkeys.ptr<int>();
+            int* optr = tofs.ptr<int>();
+
+            for( n = 0, nkeys = 0; n < N; n++ )
+            {
+                if( n == 0 || (buf[n] >> 32) != (buf[n-1] >> 32) )
+                {
+                    kptr[nkeys] = (int)(buf[n] >> 32);
+                    optr[nkeys++] = n;
+                }
+                iptr[n] = (int)(buf[n] & 0xffffffff);
+            }
+            optr[nkeys] = N;
+
+            // the load factor of the hash table is below 1/2
+            int nslots = 2;
+            while( nslots < nkeys*2 )
+                nslots *= 2;
+            tslots.create(1, nslots, CV_32S);
+            tslots = Scalar::all(-1);
+            int* sptr = tslots.ptr<int>();
+            int mask = nslots - 1, shift = mihHashShift(tslots);
+            for( int k = 0; k < nkeys; k++ )
+            {
+                unsigned h = mihHash((unsigned)kptr[k], shift);
+                while( sptr[h] >= 0 )
+                    h = (h + 1) & mask;
+                sptr[h] = k;
+            }
+        }
+    }
+
+private:
+    const Mat* descriptors;
+    const vector<int>* substrOfs;
+    vector<Mat>* keys;
+    vector<Mat>* ofs;
+    vector<Mat>* ids;
+    vector<Mat>* slots;
+};
+
+// Searches the multi-index for a range of queries. In the k-NN mode (knn > 0) the buckets
+// at the substring distance t = 0, 1, 2, ... are visited substring by substring; after the
+// level t of the substring i is done, any descriptor not seen yet is at least m*t + i + 1 away
+// from the query, so the search stops as soon as the k-th best distance is below that. In the
+// radius mode the levels up to floor(maxDistance/m) are visited. When the number of buckets to
+// visit gets too large compared to the train set size, the query is flagged for brute force.
+// Ties are resolved by the train descriptor index, so the result is the same as brute force gives.
+class MIHSearchInvoker : public ParallelLoopBody
+{
+public:
+    MIHSearchInvoker( const Mat& _query, const Mat& _train, const vector<int>& _startIdxs,
+                      const vector<int>& _substrOfs, const vector<Mat>& _keys, const vector<Mat>& _ofs,
+                      const vector<Mat>& _ids, const vector<Mat>& _slots, const vector<Mat>& _masks,
+                      int _knn, float _maxDistance, vector<vector<DMatch> >& _matches,
+                      vector<uchar>& _exhaustiveFlags )
+        : query(&_query), train(&_train), startIdxs(&_startIdxs), substrOfs(&_substrOfs),
+          keys(&_keys), ofs(&_ofs), ids(&_ids), slots(&_slots), masks(&_masks),
+          knn(_knn), maxDistance(_maxDistance), matches(&_matches), exhaustiveFlags(&_exhaustiveFlags)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int i, m = (int)substrOfs->size() - 1, N = train->rows;
+        int maxLen = 0;
+        AutoBuffer<int> _shifts(m);
+        int* shifts = _shifts;
+        for( i = 0; i < m; i++ )
+        {
+            shifts[i] = (*slots)[i].empty() ? 0 : mihHashShift((*slots)[i]);
+            maxLen = std::max(maxLen, (*substrOfs)[i+1] - (*substrOfs)[i]);
+        }
+
+        vector<uchar> visited((N + 7)/8, (uchar)0);
+        vector<int> touched;
+        AutoBuffer<unsigned> _qkeys(m);
+        AutoBuffer<int> _best(std::max(knn, 1)*2);
+        unsigned* qkeys = _qkeys;
+        int* bestDist = _best;
+        int* bestIdx = bestDist + std::max(knn, 1);
+
+        double maxProbes = std::max(N/256, 64);
+        int lastLevel = knn > 0 ? maxLen :
+            (int)std::min(std::floor(maxDistance), (float)train->cols*8)/m;
+
+        for( int qIdx = range.start; qIdx < range.end; qIdx++ )
+        {
+            const uchar* q = query->ptr(qIdx);
+            vector<DMatch>& mq = (*matches)[qIdx];
+            double probes = 0;
+            bool done = false, exhaustive = false;
+
+            for( i = 0; i < m; i++ )
+                qkeys[i] = mihSubstring(q, (*substrOfs)[i], (*substrOfs)[i+1] - (*substrOfs)[i]);
+            for( i = 0; i < knn; i++ )
+                bestDist[i] = bestIdx[i] = INT_MAX;
+            mq.clear();
+            touched.clear();
+
+            for( int t = 0; t <= lastLevel && !done && !exhaustive; t++ )
+            {
+                for( i = 0; i < m; i++ )
+                {
+                    int slen = (*substrOfs)[i+1] - (*substrOfs)[i];
+                    if( t <= slen )
+                    {
+                        double nbuckets = 1;
+                        for( int j = 0; j < t; j++ )
+                            nbuckets = nbuckets*(slen - j)/(j + 1);
+                        probes += nbuckets;
+                        if( probes > maxProbes )
+                        {
+                            exhaustive = true;
+                            break;
+                        }
+
+                        const int* tkeys = (*keys)[i].empty() ? 0 : (*keys)[i].ptr<int>();
+                        const int* tofs = (*ofs)[i].ptr<int>();
+                        const int* tids = (*ids)[i].ptr<int>();
+                        const int* tslots = (*slots)[i].ptr<int>();
+                        int mask = (*slots)[i].cols - 1;
+                        uint64 flips = (CV_BIG_UINT(1) << t) - 1, end = CV_BIG_UINT(1) << slen;
+
+                        // all the slen-bit words with t bits set, in increasing order
+                        for( ;; )
+                        {
+                            unsigned key = qkeys[i] ^ (unsigned)flips;
+                            int j = 0, j1 = 0;
+                            if( !tkeys )
+                                j = tofs[key], j1 = tofs[key + 1];
+                            else
+                            {
+                                int k = mihLookup(tkeys, tslots, mask, shifts[i], key);
+                                if( k >= 0 )
+                                    j = tofs[k], j1 = tofs[k + 1];
+                            }
+                            for( ; j < j1; j++ )
+                            {
+                                int n = tids[j];
+                                if( visited[n >> 3] & (1 << (n & 7)) )
+                                    continue;
+                                visited[n >> 3] |= (uchar)(1 << (n & 7));
+                                touched.push_back(n);
+                                check(qIdx, q, n, bestDist, bestIdx, mq);
+                            }
+                            if( t == 0 )
+                                break;
+                            uint64 c = flips & (0 - flips), r = flips + c;
+                            flips = (((r ^ flips) >> 2)/c) | r;
+                            if( flips >= end )
+                                break;
+                        }
+                    }
+
+                    if( knn > 0 && bestDist[knn-1] < m*t + i + 1 )
+                    {
+                        done = true;
+                        break;
+                    }
+                }
+            }
+
+            // left to the brute force matcher, which is faster on many such queries at once
+            (*exhaustiveFlags)[qIdx] = exhaustive;
+
+            for( size_t j = 0; j < touched.size(); j++ )
+                visited[touched[j] >> 3] = 0;
+
+            if( exhaustive )
+                mq.clear();
+            else if( knn > 0 )
+            {
+                for( i = 0; i < knn && bestIdx[i] != INT_MAX; i++ )
+                    mq.push_back(makeMatch(qIdx, bestIdx[i], bestDist[i]));
+            }
+            else
+                std::sort(mq.begin(), mq.end(), mihLessMatch);
+        }
+    }
+
+private:
+    int imageOf( int n ) const
+    {
+        return (int)(std::upper_bound(startIdxs->begin(), startIdxs->end(), n) - startIdxs->begin()) - 1;
+    }
+
+    DMatch makeMatch( int qIdx, int n, int d ) const
+    {
+        int imgIdx = imageOf(n);
+        return DMatch(qIdx, n - (*startIdxs)[imgIdx], imgIdx, (float)d);
+    }
+
+    void check( int qIdx, const uchar* q, int n, int* bestDist, int* bestIdx, vector<DMatch>& found ) const
+    {
+        if( !masks->empty() )
+        {
+            int imgIdx = imageOf(n);
+            const Mat& mask = (*masks)[imgIdx];
+            if( !mask.empty() && !mask.at<uchar>(qIdx, n - (*startIdxs)[imgIdx]) )
+                return;
+        }
+
+        int d = normHamming(q, train->ptr(n), train->cols);
+        if( knn > 0 )
+        {
+            if( d > bestDist[knn-1] || (d == bestDist[knn-1] && n > bestIdx[knn-1]) )
+                return;
+            int k = knn - 2;
+            for( ; k >= 0 && (bestDist[k] > d || (bestDist[k] == d && bestIdx[k] > n)); k-- )
+            {
+                bestDist[k+1] = bestDist[k];
+                bestIdx[k+1] = bestIdx[k];
+            }
+            bestDist[k+1] = d;
+            bestIdx[k+1] = n;
+        }
+        else if( d <= maxDistance )
+            found.push_back(makeMatch(qIdx, n, d));
+    }
+
+    const Mat* query;
+    const Mat* train;
+    const vector<int>* startIdxs;
+    const vector<int>* substrOfs;
+    const vector<Mat>* keys;
+    const vector<Mat>* ofs;
+    const vector<Mat>* ids;
+    const vector<Mat>* slots;
+    const vector<Mat>* masks;
+    int knn;
+    float maxDistance;
+    vector<vector<DMatch> >* matches;
+    vector<uchar>* exhaustiveFlags;
+};
+
+// Every stripe of MIHSearchInvoker allocates and clears the visited bitmap of the whole train set,
+// so the queries are split into a few stripes per thread rather than into the default ones
+static double mihSearchStripes( int nqueries )
+{
+    return std::max(1, std::min(nqueries, getNumThreads()*4));
+}
+
+// Matches the queries flagged by MIHSearchInvoker with BFMatcher
+static void mihBruteForce( const Mat& query, const vector<Mat>& trainCollection, const vector<Mat>& masks,
+                           const vector<uchar>& flags, int knn, float maxDistance, vector<vector<DMatch> >& matches )
+{
+    vector<int> qidx;
+    for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+        if( flags[qIdx] )
+            qidx.push_back(qIdx);
+    if( qidx.empty() )
+        return;
+
+    Mat subQuery((int)qidx.size(), query.cols, query.type());
+    vector<Mat> subMasks(masks.size());
+    for( size_t i = 0; i < qidx.size(); i++ )
+        query.row(qidx[i]).copyTo(subQuery.row((int)i));
+    for( size_t j = 0; j < masks.size(); j++ )
+        if( !masks[j].empty() )
+        {
+            subMasks[j].create((int)qidx.size(), masks[j].cols, masks[j].type());
+            for( size_t i = 0; i < qidx.size(); i++ )
+                masks[j].row(qidx[i]).copyTo(subMasks[j].row((int)i));
+        }
+
+    // BFMatcher packs the image index and the descriptor index into one int,
+    // so large train images are passed to it in parts
+    const int MAX_PART_ROWS = 1 << 17;
+    vector<Mat> parts, partMasks;
+    vector<int> partImg, partOfs;
+    for( size_t j = 0; j < trainCollection.size(); j++ )
+        for( int r = 0; r == 0 || r < trainCollection[j].rows; r += MAX_PART_ROWS )
+        {
+            int r1 = std::min(r + MAX_PART_ROWS, trainCollection[j].rows);
+            parts.push_back(trainCollection[j].rowRange(r, r1));
+            partImg.push_back((int)j);
+            partOfs.push_back(r);
+            if( !subMasks.empty() )
+                partMasks.push_back(subMasks[j].empty() ? Mat() : subMasks[j].colRange(r, r1));
+        }
+
+    BFMatcher matcher(NORM_HAMMING);
+    vector<vector<DMatch> > subMatches;
+    matcher.add(parts);
+    if( knn > 0 )
+        matcher.knnMatch(subQuery, subMatches, knn, partMasks);
+    else
+        matcher.radiusMatch(subQuery, subMatches, maxDistance, partMasks);
+
+    for( size_t i = 0; i < qidx.size(); i++ )
+    {
+        vector<DMatch>& mq = matches[qidx[i]];
+        mq.swap(subMatches[i]);
+        for( size_t k = 0; k < mq.size(); k++ )
+        {
+            mq[k].queryIdx = qidx[i];
+            mq[k].trainIdx += partOfs[mq[k].imgIdx];
+            mq[k].imgIdx = partImg[mq[k].imgIdx];
+        }
+        if( knn == 0 )
+            std::sort(mq.begin(), mq.end(), mihLessMatch);
+    }
+}
+
+MIHMatcher::MIHMatcher( int _substringBits )
+    : substringBits(_substringBits), addedDescCount(0)
+{
+    CV_Assert( 0 <= substringBits && substringBits <= 32 );
+}
+
+void MIHMatcher::add( const vector<Mat>& descriptors )
+{
+    for( size_t i = 0; i < descriptors.size(); i++ )
+        CV_Assert( descriptors[i].empty() || descriptors[i].type() == CV_8U );
+    DescriptorMatcher::add( descriptors );
+    for( size_t i = 0; i < descriptors.size(); i++ )
+        addedDescCount += descriptors[i].rows;
+}
+
+void MIHMatcher::clear()
+{
+    DescriptorMatcher::clear();
+
+    mergedDescriptors.release();
+    startIdxs.clear();
+    substrOfs.clear();
+    tableKeys.clear();
+    tableOfs.clear();
+    tableIds.clear();
+    tableSlots.clear();
+
+    addedDescCount = 0;
+}
+
+void MIHMatcher::train()
+{
+    if( !substrOfs.empty() && mergedDescriptors.rows == addedDescCount )
+        return;
+
+    int i, imgCount = (int)trainDescCollection.size(), N = 0, cols = 0;
+    startIdxs.resize(imgCount);
+    for( i = 0; i < imgCount; i++ )
+    {
+        startIdxs[i] = N;
+        N += trainDescCollection[i].rows;
+        if( !trainDescCollection[i].empty() )
+        {
+            CV_Assert( cols == 0 || cols == trainDescCollection[i].cols );
+            cols = trainDescCollection[i].cols;
+        }
+    }
+    CV_Assert( N > 0 );
+
+    mergedDescriptors.create(N, cols, CV_8U);
+    for( i = 0; i < imgCount; i++ )
+        if( !trainDescCollection[i].empty() )
+            trainDescCollection[i].copyTo(mergedDescriptors.rowRange(startIdxs[i], startIdxs[i] + trainDescCollection[i].rows));
+
+    // the substrings are about log2(N) bits long, so that there is about one train descriptor per bucket
+    int bits = cols*8, sbits = substringBits;
+    if( sbits == 0 )
+        sbits = std::min(std::max(cvRound(std::log((double)N)/std::log(2.)), 8), 32);
+    int m = (bits + sbits - 1)/sbits;
+    substrOfs.resize(m + 1);
+    for( i = 0; i <= m; i++ )
+        substrOfs[i] = (int)((int64)bits*i/m);
+
+    tableKeys.resize(m);
+    tableOfs.resize(m);
+    tableIds.resize(m);
+    tableSlots.resize(m);
+    parallel_for_(Range(0, m), MIHTableBuilder(mergedDescriptors, substrOfs, tableKeys, tableOfs, tableIds, tableSlots));
+}
+
+void MIHMatcher::knnMatchImpl( const Mat& queryDescriptors, vector<vector<DMatch> >& matches, int knn,
+                               const vector<Mat>& masks, bool compactResult )
+{
+    CV_Assert( queryDescriptors.type() == CV_8U && queryDescriptors.cols == mergedDescriptors.cols );
+
+    vector<uchar> exhaustive(queryDescriptors.rows);
+    matches.resize(queryDescriptors.rows);
+    parallel_for_(Range(0, queryDescriptors.rows),
+                  MIHSearchInvoker(queryDescriptors, mergedDescriptors, startIdxs, substrOfs, tableKeys, tableOfs,
+                                   tableIds, tableSlots, masks, knn, 0.f, matches, exhaustive),
+                  mihSearchStripes(queryDescriptors.rows));
+    mihBruteForce(queryDescriptors, trainDescCollection, masks, exhaustive, knn, 0.f, matches);
+
+    if( compactResult )
+    {
+        int qIdx0 = 0;
+        for( int qIdx = 0; qIdx < queryDescriptors.rows; qIdx++ )
+            if( !matches[qIdx].empty() )
+                std::swap(matches[qIdx], matches[qIdx0++]);
+        matches.resize(qIdx0);
+    }
+}
+
+void MIHMatcher::radiusMatchImpl( const Mat& queryDescriptors, vector<vector<DMatch> >& matches, float maxDistance,
+                                  const vector<Mat>& masks, bool compactResult )
+{
+    CV_Assert( queryDescriptors.type() == CV_8U && queryDescriptors.cols == mergedDescriptors.cols );
+
+    vector<uchar> exhaustive(queryDescriptors.rows);
+    matches.resize(queryDescriptors.rows);
+    parallel_for_(Range(0, queryDescriptors.rows),
+                  MIHSearchInvoker(queryDescriptors, mergedDescriptors, startIdxs, substrOfs, tableKeys, tableOfs,
+                                   tableIds, tableSlots, masks, 0, maxDistance, matches, exhaustive),
+                  mihSearchStripes(queryDescriptors.rows));
+    mihBruteForce(queryDescriptors, trainDescCollection, masks, exhaustive, 0, maxDistance, matches);
+
+    if( compactResult )
+    {
+        int qIdx0 = 0;
+        for( int qIdx = 0; qIdx < queryDescriptors.rows; qIdx++ )
+            if( !matches[qIdx].empty() )
+                std::swap(matches[qIdx], matches[qIdx0++]);
+        matches.resize(qIdx0);
+    }
+}
+
+void MIHMatcher::read( const FileNode& fn )
+{
+    int _substringBits = (int)fn["substringBits"];
+    CV_Assert( 0 <= _substringBits && _substringBits <= 32 );
+    substringBits = _substringBits;
+}
+
+void MIHMatcher::write( FileStorage& fs ) const
+{
+    fs << "substringBits" << substringBits;
+}
+
+static const char MIH_SIGNATURE[] = "OpenCV-MIH-1";
+
+static void mihWriteInts( FILE* f, const int* data, size_t n )
+{
+    if( n > 0 && fwrite(data, sizeof(int), n, f) != n )
+        CV_Error( CV_StsError, "Can not write the multi-index hashing index" );
+}
+
+static void mihReadInts( FILE* f, int* data, size_t n )
+{
+    if( n > 0 && fread(data, sizeof(int), n, f) != n )
+        CV_Error( CV_StsParseError, "The multi-index hashing index file is truncated" );
+}
+
+static void mihWriteRow( FILE* f, const Mat& row )
+{
+    int n = row.cols;
+    mihWriteInts(f, &n, 1);
+    mihWriteInts(f, row.ptr<int>(), n);
+}
+
+static void mihReadRow( FILE* f, Mat& row )
+{
+    int n = 0;
+    mihReadInts(f, &n, 1);
+    CV_Assert( n >= 0 );
+    row.create(1, n, CV_32S);
+    mihReadInts(f, row.ptr<int>(), n);
+}
+
+void MIHMatcher::save( const string& filename ) const
+{
+    CV_Assert( !substrOfs.empty() && mergedDescriptors.rows == addedDescCount );
+
+    FILE* f = fopen(filename.c_str(), "wb");
+    if( !f )
+        CV_Error( CV_StsError, "Can not open " + filename + " for writing" );
+
+    int hdr[] = { substringBits, mergedDescriptors.rows, mergedDescriptors.cols,
+                  (int)startIdxs.size(), (int)substrOfs.size() };
+    try
+    {
+        if( fwrite(MIH_SIGNATURE, 1, sizeof(MIH_SIGNATURE), f) != sizeof(MIH_SIGNATURE) )
+            CV_Error( CV_StsError, "Can not write the multi-index hashing index" );
+        mihWriteInts(f, hdr, sizeof(hdr)/sizeof(hdr[0]));
+        mihWriteInts(f, &startIdxs[0], startIdxs.size());
+        mihWriteInts(f, &substrOfs[0], substrOfs.size());
+        for( int i = 0; i < mergedDescriptors.rows; i++ )
+            if( fwrite(mergedDescriptors.ptr(i), 1, mergedDescriptors.cols, f) != (size_t)mergedDescriptors.cols )
+                CV_Error( CV_StsError, "Can not write the multi-index hashing index" );
+        for( size_t i = 0; i + 1 < substrOfs.size(); i++ )
+        {
+            mihWriteRow(f, tableKeys[i]);
+            mihWriteRow(f, tableOfs[i]);
+            mihWriteRow(f, tableIds[i]);
+            mihWriteRow(f, tableSlots[i]);
+        }
+    }
+    catch(...)
+    {
+        fclose(f);
+        throw;
+    }
+    fclose(f);
+}
+
+void MIHMatcher::load( const string& filename )
+{
+    FILE* f = fopen(filename.c_str(), "rb");
+    if( !f )
+        CV_Error( CV_StsError, "Can not open " + filename + " for reading" );
+
+    clear();
+    try
+    {
+        char signature[sizeof(MIH_SIGNATURE)];
+        if( fread(signature, 1, sizeof(signature), f) != sizeof(signature) ||
+            memcmp(signature, MIH_SIGNATURE, sizeof(signature)) != 0 )
+            CV_Error( CV_StsParseError, filename + " is not a multi-index hashing index" );
+
+        int hdr[5];
+        mihReadInts(f, hdr, 5);
+        CV_Assert( 0 <= hdr[0] && hdr[0] <= 32 && hdr[1] > 0 && hdr[2] > 0 && hdr[3] > 0 && hdr[4] > 1 );
+        substringBits = hdr[0];
+        startIdxs.resize(hdr[3]);
+        substrOfs.resize(hdr[4]);
+        mihReadInts(f, &startIdxs[0], startIdxs.size());
+        mihReadInts(f, &substrOfs[0], substrOfs.size());
+
+        // the search uses all of them as array indices
+        CV_Assert( startIdxs[0] == 0 && substrOfs[0] == 0 && substrOfs[hdr[4]-1] == (int64)hdr[2]*8 );
+        for( size_t i = 1; i < startIdxs.size(); i++ )
+            CV_Assert( startIdxs[i-1] <= startIdxs[i] && startIdxs[i] <= hdr[1] );
+
+        mergedDescriptors.create(hdr[1], hdr[2], CV_8U);
+        for( int i = 0; i < mergedDescriptors.rows; i++ )
+            if( fread(mergedDescriptors.ptr(i), 1, mergedDescriptors.cols, f) != (size_t)mergedDescriptors.cols )
+                CV_Error( CV_StsParseError, "The multi-index hashing index file is truncated" );
+
+        int m = hdr[4] - 1;
+        tableKeys.resize(m);
+        tableOfs.resize(m);
+        tableIds.resize(m);
+        tableSlots.resize(m);
+        for( int i = 0; i < m; i++ )
+        {
+            mihReadRow(f, tableKeys[i]);
+            mihReadRow(f, tableOfs[i]);
+            mihReadRow(f, tableIds[i]);
+            mihReadRow(f, tableSlots[i]);
+            int len = substrOfs[i+1] - substrOfs[i];
+            CV_Assert( 0 < len && len <= 32 && tableIds[i].cols == hdr[1] );
+            if( mihIsDirect(len, hdr[1]) )
+                CV_Assert( tableKeys[i].empty() && tableSlots[i].empty() && tableOfs[i].cols == (1 << len) + 1 );
+            else
+                CV_Assert( tableOfs[i].cols == tableKeys[i].cols + 1 && tableSlots[i].cols > tableKeys[i].cols &&
+                           (tableSlots[i].cols & (tableSlots[i].cols - 1)) == 0 );
+
+            const int* optr = tableOfs[i].ptr<int>();
+            const int* iptr = tableIds[i].ptr<int>();
+            const int* sptr = tableSlots[i].ptr<int>();
+            int k, nkeys = tableKeys[i].cols, nofs = tableOfs[i].cols, nempty = 0;
+            CV_Assert( optr[0] == 0 && optr[nofs-1] == hdr[1] );
+            for( k = 1; k < nofs; k++ )
+                CV_Assert( optr[k-1] <= optr[k] );
+            for( k = 0; k < hdr[1]; k++ )
+                CV_Assert( (unsigned)iptr[k] < (unsigned)hdr[1] );
+            // an empty slot ends every probe sequence of the hash table
+            for( k = 0; k < tableSlots[i].cols; k++ )
+            {
+                CV_Assert( -1 <= sptr[k] && sptr[k] < nkeys );
+                nempty += sptr[k] < 0;
+            }
+            CV_Assert( tableSlots[i].empty() || nempty > 0 );
+        }
+    }
+    catch(...)
+    {
+        fclose(f);
+        clear();
+        throw;
+    }
+    fclose(f);
+
+    // the train collection refers to the loaded descriptors
+    for( size_t i = 0; i < startIdxs.size(); i++ )
+    {
+        int end = i + 1 < startIdxs.size() ? startIdxs[i+1] : mergedDescriptors.rows;
+        trainDescCollection.push_back(mergedDescriptors.rowRange(startIdxs[i], end));
+    }
+    addedDescCount = mergedDescriptors.rows;
+}
+
+Ptr<DescriptorMatcher> MIHMatcher::clone( bool emptyTrainData ) const
+{
+    MIHMatcher* matcher = new MIHMatcher(substringBits);
+    if( !emptyTrainData )
+    {
+        matcher->trainDescCollection.resize(trainDescCollection.size());
+        std::transform( trainDescCollection.begin(), trainDescCollection.end(),
+                        matcher->trainDescCollection.begin(), clone_op );
+        matcher->addedDescCount = addedDescCount;
+        matcher->mergedDescriptors = mergedDescriptors.clone();
+        matcher->startIdxs = startIdxs;
+        matcher->substrOfs = substrOfs;
+        matcher->tableKeys.resize(tableKeys.size());
+        matcher->tableOfs.resize(tableOfs.size());
+        matcher->tableIds.resize(tableIds.size());
+        matcher->tableSlots.resize(tableSlots.size());
+        std::transform( tableKeys.begin(), tableKeys.end(), matcher->tableKeys.begin(), clone_op );
+        std::transform( tableOfs.begin(), tableOfs.end(), matcher->tableOfs.begin(), clone_op );
+        std::transform( tableIds.begin(), tableIds.end(), matcher->tableIds.begin(), clone_op );
+        std::transform( tableSlots.begin(), tableSlots.end(), matcher->tableSlots.begin(), clone_op );
+    }
+    return matcher;
+}
+
+}
@@ -367,22 +367,18 @@ static void accumulateMSERComp( MSERConnectedComp* comp, LinkedPoint* point )
     comp->size++;
 }
 
-// convert the point set to CvSeq
-static CvContour* MSERToContour( MSERConnectedComp* comp, CvMemStorage* storage )
+// append the point set of a stable region to the output
+static void MSERToPoints( MSERConnectedComp* comp, vector<vector<Point> >& msers )
 {
-    CvSeq* _contour = cvCreateSeq( CV_SEQ_KIND_GENERIC|CV_32SC2, sizeof(CvContour), sizeof(CvPoint), storage );
-    CvContour* contour = (CvContour*)_contour;
-    cvSeqPushMulti( _contour, 0, comp->history->size );
+    msers.push_back( vector<Point>() );
+    vector<Point>& pts = msers.back();
+    pts.resize( comp->history->size );
     LinkedPoint* lpt = comp->head;
     for ( int i = 0; i < comp->history->size; i++ )
     {
-        CvPoint* pt = CV_GET_SEQ_ELEM( CvPoint, _contour, i );
-        pt->x = lpt->pt.x;
-        pt->y = lpt->pt.y;
+        pts[i] = lpt->pt;
         lpt = lpt->next;
     }
-    cvBoundingRect( contour );
-    return contour;
 }
 
 // to preprocess src image to following format
@@ -391,10 +387,12 @@ static CvContour* MSERToContour( MSERConnectedComp* comp, CvMemStorage* storage
 // 17~19 bits is the direction
 // 8~11 bits is the bucket it falls to (for BitScanForward)
 // 0~8 bits is the color
+// the source image is not modified, inv = 0xff gives the levels of the inverted image
 static int* preprocessMSER_8UC1( CvMat* img,
             int*** heap_cur,
-            CvMat* src,
-            CvMat* mask )
+            const CvMat* src,
+            const CvMat* mask,
+            int inv )
 {
     int srccpt = src->step-src->cols;
     int cpt_1 = img->cols-src->cols-1;
@@ -411,11 +409,11 @@ static int* preprocessMSER_8UC1( CvMat* img,
         imgptr++;
     }
     imgptr += cpt_1-1;
-    uchar* srcptr = src->data.ptr;
+    const uchar* srcptr = src->data.ptr;
     if ( mask )
     {
         startptr = 0;
-        uchar* maskptr = mask->data.ptr;
+        const uchar* maskptr = mask->data.ptr;
         for ( int i = 0; i < src->rows; i++ )
         {
             *imgptr = -1;
@@ -426,9 +424,9 @@ static int* preprocessMSER_8UC1( CvMat* img,
                 {
                     if ( !startptr )
                         startptr = imgptr;
-                    *srcptr = 0xff-*srcptr;
-                    level_size[*srcptr]++;
-                    *imgptr = ((*srcptr>>5)<<8)|(*srcptr);
+                    int val = (*srcptr)^inv;
+                    level_size[val]++;
+                    *imgptr = ((val>>5)<<8)|val;
                 } else {
                     *imgptr = -1;
                 }
@@ -449,9 +447,9 @@ static int* preprocessMSER_8UC1( CvMat* img,
             imgptr++;
             for ( int j = 0; j < src->cols; j++ )
             {
-                *srcptr = 0xff-*srcptr;
-                level_size[*srcptr]++;
-                *imgptr = ((*srcptr>>5)<<8)|(*srcptr);
+                int val = (*srcptr)^inv;
+                level_size[val]++;
+                *imgptr = ((val>>5)<<8)|val;
                 imgptr++;
                 srcptr++;
             }
@@ -485,9 +483,7 @@ static void extractMSER_8UC1_Pass( int* ioptr,
               int stepmask,
               int stepgap,
               MSERParams params,
-              int color,
-              CvSeq* contours,
-              CvMemStorage* storage )
+              vector<vector<Point> >& msers )
 {
     comptr->grey_level = 256;
     comptr++;
@@ -594,11 +590,7 @@ static void extractMSER_8UC1_Pass( int* ioptr,
                 {
                     // check the stablity and push a new history, increase the grey level
                     if ( MSERStableCheck( comptr, params ) )
-                    {
-                        CvContour* contour = MSERToContour( comptr, storage );
-                        contour->color = color;
-                        cvSeqPush( contours, &contour );
-                    }
+                        MSERToPoints( comptr, msers );
                     MSERNewHistory( comptr, histptr );
                     comptr[0].grey_level = pixel_val;
                     histptr++;
@@ -615,11 +607,7 @@ static void extractMSER_8UC1_Pass( int* ioptr,
                         {
                             // check the stablity here otherwise it wouldn't be an ER
                             if ( MSERStableCheck( comptr, params ) )
-                            {
-                                CvContour* contour = MSERToContour( comptr, storage );
-                                contour->color = color;
-                                cvSeqPush( contours, &contour );
-                            }
+                                MSERToPoints( comptr, msers );
                             MSERNewHistory( comptr, histptr );
                             comptr[0].grey_level = pixel_val;
                             histptr++;
@@ -633,48 +621,80 @@ static void extractMSER_8UC1_Pass( int* ioptr,
     }
 }
 
-static void extractMSER_8UC1( CvMat* src,
-             CvMat* mask,
-             CvSeq* contours,
-             CvMemStorage* storage,
-             MSERParams params )
+// runs the darker to brighter (MSER-, pass 0) and the brighter to darker (MSER+, pass 1) flooding;
+// the passes share nothing but the source image, so they run concurrently,
+// and a stripe that gets both passes reuses its buffers for the second one
+class MSERPassInvoker : public ParallelLoopBody
 {
-    int step = 8;
-    int stepgap = 3;
-    while ( step < src->step+2 )
+public:
+    MSERPassInvoker( const CvMat* _src, const CvMat* _mask, const MSERParams& _params,
+                     vector<vector<Point> >* _msers )
+        : src(_src), mask(_mask), params(_params), msers(_msers)
     {
-        step <<= 1;
-        stepgap++;
     }
-    int stepmask = step-1;
 
-    // to speedup the process, make the width to be 2^N
-    CvMat* img = cvCreateMat( src->rows+2, step, CV_32SC1 );
-    int* ioptr = img->data.i+step+1;
-    int* imgptr;
+    void operator()( const Range& range ) const
+    {
+        int step = 8;
+        int stepgap = 3;
+        while ( step < src->step+2 )
+        {
+            step <<= 1;
+            stepgap++;
+        }
+        int stepmask = step-1;
 
-    // pre-allocate boundary heap
-    int** heap = (int**)cvAlloc( (src->rows*src->cols+256)*sizeof(heap[0]) );
-    int** heap_start[256];
-    heap_start[0] = heap;
+        // to speedup the process, make the width to be 2^N
+        CvMat* img = cvCreateMat( src->rows+2, step, CV_32SC1 );
+        int* ioptr = img->data.i+step+1;
+        int* imgptr;
 
-    // pre-allocate linked point and grow history
-    LinkedPoint* pts = (LinkedPoint*)cvAlloc( src->rows*src->cols*sizeof(pts[0]) );
-    MSERGrowHistory* history = (MSERGrowHistory*)cvAlloc( src->rows*src->cols*sizeof(history[0]) );
-    MSERConnectedComp comp[257];
+        // pre-allocate boundary heap
+        int** heap = (int**)cvAlloc( (src->rows*src->cols+256)*sizeof(heap[0]) );
+        int** heap_start[256];
+        heap_start[0] = heap;
 
-    // darker to brighter (MSER-)
-    imgptr = preprocessMSER_8UC1( img, heap_start, src, mask );
-    extractMSER_8UC1_Pass( ioptr, imgptr, heap_start, pts, history, comp, step, stepmask, stepgap, params, -1, contours, storage );
-    // brighter to darker (MSER+)
-    imgptr = preprocessMSER_8UC1( img, heap_start, src, mask );
-    extractMSER_8UC1_Pass( ioptr, imgptr, heap_start, pts, history, comp, step, stepmask, stepgap, params, 1, contours, storage );
+        // pre-allocate linked point and grow history
+        LinkedPoint* pts = (LinkedPoint*)cvAlloc( src->rows*src->cols*sizeof(pts[0]) );
+        MSERGrowHistory* history = (MSERGrowHistory*)cvAlloc( src->rows*src->cols*sizeof(history[0]) );
+        MSERConnectedComp comp[257];
+
+        for ( int pass = range.start; pass < range.end; pass++ )
+        {
+            imgptr = preprocessMSER_8UC1( img, heap_start, src, mask, pass == 0 ? 0xff : 0 );
+            extractMSER_8UC1_Pass( ioptr, imgptr, heap_start, pts, history, comp, step, stepmask, stepgap,
+                                   params, msers[pass] );
+        }
+
+        // clean up
+        cvFree( &history );
+        cvFree( &heap );
+        cvFree( &pts );
+        cvReleaseMat( &img );
+    }
+
+private:
+    const CvMat* src;
+    const CvMat* mask;
+    MSERParams params;
+    vector<vector<Point> >* msers;
+};
 
-    // clean up
-    cvFree( &history );
-    cvFree( &heap );
-    cvFree( &pts );
-    cvReleaseMat( &img );
+static void extractMSER_8UC1( const CvMat* src,
+             const CvMat* mask,
+             vector<vector<Point> >& msers,
+             MSERParams params )
+{
+    vector<vector<Point> > passMsers[2];
+    parallel_for_( Range(0, 2), MSERPassInvoker( src, mask, params, passMsers ), getNumThreads() > 1 ? 2 : 1 );
+
+    // MSER- regions first, then MSER+ ones
+    size_t n0 = passMsers[0].size(), n1 = passMsers[1].size();
+    msers.resize( n0+n1 );
+    for ( size_t i = 0; i < n0; i++ )
+        msers[i].swap( passMsers[0][i] );
+    for ( size_t i = 0; i < n1; i++ )
+        msers[n0+i].swap( passMsers[1][i] );
 }
 
 struct MSCRNode;
@@ -687,10 +707,10 @@ struct TempMSCR
     int size;
 };
 
+// the links to the region roots are kept in a separate index array,
+// so the root lookups of the evolution touch as little memory as possible
 struct MSCRNode
 {
-    MSCRNode* shortcut;
-    // to make the finding of root less painful
     MSCRNode* prev;
     MSCRNode* next;
     // a point double-linked list
@@ -710,11 +730,12 @@ struct MSCRNode
 struct MSCREdge
 {
     double chi;
-    MSCRNode* left;
-    MSCRNode* right;
+    // the indices of the nodes, to keep the edge list compact
+    int left;
+    int right;
 };
 
-static double ChiSquaredDistance( uchar* x, uchar* y )
+static double ChiSquaredDistance( const uchar* x, const uchar* y )
 {
     return (double)((x[0]-y[0])*(x[0]-y[0]))/(double)(x[0]+y[0]+1e-10)+
            (double)((x[1]-y[1])*(x[1]-y[1]))/(double)(x[1]+y[1]+1e-10)+
@@ -727,51 +748,55 @@ static void initMSCRNode( MSCRNode* node )
     node->reinit = 0xffff;
     node->rank = 0;
     node->sizei = node->size = 1;
-    node->prev = node->next = node->shortcut = node;
+    node->prev = node->next = node;
 }
 
+// computes the distances to the right (dx) and to the bottom (dy) neighbours for a range of rows
+class MSCRDistanceInvoker : public ParallelLoopBody
+{
+public:
+    MSCRDistanceInvoker( const CvMat* _src, CvMat* _dx, CvMat* _dy )
+        : src(_src), dx(_dx), dy(_dy)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        for ( int i = range.start; i < range.end; i++ )
+        {
+            const uchar* srcptr = src->data.ptr+i*src->step;
+            double* dxptr = (double*)(dx->data.ptr+i*dx->step);
+            for ( int j = 0; j < src->cols-1; j++ )
+                dxptr[j] = ChiSquaredDistance( srcptr+j*3, srcptr+j*3+3 );
+            if ( i < src->rows-1 )
+            {
+                double* dyptr = (double*)(dy->data.ptr+i*dy->step);
+                for ( int j = 0; j < src->cols; j++ )
+                    dyptr[j] = ChiSquaredDistance( srcptr+j*3, srcptr+j*3+src->step );
+            }
+        }
+    }
+
+private:
+    const CvMat* src;
+    CvMat* dx;
+    CvMat* dy;
+};
+
 // the preprocess to get the edge list with proper gaussian blur
 static int preprocessMSER_8UC3( MSCRNode* node,
             MSCREdge* edge,
             double* total,
-            CvMat* src,
-            CvMat* mask,
+            const CvMat* src,
+            const CvMat* mask,
             CvMat* dx,
             CvMat* dy,
             int Ne,
             int edgeBlurSize )
 {
-    int srccpt = src->step-src->cols*3;
-    uchar* srcptr = src->data.ptr;
-    uchar* lastptr = src->data.ptr+3;
-    double* dxptr = dx->data.db;
-    for ( int i = 0; i < src->rows; i++ )
-    {
-        for ( int j = 0; j < src->cols-1; j++ )
-        {
-            *dxptr = ChiSquaredDistance( srcptr, lastptr );
-            dxptr++;
-            srcptr += 3;
-            lastptr += 3;
-        }
-        srcptr += srccpt+3;
-        lastptr += srccpt+3;
-    }
-    srcptr = src->data.ptr;
-    lastptr = src->data.ptr+src->step;
-    double* dyptr = dy->data.db;
-    for ( int i = 0; i < src->rows-1; i++ )
-    {
-        for ( int j = 0; j < src->cols; j++ )
-        {
-            *dyptr = ChiSquaredDistance( srcptr, lastptr );
-            dyptr++;
-            srcptr += 3;
-            lastptr += 3;
-        }
-        srcptr += srccpt;
-        lastptr += srccpt;
-    }
+    parallel_for_( Range(0, src->rows), MSCRDistanceInvoker( src, dx, dy ) );
+    double* dxptr;
+    double* dyptr;
     // get dx and dy and blur it
     if ( edgeBlurSize >= 1 )
     {
@@ -786,15 +811,15 @@ static int preprocessMSER_8UC3( MSCRNode* node,
     {
         Ne = 0;
         int maskcpt = mask->step-mask->cols+1;
-        uchar* maskptr = mask->data.ptr;
+        const uchar* maskptr = mask->data.ptr;
         MSCRNode* nodeptr = node;
         initMSCRNode( nodeptr );
         nodeptr->index = 0;
         *total += edge->chi = *dxptr;
         if ( maskptr[0] && maskptr[1] )
         {
-            edge->left = nodeptr;
-            edge->right = nodeptr+1;
+            edge->left = (int)(nodeptr-node);
+            edge->right = (int)(nodeptr-node)+1;
             edge++;
             Ne++;
         }
@@ -808,8 +833,8 @@ static int preprocessMSER_8UC3( MSCRNode* node,
             if ( maskptr[0] && maskptr[1] )
             {
                 *total += edge->chi = *dxptr;
-                edge->left = nodeptr;
-                edge->right = nodeptr+1;
+                edge->left = (int)(nodeptr-node);
+                edge->right = (int)(nodeptr-node)+1;
                 edge++;
                 Ne++;
             }
@@ -830,16 +855,16 @@ static int preprocessMSER_8UC3( MSCRNode* node,
                 if ( maskptr[-mask->step] )
                 {
                     *total += edge->chi = *dyptr;
-                    edge->left = nodeptr-src->cols;
-                    edge->right = nodeptr;
+                    edge->left = (int)(nodeptr-node)-src->cols;
+                    edge->right = (int)(nodeptr-node);
                     edge++;
                     Ne++;
                 }
                 if ( maskptr[1] )
                 {
                     *total += edge->chi = *dxptr;
-                    edge->left = nodeptr;
-                    edge->right = nodeptr+1;
+                    edge->left = (int)(nodeptr-node);
+                    edge->right = (int)(nodeptr-node)+1;
                     edge++;
                     Ne++;
                 }
@@ -857,16 +882,16 @@ static int preprocessMSER_8UC3( MSCRNode* node,
                     if ( maskptr[-mask->step] )
                     {
                         *total += edge->chi = *dyptr;
-                        edge->left = nodeptr-src->cols;
-                        edge->right = nodeptr;
+                        edge->left = (int)(nodeptr-node)-src->cols;
+                        edge->right = (int)(nodeptr-node);
                         edge++;
                         Ne++;
                     }
                     if ( maskptr[1] )
                     {
                         *total += edge->chi = *dxptr;
-                        edge->left = nodeptr;
-                        edge->right = nodeptr+1;
+                        edge->left = (int)(nodeptr-node);
+                        edge->right = (int)(nodeptr-node)+1;
                         edge++;
                         Ne++;
                     }
@@ -881,8 +906,8 @@ static int preprocessMSER_8UC3( MSCRNode* node,
             if ( maskptr[0] && maskptr[-mask->step] )
             {
                 *total += edge->chi = *dyptr;
-                edge->left = nodeptr-src->cols;
-                edge->right = nodeptr;
+                edge->left = (int)(nodeptr-node)-src->cols;
+                edge->right = (int)(nodeptr-node);
                 edge++;
                 Ne++;
             }
@@ -897,16 +922,16 @@ static int preprocessMSER_8UC3( MSCRNode* node,
             if ( maskptr[1] )
             {
                 *total += edge->chi = *dxptr;
-                edge->left = nodeptr;
-                edge->right = nodeptr+1;
+                edge->left = (int)(nodeptr-node);
+                edge->right = (int)(nodeptr-node)+1;
                 edge++;
                 Ne++;
             }
             if ( maskptr[-mask->step] )
             {
                 *total += edge->chi = *dyptr;
-                edge->left = nodeptr-src->cols;
-                edge->right = nodeptr;
+                edge->left = (int)(nodeptr-node)-src->cols;
+                edge->right = (int)(nodeptr-node);
                 edge++;
                 Ne++;
             }
@@ -924,16 +949,16 @@ static int preprocessMSER_8UC3( MSCRNode* node,
                 if ( maskptr[1] )
                 {
                     *total += edge->chi = *dxptr;
-                    edge->left = nodeptr;
-                    edge->right = nodeptr+1;
+                    edge->left = (int)(nodeptr-node);
+                    edge->right = (int)(nodeptr-node)+1;
                     edge++;
                     Ne++;
                 }
                 if ( maskptr[-mask->step] )
                 {
                     *total += edge->chi = *dyptr;
-                    edge->left = nodeptr-src->cols;
-                    edge->right = nodeptr;
+                    edge->left = (int)(nodeptr-node)-src->cols;
+                    edge->right = (int)(nodeptr-node);
                     edge++;
                     Ne++;
                 }
@@ -948,8 +973,8 @@ static int preprocessMSER_8UC3( MSCRNode* node,
         if ( maskptr[0] && maskptr[-mask->step] )
         {
             *total += edge->chi = *dyptr;
-            edge->left = nodeptr-src->cols;
-            edge->right = nodeptr;
+            edge->left = (int)(nodeptr-node)-src->cols;
+            edge->right = (int)(nodeptr-node);
             Ne++;
         }
     } else {
@@ -958,8 +983,8 @@ static int preprocessMSER_8UC3( MSCRNode* node,
         nodeptr->index = 0;
         *total += edge->chi = *dxptr;
         dxptr++;
-        edge->left = nodeptr;
-        edge->right = nodeptr+1;
+        edge->left = (int)(nodeptr-node);
+        edge->right = (int)(nodeptr-node)+1;
         edge++;
         nodeptr++;
         for ( int i = 1; i < src->cols-1; i++ )
@@ -968,8 +993,8 @@ static int preprocessMSER_8UC3( MSCRNode* node,
             nodeptr->index = i;
             *total += edge->chi = *dxptr;
             dxptr++;
-            edge->left = nodeptr;
-            edge->right = nodeptr+1;
+            edge->left = (int)(nodeptr-node);
+            edge->right = (int)(nodeptr-node)+1;
             edge++;
             nodeptr++;
         }
@@ -982,13 +1007,13 @@ static int preprocessMSER_8UC3( MSCRNode* node,
             nodeptr->index = i<<16;
             *total += edge->chi = *dyptr;
             dyptr++;
-            edge->left = nodeptr-src->cols;
-            edge->right = nodeptr;
+            edge->left = (int)(nodeptr-node)-src->cols;
+            edge->right = (int)(nodeptr-node);
             edge++;
             *total += edge->chi = *dxptr;
             dxptr++;
-            edge->left = nodeptr;
-            edge->right = nodeptr+1;
+            edge->left = (int)(nodeptr-node);
+            edge->right = (int)(nodeptr-node)+1;
             edge++;
             nodeptr++;
             for ( int j = 1; j < src->cols-1; j++ )
@@ -997,13 +1022,13 @@ static int preprocessMSER_8UC3( MSCRNode* node,
                 nodeptr->index = (i<<16)|j;
                 *total += edge->chi = *dyptr;
                 dyptr++;
-                edge->left = nodeptr-src->cols;
-                edge->right = nodeptr;
+                edge->left = (int)(nodeptr-node)-src->cols;
+                edge->right = (int)(nodeptr-node);
                 edge++;
                 *total += edge->chi = *dxptr;
                 dxptr++;
-                edge->left = nodeptr;
-                edge->right = nodeptr+1;
+                edge->left = (int)(nodeptr-node);
+                edge->right = (int)(nodeptr-node)+1;
                 edge++;
                 nodeptr++;
             }
@@ -1011,8 +1036,8 @@ static int preprocessMSER_8UC3( MSCRNode* node,
             nodeptr->index = (i<<16)|(src->cols-1);
             *total += edge->chi = *dyptr;
             dyptr++;
-            edge->left = nodeptr-src->cols;
-            edge->right = nodeptr;
+            edge->left = (int)(nodeptr-node)-src->cols;
+            edge->right = (int)(nodeptr-node);
             edge++;
             nodeptr++;
         }
@@ -1020,13 +1045,13 @@ static int preprocessMSER_8UC3( MSCRNode* node,
         nodeptr->index = (src->rows-1)<<16;
         *total += edge->chi = *dxptr;
         dxptr++;
-        edge->left = nodeptr;
-        edge->right = nodeptr+1;
+        edge->left = (int)(nodeptr-node);
+        edge->right = (int)(nodeptr-node)+1;
         edge++;
         *total += edge->chi = *dyptr;
         dyptr++;
-        edge->left = nodeptr-src->cols;
-        edge->right = nodeptr;
+        edge->left = (int)(nodeptr-node)-src->cols;
+        edge->right = (int)(nodeptr-node);
         edge++;
         nodeptr++;
         for ( int i = 1; i < src->cols-1; i++ )
@@ -1035,51 +1060,85 @@ static int preprocessMSER_8UC3( MSCRNode* node,
             nodeptr->index = ((src->rows-1)<<16)|i;
             *total += edge->chi = *dxptr;
             dxptr++;
-            edge->left = nodeptr;
-            edge->right = nodeptr+1;
+            edge->left = (int)(nodeptr-node);
+            edge->right = (int)(nodeptr-node)+1;
             edge++;
             *total += edge->chi = *dyptr;
             dyptr++;
-            edge->left = nodeptr-src->cols;
-            edge->right = nodeptr;
+            edge->left = (int)(nodeptr-node)-src->cols;
+            edge->right = (int)(nodeptr-node);
             edge++;
             nodeptr++;
         }
         initMSCRNode( nodeptr );
         nodeptr->index = ((src->rows-1)<<16)|(src->cols-1);
         *total += edge->chi = *dyptr;
-        edge->left = nodeptr-src->cols;
-        edge->right = nodeptr;
+        edge->left = (int)(nodeptr-node)-src->cols;
+        edge->right = (int)(nodeptr-node);
     }
     return Ne;
 }
 
-#define cmp_mscr_edge(edge1, edge2) \
-    ((edge1).chi < (edge2).chi)
+// maps a double to an unsigned integer with the same ordering (IEEE 754 sign-magnitude to offset binary)
+static inline uint64 MSCREdgeKey( double chi )
+{
+    Cv64suf key;
+    key.f = chi;
+    return key.i < 0 ? ~key.u : key.u | ((uint64)1 << 63);
+}
+
+// sort the edges by ascending distance; it is a LSD radix sort (linear in the number of edges),
+// so the edges with the same distance keep their raster order
+static void RadixSortMSCREdge( MSCREdge* edge, int Ne )
+{
+    const int RADIX_BITS = 11, RADIX = 1 << RADIX_BITS, PASSES = 6;
+    AutoBuffer<int> _hist(RADIX*PASSES);
+    int* hist = _hist;
+    memset( hist, 0, RADIX*PASSES*sizeof(hist[0]) );
+    for ( int i = 0; i < Ne; i++ )
+    {
+        uint64 key = MSCREdgeKey( edge[i].chi );
+        for ( int p = 0; p < PASSES; p++ )
+            hist[p*RADIX+(int)((key >> (p*RADIX_BITS))&(RADIX-1))]++;
+    }
 
-static CV_IMPLEMENT_QSORT( QuickSortMSCREdge, MSCREdge, cmp_mscr_edge )
+    AutoBuffer<MSCREdge> _buf(Ne);
+    MSCREdge* src = edge;
+    MSCREdge* dst = _buf;
+    for ( int p = 0; p < PASSES; p++ )
+    {
+        int shift = p*RADIX_BITS;
+        int* ofs = hist+p*RADIX;
+        // skip the digits that are the same for all the edges
+        if ( ofs[(int)((MSCREdgeKey( src[0].chi ) >> shift)&(RADIX-1))] == Ne )
+            continue;
+        for ( int i = 0, sum = 0; i < RADIX; i++ )
+        {
+            int count = ofs[i];
+            ofs[i] = sum;
+            sum += count;
+        }
+        for ( int i = 0; i < Ne; i++ )
+            dst[ofs[(int)((MSCREdgeKey( src[i].chi ) >> shift)&(RADIX-1))]++] = src[i];
+        std::swap( src, dst );
+    }
+    if ( src != edge )
+        memcpy( edge, src, Ne*sizeof(edge[0]) );
+}
 
 // to find the root of one region
-static MSCRNode* findMSCR( MSCRNode* x )
+static int findMSCR( int* shortcut, int x )
 {
-    MSCRNode* prev = x;
-    MSCRNode* next;
-    for ( ; ; )
+    int root = x;
+    while ( shortcut[root] != root )
+        root = shortcut[root];
+    // make the finding of root less painful next time
+    while ( shortcut[x] != root )
     {
-        next = x->shortcut;
-        x->shortcut = prev;
-        if ( next == x ) break;
-        prev= x;
+        int next = shortcut[x];
+        shortcut[x] = root;
         x = next;
     }
-    MSCRNode* root = x;
-    for ( ; ; )
-    {
-        prev = x->shortcut;
-        x->shortcut = root;
-        if ( prev == x ) break;
-        x = prev;
-    }
     return root;
 }
 
@@ -1097,13 +1156,15 @@ static bool MSCRStableCheck( MSCRNode* x, MSERParams params )
 }
 
 static void
-extractMSER_8UC3( CvMat* src,
-             CvMat* mask,
-             CvSeq* contours,
-             CvMemStorage* storage,
+extractMSER_8UC3( const CvMat* src,
+             const CvMat* mask,
+             vector<vector<Point> >& msers,
              MSERParams params )
 {
     MSCRNode* map = (MSCRNode*)cvAlloc( src->cols*src->rows*sizeof(map[0]) );
+    int* shortcut = (int*)cvAlloc( src->cols*src->rows*sizeof(shortcut[0]) );
+    for ( int i = 0; i < src->cols*src->rows; i++ )
+        shortcut[i] = i;
     int Ne = src->cols*src->rows*2-src->cols-src->rows;
     MSCREdge* edge = (MSCREdge*)cvAlloc( Ne*sizeof(edge[0]) );
     TempMSCR* mscr = (TempMSCR*)cvAlloc( src->cols*src->rows*sizeof(mscr[0]) );
@@ -1112,7 +1173,11 @@ extractMSER_8UC3( CvMat* src,
     CvMat* dy = cvCreateMat( src->rows-1, src->cols, CV_64FC1 );
     Ne = preprocessMSER_8UC3( map, edge, &emean, src, mask, dx, dy, Ne, params.edgeBlurSize );
     emean = emean / (double)Ne;
-    QuickSortMSCREdge( edge, Ne, 0 );
+    if ( Ne > 0 )
+        RadixSortMSCREdge( edge, Ne );
+    // the evolution below relies on the order, and checking it is much cheaper than the sort
+    for ( int i = 1; i < Ne; i++ )
+        CV_Assert( edge[i-1].chi <= edge[i].chi );
     MSCREdge* edge_ub = edge+Ne;
     MSCREdge* edgeptr = edge;
     TempMSCR* mscrptr = mscr;
@@ -1126,8 +1191,8 @@ extractMSER_8UC3( CvMat* src,
         // to process all the edges in the list that chi < thres
         while ( edgeptr < edge_ub && edgeptr->chi < thres )
         {
-            MSCRNode* lr = findMSCR( edgeptr->left );
-            MSCRNode* rr = findMSCR( edgeptr->right );
+            MSCRNode* lr = map+findMSCR( shortcut, edgeptr->left );
+            MSCRNode* rr = map+findMSCR( shortcut, edgeptr->right );
             // get the region root (who is responsible)
             if ( lr != rr )
             {
@@ -1145,7 +1210,7 @@ extractMSER_8UC3( CvMat* src,
                     }
                     lr->rank++;
                 }
-                rr->shortcut = lr;
+                shortcut[rr-map] = (int)(lr-map);
                 lr->size += rr->size;
                 // join rr to the end of list lr (lr is a endless double-linked list)
                 lr->prev->next = rr;
@@ -1197,45 +1262,39 @@ extractMSER_8UC3( CvMat* src,
         // to prune area with margin less than minMargin
         if ( ptr->m > params.minMargin )
         {
-            CvSeq* _contour = cvCreateSeq( CV_SEQ_KIND_GENERIC|CV_32SC2, sizeof(CvContour), sizeof(CvPoint), storage );
-            cvSeqPushMulti( _contour, 0, ptr->size );
+            msers.push_back( vector<Point>() );
+            vector<Point>& pts = msers.back();
+            pts.resize( ptr->size );
             MSCRNode* lpt = ptr->head;
             for ( int i = 0; i < ptr->size; i++ )
             {
-                CvPoint* pt = CV_GET_SEQ_ELEM( CvPoint, _contour, i );
-                pt->x = (lpt->index)&0xffff;
-                pt->y = (lpt->index)>>16;
+                pts[i].x = (lpt->index)&0xffff;
+                pts[i].y = (lpt->index)>>16;
                 lpt = lpt->next;
             }
-            CvContour* contour = (CvContour*)_contour;
-            cvBoundingRect( contour );
-            contour->color = 0;
-            cvSeqPush( contours, &contour );
         }
     cvReleaseMat( &dx );
     cvReleaseMat( &dy );
     cvFree( &mscr );
     cvFree( &edge );
+    cvFree( &shortcut );
     cvFree( &map );
 }
 
 static void
-extractMSER( CvArr* _img,
-           CvArr* _mask,
-           CvSeq** _contours,
-           CvMemStorage* storage,
+extractMSER( const Mat& image,
+           const Mat& _mask,
+           vector<vector<Point> >& msers,
            MSERParams params )
 {
-    CvMat srchdr, *src = cvGetMat( _img, &srchdr );
-    CvMat maskhdr, *mask = _mask ? cvGetMat( _mask, &maskhdr ) : 0;
-    CvSeq* contours = 0;
+    CvMat srchdr = image, *src = &srchdr;
+    CvMat maskhdr, *mask = _mask.data ? &(maskhdr = _mask) : 0;
 
-    CV_Assert(src != 0);
+    CV_Assert(src->data.ptr != 0);
     CV_Assert(CV_MAT_TYPE(src->type) == CV_8UC1 || CV_MAT_TYPE(src->type) == CV_8UC3);
     CV_Assert(mask == 0 || (CV_ARE_SIZES_EQ(src, mask) && CV_MAT_TYPE(mask->type) == CV_8UC1));
-    CV_Assert(storage != 0);
 
-    contours = *_contours = cvCreateSeq( 0, sizeof(CvSeq), sizeof(CvSeq*), storage );
+    msers.clear();
 
     // choose different method for different image type
     // for grey image, it is: Linear Time Maximally Stable Extremal Regions
@@ -1243,10 +1302,10 @@ extractMSER( CvArr* _img,
     switch ( CV_MAT_TYPE(src->type) )
     {
         case CV_8UC1:
-            extractMSER_8UC1( src, mask, contours, storage, params );
+            extractMSER_8UC1( src, mask, msers, params );
             break;
         case CV_8UC3:
-            extractMSER_8UC3( src, mask, contours, storage, params );
+            extractMSER_8UC3( src, mask, msers, params );
             break;
     }
 }
@@ -1265,19 +1324,9 @@ MSER::MSER( int _delta, int _min_area, int _max_area,
 
 void MSER::operator()( const Mat& image, vector<vector<Point> >& dstcontours, const Mat& mask ) const
 {
-    CvMat _image = image, _mask, *pmask = 0;
-    if( mask.data )
-        pmask = &(_mask = mask);
-    MemStorage storage(cvCreateMemStorage(0));
-    Seq<CvSeq*> contours;
-    extractMSER( &_image, pmask, &contours.seq, storage,
+    extractMSER( image, mask, dstcontours,
                  MSERParams(delta, minArea, maxArea, maxVariation, minDiversity,
                             maxEvolution, areaThreshold, minMargin, edgeBlurSize));
-    SeqIterator<CvSeq*> it = contours.begin();
-    size_t i, ncontours = contours.size();
-    dstcontours.resize(ncontours);
-    for( i = 0; i < ncontours; i++, ++it )
-        Seq<Point>(*it).copyTo(dstcontours[i]);
 }
 
 
@@ -249,6 +249,64 @@ static void computeOrbDescriptor(const KeyPoint& kpt,
 }
 
 
+#if CV_SSE2
+/** The WTA_K == 2 descriptor computed 16 bit tests at a time. The rotated sample points are rounded the same way
+ * cvRound() does it, so the result is identical to the one of computeOrbDescriptor(); dsize must be even
+ */
+static void computeOrbDescriptor_SSE2(const KeyPoint& kpt, const Mat& img, const Point* pattern,
+                                      uchar* desc, int dsize)
+{
+    float angle = kpt.angle;
+    angle *= (float)(CV_PI/180.f);
+    float a = (float)cos(angle), b = (float)sin(angle);
+
+    const uchar* center = &img.at<uchar>(cvRound(kpt.pt.y), cvRound(kpt.pt.x));
+    int step = (int)img.step;
+
+    const int npoints = 32; // 16 point pairs, 2 descriptor bytes
+    int CV_DECL_ALIGNED(16) ofs[npoints];
+    uchar CV_DECL_ALIGNED(16) vals[npoints];
+    __m128 va = _mm_set1_ps(a), vb = _mm_set1_ps(b);
+    __m128i vstep = _mm_set1_epi32(step), vmask = _mm_set1_epi16(0xff);
+
+    for( int i = 0; i < dsize; i += 2, pattern += npoints )
+    {
+        for( int k = 0; k < npoints; k += 4 )
+        {
+            // (x0, y0, x1, y1), (x2, y2, x3, y3) -> (x0, x1, x2, x3), (y0, y1, y2, y3)
+            __m128 p0 = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(pattern + k)));
+            __m128 p1 = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(pattern + k + 2)));
+            __m128 px = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 py = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1));
+
+            __m128i ix = _mm_cvtps_epi32(_mm_sub_ps(_mm_mul_ps(px, va), _mm_mul_ps(py, vb)));
+            __m128i iy = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(px, vb), _mm_mul_ps(py, va)));
+
+            // the low 32 bits of iy*step, SSE2 has no 32-bit multiplication
+            __m128i e = _mm_mul_epu32(iy, vstep);
+            __m128i o = _mm_mul_epu32(_mm_srli_si128(iy, 4), _mm_srli_si128(vstep, 4));
+            __m128i ystep = _mm_unpacklo_epi32(_mm_shuffle_epi32(e, _MM_SHUFFLE(0, 0, 2, 0)),
+                                               _mm_shuffle_epi32(o, _MM_SHUFFLE(0, 0, 2, 0)));
+            _mm_store_si128((__m128i*)(ofs + k), _mm_add_epi32(ystep, ix));
+        }
+
+        for( int k = 0; k < npoints; k++ )
+            vals[k] = center[ofs[k]];
+
+        // the first point of a pair is in the low byte of a 16-bit word, the second one in the high byte
+        __m128i v0 = _mm_load_si128((const __m128i*)vals);
+        __m128i v1 = _mm_load_si128((const __m128i*)(vals + 16));
+        __m128i lt0 = _mm_cmplt_epi16(_mm_and_si128(v0, vmask), _mm_srli_epi16(v0, 8));
+        __m128i lt1 = _mm_cmplt_epi16(_mm_and_si128(v1, vmask), _mm_srli_epi16(v1, 8));
+        int bits = _mm_movemask_epi8(_mm_packs_epi16(lt0, lt1));
+
+        desc[i] = (uchar)bits;
+        desc[i+1] = (uchar)(bits >> 8);
+    }
+}
+#endif
+
+
 static void initializeOrbPattern( const Point* pattern0, vector<Point>& pattern, int ntuples, int tupleSize, int poolSize )
 {
     RNG rng(0x12345678);
@@ -586,32 +644,116 @@ void ORB::operator()(InputArray image, InputArray mask, vector<KeyPoint>& keypoi
 }
 
 
-/** Compute the ORB keypoint orientations
- * @param image the image to compute the features and descriptors on
- * @param integral_image the integral image of the iamge (can be empty, but the computation will be slower)
- * @param scale the scale at which we compute the orientation
- * @param keypoints the resulting keypoints
+/** Computes the ORB keypoint orientations, the keypoints are split into blocks processed in parallel
+ * @param imagePyramid the image pyramid, the keypoint octave is the pyramid level it belongs to
+ * @param keypoints the keypoints of all the levels, with the coordinates at their level scale
  */
-static void computeOrientation(const Mat& image, vector<KeyPoint>& keypoints,
-                               int halfPatchSize, const vector<int>& umax)
+class ORBOrientationInvoker : public ParallelLoopBody
 {
-    // Process each keypoint
-    for (vector<KeyPoint>::iterator keypoint = keypoints.begin(),
-         keypointEnd = keypoints.end(); keypoint != keypointEnd; ++keypoint)
+public:
+    ORBOrientationInvoker(const vector<Mat>& _imagePyramid, vector<KeyPoint>& _keypoints,
+                          int _halfPatchSize, const vector<int>& _umax)
+        : imagePyramid(&_imagePyramid), keypoints(&_keypoints),
+          halfPatchSize(_halfPatchSize), umax(&_umax)
     {
-        keypoint->angle = IC_Angle(image, halfPatchSize, keypoint->pt, umax);
     }
-}
+
+    void operator()(const Range& range) const
+    {
+        for( int i = range.start; i < range.end; i++ )
+        {
+            KeyPoint& kpt = (*keypoints)[i];
+            kpt.angle = IC_Angle((*imagePyramid)[kpt.octave], halfPatchSize, kpt.pt, *umax);
+        }
+    }
+
+private:
+    const vector<Mat>* imagePyramid;
+    vector<KeyPoint>* keypoints;
+    int halfPatchSize;
+    const vector<int>* umax;
+};
+
+
+/** Detects the ORB keypoints, every pyramid level is processed by its own task
+ * @param imagePyramid the image pyramid to compute the features on
+ * @param maskPyramid the masks to apply at every level
+ * @param allKeypoints the resulting keypoints, clustered per level
+ */
+class ORBLevelDetector : public ParallelLoopBody
+{
+public:
+    ORBLevelDetector(const vector<Mat>& _imagePyramid, const vector<Mat>& _maskPyramid,
+                     const vector<int>& _nfeaturesPerLevel, vector<vector<KeyPoint> >& _allKeypoints,
+                     int _firstLevel, double _scaleFactor, int _edgeThreshold, int _patchSize, int _scoreType)
+        : imagePyramid(&_imagePyramid), maskPyramid(&_maskPyramid),
+          nfeaturesPerLevel(&_nfeaturesPerLevel), allKeypoints(&_allKeypoints),
+          firstLevel(_firstLevel), scaleFactor(_scaleFactor), edgeThreshold(_edgeThreshold),
+          patchSize(_patchSize), scoreType(_scoreType)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        for( int level = range.start; level < range.end; level++ )
+        {
+            int featuresNum = (*nfeaturesPerLevel)[level];
+            const Mat& image = (*imagePyramid)[level];
+            vector<KeyPoint> & keypoints = (*allKeypoints)[level];
+            keypoints.reserve(featuresNum*2);
+
+            // Detect FAST features, 20 is a good threshold
+            FastFeatureDetector fd(20, true);
+            fd.detect(image, keypoints, (*maskPyramid)[level]);
+
+            // Remove keypoints very close to the border
+            KeyPointsFilter::runByImageBorder(keypoints, image.size(), edgeThreshold);
+
+            if( scoreType == ORB::HARRIS_SCORE )
+            {
+                // Keep more points than necessary as FAST does not give amazing corners
+                KeyPointsFilter::retainBest(keypoints, 2 * featuresNum);
+
+                // Compute the Harris cornerness (better scoring than FAST)
+                HarrisResponses(image, keypoints, 7, HARRIS_K);
+            }
+
+            //cull to the final desired level, using the new Harris scores or the original FAST scores.
+            KeyPointsFilter::retainBest(keypoints, featuresNum);
+
+            float sf = getScale(level, firstLevel, scaleFactor);
+
+            // Set the level of the coordinates
+            for (vector<KeyPoint>::iterator keypoint = keypoints.begin(),
+                 keypointEnd = keypoints.end(); keypoint != keypointEnd; ++keypoint)
+            {
+                keypoint->octave = level;
+                keypoint->size = patchSize*sf;
+            }
+        }
+    }
+
+private:
+    const vector<Mat>* imagePyramid;
+    const vector<Mat>* maskPyramid;
+    const vector<int>* nfeaturesPerLevel;
+    vector<vector<KeyPoint> >* allKeypoints;
+    int firstLevel;
+    double scaleFactor;
+    int edgeThreshold;
+    int patchSize;
+    int scoreType;
+};
 
 
 /** Compute the ORB keypoints on an image
  * @param image_pyramid the image pyramid to compute the features and descriptors on
  * @param mask_pyramid the masks to apply at every level
- * @param keypoints the resulting keypoints, clustered per level
+ * @param keypoints the resulting keypoints, ordered by level
  */
 static void computeKeyPoints(const vector<Mat>& imagePyramid,
                              const vector<Mat>& maskPyramid,
-                             vector<vector<KeyPoint> >& allKeypoints,
+                             vector<KeyPoint>& keypoints,
                              int nfeatures, int firstLevel, double scaleFactor,
                              int edgeThreshold, int patchSize, int scoreType )
 {
@@ -652,67 +794,99 @@ static void computeKeyPoints(const vector<Mat>& imagePyramid,
         ++v0;
     }
 
-    allKeypoints.resize(nlevels);
+    vector<vector<KeyPoint> > allKeypoints(nlevels);
+    parallel_for_(Range(0, nlevels),
+                  ORBLevelDetector(imagePyramid, maskPyramid, nfeaturesPerLevel, allKeypoints,
+                                   firstLevel, scaleFactor, edgeThreshold, patchSize, scoreType));
 
+    keypoints.clear();
     for (int level = 0; level < nlevels; ++level)
-    {
-        int featuresNum = nfeaturesPerLevel[level];
-        allKeypoints[level].reserve(featuresNum*2);
+        keypoints.insert(keypoints.end(), allKeypoints[level].begin(), allKeypoints[level].end());
 
-        vector<KeyPoint> & keypoints = allKeypoints[level];
+    parallel_for_(Range(0, (int)keypoints.size()),
+                  ORBOrientationInvoker(imagePyramid, keypoints, halfPatchSize, umax));
+}
 
-        // Detect FAST features, 20 is a good threshold
-        FastFeatureDetector fd(20, true);
-        fd.detect(imagePyramid[level], keypoints, maskPyramid[level]);
 
-        // Remove keypoints very close to the border
-        KeyPointsFilter::runByImageBorder(keypoints, imagePyramid[level].size(), edgeThreshold);
+/** Smoothes the pyramid levels before computing the descriptors
+ * @param imagePyramid the image pyramid, with the borders already made
+ * @param levelUsed non-zero for the levels that have keypoints
+ */
+class ORBLevelPreprocessor : public ParallelLoopBody
+{
+public:
+    ORBLevelPreprocessor(vector<Mat>& _imagePyramid, const vector<uchar>& _levelUsed)
+        : imagePyramid(&_imagePyramid), levelUsed(&_levelUsed)
+    {
+    }
 
-        if( scoreType == ORB::HARRIS_SCORE )
+    void operator()(const Range& range) const
+    {
+        for( int level = range.start; level < range.end; level++ )
         {
-            // Keep more points than necessary as FAST does not give amazing corners
-            KeyPointsFilter::retainBest(keypoints, 2 * featuresNum);
-
-            // Compute the Harris cornerness (better scoring than FAST)
-            HarrisResponses(imagePyramid[level], keypoints, 7, HARRIS_K);
-        }
-
-        //cull to the final desired level, using the new Harris scores or the original FAST scores.
-        KeyPointsFilter::retainBest(keypoints, featuresNum);
-
-        float sf = getScale(level, firstLevel, scaleFactor);
+            if( !(*levelUsed)[level] )
+                continue;
 
-        // Set the level of the coordinates
-        for (vector<KeyPoint>::iterator keypoint = keypoints.begin(),
-             keypointEnd = keypoints.end(); keypoint != keypointEnd; ++keypoint)
-        {
-            keypoint->octave = level;
-            keypoint->size = patchSize*sf;
+            Mat& workingMat = (*imagePyramid)[level];
+            // preprocess the resized image
+            //boxFilter(working_mat, working_mat, working_mat.depth(), Size(5,5), Point(-1,-1), true, BORDER_REFLECT_101);
+            GaussianBlur(workingMat, workingMat, Size(7, 7), 2, 2, BORDER_REFLECT_101);
         }
-
-        computeOrientation(imagePyramid[level], keypoints, halfPatchSize, umax);
     }
-}
+
+private:
+    vector<Mat>* imagePyramid;
+    const vector<uchar>* levelUsed;
+};
 
 
-/** Compute the ORB decriptors
- * @param image the image to compute the features and descriptors on
- * @param integral_image the integral image of the image (can be empty, but the computation will be slower)
- * @param level the scale at which we compute the orientation
+/** Compute the ORB decriptors, the keypoints are split into blocks processed in parallel
+ * @param imagePyramid the smoothed image pyramid, the keypoint octave is the pyramid level it belongs to
  * @param keypoints the keypoints to use
- * @param descriptors the resulting descriptors
+ * @param descriptors the resulting descriptors, one row per keypoint
  */
-static void computeDescriptors(const Mat& image, vector<KeyPoint>& keypoints, Mat& descriptors,
-                               const vector<Point>& pattern, int dsize, int WTA_K)
+class ORBDescriptorInvoker : public ParallelLoopBody
 {
-    //convert to grayscale if more than one color
-    CV_Assert(image.type() == CV_8UC1);
-    //create the descriptor mat, keypoints.size() rows, BYTES cols
-    descriptors = Mat::zeros((int)keypoints.size(), dsize, CV_8UC1);
+public:
+    ORBDescriptorInvoker(const vector<Mat>& _imagePyramid, const vector<KeyPoint>& _keypoints,
+                         Mat& _descriptors, const vector<Point>& _pattern, int _dsize, int _WTA_K)
+        : imagePyramid(&_imagePyramid), keypoints(&_keypoints), descriptors(&_descriptors),
+          pattern(&_pattern), dsize(_dsize), WTA_K(_WTA_K)
+    {
+#if CV_SSE2
+        useSIMD = WTA_K == 2 && dsize % 2 == 0 && checkHardwareSupport(CV_CPU_SSE2);
+#else
+        useSIMD = false;
+#endif
+    }
 
-    for (size_t i = 0; i < keypoints.size(); i++)
-        computeOrbDescriptor(keypoints[i], image, &pattern[0], descriptors.ptr((int)i), dsize, WTA_K);
-}
+    void operator()(const Range& range) const
+    {
+        for( int i = range.start; i < range.end; i++ )
+        {
+            const KeyPoint& kpt = (*keypoints)[i];
+#if CV_SSE2
+            if( useSIMD )
+            {
+                computeOrbDescriptor_SSE2(kpt, (*imagePyramid)[kpt.octave], &(*pattern)[0],
+                                          descriptors->ptr(i), dsize);
+                continue;
+            }
+#endif
+            computeOrbDescriptor(kpt, (*imagePyramid)[kpt.octave], &(*pattern)[0],
+                                 descriptors->ptr(i), dsize, WTA_K);
+        }
+    }
+
+private:
+    const vector<Mat>* imagePyramid;
+    const vector<KeyPoint>* keypoints;
+    Mat* descriptors;
+    const vector<Point>* pattern;
+    int dsize;
+    int WTA_K;
+    bool useSIMD;
+};
 
 
 /** Compute the ORB features and descriptors on an image
@@ -762,7 +936,8 @@ void ORB::operator()( InputArray _image, InputArray _mask, vector<KeyPoint>& _ke
         levelsNum++;
     }
 
-    // Pre-compute the scale pyramids
+    // Pre-compute the scale pyramids. Every level is resized from the previous one, so this part is
+    // sequential; the borders are made here, as the orientation and the Harris score read them too
     vector<Mat> imagePyramid(levelsNum), maskPyramid(levelsNum);
     for (int level = 0; level < levelsNum; ++level)
     {
@@ -814,29 +989,12 @@ void ORB::operator()( InputArray _image, InputArray _mask, vector<KeyPoint>& _ke
     }
 
     // Pre-compute the keypoints (we keep the best over all scales, so this has to be done beforehand
-    vector < vector<KeyPoint> > allKeypoints;
     if( do_keypoints )
     {
         // Get keypoints, those will be far enough from the border that no check will be required for the descriptor
-        computeKeyPoints(imagePyramid, maskPyramid, allKeypoints,
+        computeKeyPoints(imagePyramid, maskPyramid, _keypoints,
                          nfeatures, firstLevel, scaleFactor,
                          edgeThreshold, patchSize, scoreType);
-
-        // make sure we have the right number of keypoints keypoints
-        /*vector<KeyPoint> temp;
-
-        for (int level = 0; level < n_levels; ++level)
-        {
-            vector<KeyPoint>& keypoints = all_keypoints[level];
-            temp.insert(temp.end(), keypoints.begin(), keypoints.end());
-            keypoints.clear();
-        }
-
-        KeyPoint::retainBest(temp, n_features_);
-
-        for (vector<KeyPoint>::iterator keypoint = temp.begin(),
-             keypoint_end = temp.end(); keypoint != keypoint_end; ++keypoint)
-            all_keypoints[keypoint->octave].push_back(*keypoint);*/
     }
     else
     {
@@ -844,33 +1002,34 @@ void ORB::operator()( InputArray _image, InputArray _mask, vector<KeyPoint>& _ke
         KeyPointsFilter::runByImageBorder(_keypoints, image.size(), edgeThreshold);
 
         // Cluster the input keypoints depending on the level they were computed at
-        allKeypoints.resize(levelsNum);
+        vector < vector<KeyPoint> > allKeypoints(levelsNum);
         for (vector<KeyPoint>::iterator keypoint = _keypoints.begin(),
              keypointEnd = _keypoints.end(); keypoint != keypointEnd; ++keypoint)
             allKeypoints[keypoint->octave].push_back(*keypoint);
 
         // Make sure we rescale the coordinates
+        _keypoints.clear();
         for (int level = 0; level < levelsNum; ++level)
         {
-            if (level == firstLevel)
-                continue;
-
             vector<KeyPoint> & keypoints = allKeypoints[level];
-            float scale = 1/getScale(level, firstLevel, scaleFactor);
-            for (vector<KeyPoint>::iterator keypoint = keypoints.begin(),
-                 keypointEnd = keypoints.end(); keypoint != keypointEnd; ++keypoint)
-                keypoint->pt *= scale;
+            if (level != firstLevel)
+            {
+                float scale = 1/getScale(level, firstLevel, scaleFactor);
+                for (vector<KeyPoint>::iterator keypoint = keypoints.begin(),
+                     keypointEnd = keypoints.end(); keypoint != keypointEnd; ++keypoint)
+                    keypoint->pt *= scale;
+            }
+            _keypoints.insert(_keypoints.end(), keypoints.begin(), keypoints.end());
         }
     }
 
-    Mat descriptors;
-    vector<Point> pattern;
+    int nkeypoints = (int)_keypoints.size();
 
     if( do_descriptors )
     {
-        int nkeypoints = 0;
-        for (int level = 0; level < levelsNum; ++level)
-            nkeypoints += (int)allKeypoints[level].size();
+        Mat descriptors;
+        vector<Point> pattern;
+
         if( nkeypoints == 0 )
             _descriptors.release();
         else
@@ -898,43 +1057,25 @@ void ORB::operator()( InputArray _image, InputArray _mask, vector<KeyPoint>& _ke
             int ntuples = descriptorSize()*4;
             initializeOrbPattern(pattern0, pattern, ntuples, WTA_K, npoints);
         }
+
+        vector<uchar> levelUsed(levelsNum, (uchar)0);
+        for (int i = 0; i < nkeypoints; ++i)
+            levelUsed[_keypoints[i].octave] = 1;
+
+        parallel_for_(Range(0, levelsNum), ORBLevelPreprocessor(imagePyramid, levelUsed));
+        parallel_for_(Range(0, nkeypoints),
+                      ORBDescriptorInvoker(imagePyramid, _keypoints, descriptors, pattern, descriptorSize(), WTA_K));
     }
 
-    _keypoints.clear();
-    int offset = 0;
+    // Copy to the output data
+    vector<float> levelScale(levelsNum);
     for (int level = 0; level < levelsNum; ++level)
+        levelScale[level] = getScale(level, firstLevel, scaleFactor);
+    for (int i = 0; i < nkeypoints; ++i)
     {
-        // Get the features and compute their orientation
-        vector<KeyPoint>& keypoints = allKeypoints[level];
-        int nkeypoints = (int)keypoints.size();
-
-        // Compute the descriptors
-        if (do_descriptors)
-        {
-            Mat desc;
-            if (!descriptors.empty())
-            {
-                desc = descriptors.rowRange(offset, offset + nkeypoints);
-            }
-
-            offset += nkeypoints;
-            // preprocess the resized image
-            Mat& workingMat = imagePyramid[level];
-            //boxFilter(working_mat, working_mat, working_mat.depth(), Size(5,5), Point(-1,-1), true, BORDER_REFLECT_101);
-            GaussianBlur(workingMat, workingMat, Size(7, 7), 2, 2, BORDER_REFLECT_101);
-            computeDescriptors(workingMat, keypoints, desc, pattern, descriptorSize(), WTA_K);
-        }
-
-        // Copy to the output data
-        if (level != firstLevel)
-        {
-            float scale = getScale(level, firstLevel, scaleFactor);
-            for (vector<KeyPoint>::iterator keypoint = keypoints.begin(),
-                 keypointEnd = keypoints.end(); keypoint != keypointEnd; ++keypoint)
-                keypoint->pt *= scale;
-        }
-        // And add the keypoints to the output
-        _keypoints.insert(_keypoints.end(), keypoints.begin(), keypoints.end());
+        KeyPoint& keypoint = _keypoints[i];
+        if (keypoint.octave != firstLevel)
+            keypoint.pt *= levelScale[keypoint.octave];
     }
 }
 
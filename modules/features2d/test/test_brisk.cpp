@@ -92,3 +92,46 @@ void CV_BRISKTest::run( int )
 }
 
 TEST(Features2d_BRISK, regression) { CV_BRISKTest test; test.safe_run(); }
+
+TEST(Features2d_BRISK, optimized)
+{
+    RNG rng(7);
+    Mat image(480, 640, CV_8UC1);
+    rng.fill(image, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+    GaussianBlur(image, image, Size(0, 0), 1.5);
+    for( int i = 0; i < 50; i++ )
+    {
+        Point p(rng.uniform(0, image.cols), rng.uniform(0, image.rows));
+        rectangle(image, p, p + Point(rng.uniform(5, 60), rng.uniform(5, 60)), Scalar::all(rng.uniform(0, 256)), -1);
+    }
+
+    BRISK brisk(30, 3);
+    bool prevOptimized = useOptimized();
+    int prevThreads = getNumThreads();
+
+    vector<KeyPoint> refKeypoints;
+    Mat refDescriptors;
+    setUseOptimized(false);
+    setNumThreads(1);
+    brisk(image, noArray(), refKeypoints, refDescriptors, false);
+
+    // the SIMD sampling and the parallel detection and description must reproduce the serial results exactly
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+    setUseOptimized(true);
+    setNumThreads(prevThreads);
+    brisk(image, noArray(), keypoints, descriptors, false);
+
+    setUseOptimized(prevOptimized);
+
+    ASSERT_FALSE(refKeypoints.empty());
+    ASSERT_EQ(refKeypoints.size(), keypoints.size());
+    for( size_t i = 0; i < keypoints.size(); i++ )
+    {
+        EXPECT_EQ(refKeypoints[i].pt, keypoints[i].pt);
+        EXPECT_EQ(refKeypoints[i].size, keypoints[i].size);
+        EXPECT_EQ(refKeypoints[i].angle, keypoints[i].angle);
+        EXPECT_EQ(refKeypoints[i].octave, keypoints[i].octave);
+    }
+    EXPECT_EQ(0, norm(refDescriptors, descriptors, NORM_HAMMING));
+}
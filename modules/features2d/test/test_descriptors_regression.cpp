@@ -331,6 +331,35 @@ TEST( Features2d_DescriptorExtractor_BRIEF, regression )
     test.safe_run();
 }
 
+TEST( Features2d_DescriptorExtractor_BRIEF, optimized )
+{
+    Mat image(480, 640, CV_8UC1);
+    RNG& rng = theRNG();
+    rng.fill(image, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+
+    vector<KeyPoint> keypoints;
+    for( int i = 0; i < 1000; i++ )
+        keypoints.push_back(KeyPoint(rng.uniform(0.f, (float)image.cols), rng.uniform(0.f, (float)image.rows), 7.f));
+
+    bool prevOptimized = useOptimized();
+    for( int bytes = 16; bytes <= 64; bytes *= 2 )
+    {
+        BriefDescriptorExtractor extractor(bytes);
+        vector<KeyPoint> keypoints0 = keypoints, keypoints1 = keypoints;
+        Mat descriptors0, descriptors1;
+
+        setUseOptimized(false);
+        extractor.compute(image, keypoints0, descriptors0);
+        setUseOptimized(true);
+        extractor.compute(image, keypoints1, descriptors1);
+        setUseOptimized(prevOptimized);
+
+        ASSERT_EQ(keypoints0.size(), keypoints1.size());
+        ASSERT_EQ(bytes, descriptors1.cols);
+        ASSERT_EQ(0, norm(descriptors0, descriptors1, NORM_HAMMING));
+    }
+}
+
 TEST( Features2d_DescriptorExtractor_OpponentBRIEF, regression )
 {
     CV_DescriptorExtractorTest<Hamming> test( "descriptor-opponent-brief",  1,
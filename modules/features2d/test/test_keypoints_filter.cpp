@@ -0,0 +1,226 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                        Intel License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000, Intel Corporation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of Intel Corporation may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "test_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+
+static void generateKeypoints( vector<KeyPoint>& keypoints, int n, Size imageSize, RNG& rng )
+{
+    keypoints.resize(n);
+    for( int i = 0; i < n; i++ )
+    {
+        // the positions and the responses are quantized to produce duplicates and ties
+        KeyPoint& kp = keypoints[i];
+        kp.pt = Point2f(rng.uniform(0, imageSize.width*2 - 1)*0.5f, rng.uniform(0, imageSize.height*2 - 1)*0.5f);
+        kp.size = (float)rng.uniform(1, 8);
+        kp.angle = (float)rng.uniform(0, 4)*90.f;
+        kp.response = (float)rng.uniform(0, 100);
+        kp.class_id = i;
+    }
+}
+
+static bool isSameKeypoint( const KeyPoint& a, const KeyPoint& b )
+{
+    return a.pt == b.pt && a.size == b.size && a.angle == b.angle &&
+           a.response == b.response && a.octave == b.octave && a.class_id == b.class_id;
+}
+
+static void checkSameKeypoints( const vector<KeyPoint>& expected, const vector<KeyPoint>& actual )
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for( size_t i = 0; i < expected.size(); i++ )
+        ASSERT_TRUE(isSameKeypoint(expected[i], actual[i])) << "keypoint " << i;
+}
+
+struct KeypointPositionLess
+{
+    bool operator()( const KeyPoint& a, const KeyPoint& b ) const
+    {
+        if( a.pt.x != b.pt.x ) return a.pt.x < b.pt.x;
+        if( a.pt.y != b.pt.y ) return a.pt.y < b.pt.y;
+        if( a.size != b.size ) return a.size < b.size;
+        return a.angle < b.angle;
+    }
+};
+
+TEST(Features2d_KeyPointsFilter, accuracy)
+{
+    RNG rng(17);
+    Size imageSize(640, 480);
+    vector<KeyPoint> keypoints;
+    // long enough to be split into several parallel blocks
+    generateKeypoints(keypoints, 100000, imageSize, rng);
+    int prevThreads = getNumThreads();
+    setNumThreads(std::max(prevThreads, 4));
+
+    // filters keep the order of the remaining keypoints
+    {
+        vector<KeyPoint> expected, actual = keypoints;
+        Rect r(Point(31, 31), Point(imageSize.width - 31, imageSize.height - 31));
+        for( size_t i = 0; i < keypoints.size(); i++ )
+            if( r.contains(keypoints[i].pt) )
+                expected.push_back(keypoints[i]);
+        KeyPointsFilter::runByImageBorder(actual, imageSize, 31);
+        checkSameKeypoints(expected, actual);
+    }
+    {
+        vector<KeyPoint> expected, actual = keypoints;
+        for( size_t i = 0; i < keypoints.size(); i++ )
+            if( keypoints[i].size >= 3 && keypoints[i].size <= 5 )
+                expected.push_back(keypoints[i]);
+        KeyPointsFilter::runByKeypointSize(actual, 3, 5);
+        checkSameKeypoints(expected, actual);
+    }
+    {
+        Mat mask(imageSize, CV_8U, Scalar(0));
+        circle(mask, Point(imageSize.width/2, imageSize.height/2), imageSize.height/3, Scalar(255), -1);
+        vector<KeyPoint> expected, actual = keypoints;
+        for( size_t i = 0; i < keypoints.size(); i++ )
+            if( mask.at<uchar>((int)(keypoints[i].pt.y + 0.5f), (int)(keypoints[i].pt.x + 0.5f)) )
+                expected.push_back(keypoints[i]);
+        KeyPointsFilter::runByPixelsMask(actual, mask);
+        checkSameKeypoints(expected, actual);
+    }
+    {
+        // the strongest one of the duplicates is retained (class_id is unique here and breaks the ties)
+        vector<KeyPoint> expected, actual = keypoints;
+        map<KeyPoint, int, KeypointPositionLess> best;
+        for( size_t i = 0; i < keypoints.size(); i++ )
+        {
+            const KeyPoint& kp = keypoints[i];
+            map<KeyPoint, int, KeypointPositionLess>::iterator it = best.find(kp);
+            if( it == best.end() )
+                best[kp] = (int)i;
+            else
+            {
+                const KeyPoint& prev = keypoints[it->second];
+                if( kp.response > prev.response || (kp.response == prev.response && kp.class_id > prev.class_id) )
+                    it->second = (int)i;
+            }
+        }
+        for( size_t i = 0; i < keypoints.size(); i++ )
+            if( best[keypoints[i]] == (int)i )
+                expected.push_back(keypoints[i]);
+        ASSERT_LT(expected.size(), keypoints.size());
+        KeyPointsFilter::removeDuplicated(actual);
+        checkSameKeypoints(expected, actual);
+    }
+    setNumThreads(prevThreads);
+}
+
+TEST(Features2d_KeyPointsFilter, removeNonMaxima)
+{
+    RNG rng(19);
+    vector<KeyPoint> keypoints;
+    generateKeypoints(keypoints, 5000, Size(200, 150), rng);
+
+    const float radii[] = { 0.5f, 3.f, 10.f };
+    for( int k = 0; k < 3; k++ )
+    {
+        float radius = radii[k];
+        vector<KeyPoint> expected, actual = keypoints;
+        for( size_t i = 0; i < keypoints.size(); i++ )
+        {
+            const KeyPoint& kp = keypoints[i];
+            bool isMax = true;
+            for( size_t j = 0; j < keypoints.size() && isMax; j++ )
+            {
+                const KeyPoint& other = keypoints[j];
+                if( j != i && norm(other.pt - kp.pt) < radius &&
+                    (other.response > kp.response || (other.response == kp.response && j < i)) )
+                    isMax = false;
+            }
+            if( isMax )
+                expected.push_back(kp);
+        }
+        KeyPointsFilter::removeNonMaxima(actual, radius);
+        checkSameKeypoints(expected, actual);
+    }
+}
+
+TEST(Features2d_Detector_Dense, accuracy)
+{
+    Mat image(480, 640, CV_8U, Scalar(0));
+    DenseFeatureDetector detector(1.f, 3, 0.5f, 6, 4, true, true);
+
+    vector<KeyPoint> expected, actual;
+    float scale = 1.f;
+    int step = 6, bound = 4;
+    for( int level = 0; level < 3; level++ )
+    {
+        for( int x = bound; x < image.cols - bound; x += step )
+            for( int y = bound; y < image.rows - bound; y += step )
+                expected.push_back(KeyPoint((float)x, (float)y, scale));
+        scale *= 0.5f;
+        step = (int)(step*0.5f + 0.5f);
+        bound = (int)(bound*0.5f + 0.5f);
+    }
+    detector.detect(image, actual);
+    checkSameKeypoints(expected, actual);
+}
+
+TEST(Features2d_Detector_PyramidFAST, parallelDeterminism)
+{
+    RNG rng(23);
+    Mat image(480, 640, CV_8U);
+    rng.fill(image, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+    GaussianBlur(image, image, Size(0, 0), 2);
+    Mat mask(image.size(), CV_8U, Scalar(255));
+    mask(Rect(100, 100, 200, 150)).setTo(Scalar(0));
+
+    PyramidAdaptedFeatureDetector pyramid(new FastFeatureDetector(5), 3);
+    GridAdaptedFeatureDetector grid(new FastFeatureDetector(5), 2000, 4, 4);
+    FeatureDetector* detectors[] = { &pyramid, &grid };
+
+    int prevThreads = getNumThreads();
+    for( int k = 0; k < 2; k++ )
+    {
+        vector<KeyPoint> expected, actual;
+        setNumThreads(1);
+        detectors[k]->detect(image, expected, mask);
+        setNumThreads(prevThreads);
+        detectors[k]->detect(image, actual, mask);
+        ASSERT_FALSE(expected.empty());
+        checkSameKeypoints(expected, actual);
+    }
+}
@@ -541,3 +541,384 @@ TEST( Features2d_DescriptorMatcher_FlannBased, regression )
     CV_DescriptorMatcherTest test( "descriptor-matcher-flann-based", Algorithm::create<DescriptorMatcher>("DescriptorMatcher.FlannBasedMatcher"), 0.04f );
     test.safe_run();
 }
+
+static bool lessMatch( const DMatch& a, const DMatch& b )
+{
+    return a.distance < b.distance || (a.distance == b.distance &&
+           (a.imgIdx < b.imgIdx || (a.imgIdx == b.imgIdx && a.trainIdx < b.trainIdx)));
+}
+
+static void bfKnnMatchReference( const Mat& query, const vector<Mat>& train, const vector<Mat>& masks,
+                                 int normType, int knn, vector<DMatch>& matches )
+{
+    matches.assign((size_t)query.rows*knn, DMatch());
+    vector<Mat> dists(train.size());
+    for( size_t iIdx = 0; iIdx < train.size(); iIdx++ )
+    {
+        Mat d;
+        batchDistance(query, train[iIdx], d, -1, noArray(), normType);
+        d.convertTo(dists[iIdx], CV_32F);
+    }
+
+    for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+    {
+        vector<DMatch> all;
+        for( size_t iIdx = 0; iIdx < train.size(); iIdx++ )
+            for( int tIdx = 0; tIdx < train[iIdx].rows; tIdx++ )
+                if( masks.empty() || masks[iIdx].at<uchar>(qIdx, tIdx) )
+                    all.push_back(DMatch(qIdx, tIdx, (int)iIdx, dists[iIdx].at<float>(qIdx, tIdx)));
+        int n = std::min(knn, (int)all.size());
+        std::partial_sort(all.begin(), all.begin() + n, all.end(), lessMatch);
+        for( int k = 0; k < n; k++ )
+            matches[(size_t)qIdx*knn + k] = all[k];
+    }
+}
+
+static bool sameMatches( const vector<DMatch>& a, const vector<DMatch>& b )
+{
+    if( a.size() != b.size() )
+        return false;
+    for( size_t i = 0; i < a.size(); i++ )
+        if( a[i].queryIdx != b[i].queryIdx || a[i].trainIdx != b[i].trainIdx ||
+            a[i].imgIdx != b[i].imgIdx || a[i].distance != b[i].distance )
+            return false;
+    return true;
+}
+
+TEST( Features2d_BFMatcher, knnMatchFlat )
+{
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+    const int knn = 3;
+
+    for( int iter = 0; iter < 2; iter++ )
+    {
+        // binary descriptors span two 4 MB cache blocks (the second one partially); float ones
+        // are split into two images with masks, the second one having fewer descriptors than knn
+        bool binary = iter == 0;
+        int normType = binary ? NORM_HAMMING : NORM_L2;
+        int type = binary ? CV_8U : CV_32F, cols = binary ? 32 : 64;
+        Mat query(binary ? 100 : 300, cols, type);
+        vector<Mat> train(binary ? 1 : 2), masks;
+
+        rng.fill(query, RNG::UNIFORM, 0, binary ? 256 : 16);
+        for( size_t i = 0; i < train.size(); i++ )
+        {
+            train[i].create(binary ? 140000 : i == 0 ? 1500 : 2, cols, type);
+            rng.fill(train[i], RNG::UNIFORM, 0, binary ? 256 : 16);
+            if( !binary )
+            {
+                masks.push_back(Mat(query.rows, train[i].rows, CV_8U));
+                rng.fill(masks.back(), RNG::UNIFORM, 0, 2);
+            }
+        }
+
+        vector<DMatch> ref, flat;
+        bfKnnMatchReference(query, train, masks, normType, knn, ref);
+
+        BFMatcher matcher(normType);
+        matcher.add(train);
+        matcher.knnMatchFlat(query, flat, knn, 1.f, masks);
+        ASSERT_TRUE(sameMatches(ref, flat)) << "normType = " << normType;
+
+        vector<vector<DMatch> > nested;
+        matcher.knnMatch(query, nested, knn, masks);
+        ASSERT_EQ(query.rows, (int)nested.size());
+        vector<DMatch> unnested;
+        for( size_t i = 0; i < nested.size(); i++ )
+        {
+            ASSERT_EQ(knn, (int)nested[i].size());
+            unnested.insert(unnested.end(), nested[i].begin(), nested[i].end());
+        }
+        ASSERT_TRUE(sameMatches(ref, unnested));
+
+        const float maxRatio = 0.9f;
+        matcher.knnMatchFlat(query, flat, knn, maxRatio, masks);
+        for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+        {
+            const DMatch* r = &ref[qIdx*knn];
+            bool passed = r[1].trainIdx >= 0 && r[0].distance < maxRatio*r[1].distance;
+            for( int k = 0; k < knn; k++ )
+            {
+                const DMatch& m = flat[qIdx*knn + k];
+                if( passed )
+                    ASSERT_TRUE(m.trainIdx == r[k].trainIdx && m.imgIdx == r[k].imgIdx);
+                else
+                    ASSERT_TRUE(m.queryIdx == -1 && m.trainIdx == -1);
+            }
+        }
+
+        if( binary )
+        {
+            matcher.knnMatchFlat(query, train[0], flat, knn);
+            ASSERT_TRUE(sameMatches(ref, flat));
+        }
+    }
+}
+
+TEST( Features2d_BFMatcher, knnMatchFlatSingleCandidate )
+{
+    // a query with only one neighbour cannot pass the ratio test
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+    const int knn = 2, ntrain = 10;
+    const float maxRatio = 0.8f;
+    Mat query(20, 32, CV_8U), train(ntrain, 32, CV_8U), mask(query.rows, ntrain, CV_8U, Scalar(0));
+    rng.fill(train, RNG::UNIFORM, 0, 256);
+    for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+    {
+        // every query is a copy of its only permitted train descriptor;
+        // the odd ones may also be matched to the next train descriptor
+        int tIdx = qIdx % ntrain;
+        train.row(tIdx).copyTo(query.row(qIdx));
+        mask.at<uchar>(qIdx, tIdx) = 1;
+        if( qIdx % 2 )
+            mask.at<uchar>(qIdx, (tIdx + 1) % ntrain) = 1;
+    }
+
+    BFMatcher matcher(NORM_HAMMING);
+    vector<DMatch> flat;
+    matcher.knnMatchFlat(query, train.row(0), flat, knn, maxRatio);
+    ASSERT_EQ(query.rows*knn, (int)flat.size());
+    for( size_t i = 0; i < flat.size(); i++ )
+        ASSERT_TRUE(flat[i].queryIdx == -1 && flat[i].trainIdx == -1);
+
+    matcher.knnMatchFlat(query, train, flat, knn, 1.f, mask);
+    ASSERT_EQ(query.rows*knn, (int)flat.size());
+    for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+    {
+        EXPECT_EQ(qIdx % ntrain, flat[qIdx*knn].trainIdx);
+        EXPECT_EQ(qIdx % 2 ? (qIdx + 1) % ntrain : -1, flat[qIdx*knn + 1].trainIdx);
+    }
+
+    matcher.knnMatchFlat(query, train, flat, knn, maxRatio, mask);
+    ASSERT_EQ(query.rows*knn, (int)flat.size());
+    for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+    {
+        EXPECT_EQ(qIdx % 2 ? qIdx % ntrain : -1, flat[qIdx*knn].trainIdx) << "query " << qIdx;
+        EXPECT_EQ(qIdx % 2 ? (qIdx + 1) % ntrain : -1, flat[qIdx*knn + 1].trainIdx) << "query " << qIdx;
+    }
+}
+
+TEST( Features2d_BFMatcher, radiusMatchAndCrossCheck )
+{
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+
+    for( int iter = 0; iter < 3; iter++ )
+    {
+        bool binary = iter == 0;
+        int normType = iter == 0 ? NORM_HAMMING : iter == 1 ? NORM_L1 : NORM_L2;
+        int type = binary ? CV_8U : CV_32F, cols = binary ? 32 : 64;
+        Mat query(500, cols, type);
+        vector<Mat> train(2), masks, dists(train.size());
+
+        rng.fill(query, RNG::UNIFORM, 0, binary ? 256 : 16);
+        for( size_t i = 0; i < train.size(); i++ )
+        {
+            // the train descriptors are perturbed copies of the queries, so there are plenty of mutual pairs
+            train[i].create(i == 0 ? 3000 : 700, cols, type);
+            rng.fill(train[i], RNG::UNIFORM, 0, binary ? 256 : 16);
+            for( int j = 0; j < train[i].rows; j += 3 )
+            {
+                query.row(rng.uniform(0, query.rows)).copyTo(train[i].row(j));
+                if( binary )
+                    train[i].at<uchar>(j, rng.uniform(0, cols)) ^= (uchar)(1 << rng.uniform(0, 8));
+                else
+                    train[i].at<float>(j, rng.uniform(0, cols)) += 1.f;
+            }
+            masks.push_back(Mat(query.rows, train[i].rows, CV_8U));
+            rng.fill(masks.back(), RNG::UNIFORM, 0, 8);
+
+            Mat d;
+            batchDistance(query, train[i], d, -1, noArray(), normType);
+            d.convertTo(dists[i], CV_32F);
+        }
+
+        BFMatcher matcher(normType);
+        matcher.add(train);
+
+        float maxDistance = binary ? 100.f : normType == NORM_L1 ? 300.f : 50.f;
+        vector<vector<DMatch> > matches;
+        matcher.radiusMatch(query, matches, maxDistance, masks);
+        ASSERT_EQ(query.rows, (int)matches.size());
+        for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+        {
+            vector<DMatch> ref;
+            for( size_t iIdx = 0; iIdx < train.size(); iIdx++ )
+                for( int tIdx = 0; tIdx < train[iIdx].rows; tIdx++ )
+                {
+                    float d = dists[iIdx].at<float>(qIdx, tIdx);
+                    if( masks[iIdx].at<uchar>(qIdx, tIdx) && d <= maxDistance )
+                        ref.push_back(DMatch(qIdx, tIdx, (int)iIdx, d));
+                }
+            std::sort(ref.begin(), ref.end(), lessMatch);
+            vector<DMatch> mq = matches[qIdx];
+            std::sort(mq.begin(), mq.end(), lessMatch);
+            ASSERT_TRUE(sameMatches(ref, mq)) << "query " << qIdx;
+        }
+
+        BFMatcher crossMatcher(normType, true);
+        crossMatcher.add(train);
+        vector<DMatch> cmatches;
+        crossMatcher.match(query, cmatches, masks);
+
+        // mutual nearest neighbours over the whole collection, the first index wins on ties
+        vector<DMatch> ref;
+        vector<DMatch> best(query.rows);
+        vector<vector<int> > bestQuery(train.size());
+        for( size_t iIdx = 0; iIdx < train.size(); iIdx++ )
+        {
+            bestQuery[iIdx].assign(train[iIdx].rows, -1);
+            for( int tIdx = 0; tIdx < train[iIdx].rows; tIdx++ )
+            {
+                float bd = FLT_MAX;
+                for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+                {
+                    float d = masks[iIdx].at<uchar>(qIdx, tIdx) ? dists[iIdx].at<float>(qIdx, tIdx) : FLT_MAX;
+                    if( d < bd )
+                        bd = d, bestQuery[iIdx][tIdx] = qIdx;
+                    if( d < best[qIdx].distance ||
+                        (d == best[qIdx].distance && d < FLT_MAX &&
+                         (best[qIdx].imgIdx > (int)iIdx || (best[qIdx].imgIdx == (int)iIdx && best[qIdx].trainIdx > tIdx))) )
+                        best[qIdx] = DMatch(qIdx, tIdx, (int)iIdx, d);
+                }
+            }
+        }
+        for( int qIdx = 0; qIdx < query.rows; qIdx++ )
+            if( best[qIdx].trainIdx >= 0 && bestQuery[best[qIdx].imgIdx][best[qIdx].trainIdx] == qIdx )
+                ref.push_back(best[qIdx]);
+
+        ASSERT_LT(query.rows/10, (int)ref.size());
+        ASSERT_TRUE(sameMatches(ref, cmatches)) << "normType = " << normType;
+    }
+}
+
+static bool sameMatches( const vector<vector<DMatch> >& a, const vector<vector<DMatch> >& b, bool sortByIdx )
+{
+    if( a.size() != b.size() )
+        return false;
+    for( size_t i = 0; i < a.size(); i++ )
+    {
+        vector<DMatch> ai = a[i], bi = b[i];
+        if( sortByIdx )
+        {
+            std::sort(ai.begin(), ai.end(), lessMatch);
+            std::sort(bi.begin(), bi.end(), lessMatch);
+        }
+        if( !sameMatches(ai, bi) )
+            return false;
+    }
+    return true;
+}
+
+TEST( Features2d_MIHMatcher, accuracy )
+{
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+    string filename = cv::tempfile(".mih");
+
+    for( int iter = 0; iter < 2; iter++ )
+    {
+        // ORB (256 bit) and BRISK/FREAK (512 bit) sized descriptors; half of the queries have
+        // near duplicates in the train set, the other half are random and far from everything
+        int cols = iter == 0 ? 32 : 64;
+        Mat query(200, cols, CV_8U);
+        vector<Mat> train(3), masks;
+        rng.fill(query, RNG::UNIFORM, 0, 256);
+        for( size_t i = 0; i < train.size(); i++ )
+        {
+            train[i].create(i == 1 ? 0 : 4000, cols, CV_8U);
+            rng.fill(train[i], RNG::UNIFORM, 0, 256);
+            for( int j = 0; j < train[i].rows; j += 2 )
+            {
+                query.row(rng.uniform(0, query.rows/2)).copyTo(train[i].row(j));
+                for( int k = rng.uniform(0, 40); k > 0; k-- )
+                    train[i].at<uchar>(j, rng.uniform(0, cols)) ^= (uchar)(1 << rng.uniform(0, 8));
+            }
+            masks.push_back(train[i].empty() ? Mat() : Mat(query.rows, train[i].rows, CV_8U));
+            if( !train[i].empty() )
+                rng.fill(masks.back(), RNG::UNIFORM, 0, 8);
+        }
+
+        BFMatcher bf(NORM_HAMMING);
+        bf.add(train);
+        // the default substrings index the tables directly, the long ones go through hashing
+        Ptr<DescriptorMatcher> mih = iter == 0 ? DescriptorMatcher::create("MultiIndexHashing") :
+            Ptr<DescriptorMatcher>(new MIHMatcher(24));
+        ASSERT_FALSE(mih.empty());
+        mih->add(train);
+
+        vector<vector<DMatch> > ref, res;
+        bf.knnMatch(query, ref, 5, masks);
+        mih->knnMatch(query, res, 5, masks);
+        ASSERT_TRUE(sameMatches(ref, res, false)) << "knnMatch, " << cols << " bytes";
+
+        bf.radiusMatch(query, ref, 60.f);
+        mih->radiusMatch(query, res, 60.f);
+        ASSERT_TRUE(sameMatches(ref, res, true)) << "radiusMatch, " << cols << " bytes";
+
+        ((MIHMatcher*)(DescriptorMatcher*)mih)->save(filename);
+        MIHMatcher loaded;
+        loaded.load(filename);
+        ASSERT_EQ(train.size(), loaded.getTrainDescriptors().size());
+        loaded.knnMatch(query, res, 2);
+        bf.knnMatch(query, ref, 2);
+        ASSERT_TRUE(sameMatches(ref, res, false)) << "knnMatch after load, " << cols << " bytes";
+    }
+    remove(filename.c_str());
+}
+
+TEST( Features2d_MIHMatcher, loadMalformed )
+{
+    // the offsets and the indices of a corrupted index file have to be rejected on loading
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+    string filename = cv::tempfile(".mih");
+    vector<Mat> train(2);
+    for( size_t i = 0; i < train.size(); i++ )
+    {
+        train[i].create(500, 32, CV_8U);
+        rng.fill(train[i], RNG::UNIFORM, 0, 256);
+    }
+
+    MIHMatcher mih;
+    mih.add(train);
+    mih.train();
+    mih.save(filename);
+
+    vector<char> data;
+    FILE* f = fopen(filename.c_str(), "rb");
+    ASSERT_TRUE(f != 0);
+    for( int c; (c = fgetc(f)) != EOF; )
+        data.push_back((char)c);
+    fclose(f);
+
+    // the signature, the header {substringBits, rows, cols, images, substrings + 1},
+    // the image offsets, the substring offsets, the descriptors and then the tables,
+    // each of them stored as {keys, offsets, ids, slots} with the sizes in front
+    const size_t hdrPos = sizeof("OpenCV-MIH-1");
+    int hdr[5];
+    memcpy(hdr, &data[hdrPos], sizeof(hdr));
+    ASSERT_EQ(1000, hdr[1]);
+    size_t startPos = hdrPos + sizeof(hdr), tablePos = startPos + (hdr[3] + hdr[4])*sizeof(int) + hdr[1]*hdr[2];
+    int nkeys;
+    memcpy(&nkeys, &data[tablePos], sizeof(int));
+    size_t ofsPos = tablePos + (nkeys + 2)*sizeof(int);
+    int nofs;
+    memcpy(&nofs, &data[ofsPos - sizeof(int)], sizeof(int));
+    size_t idsPos = ofsPos + (nofs + 1)*sizeof(int);
+
+    const size_t positions[] = { startPos + sizeof(int), ofsPos + sizeof(int), idsPos };
+    const int values[] = { hdr[1] + 1, -1, hdr[1] };
+    for( int k = 0; k < 3; k++ )
+    {
+        // an image starting after the end, decreasing offsets and an id out of range
+        vector<char> bad = data;
+        memcpy(&bad[positions[k]], &values[k], sizeof(int));
+        f = fopen(filename.c_str(), "wb");
+        ASSERT_TRUE(f != 0);
+        fwrite(&bad[0], 1, bad.size(), f);
+        fclose(f);
+
+        MIHMatcher loaded;
+        EXPECT_THROW(loaded.load(filename), cv::Exception) << "case " << k;
+        EXPECT_TRUE(loaded.getTrainDescriptors().empty()) << "case " << k;
+    }
+    remove(filename.c_str());
+}
@@ -204,3 +204,95 @@ void CV_MserTest::run(int)
 }
 
 TEST(Features2d_MSER, DISABLED_regression) { CV_MserTest test; test.safe_run(); }
+
+TEST(Features2d_MSER, parallelDeterminism)
+{
+    RNG rng(3);
+    Mat image(240, 320, CV_8UC3);
+    rng.fill(image, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+    GaussianBlur(image, image, Size(0, 0), 3);
+    for( int i = 0; i < 40; i++ )
+    {
+        Point p(rng.uniform(0, image.cols), rng.uniform(0, image.rows));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        rectangle(image, p, p + Point(rng.uniform(5, 50), rng.uniform(5, 50)), color, -1);
+    }
+    Mat gray;
+    cvtColor(image, gray, COLOR_BGR2GRAY);
+
+    const Mat* images[] = { &gray, &image };
+    int prevThreads = getNumThreads();
+    for( int k = 0; k < 2; k++ )
+    {
+        const Mat& src = *images[k];
+        Mat srcCopy = src.clone();
+
+        vector<vector<Point> > refRegions, regions;
+        setNumThreads(1);
+        MSER()(src, refRegions);
+        setNumThreads(prevThreads);
+        MSER()(src, regions);
+
+        // the input is left untouched, and the regions do not depend on the number of threads
+        EXPECT_EQ(0, norm(src, srcCopy, NORM_INF));
+        ASSERT_FALSE(refRegions.empty());
+        ASSERT_EQ(refRegions.size(), regions.size());
+        for( size_t i = 0; i < regions.size(); i++ )
+            ASSERT_TRUE(refRegions[i] == regions[i]) << "region " << i;
+    }
+}
+
+TEST(Features2d_MSER, colorReference)
+{
+    // an image where all the blurred edge distances are different, so the order of the edges
+    // does not depend on the sort algorithm; the reference values come from the implementation
+    // that sorted the edges with a quicksort and kept the root links in the nodes
+    RNG rng(7);
+    Mat image(120, 160, CV_8UC3, Scalar::all(128)), noise(image.size(), CV_8UC3);
+    for( int i = 0; i < 25; i++ )
+    {
+        Point p(rng.uniform(0, image.cols), rng.uniform(0, image.rows));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        rectangle(image, p, p + Point(rng.uniform(8, 40), rng.uniform(8, 40)), color, -1);
+    }
+    rng.fill(noise, RNG::UNIFORM, 0, 16);
+    image += noise;
+
+    // the chi-squared distances to the right and to the bottom neighbours, blurred as MSER does
+    Mat dx(image.rows, image.cols - 1, CV_64F), dy(image.rows - 1, image.cols, CV_64F);
+    for( int i = 0; i < image.rows; i++ )
+        for( int j = 0; j < image.cols; j++ )
+        {
+            const uchar* x = image.ptr(i) + j*3;
+            for( int d = 0; d < 2; d++ )
+            {
+                if( d == 0 ? j == image.cols - 1 : i == image.rows - 1 )
+                    continue;
+                const uchar* y = d == 0 ? x + 3 : image.ptr(i + 1) + j*3;
+                double chi = 0;
+                for( int k = 0; k < 3; k++ )
+                    chi += (double)((x[k] - y[k])*(x[k] - y[k]))/(double)(x[k] + y[k] + 1e-10);
+                (d == 0 ? dx : dy).at<double>(i, j) = chi;
+            }
+        }
+    GaussianBlur(dx, dx, Size(5, 5), 0, 0, BORDER_REPLICATE);
+    GaussianBlur(dy, dy, Size(5, 5), 0, 0, BORDER_REPLICATE);
+    vector<double> chis(dx.begin<double>(), dx.end<double>());
+    chis.insert(chis.end(), dy.begin<double>(), dy.end<double>());
+    std::sort(chis.begin(), chis.end());
+    ASSERT_TRUE(std::adjacent_find(chis.begin(), chis.end()) == chis.end());
+
+    vector<vector<Point> > regions;
+    MSER()(image, regions);
+
+    double npoints = 0, checksum = 0;
+    for( size_t i = 0; i < regions.size(); i++ )
+        for( size_t j = 0; j < regions[i].size(); j++ )
+        {
+            npoints++;
+            checksum += (double)(i + 1)*(regions[i][j].x*1000 + regions[i][j].y);
+        }
+    EXPECT_EQ(34, (int)regions.size());
+    EXPECT_EQ(29168., npoints);
+    EXPECT_EQ(44854915270., checksum);
+}
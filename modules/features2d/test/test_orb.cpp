@@ -90,3 +90,104 @@ TEST(Features2D_ORB, _1996)
 
     ASSERT_EQ(0, roiViolations);
 }
+
+TEST(Features2D_ORB, parallelDeterminism)
+{
+    Mat image(600, 800, CV_8UC1);
+    RNG& rng = theRNG();
+    rng.fill(image, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+    GaussianBlur(image, image, Size(0, 0), 3);
+    for( int i = 0; i < 200; i++ )
+    {
+        Point pt(rng.uniform(0, image.cols), rng.uniform(0, image.rows));
+        rectangle(image, pt, pt + Point(rng.uniform(5, 60), rng.uniform(5, 60)), Scalar::all(rng.uniform(0, 256)), -1);
+    }
+
+    for( int scoreType = ORB::HARRIS_SCORE; scoreType <= ORB::FAST_SCORE; scoreType++ )
+    {
+        ORB orb(1000, 1.2f, 8, 31, 0, 2, scoreType);
+        int nthreads = getNumThreads();
+
+        std::vector<KeyPoint> keypoints0, keypoints1, keypoints2, keypoints3;
+        Mat descriptors0, descriptors1, descriptors2, descriptors3;
+        setNumThreads(1);
+        orb(image, Mat(), keypoints0, descriptors0);
+        keypoints2 = keypoints0;
+        orb(image, Mat(), keypoints2, descriptors2, true);
+        setNumThreads(nthreads);
+        orb(image, Mat(), keypoints1, descriptors1);
+        keypoints3 = keypoints0;
+        orb(image, Mat(), keypoints3, descriptors3, true);
+
+        ASSERT_EQ(keypoints0.size(), keypoints1.size());
+        ASSERT_EQ(keypoints2.size(), keypoints3.size());
+        for( size_t i = 0; i < keypoints0.size(); i++ )
+        {
+            ASSERT_EQ(keypoints0[i].pt, keypoints1[i].pt);
+            ASSERT_EQ(keypoints0[i].octave, keypoints1[i].octave);
+            ASSERT_EQ(keypoints0[i].angle, keypoints1[i].angle);
+            ASSERT_EQ(keypoints0[i].response, keypoints1[i].response);
+        }
+        ASSERT_EQ(0, norm(descriptors0, descriptors1, NORM_HAMMING));
+        ASSERT_EQ(0, norm(descriptors2, descriptors3, NORM_HAMMING));
+    }
+}
+
+TEST(Features2D_ORB, smallEdgeThreshold)
+{
+    // with edgeThreshold < patchSize/2 the orientation and the Harris score read the reflected
+    // borders of the pyramid levels, so they must be ready before the keypoints are computed
+    Mat image(480, 640, CV_8UC1);
+    RNG rng(11);
+    rng.fill(image, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+    GaussianBlur(image, image, Size(0, 0), 3);
+    for( int i = 0; i < 150; i++ )
+    {
+        Point pt(rng.uniform(0, image.cols), rng.uniform(0, image.rows));
+        rectangle(image, pt, pt + Point(rng.uniform(5, 60), rng.uniform(5, 60)), Scalar::all(rng.uniform(0, 256)), -1);
+    }
+
+    // the number of keypoints, the sum of their angles and the number of the descriptor bits set,
+    // as computed by the serial implementation
+    const int refCount[] = { 1831, 1844 };
+    const double refAngleSum[] = { 341295.009, 341708.586 };
+    const double refBits[] = { 229846, 232035 };
+
+    for( int scoreType = ORB::HARRIS_SCORE; scoreType <= ORB::FAST_SCORE; scoreType++ )
+    {
+        ORB orb(2000, 1.2f, 8, 3, 0, 2, scoreType, 31);
+        std::vector<KeyPoint> keypoints[2];
+        Mat descriptors[2];
+        for( int k = 0; k < 2; k++ )
+        {
+            // leave some garbage in the freed memory that the pyramid may reuse
+            {
+                std::vector<Mat> junk(10);
+                for( size_t j = 0; j < junk.size(); j++ )
+                {
+                    junk[j].create(500, 700, CV_8UC1);
+                    rng.fill(junk[j], RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+                }
+            }
+            orb(image, Mat(), keypoints[k], descriptors[k]);
+        }
+
+        ASSERT_EQ(keypoints[0].size(), keypoints[1].size());
+        for( size_t i = 0; i < keypoints[0].size(); i++ )
+        {
+            ASSERT_EQ(keypoints[0][i].pt, keypoints[1][i].pt);
+            ASSERT_EQ(keypoints[0][i].angle, keypoints[1][i].angle);
+            ASSERT_EQ(keypoints[0][i].response, keypoints[1][i].response);
+        }
+        ASSERT_EQ(0, norm(descriptors[0], descriptors[1], NORM_HAMMING));
+
+        double angleSum = 0, bits = 0;
+        for( size_t i = 0; i < keypoints[0].size(); i++ )
+            angleSum += keypoints[0][i].angle;
+        for( int i = 0; i < descriptors[0].rows; i++ )
+            bits += norm(descriptors[0].row(i), NORM_HAMMING);
+        EXPECT_EQ(refCount[scoreType], (int)keypoints[0].size());
+        EXPECT_NEAR(refAngleSum[scoreType], angleSum, 1.);
+        EXPECT_NEAR(refBits[scoreType], bits, 10.);
+    }
+}
@@ -487,6 +487,11 @@ CV_EXPORTS_W void HoughLinesP( InputArray image, OutputArray lines,
                                double rho, double theta, int threshold,
                                double minLineLength=0, double maxLineGap=0 );
 
+//! the same as above, but stops as soon as maxLines segments are found (maxLines <= 0 means no limit)
+CV_EXPORTS void HoughLinesP( InputArray image, OutputArray lines,
+                             double rho, double theta, int threshold,
+                             double minLineLength, double maxLineGap, int maxLines );
+
 //! finds circles in the grayscale image using 2+1 gradient Hough transform
 CV_EXPORTS_W void HoughCircles( InputArray image, OutputArray circles,
                                int method, double dp, double minDist,
@@ -565,6 +570,12 @@ CV_EXPORTS_W void resize( InputArray src, OutputArray dst,
                           Size dsize, double fx=0, double fy=0,
                           int interpolation=INTER_LINEAR );
 
+//! converts the color space, resizes the image and converts it to the specified depth in one pass over row bands
+CV_EXPORTS_W void cvtColorResize( InputArray src, OutputArray dst, int code,
+                                  Size dsize, double fx=0, double fy=0,
+                                  int interpolation=INTER_LINEAR, int rtype=-1,
+                                  double alpha=1, double beta=0 );
+
 //! warps the image using affine transformation
 CV_EXPORTS_W void warpAffine( InputArray src, OutputArray dst,
                               InputArray M, Size dsize,
@@ -686,6 +697,38 @@ CV_EXPORTS_W void initUndistortRectifyMap( InputArray cameraMatrix, InputArray d
                            InputArray R, InputArray newCameraMatrix,
                            Size size, int m1type, OutputArray map1, OutputArray map2 );
 
+/*!
+ Undistortion + rectification + scaling + optional color conversion, applied in one pass.
+
+ The geometric transformations are composed into one fixed-point map (CV_16SC2 + CV_16UC1)
+ once; then each frame is processed by tiles in parallel: every tile is remapped and,
+ optionally, color-converted while it is still in cache, without full-frame intermediates.
+*/
+class CV_EXPORTS UndistortRectifyPlan
+{
+public:
+    //! the default constructor
+    UndistortRectifyPlan();
+    //! the constructor that builds the plan (see create())
+    UndistortRectifyPlan( InputArray cameraMatrix, InputArray distCoeffs,
+                          InputArray R, InputArray newCameraMatrix, Size imageSize,
+                          Size dstSize=Size(), int interpolation=INTER_LINEAR, int colorCode=-1 );
+    //! builds the plan. imageSize is the size of the undistorted image in newCameraMatrix coordinates,
+    //! dstSize is the size of the final (scaled) image, colorCode is the optional cvtColor() code
+    void create( InputArray cameraMatrix, InputArray distCoeffs,
+                 InputArray R, InputArray newCameraMatrix, Size imageSize,
+                 Size dstSize=Size(), int interpolation=INTER_LINEAR, int colorCode=-1 );
+    //! processes the frame
+    void operator()( InputArray src, OutputArray dst, int borderMode=BORDER_CONSTANT,
+                     const Scalar& borderValue=Scalar() ) const;
+    //! returns true if the plan has not been built yet
+    bool empty() const;
+
+    Mat map1, map2; //!< the composed fixed-point maps
+    int interpolation; //!< interpolation method used by remap()
+    int colorCode; //!< the color conversion code or -1
+};
+
 enum
 {
     PROJ_SPHERICAL_ORTHO = 0,
@@ -805,7 +848,8 @@ enum
 {
     GC_INIT_WITH_RECT  = 0,
     GC_INIT_WITH_MASK  = 1,
-    GC_EVAL            = 2
+    GC_EVAL            = 2,
+    GC_MULTISCALE      = 16  //!< may be combined with the other flags: coarse-to-fine processing of large images
 };
 
 //! segments the image using GrabCut algorithm
@@ -1115,6 +1159,9 @@ public:
 //! computes moments of the rasterized shape or a vector of points
 CV_EXPORTS_W Moments moments( InputArray array, bool binaryImage=false );
 
+//! computes the binary moments of every region of the label image; mu[i] corresponds to label i
+CV_EXPORTS void labelMoments( InputArray labels, CV_OUT vector<Moments>& mu, int nlabels=-1 );
+
 //! computes 7 Hu invariants from the moments
 CV_EXPORTS void HuMoments( const Moments& moments, double hu[7] );
 CV_EXPORTS_W void HuMoments( const Moments& m, CV_OUT OutputArray hu );
@@ -1126,6 +1173,10 @@ enum { TM_SQDIFF=0, TM_SQDIFF_NORMED=1, TM_CCORR=2, TM_CCORR_NORMED=3, TM_CCOEFF
 CV_EXPORTS_W void matchTemplate( InputArray image, InputArray templ,
                                  OutputArray result, int method );
 
+//! computes the proximity maps for a set of same-sized templates, sharing the image spectrum between them
+CV_EXPORTS_W void matchTemplates( InputArray image, InputArrayOfArrays templs,
+                                  OutputArrayOfArrays results, int method );
+
 //! mode of the contour retrieval algorithm
 enum
 {
@@ -0,0 +1,91 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+CV_ENUM(AccDepth, CV_32F, CV_64F)
+
+typedef std::tr1::tuple<Size, MatType, AccDepth, bool> Size_MatType_AccDepth_Mask_t;
+typedef perf::TestBaseWithParam<Size_MatType_AccDepth_Mask_t> Size_MatType_AccDepth_Mask;
+
+#define ACCUMULATE_PARAMS testing::Combine( \
+                testing::Values(::perf::sz1080p, ::perf::sz2160p), \
+                testing::Values(CV_8UC1, CV_8UC3, CV_32FC1), \
+                AccDepth::all(), \
+                testing::Bool() \
+                )
+
+static void initAccumulateArgs( Size sz, int type, int ddepth, bool useMask, Mat& src, Mat& dst, Mat& mask )
+{
+    src.create(sz, type);
+    dst.create(sz, CV_MAKETYPE(ddepth, CV_MAT_CN(type)));
+    dst = Scalar::all(0);
+    if( useMask )
+    {
+        mask.create(sz, CV_8UC1);
+        randu(mask, 0, 2);
+    }
+}
+
+PERF_TEST_P(Size_MatType_AccDepth_Mask, accumulate, ACCUMULATE_PARAMS)
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam()), ddepth = get<2>(GetParam());
+    bool useMask = get<3>(GetParam());
+
+    Mat src, dst, mask;
+    initAccumulateArgs(sz, type, ddepth, useMask, src, dst, mask);
+    declare.in(src, WARMUP_RNG).out(dst).time(30);
+
+    TEST_CYCLE() accumulate(src, dst, mask);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(Size_MatType_AccDepth_Mask, accumulateSquare, ACCUMULATE_PARAMS)
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam()), ddepth = get<2>(GetParam());
+    bool useMask = get<3>(GetParam());
+
+    Mat src, dst, mask;
+    initAccumulateArgs(sz, type, ddepth, useMask, src, dst, mask);
+    declare.in(src, WARMUP_RNG).out(dst).time(30);
+
+    TEST_CYCLE() accumulateSquare(src, dst, mask);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(Size_MatType_AccDepth_Mask, accumulateProduct, ACCUMULATE_PARAMS)
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam()), ddepth = get<2>(GetParam());
+    bool useMask = get<3>(GetParam());
+
+    Mat src1, src2(sz, type), dst, mask;
+    initAccumulateArgs(sz, type, ddepth, useMask, src1, dst, mask);
+    declare.in(src1, src2, WARMUP_RNG).out(dst).time(30);
+
+    TEST_CYCLE() accumulateProduct(src1, src2, dst, mask);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(Size_MatType_AccDepth_Mask, accumulateWeighted, ACCUMULATE_PARAMS)
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam()), ddepth = get<2>(GetParam());
+    bool useMask = get<3>(GetParam());
+
+    Mat src, dst, mask;
+    initAccumulateArgs(sz, type, ddepth, useMask, src, dst, mask);
+    declare.in(src, WARMUP_RNG).out(dst).time(30);
+
+    TEST_CYCLE() accumulateWeighted(src, dst, 0.05, mask);
+
+    SANITY_CHECK_NOTHING();
+}
@@ -290,6 +290,41 @@ PERF_TEST_P(Size_CvtMode_Bayer, cvtColorBayer8u,
     SANITY_CHECK(dst, 1);
 }
 
+CV_ENUM(CvtModeSIMD, CV_BGR2GRAY, CV_BGRA2GRAY, CV_GRAY2BGR, CV_GRAY2BGRA,
+        CV_YUV2BGR_NV12, CV_YUV2BGRA_NV12, CV_YUV2BGR_IYUV, CV_YUV2BGRA_IYUV)
+
+typedef std::tr1::tuple<Size, CvtModeSIMD, bool> Size_CvtModeSIMD_Optimized_t;
+typedef perf::TestBaseWithParam<Size_CvtModeSIMD_Optimized_t> Size_CvtModeSIMD_Optimized;
+
+// compares the vectorized code paths (useOptimized = true) with the generic ones
+PERF_TEST_P(Size_CvtModeSIMD_Optimized, cvtColor8uSIMD,
+            testing::Combine(
+                testing::Values(szVGA, sz1080p),
+                CvtModeSIMD::all(),
+                testing::Bool()
+                )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int mode = get<1>(GetParam());
+    bool optimized = get<2>(GetParam());
+    ChPair ch = getConversionInfo(mode);
+    bool yuv420 = (mode >= CV_YUV2RGB_NV12 && mode <= CV_YUV2BGRA_NV21) ||
+                  (mode >= CV_YUV2RGB_YV12 && mode <= CV_YUV2BGRA_IYUV);
+
+    Mat src(yuv420 ? sz.height + sz.height / 2 : sz.height, sz.width, CV_8UC(ch.scn));
+    Mat dst(sz, CV_8UC(ch.dcn));
+
+    declare.in(src, WARMUP_RNG).out(dst);
+
+    bool prevOptimized = useOptimized();
+    setUseOptimized(optimized);
+    TEST_CYCLE() cvtColor(src, dst, mode, ch.dcn);
+    setUseOptimized(prevOptimized);
+
+    SANITY_CHECK_NOTHING();
+}
+
 typedef std::tr1::tuple<Size, CvtMode2> Size_CvtMode2_t;
 typedef perf::TestBaseWithParam<Size_CvtMode2_t> Size_CvtMode2;
 
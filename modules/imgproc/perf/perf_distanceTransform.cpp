@@ -1,23 +1,69 @@
-/*#include "perf_precomp.hpp"
-#include "distransform.cpp"
+#include "perf_precomp.hpp"
 
 using namespace std;
 using namespace cv;
 using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
 
-typedef perf::TestBaseWithParam<Size> Size_DistanceTransform;
+CV_ENUM(DistanceType, CV_DIST_L1, CV_DIST_L2, CV_DIST_C)
+CV_ENUM(MaskSize, CV_DIST_MASK_3, CV_DIST_MASK_5, CV_DIST_MASK_PRECISE)
+CV_ENUM(LabelType, DIST_LABEL_CCOMP, DIST_LABEL_PIXEL)
 
-PERF_TEST_P(Size_DistanceTransform, icvTrueDistTrans, testing::Values(TYPICAL_MAT_SIZES))
+typedef std::tr1::tuple<Size, DistanceType, MaskSize> Size_DistanceType_MaskSize_t;
+typedef perf::TestBaseWithParam<Size_DistanceType_MaskSize_t> Size_DistanceType_MaskSize;
+
+typedef std::tr1::tuple<Size, MaskSize, LabelType> Size_MaskSize_LabelType_t;
+typedef perf::TestBaseWithParam<Size_MaskSize_LabelType_t> Size_MaskSize_LabelType;
+
+static void makeDistanceTransformSource(Mat& src)
+{
+    // sparse zero pixels, so that the distances are not trivial
+    Mat noise(src.size(), CV_8UC1);
+    randu(noise, 0, 256);
+    src = noise != 0;
+}
+
+PERF_TEST_P(Size_DistanceType_MaskSize, distanceTransform,
+            testing::Combine(
+                testing::Values(::perf::sz1080p, ::perf::sz2160p),
+                DistanceType::all(),
+                MaskSize::all()
+                )
+            )
 {
-    Size size = GetParam();
-    Mat src(size, CV_8UC1);
-    Mat dst(size, CV_32FC1);
-    CvMat srcStub = src;
-    CvMat dstStub = dst;
+    Size sz = get<0>(GetParam());
+    int distanceType = get<1>(GetParam());
+    int maskSize = get<2>(GetParam());
+
+    Mat src(sz, CV_8UC1), dst(sz, CV_32FC1);
+    makeDistanceTransformSource(src);
+
+    declare.in(src).out(dst);
+
+    TEST_CYCLE() distanceTransform(src, dst, distanceType, maskSize);
+
+    SANITY_CHECK(dst, 1e-3);
+}
+
+PERF_TEST_P(Size_MaskSize_LabelType, distanceTransform_labels,
+            testing::Combine(
+                testing::Values(::perf::sz1080p, ::perf::sz2160p),
+                testing::Values((int)CV_DIST_MASK_5, (int)CV_DIST_MASK_PRECISE),
+                LabelType::all()
+                )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int maskSize = get<1>(GetParam());
+    int labelType = get<2>(GetParam());
+
+    Mat src(sz, CV_8UC1), dst(sz, CV_32FC1), labels(sz, CV_32SC1);
+    makeDistanceTransformSource(src);
 
-    declare.in(src, WARMUP_RNG).out(dst);
+    declare.in(src).out(dst, labels).time(30);
 
-    TEST_CYCLE() icvTrueDistTrans(&srcStub, &dstStub);
+    TEST_CYCLE() distanceTransform(src, dst, labels, CV_DIST_L2, maskSize, labelType);
 
-    SANITY_CHECK(dst, 1);
-}*/
+    SANITY_CHECK(dst, 1e-3);
+}
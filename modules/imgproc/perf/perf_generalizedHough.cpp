@@ -0,0 +1,84 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+CV_FLAGS(GHMethod, GHT_POSITION, GHT_SCALE, GHT_ROTATION)
+
+typedef std::tr1::tuple<GHMethod, Size> Method_Size_t;
+typedef perf::TestBaseWithParam<Method_Size_t> Method_Size;
+
+static Mat makeGeneralizedHoughTemplate()
+{
+    Mat templ(80, 100, CV_8UC1, Scalar::all(0));
+
+    rectangle(templ, Point(10, 10), Point(60, 50), Scalar::all(255), 2);
+    circle(templ, Point(70, 55), 15, Scalar::all(255), 2);
+    line(templ, Point(15, 70), Point(90, 20), Scalar::all(255), 2);
+
+    return templ;
+}
+
+PERF_TEST_P(Method_Size, GeneralizedHough,
+            testing::Combine(
+                testing::Values( GHMethod(GHT_POSITION), GHMethod(GHT_POSITION | GHT_SCALE),
+                                 GHMethod(GHT_POSITION | GHT_ROTATION), GHMethod(GHT_POSITION | GHT_SCALE | GHT_ROTATION) ),
+                testing::Values( ::perf::szVGA, ::perf::sz720p )
+                )
+            )
+{
+    const int method = get<0>(GetParam());
+    const Size imageSize = get<1>(GetParam());
+
+    const Mat templ = makeGeneralizedHoughTemplate();
+
+    Mat image(imageSize, CV_8UC1, Scalar::all(0));
+    templ.copyTo(image(Rect(50, 50, templ.cols, templ.rows)));
+
+    RNG rng(123456789);
+    const int objCount = rng.uniform(5, 15);
+    for (int i = 0; i < objCount; ++i)
+    {
+        double scale = rng.uniform(0.7, 1.3);
+        bool rotate = 1 == rng.uniform(0, 2);
+
+        Mat obj;
+        resize(templ, obj, Size(), scale, scale);
+        if (rotate)
+            obj = obj.t();
+
+        Point pos;
+
+        pos.x = rng.uniform(0, image.cols - obj.cols);
+        pos.y = rng.uniform(0, image.rows - obj.rows);
+
+        Mat roi = image(Rect(pos, obj.size()));
+        add(roi, obj, roi);
+    }
+
+    Mat edges;
+    Canny(image, edges, 50, 100);
+
+    Mat dx, dy;
+    Sobel(image, dx, CV_32F, 1, 0);
+    Sobel(image, dy, CV_32F, 0, 1);
+
+    Ptr<GeneralizedHough> hough = GeneralizedHough::create(method);
+    if (method & GHT_ROTATION)
+    {
+        hough->set("maxAngle", 90.0);
+        hough->set("angleStep", 2.0);
+    }
+
+    hough->setTemplate(templ);
+
+    Mat positions;
+    declare.time(60);
+
+    TEST_CYCLE() hough->detect(edges, dx, dy, positions);
+
+    SANITY_CHECK_NOTHING();
+}
@@ -0,0 +1,42 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+typedef std::tr1::tuple<Size, bool> Size_MultiScale_t;
+typedef perf::TestBaseWithParam<Size_MultiScale_t> Size_MultiScale;
+
+PERF_TEST_P(Size_MultiScale, grabCut,
+            testing::Combine(
+                testing::Values(::perf::szVGA, ::perf::sz1080p),
+                testing::Bool()
+                )
+            )
+{
+    Size sz = get<0>(GetParam());
+    bool multiScale = get<1>(GetParam());
+
+    Mat img(sz, CV_8UC3), noise(sz, CV_8UC3);
+    img.setTo(Scalar(40, 90, 160));
+    ellipse(img, Point(sz.width/2, sz.height/2), Size(sz.width/4, sz.height/4), 0, 0, 360, Scalar(200, 180, 60), -1);
+    randu(noise, 0, 32);
+    img += noise;
+
+    Rect rect(sz.width/8, sz.height/8, sz.width*3/4, sz.height*3/4);
+    int mode = GC_INIT_WITH_RECT | (multiScale ? GC_MULTISCALE : 0);
+    Mat mask, bgdModel, fgdModel;
+
+    declare.in(img).time(60);
+
+    TEST_CYCLE()
+    {
+        bgdModel.release();
+        fgdModel.release();
+        grabCut(img, mask, rect, bgdModel, fgdModel, 3, mode);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
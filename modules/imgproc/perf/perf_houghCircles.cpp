@@ -0,0 +1,37 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+typedef std::tr1::tuple<Size, int> Size_MinDist_t;
+typedef perf::TestBaseWithParam<Size_MinDist_t> Size_MinDist;
+
+PERF_TEST_P(Size_MinDist, HoughCircles,
+            testing::Combine(
+                testing::Values( ::perf::szVGA, ::perf::sz1080p ),
+                testing::Values( 1, 20 )
+                )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int minDist = get<1>(GetParam());
+
+    Mat image(sz, CV_8UC1, Scalar::all(0));
+    RNG rng(0x12345);
+    for( int i = 0; i < 30; i++ )
+    {
+        Point center(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        circle(image, center, rng.uniform(10, 100), Scalar::all(255), 2);
+    }
+    GaussianBlur(image, image, Size(9, 9), 2, 2);
+
+    vector<Vec3f> circles;
+    declare.time(60);
+
+    TEST_CYCLE() HoughCircles(image, circles, CV_HOUGH_GRADIENT, 1, minDist, 100, 30, 10, 100);
+
+    SANITY_CHECK_NOTHING();
+}
@@ -38,3 +38,60 @@ PERF_TEST_P(Image_RhoStep_ThetaStep_Threshold, HoughLines,
 
     SANITY_CHECK(lines);
 }
+
+static void makeHoughLinesImage( Size sz, Mat& image )
+{
+    image.create(sz, CV_8UC1);
+    image = Scalar::all(0);
+    RNG rng(0x12345);
+    for( int i = 0; i < 100; i++ )
+    {
+        Point pt1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Point pt2(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        line(image, pt1, pt2, Scalar::all(255));
+    }
+}
+
+typedef std::tr1::tuple<Size, int> Size_MaxLines_t;
+typedef perf::TestBaseWithParam<Size_MaxLines_t> Size_MaxLines;
+
+PERF_TEST_P(Size_MaxLines, HoughLinesP,
+            testing::Combine(
+                testing::Values( ::perf::sz1080p, ::perf::sz2160p ),
+                testing::Values( 0, 50 )
+                )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int maxLines = get<1>(GetParam());
+
+    Mat image;
+    makeHoughLinesImage(sz, image);
+
+    vector<Vec4i> lines;
+    declare.time(60);
+
+    TEST_CYCLE() HoughLinesP(image, lines, 1, CV_PI/180, 50, 30, 10, maxLines);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(Size_MaxLines, HoughLinesSynthetic,
+            testing::Combine(
+                testing::Values( ::perf::sz1080p, ::perf::sz2160p ),
+                testing::Values( 0 )
+                )
+            )
+{
+    Size sz = get<0>(GetParam());
+
+    Mat image;
+    makeHoughLinesImage(sz, image);
+
+    vector<Vec2f> lines;
+    declare.time(60);
+
+    TEST_CYCLE() HoughLines(image, lines, 1, CV_PI/180, 300);
+
+    SANITY_CHECK_NOTHING();
+}
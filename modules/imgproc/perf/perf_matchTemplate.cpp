@@ -81,3 +81,68 @@ PERF_TEST_P(ImgSize_TmplSize_Method, matchTemplateBig,
 
     SANITY_CHECK(result, eps);
 }
+
+PERF_TEST_P(ImgSize_TmplSize_Method, matchTemplateSmallColor,
+            testing::Combine(
+                testing::Values(cv::Size(640, 480), cv::Size(1280, 1024)),
+                testing::Values(cv::Size(8, 8), cv::Size(16, 16), cv::Size(32, 32)),
+                MethodType::all()
+                )
+            )
+{
+    Size imgSz = get<0>(GetParam());
+    Size tmplSz = get<1>(GetParam());
+    int method = get<2>(GetParam());
+
+    Mat img(imgSz, CV_8UC3);
+    Mat tmpl(tmplSz, CV_8UC3);
+    Mat result(imgSz - tmplSz + Size(1,1), CV_32F);
+
+    declare
+        .in(img, WARMUP_RNG)
+        .in(tmpl, WARMUP_RNG)
+        .out(result)
+        .time(30);
+
+    TEST_CYCLE() matchTemplate(img, tmpl, result, method);
+
+    bool isNormed =
+        method == CV_TM_CCORR_NORMED ||
+        method == CV_TM_SQDIFF_NORMED ||
+        method == CV_TM_CCOEFF_NORMED;
+    double eps = isNormed ? 3e-6
+        : 255 * 255 * tmpl.total() * 1e-6;
+
+    SANITY_CHECK(result, eps);
+}
+
+typedef std::tr1::tuple<Size, Size, int> ImgSize_TmplSize_Count_t;
+typedef perf::TestBaseWithParam<ImgSize_TmplSize_Count_t> ImgSize_TmplSize_Count;
+
+PERF_TEST_P(ImgSize_TmplSize_Count, matchTemplates,
+            testing::Combine(
+                testing::Values(cv::Size(640, 480), cv::Size(1280, 1024)),
+                testing::Values(cv::Size(24, 24), cv::Size(64, 64)),
+                testing::Values(1, 50, 200)
+                )
+            )
+{
+    Size imgSz = get<0>(GetParam());
+    Size tmplSz = get<1>(GetParam());
+    int count = get<2>(GetParam());
+
+    Mat img(imgSz, CV_8UC1);
+    vector<Mat> tmpls(count);
+    for( int i = 0; i < count; i++ )
+    {
+        tmpls[i].create(tmplSz, CV_8UC1);
+        declare.in(tmpls[i], WARMUP_RNG);
+    }
+    vector<Mat> results;
+
+    declare.in(img, WARMUP_RNG).time(100);
+
+    TEST_CYCLE() matchTemplates(img, tmpls, results, CV_TM_CCOEFF_NORMED);
+
+    SANITY_CHECK(results[0], 1e-6);
+}
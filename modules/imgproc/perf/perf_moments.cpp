@@ -0,0 +1,69 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+typedef std::tr1::tuple<Size, MatDepth, bool> MatSize_MatDepth_Binary_t;
+typedef perf::TestBaseWithParam<MatSize_MatDepth_Binary_t> MatSize_MatDepth_Binary;
+
+PERF_TEST_P(MatSize_MatDepth_Binary, Moments,
+            testing::Combine(
+                testing::Values(TYPICAL_MAT_SIZES, ::perf::sz2160p),
+                testing::Values(CV_8U, CV_16U, CV_32F),
+                testing::Bool()
+                )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int depth = get<1>(GetParam());
+    bool binary = get<2>(GetParam());
+
+    Mat src(sz, depth);
+    Moments m;
+
+    declare.in(src, WARMUP_RNG);
+
+    TEST_CYCLE() m = moments(src, binary);
+
+    double mom[] = { m.m00, m.m10, m.m01, m.m20, m.m11, m.m02, m.m30, m.m21, m.m12, m.m03 };
+    Mat dst(1, 10, CV_64F, mom);
+
+    SANITY_CHECK(dst, 2e-4, ERROR_RELATIVE);
+}
+
+typedef std::tr1::tuple<Size, int> MatSize_Labels_t;
+typedef perf::TestBaseWithParam<MatSize_Labels_t> MatSize_Labels;
+
+PERF_TEST_P(MatSize_Labels, labelMoments,
+            testing::Combine(
+                testing::Values(::perf::sz1080p, ::perf::sz2160p),
+                testing::Values(16, 1000)
+                )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int nlabels = get<1>(GetParam());
+
+    // rectangular regions of random labels
+    Mat labels(sz, CV_32SC1, Scalar::all(0));
+    RNG rng(12345);
+    for( int i = 0; i < nlabels*4; i++ )
+    {
+        Point pt(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Size rsz(rng.uniform(8, sz.width/8), rng.uniform(8, sz.height/8));
+        rectangle(labels, Rect(pt, rsz), Scalar::all(rng.uniform(0, nlabels)), -1);
+    }
+
+    vector<Moments> mu;
+
+    TEST_CYCLE() labelMoments(labels, mu, nlabels);
+
+    Mat m00(1, nlabels, CV_64F);
+    for( int l = 0; l < nlabels; l++ )
+        m00.at<double>(l) = mu[l].m00;
+
+    SANITY_CHECK(m00);
+}
@@ -68,3 +68,61 @@ PERF_TEST_P( TestRemap, Remap,
 
     SANITY_CHECK(dst);
 }
+
+typedef TestBaseWithParam< tr1::tuple<MatType, MatType, double> > TestRemapRotation;
+
+PERF_TEST_P( TestRemapRotation, RemapRotation4K,
+             Combine(
+                Values( CV_8UC1, CV_8UC4, CV_32FC1 ),
+                Values( CV_16SC2, CV_32FC1 ),
+                Values( 0., 30., 90. )
+             )
+)
+{
+    int type = get<0>(GetParam()), map1_type = get<1>(GetParam());
+    double angle = get<2>(GetParam());
+    Size sz = sz2160p;
+    Mat src(sz, type), dst(sz, type);
+    declare.in(src, WARMUP_RNG).out(dst).time(30);
+
+    Mat M = getRotationMatrix2D(Point2f(sz.width/2.f, sz.height/2.f), angle, 1.);
+    Mat_<float> mapx(sz), mapy(sz);
+    for( int y = 0; y < sz.height; y++ )
+        for( int x = 0; x < sz.width; x++ )
+        {
+            mapx(y, x) = (float)(M.at<double>(0, 0)*x + M.at<double>(0, 1)*y + M.at<double>(0, 2));
+            mapy(y, x) = (float)(M.at<double>(1, 0)*x + M.at<double>(1, 1)*y + M.at<double>(1, 2));
+        }
+    Mat map1 = mapx, map2 = mapy;
+    if( map1_type == CV_16SC2 )
+        convertMaps(mapx, mapy, map1, map2, CV_16SC2);
+
+    TEST_CYCLE() remap(src, dst, map1, map2, INTER_LINEAR);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef TestBaseWithParam< tr1::tuple<Size, Size> > TestUndistortRectifyPlan;
+
+PERF_TEST_P( TestUndistortRectifyPlan, UndistortResizeCvtColor,
+             Combine(
+                Values( sz1080p, sz2160p ),
+                Values( szVGA, sz720p )
+             )
+)
+{
+    Size sz = get<0>(GetParam()), dsz = get<1>(GetParam());
+    Mat src(sz, CV_8UC3), dst(dsz, CV_8UC1);
+    declare.in(src, WARMUP_RNG).out(dst).time(20);
+
+    Mat_<double> A(3, 3);
+    A << sz.width*0.8, 0, sz.width*0.5, 0, sz.width*0.8, sz.height*0.5, 0, 0, 1;
+    Mat_<double> k(1, 5);
+    k << -0.2, 0.05, 0.001, -0.001, 0;
+
+    UndistortRectifyPlan plan(A, k, noArray(), A, sz, dsz, INTER_LINEAR, COLOR_BGR2GRAY);
+
+    TEST_CYCLE() plan(src, dst);
+
+    SANITY_CHECK_NOTHING();
+}
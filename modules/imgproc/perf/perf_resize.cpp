@@ -120,3 +120,32 @@ PERF_TEST_P(MatInfo_Size_Scale_Area, ResizeArea,
     //difference equal to 1 is allowed because of different possible rounding modes: round-to-nearest vs bankers' rounding
     SANITY_CHECK(dst, 1);
 }
+
+CV_ENUM(IngestCode, -1, CV_BayerBG2BGR, CV_YUV2BGR_NV12, CV_YUV2BGR_YUY2)
+
+typedef tr1::tuple<IngestCode, Size, Size> IngestCode_Size_Size_t;
+typedef TestBaseWithParam<IngestCode_Size_Size_t> IngestCode_Size_Size;
+
+PERF_TEST_P(IngestCode_Size_Size, cvtColorResize,
+            testing::Combine(
+                IngestCode::all(),
+                testing::Values(sz1080p),
+                testing::Values(szVGA, Size(960, 540))
+                )
+            )
+{
+    int code = get<0>(GetParam());
+    Size sz = get<1>(GetParam());
+    Size dsize = get<2>(GetParam());
+
+    int type = code == CV_BayerBG2BGR ? CV_8UC1 : code == CV_YUV2BGR_NV12 ? CV_8UC1 :
+               code == CV_YUV2BGR_YUY2 ? CV_8UC2 : CV_8UC3;
+    Size srcSize(sz.width, code == CV_YUV2BGR_NV12 ? sz.height*3/2 : sz.height);
+
+    Mat src(srcSize, type), dst(dsize, CV_32FC3);
+    declare.in(src, WARMUP_RNG).out(dst);
+
+    TEST_CYCLE() cvtColorResize(src, dst, code, dsize, 0, 0, INTER_LINEAR, CV_32F, 1./255);
+
+    SANITY_CHECK_NOTHING();
+}
@@ -0,0 +1,68 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+static void makeSegmentationSource(Mat& img)
+{
+    Mat noise(img.size(), CV_8UC3);
+    randu(noise, 0, 256);
+    GaussianBlur(noise, img, Size(9, 9), 4);
+}
+
+typedef std::tr1::tuple<Size, int> Size_MarkersCount_t;
+typedef perf::TestBaseWithParam<Size_MarkersCount_t> Size_MarkersCount;
+
+PERF_TEST_P(Size_MarkersCount, watershed,
+            testing::Combine(
+                testing::Values(::perf::szVGA, ::perf::sz1080p),
+                testing::Values(16, 256)
+                )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int count = get<1>(GetParam());
+
+    Mat img(sz, CV_8UC3), markers0(sz, CV_32SC1, Scalar(0)), markers;
+    makeSegmentationSource(img);
+
+    RNG& rng = theRNG();
+    for( int i = 0; i < count; i++ )
+        circle(markers0, Point(rng.uniform(0, sz.width), rng.uniform(0, sz.height)), 4, Scalar(i + 1), -1);
+
+    declare.in(img, markers0);
+
+    TEST_CYCLE()
+    {
+        markers0.copyTo(markers);
+        watershed(img, markers);
+    }
+
+    SANITY_CHECK(markers);
+}
+
+typedef std::tr1::tuple<Size, int> Size_MaxLevel_t;
+typedef perf::TestBaseWithParam<Size_MaxLevel_t> Size_MaxLevel;
+
+PERF_TEST_P(Size_MaxLevel, pyrMeanShiftFiltering,
+            testing::Combine(
+                testing::Values(::perf::szVGA, ::perf::sz1080p),
+                testing::Values(0, 1)
+                )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int maxLevel = get<1>(GetParam());
+
+    Mat img(sz, CV_8UC3), dst(sz, CV_8UC3);
+    makeSegmentationSource(img);
+
+    declare.in(img).out(dst).time(60);
+
+    TEST_CYCLE() pyrMeanShiftFiltering(img, dst, 20, 30, maxLevel);
+
+    SANITY_CHECK(dst, 1);
+}
@@ -90,3 +90,39 @@ PERF_TEST_P(Size_AdaptThreshType_AdaptThreshMethod_BlockSize, adaptiveThreshold,
 
     SANITY_CHECK(dst);
 }
+
+typedef std::tr1::tuple<AdaptThreshMethod, int> AdaptThreshMethod_BlockSize_t;
+typedef perf::TestBaseWithParam<AdaptThreshMethod_BlockSize_t> AdaptThreshMethod_BlockSize;
+
+// document scanning: a 20 MP page
+PERF_TEST_P(AdaptThreshMethod_BlockSize, adaptiveThreshold_20MP,
+            testing::Combine(
+                AdaptThreshMethod::all(),
+                testing::Values(11, 51)
+                )
+            )
+{
+    AdaptThreshMethod adaptThreshMethod = get<0>(GetParam());
+    int blockSize = get<1>(GetParam());
+
+    Mat src(Size(5472, 3648), CV_8UC1);
+    Mat dst(src.size(), CV_8UC1);
+
+    declare.in(src, WARMUP_RNG).out(dst).time(100);
+
+    TEST_CYCLE() adaptiveThreshold(src, dst, 255, adaptThreshMethod, THRESH_BINARY, blockSize, 10);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST(Threshold, threshold_otsu_20MP)
+{
+    Mat src(Size(5472, 3648), CV_8UC1);
+    Mat dst(src.size(), CV_8UC1);
+
+    declare.in(src, WARMUP_RNG).out(dst).time(100);
+
+    TEST_CYCLE() threshold(src, dst, 0, 255, THRESH_BINARY|THRESH_OTSU);
+
+    SANITY_CHECK_NOTHING();
+}
@@ -50,6 +50,49 @@ PERF_TEST_P( TestWarpAffine, WarpAffine,
 #endif
 }
 
+typedef TestBaseWithParam< tr1::tuple<MatType, double> > TestWarpAffineRotation;
+
+PERF_TEST_P( TestWarpAffineRotation, WarpAffineRotation4K,
+             Combine(
+                Values( CV_8UC1, CV_8UC4, CV_32FC1 ),
+                Values( 0., 30., 90. )
+             )
+)
+{
+    int type = get<0>(GetParam());
+    double angle = get<1>(GetParam());
+    Mat src(sz2160p, type), dst(sz2160p, type);
+    Mat warpMat = getRotationMatrix2D(Point2f(src.cols/2.f, src.rows/2.f), angle, 1.);
+    declare.in(src, WARMUP_RNG).out(dst).time(30);
+
+    TEST_CYCLE() warpAffine( src, dst, warpMat, dst.size(), INTER_LINEAR, BORDER_CONSTANT );
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef TestBaseWithParam< tr1::tuple<MatType, double> > TestWarpPerspectiveRotation;
+
+PERF_TEST_P( TestWarpPerspectiveRotation, WarpPerspectiveRotation4K,
+             Combine(
+                Values( CV_8UC1, CV_8UC4, CV_32FC1 ),
+                Values( 0., 30., 90. )
+             )
+)
+{
+    int type = get<0>(GetParam());
+    double angle = get<1>(GetParam());
+    Mat src(sz2160p, type), dst(sz2160p, type);
+    Mat rotMat = getRotationMatrix2D(Point2f(src.cols/2.f, src.rows/2.f), angle, 1.);
+    Mat warpMat = Mat::eye(3, 3, CV_64F);
+    rotMat.copyTo(warpMat.rowRange(0, 2));
+    warpMat.at<double>(2, 0) = 1e-5;
+    declare.in(src, WARMUP_RNG).out(dst).time(30);
+
+    TEST_CYCLE() warpPerspective( src, dst, warpMat, dst.size(), INTER_LINEAR, BORDER_CONSTANT );
+
+    SANITY_CHECK_NOTHING();
+}
+
 PERF_TEST_P( TestWarpPerspective, WarpPerspective,
              Combine(
                 Values( szVGA, sz720p, sz1080p ),
@@ -45,10 +45,285 @@
 namespace cv
 {
 
+// The vectorized kernels return the number of the processed elements (pixels when the mask is used)
+// and keep the operation order of the scalar code, so the results do not depend on the SIMD support.
+template<typename T, typename AT> struct Acc_SIMD
+{
+    int operator() (const T*, AT*, const uchar*, int, int) const { return 0; }
+};
+
+template<typename T, typename AT> struct AccSqr_SIMD
+{
+    int operator() (const T*, AT*, const uchar*, int, int) const { return 0; }
+};
+
+template<typename T, typename AT> struct AccProd_SIMD
+{
+    int operator() (const T*, const T*, AT*, const uchar*, int, int) const { return 0; }
+};
+
+template<typename T, typename AT> struct AccW_SIMD
+{
+    int operator() (const T*, AT*, const uchar*, int, int, AT) const { return 0; }
+};
+
+#if CV_SSE2
+
+// loads 16 uchar's and converts them to 4 vectors of floats
+static inline void load_8u32f( const uchar* src, __m128& v0, __m128& v1, __m128& v2, __m128& v3 )
+{
+    __m128i z = _mm_setzero_si128();
+    __m128i v = _mm_loadu_si128((const __m128i*)src);
+    __m128i lo = _mm_unpacklo_epi8(v, z), hi = _mm_unpackhi_epi8(v, z);
+    v0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, z));
+    v1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, z));
+    v2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, z));
+    v3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, z));
+}
+
+// expands 16 mask bytes to 4 vectors of all-ones/all-zeros 32-bit lanes
+static inline void load_mask_32( const uchar* mask, __m128& m0, __m128& m1, __m128& m2, __m128& m3 )
+{
+    __m128i z = _mm_setzero_si128();
+    __m128i m = _mm_cmpeq_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)mask), z), z);
+    __m128i lo = _mm_unpacklo_epi8(m, m), hi = _mm_unpackhi_epi8(m, m);
+    m0 = _mm_castsi128_ps(_mm_unpacklo_epi16(lo, lo));
+    m1 = _mm_castsi128_ps(_mm_unpackhi_epi16(lo, lo));
+    m2 = _mm_castsi128_ps(_mm_unpacklo_epi16(hi, hi));
+    m3 = _mm_castsi128_ps(_mm_unpackhi_epi16(hi, hi));
+}
+
+static inline __m128 select_ps( __m128 m, __m128 a, __m128 b )
+{
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+
+// computes dst[i] = op(s[i], dst[i]) for 16 consecutive 8u values, optionally under the mask
+template<class Op> static inline void process_8u32f( const uchar* src1, const uchar* src2,
+                                                     float* dst, const uchar* mask, const Op& op )
+{
+    __m128 s0, s1, s2, s3, t0, t1, t2, t3;
+    load_8u32f(src1, s0, s1, s2, s3);
+    if( src2 )
+    {
+        load_8u32f(src2, t0, t1, t2, t3);
+        s0 = _mm_mul_ps(s0, t0); s1 = _mm_mul_ps(s1, t1);
+        s2 = _mm_mul_ps(s2, t2); s3 = _mm_mul_ps(s3, t3);
+    }
+    __m128 d0 = _mm_loadu_ps(dst), d1 = _mm_loadu_ps(dst + 4);
+    __m128 d2 = _mm_loadu_ps(dst + 8), d3 = _mm_loadu_ps(dst + 12);
+    __m128 r0 = op(s0, d0), r1 = op(s1, d1), r2 = op(s2, d2), r3 = op(s3, d3);
+    if( mask )
+    {
+        __m128 m0, m1, m2, m3;
+        load_mask_32(mask, m0, m1, m2, m3);
+        r0 = select_ps(m0, r0, d0); r1 = select_ps(m1, r1, d1);
+        r2 = select_ps(m2, r2, d2); r3 = select_ps(m3, r3, d3);
+    }
+    _mm_storeu_ps(dst, r0); _mm_storeu_ps(dst + 4, r1);
+    _mm_storeu_ps(dst + 8, r2); _mm_storeu_ps(dst + 12, r3);
+}
+
+struct AccOp_32f
+{
+    __m128 operator()(__m128 s, __m128 d) const { return _mm_add_ps(s, d); }
+};
+
+struct AccSqrOp_32f
+{
+    __m128 operator()(__m128 s, __m128 d) const { return _mm_add_ps(_mm_mul_ps(s, s), d); }
+};
+
+struct AccWOp_32f
+{
+    AccWOp_32f(float _a) : a(_mm_set1_ps(_a)), b(_mm_set1_ps(1 - _a)) {}
+    __m128 operator()(__m128 s, __m128 d) const { return _mm_add_ps(_mm_mul_ps(s, a), _mm_mul_ps(d, b)); }
+    __m128 a, b;
+};
+
+template<class Op> static int accumulate_8u32f( const uchar* src1, const uchar* src2, float* dst,
+                                                const uchar* mask, int len, int cn, const Op& op )
+{
+    int x = 0;
+    if( !checkHardwareSupport(CV_CPU_SSE2) || (mask && cn != 1) )
+        return 0;
+
+    if( !mask )
+    {
+        len *= cn;
+        for( ; x <= len - 16; x += 16 )
+            process_8u32f(src1 + x, src2 ? src2 + x : 0, dst + x, 0, op);
+    }
+    else
+    {
+        for( ; x <= len - 16; x += 16 )
+            process_8u32f(src1 + x, src2 ? src2 + x : 0, dst + x, mask + x, op);
+    }
+    return x;
+}
+
+template<> struct Acc_SIMD<uchar, float>
+{
+    int operator() (const uchar* src, float* dst, const uchar* mask, int len, int cn) const
+    { return accumulate_8u32f(src, 0, dst, mask, len, cn, AccOp_32f()); }
+};
+
+template<> struct AccSqr_SIMD<uchar, float>
+{
+    int operator() (const uchar* src, float* dst, const uchar* mask, int len, int cn) const
+    { return accumulate_8u32f(src, 0, dst, mask, len, cn, AccSqrOp_32f()); }
+};
+
+template<> struct AccProd_SIMD<uchar, float>
+{
+    int operator() (const uchar* src1, const uchar* src2, float* dst, const uchar* mask, int len, int cn) const
+    { return accumulate_8u32f(src1, src2, dst, mask, len, cn, AccOp_32f()); }
+};
+
+template<> struct AccW_SIMD<uchar, float>
+{
+    int operator() (const uchar* src, float* dst, const uchar* mask, int len, int cn, float alpha) const
+    { return accumulate_8u32f(src, 0, dst, mask, len, cn, AccWOp_32f(alpha)); }
+};
+
+// 8u -> 64f: 4 values per iteration
+template<class Op> static int accumulate_8u64f( const uchar* src1, const uchar* src2, double* dst,
+                                                const uchar* mask, int len, int cn, const Op& op )
+{
+    int x = 0;
+    if( !checkHardwareSupport(CV_CPU_SSE2) || (mask && cn != 1) )
+        return 0;
+
+    if( !mask )
+        len *= cn;
+    __m128i z = _mm_setzero_si128();
+    for( ; x <= len - 4; x += 4 )
+    {
+        __m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int*)(src1 + x)), z), z);
+        __m128d s0 = _mm_cvtepi32_pd(v), s1 = _mm_cvtepi32_pd(_mm_srli_si128(v, 8));
+        if( src2 )
+        {
+            v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int*)(src2 + x)), z), z);
+            s0 = _mm_mul_pd(s0, _mm_cvtepi32_pd(v));
+            s1 = _mm_mul_pd(s1, _mm_cvtepi32_pd(_mm_srli_si128(v, 8)));
+        }
+        __m128d d0 = _mm_loadu_pd(dst + x), d1 = _mm_loadu_pd(dst + x + 2);
+        __m128d r0 = op(s0, d0), r1 = op(s1, d1);
+        if( mask )
+        {
+            __m128i m = _mm_cmpeq_epi8(_mm_cmpeq_epi8(_mm_cvtsi32_si128(*(const int*)(mask + x)), z), z);
+            m = _mm_unpacklo_epi8(m, m);
+            m = _mm_unpacklo_epi16(m, m);
+            __m128d m0 = _mm_castsi128_pd(_mm_unpacklo_epi32(m, m));
+            __m128d m1 = _mm_castsi128_pd(_mm_unpackhi_epi32(m, m));
+            r0 = _mm_or_pd(_mm_and_pd(m0, r0), _mm_andnot_pd(m0, d0));
+            r1 = _mm_or_pd(_mm_and_pd(m1, r1), _mm_andnot_pd(m1, d1));
+        }
+        _mm_storeu_pd(dst + x, r0);
+        _mm_storeu_pd(dst + x + 2, r1);
+    }
+    return x;
+}
+
+struct AccOp_64f
+{
+    __m128d operator()(__m128d s, __m128d d) const { return _mm_add_pd(s, d); }
+};
+
+struct AccSqrOp_64f
+{
+    __m128d operator()(__m128d s, __m128d d) const { return _mm_add_pd(_mm_mul_pd(s, s), d); }
+};
+
+struct AccWOp_64f
+{
+    AccWOp_64f(double _a) : a(_mm_set1_pd(_a)), b(_mm_set1_pd(1 - _a)) {}
+    __m128d operator()(__m128d s, __m128d d) const { return _mm_add_pd(_mm_mul_pd(s, a), _mm_mul_pd(d, b)); }
+    __m128d a, b;
+};
+
+template<> struct Acc_SIMD<uchar, double>
+{
+    int operator() (const uchar* src, double* dst, const uchar* mask, int len, int cn) const
+    { return accumulate_8u64f(src, 0, dst, mask, len, cn, AccOp_64f()); }
+};
+
+template<> struct AccSqr_SIMD<uchar, double>
+{
+    int operator() (const uchar* src, double* dst, const uchar* mask, int len, int cn) const
+    { return accumulate_8u64f(src, 0, dst, mask, len, cn, AccSqrOp_64f()); }
+};
+
+template<> struct AccProd_SIMD<uchar, double>
+{
+    int operator() (const uchar* src1, const uchar* src2, double* dst, const uchar* mask, int len, int cn) const
+    { return accumulate_8u64f(src1, src2, dst, mask, len, cn, AccOp_64f()); }
+};
+
+template<> struct AccW_SIMD<uchar, double>
+{
+    int operator() (const uchar* src, double* dst, const uchar* mask, int len, int cn, double alpha) const
+    { return accumulate_8u64f(src, 0, dst, mask, len, cn, AccWOp_64f(alpha)); }
+};
+
+// 32f -> 32f
+template<class Op> static int accumulate_32f( const float* src1, const float* src2, float* dst,
+                                              const uchar* mask, int len, int cn, const Op& op )
+{
+    int x = 0;
+    if( !checkHardwareSupport(CV_CPU_SSE2) || (mask && cn != 1) )
+        return 0;
+
+    if( !mask )
+        len *= cn;
+    __m128i z = _mm_setzero_si128();
+    for( ; x <= len - 4; x += 4 )
+    {
+        __m128 s = _mm_loadu_ps(src1 + x), d = _mm_loadu_ps(dst + x);
+        if( src2 )
+            s = _mm_mul_ps(s, _mm_loadu_ps(src2 + x));
+        __m128 r = op(s, d);
+        if( mask )
+        {
+            __m128i m = _mm_cmpeq_epi8(_mm_cmpeq_epi8(_mm_cvtsi32_si128(*(const int*)(mask + x)), z), z);
+            m = _mm_unpacklo_epi8(m, m);
+            r = select_ps(_mm_castsi128_ps(_mm_unpacklo_epi16(m, m)), r, d);
+        }
+        _mm_storeu_ps(dst + x, r);
+    }
+    return x;
+}
+
+template<> struct Acc_SIMD<float, float>
+{
+    int operator() (const float* src, float* dst, const uchar* mask, int len, int cn) const
+    { return accumulate_32f(src, 0, dst, mask, len, cn, AccOp_32f()); }
+};
+
+template<> struct AccSqr_SIMD<float, float>
+{
+    int operator() (const float* src, float* dst, const uchar* mask, int len, int cn) const
+    { return accumulate_32f(src, 0, dst, mask, len, cn, AccSqrOp_32f()); }
+};
+
+template<> struct AccProd_SIMD<float, float>
+{
+    int operator() (const float* src1, const float* src2, float* dst, const uchar* mask, int len, int cn) const
+    { return accumulate_32f(src1, src2, dst, mask, len, cn, AccOp_32f()); }
+};
+
+template<> struct AccW_SIMD<float, float>
+{
+    int operator() (const float* src, float* dst, const uchar* mask, int len, int cn, float alpha) const
+    { return accumulate_32f(src, 0, dst, mask, len, cn, AccWOp_32f(alpha)); }
+};
+
+#endif
+
 template<typename T, typename AT> void
 acc_( const T* src, AT* dst, const uchar* mask, int len, int cn )
 {
-    int i = 0;
+    int i = Acc_SIMD<T, AT>()(src, dst, mask, len, cn);
 
     if( !mask )
     {
@@ -106,7 +381,7 @@ acc_( const T* src, AT* dst, const uchar* mask, int len, int cn )
 template<typename T, typename AT> void
 accSqr_( const T* src, AT* dst, const uchar* mask, int len, int cn )
 {
-    int i = 0;
+    int i = AccSqr_SIMD<T, AT>()(src, dst, mask, len, cn);
 
     if( !mask )
     {
@@ -164,7 +439,7 @@ accSqr_( const T* src, AT* dst, const uchar* mask, int len, int cn )
 template<typename T, typename AT> void
 accProd_( const T* src1, const T* src2, AT* dst, const uchar* mask, int len, int cn )
 {
-    int i = 0;
+    int i = AccProd_SIMD<T, AT>()(src1, src2, dst, mask, len, cn);
 
     if( !mask )
     {
@@ -223,7 +498,7 @@ template<typename T, typename AT> void
 accW_( const T* src, AT* dst, const uchar* mask, int len, int cn, double alpha )
 {
     AT a = (AT)alpha, b = 1 - a;
-    int i = 0;
+    int i = AccW_SIMD<T, AT>()(src, dst, mask, len, cn, a);
 
     if( !mask )
     {
@@ -352,6 +627,73 @@ inline int getAccTabIdx(int sdepth, int ddepth)
            sdepth == CV_64F && ddepth == CV_64F ? 6 : -1;
 }
 
+// processes the 2D arrays by horizontal bands in parallel
+class AccumulateInvoker : public ParallelLoopBody
+{
+public:
+    AccumulateInvoker( const Mat& _src1, const Mat& _src2, Mat& _dst, const Mat& _mask,
+                       AccFunc _func, AccProdFunc _prodFunc, AccWFunc _wFunc, double _alpha ) :
+        src1(&_src1), src2(&_src2), dst(&_dst), mask(&_mask),
+        func(_func), prodFunc(_prodFunc), wFunc(_wFunc), alpha(_alpha)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int cols = dst->cols, cn = dst->channels();
+        for( int y = range.start; y < range.end; y++ )
+        {
+            const uchar* s1 = src1->ptr(y);
+            uchar* d = dst->ptr(y);
+            const uchar* m = mask->data ? mask->ptr(y) : 0;
+
+            if( func )
+                func(s1, d, m, cols, cn);
+            else if( prodFunc )
+                prodFunc(s1, src2->ptr(y), d, m, cols, cn);
+            else
+                wFunc(s1, d, m, cols, cn, alpha);
+        }
+    }
+
+private:
+    const Mat *src1, *src2;
+    Mat* dst;
+    const Mat* mask;
+    AccFunc func;
+    AccProdFunc prodFunc;
+    AccWFunc wFunc;
+    double alpha;
+};
+
+static void accumulateImpl( const Mat& src1, const Mat& src2, Mat& dst, const Mat& mask,
+                            AccFunc func, AccProdFunc prodFunc, AccWFunc wFunc, double alpha )
+{
+    int cn = dst.channels();
+
+    if( dst.dims <= 2 )
+    {
+        AccumulateInvoker invoker(src1, src2, dst, mask, func, prodFunc, wFunc, alpha);
+        parallel_for_(Range(0, dst.rows), invoker, dst.total()/(double)(1<<16));
+        return;
+    }
+
+    const Mat* arrays[] = {&src1, &src2, &dst, &mask, 0};
+    uchar* ptrs[4];
+    NAryMatIterator it(arrays, ptrs);
+    int len = (int)it.size;
+
+    for( size_t i = 0; i < it.nplanes; i++, ++it )
+    {
+        if( func )
+            func(ptrs[0], ptrs[2], ptrs[3], len, cn);
+        else if( prodFunc )
+            prodFunc(ptrs[0], ptrs[1], ptrs[2], ptrs[3], len, cn);
+        else
+            wFunc(ptrs[0], ptrs[2], ptrs[3], len, cn, alpha);
+    }
+}
+
 }
 
 void cv::accumulate( InputArray _src, InputOutputArray _dst, InputArray _mask )
@@ -366,13 +708,7 @@ void cv::accumulate( InputArray _src, InputOutputArray _dst, InputArray _mask )
     AccFunc func = fidx >= 0 ? accTab[fidx] : 0;
     CV_Assert( func != 0 );
 
-    const Mat* arrays[] = {&src, &dst, &mask, 0};
-    uchar* ptrs[3];
-    NAryMatIterator it(arrays, ptrs);
-    int len = (int)it.size;
-
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
-        func(ptrs[0], ptrs[1], ptrs[2], len, cn);
+    accumulateImpl( src, Mat(), dst, mask, func, 0, 0, 0 );
 }
 
 
@@ -388,13 +724,7 @@ void cv::accumulateSquare( InputArray _src, InputOutputArray _dst, InputArray _m
     AccFunc func = fidx >= 0 ? accSqrTab[fidx] : 0;
     CV_Assert( func != 0 );
 
-    const Mat* arrays[] = {&src, &dst, &mask, 0};
-    uchar* ptrs[3];
-    NAryMatIterator it(arrays, ptrs);
-    int len = (int)it.size;
-
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
-        func(ptrs[0], ptrs[1], ptrs[2], len, cn);
+    accumulateImpl( src, Mat(), dst, mask, func, 0, 0, 0 );
 }
 
 void cv::accumulateProduct( InputArray _src1, InputArray _src2,
@@ -411,13 +741,7 @@ void cv::accumulateProduct( InputArray _src1, InputArray _src2,
     AccProdFunc func = fidx >= 0 ? accProdTab[fidx] : 0;
     CV_Assert( func != 0 );
 
-    const Mat* arrays[] = {&src1, &src2, &dst, &mask, 0};
-    uchar* ptrs[4];
-    NAryMatIterator it(arrays, ptrs);
-    int len = (int)it.size;
-
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
-        func(ptrs[0], ptrs[1], ptrs[2], ptrs[3], len, cn);
+    accumulateImpl( src1, src2, dst, mask, 0, func, 0, 0 );
 }
 
 
@@ -434,13 +758,7 @@ void cv::accumulateWeighted( InputArray _src, InputOutputArray _dst,
     AccWFunc func = fidx >= 0 ? accWTab[fidx] : 0;
     CV_Assert( func != 0 );
 
-    const Mat* arrays[] = {&src, &dst, &mask, 0};
-    uchar* ptrs[3];
-    NAryMatIterator it(arrays, ptrs);
-    int len = (int)it.size;
-
-    for( size_t i = 0; i < it.nplanes; i++, ++it )
-        func(ptrs[0], ptrs[1], ptrs[2], len, cn, alpha);
+    accumulateImpl( src, Mat(), dst, mask, 0, 0, func, alpha );
 }
 
 
@@ -160,6 +160,63 @@ template<> struct ColorChannel<float>
     static double half() { return 0.5; }
 };*/
 
+#if CV_SSE2
+
+// 3-channel 8-bit data, 32 pixels in v[0..5] => planes c0 = (v[0], v[1]), c1 = (v[2], v[3]), c2 = (v[4], v[5]).
+// Each pass interleaves the lower and the upper half of the block, i.e. maps byte p to 2p mod 95,
+// so 5 passes move byte 3*i + c to 32*c + i.
+static inline void _mm_deinterleave3_epi8(__m128i* v)
+{
+    for( int pass = 0; pass < 5; pass++ )
+    {
+        __m128i t0 = _mm_unpacklo_epi8(v[0], v[3]), t1 = _mm_unpackhi_epi8(v[0], v[3]);
+        __m128i t2 = _mm_unpacklo_epi8(v[1], v[4]), t3 = _mm_unpackhi_epi8(v[1], v[4]);
+        __m128i t4 = _mm_unpacklo_epi8(v[2], v[5]), t5 = _mm_unpackhi_epi8(v[2], v[5]);
+        v[0] = t0; v[1] = t1; v[2] = t2; v[3] = t3; v[4] = t4; v[5] = t5;
+    }
+}
+
+// the same for 4-channel data, 16 pixels in v[0..3] => planes v[0], v[1], v[2], v[3]
+static inline void _mm_deinterleave4_epi8(__m128i* v)
+{
+    for( int pass = 0; pass < 4; pass++ )
+    {
+        __m128i t0 = _mm_unpacklo_epi8(v[0], v[2]), t1 = _mm_unpackhi_epi8(v[0], v[2]);
+        __m128i t2 = _mm_unpacklo_epi8(v[1], v[3]), t3 = _mm_unpackhi_epi8(v[1], v[3]);
+        v[0] = t0; v[1] = t1; v[2] = t2; v[3] = t3;
+    }
+}
+
+// the inverse of _mm_deinterleave3_epi8: each pass gathers the even bytes of the block
+// into its lower half and the odd bytes into its upper half
+static inline void _mm_interleave3_epi8(__m128i* v)
+{
+    const __m128i lmask = _mm_set1_epi16(0x00ff);
+    for( int pass = 0; pass < 5; pass++ )
+    {
+        __m128i t0 = _mm_packus_epi16(_mm_and_si128(v[0], lmask), _mm_and_si128(v[1], lmask));
+        __m128i t1 = _mm_packus_epi16(_mm_and_si128(v[2], lmask), _mm_and_si128(v[3], lmask));
+        __m128i t2 = _mm_packus_epi16(_mm_and_si128(v[4], lmask), _mm_and_si128(v[5], lmask));
+        __m128i t3 = _mm_packus_epi16(_mm_srli_epi16(v[0], 8), _mm_srli_epi16(v[1], 8));
+        __m128i t4 = _mm_packus_epi16(_mm_srli_epi16(v[2], 8), _mm_srli_epi16(v[3], 8));
+        __m128i t5 = _mm_packus_epi16(_mm_srli_epi16(v[4], 8), _mm_srli_epi16(v[5], 8));
+        v[0] = t0; v[1] = t1; v[2] = t2; v[3] = t3; v[4] = t4; v[5] = t5;
+    }
+}
+
+// stores 16 pixels given as 4 planes
+static inline void _mm_storeu_interleave4_epi8(uchar* dst, __m128i c0, __m128i c1, __m128i c2, __m128i c3)
+{
+    __m128i t0 = _mm_unpacklo_epi8(c0, c1), t1 = _mm_unpackhi_epi8(c0, c1);
+    __m128i t2 = _mm_unpacklo_epi8(c2, c3), t3 = _mm_unpackhi_epi8(c2, c3);
+    _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(t0, t2));
+    _mm_storeu_si128((__m128i*)(dst + 16), _mm_unpackhi_epi16(t0, t2));
+    _mm_storeu_si128((__m128i*)(dst + 32), _mm_unpacklo_epi16(t1, t3));
+    _mm_storeu_si128((__m128i*)(dst + 48), _mm_unpackhi_epi16(t1, t3));
+}
+
+#endif
+
 
 ///////////////////////////// Top-level template function ////////////////////////////////
 
@@ -633,6 +690,59 @@ struct Gray2RGB
     int dstcn;
 };
 
+#if CV_SSE2
+template<> struct Gray2RGB<uchar>
+{
+    typedef uchar channel_type;
+
+    Gray2RGB(int _dstcn) : dstcn(_dstcn)
+    {
+        haveSIMD = checkHardwareSupport(CV_CPU_SSE2);
+    }
+    void operator()(const uchar* src, uchar* dst, int n) const
+    {
+        int i = 0;
+        if( dstcn == 3 )
+        {
+            if( haveSIMD )
+                for( ; i <= n - 32; i += 32, dst += 96 )
+                {
+                    __m128i v[6];
+                    v[0] = v[2] = v[4] = _mm_loadu_si128((const __m128i*)(src + i));
+                    v[1] = v[3] = v[5] = _mm_loadu_si128((const __m128i*)(src + i + 16));
+                    _mm_interleave3_epi8(v);
+                    for( int k = 0; k < 6; k++ )
+                        _mm_storeu_si128((__m128i*)(dst + k*16), v[k]);
+                }
+            for( ; i < n; i++, dst += 3 )
+            {
+                dst[0] = dst[1] = dst[2] = src[i];
+            }
+        }
+        else
+        {
+            if( haveSIMD )
+            {
+                __m128i alpha = _mm_set1_epi8(-1);
+                for( ; i <= n - 16; i += 16, dst += 64 )
+                {
+                    __m128i g = _mm_loadu_si128((const __m128i*)(src + i));
+                    _mm_storeu_interleave4_epi8(dst, g, g, g, alpha);
+                }
+            }
+            for( ; i < n; i++, dst += 4 )
+            {
+                dst[0] = dst[1] = dst[2] = src[i];
+                dst[3] = uchar(255);
+            }
+        }
+    }
+
+    int dstcn;
+    bool haveSIMD;
+};
+#endif
+
 
 struct Gray2RGB5x5
 {
@@ -743,14 +853,71 @@ template<> struct RGB2Gray<uchar>
             tab[i+256] = g;
             tab[i+512] = r;
         }
+
+    #if CV_SSE2
+        // the vectorized loop computes the same sum as the tables,
+        // b*db + g*dg + r*dr + (1 << (yuv_shift-1)), with _mm_madd_epi16
+        haveSIMD = checkHardwareSupport(CV_CPU_SSE2) &&
+            std::abs(db) <= SHRT_MAX && std::abs(dg) <= SHRT_MAX && std::abs(dr) <= SHRT_MAX;
+        ccoeffs[0] = db; ccoeffs[1] = dg; ccoeffs[2] = dr;
+    #endif
     }
     void operator()(const uchar* src, uchar* dst, int n) const
     {
-        int scn = srccn;
+        int scn = srccn, i = 0;
         const int* _tab = tab;
-        for(int i = 0; i < n; i++, src += scn)
+    #if CV_SSE2
+        if( haveSIMD )
+        {
+            __m128i c01 = _mm_set1_epi32((ccoeffs[1] << 16) | (ccoeffs[0] & 0xffff));
+            __m128i c2r = _mm_set1_epi32((1 << (yuv_shift-1+16)) | (ccoeffs[2] & 0xffff));
+            if( scn == 3 )
+                for( ; i <= n - 32; i += 32, src += 96 )
+                {
+                    __m128i v[6];
+                    for( int k = 0; k < 6; k++ )
+                        v[k] = _mm_loadu_si128((const __m128i*)(src + k*16));
+                    _mm_deinterleave3_epi8(v);
+                    _mm_storeu_si128((__m128i*)(dst + i), rgb2gray(v[0], v[2], v[4], c01, c2r));
+                    _mm_storeu_si128((__m128i*)(dst + i + 16), rgb2gray(v[1], v[3], v[5], c01, c2r));
+                }
+            else
+                for( ; i <= n - 16; i += 16, src += 64 )
+                {
+                    __m128i v[4];
+                    for( int k = 0; k < 4; k++ )
+                        v[k] = _mm_loadu_si128((const __m128i*)(src + k*16));
+                    _mm_deinterleave4_epi8(v);
+                    _mm_storeu_si128((__m128i*)(dst + i), rgb2gray(v[0], v[1], v[2], c01, c2r));
+                }
+        }
+    #endif
+        for( ; i < n; i++, src += scn)
             dst[i] = (uchar)((_tab[src[0]] + _tab[src[1]+256] + _tab[src[2]+512]) >> yuv_shift);
     }
+
+#if CV_SSE2
+    // c01 holds the (src[0], src[1]) coefficient pairs, c2r the (src[2], rounding) pairs
+    static inline __m128i rgb2gray(__m128i s0, __m128i s1, __m128i s2, __m128i c01, __m128i c2r)
+    {
+        __m128i z = _mm_setzero_si128(), one = _mm_set1_epi16(1), res[2];
+        for( int k = 0; k < 2; k++ )
+        {
+            __m128i a0 = k == 0 ? _mm_unpacklo_epi8(s0, z) : _mm_unpackhi_epi8(s0, z);
+            __m128i a1 = k == 0 ? _mm_unpacklo_epi8(s1, z) : _mm_unpackhi_epi8(s1, z);
+            __m128i a2 = k == 0 ? _mm_unpacklo_epi8(s2, z) : _mm_unpackhi_epi8(s2, z);
+            __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a0, a1), c01),
+                                       _mm_madd_epi16(_mm_unpacklo_epi16(a2, one), c2r));
+            __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a0, a1), c01),
+                                       _mm_madd_epi16(_mm_unpackhi_epi16(a2, one), c2r));
+            res[k] = _mm_packs_epi32(_mm_srai_epi32(lo, yuv_shift), _mm_srai_epi32(hi, yuv_shift));
+        }
+        return _mm_packus_epi16(res[0], res[1]);
+    }
+
+    bool haveSIMD;
+    int ccoeffs[3];
+#endif
     int srccn;
     int tab[256*3];
 };
@@ -3056,12 +3223,125 @@ const int ITUR_BT_601_CBU =  460324;
 const int ITUR_BT_601_CGV = -385875;
 const int ITUR_BT_601_CBV = -74448;
 
+#if CV_SSE2
+
+// Vectorized YUV420 -> RGB for the 8u invokers below. The results are bit-exact:
+// the 32-bit products x*C are computed with _mm_madd_epi16 as ((x*Chi) << 16) + x*Clo,
+// where Clo is the signed lower 16-bit half of C.
+class YUV420toRGB_SSE2
+{
+public:
+    YUV420toRGB_SSE2()
+    {
+        use_simd = checkHardwareSupport(CV_CPU_SSE2);
+    }
+
+    // converts 32 pixels of two luma rows sharing 16 (u, v) pairs
+    template<int bIdx, int dcn>
+    void cvt(const uchar* y1, const uchar* y2, __m128i u, __m128i v, uchar* row1, uchar* row2) const
+    {
+        const __m128i z = _mm_setzero_si128(), c128 = _mm_set1_epi16(128);
+        const __m128i delta = _mm_set1_epi32(1 << (ITUR_BT_601_SHIFT - 1));
+        const __m128i crl = coeffs(ITUR_BT_601_CVR, 0, false), crh = coeffs(ITUR_BT_601_CVR, 0, true);
+        const __m128i cgl = coeffs(ITUR_BT_601_CVG, ITUR_BT_601_CUG, false), cgh = coeffs(ITUR_BT_601_CVG, ITUR_BT_601_CUG, true);
+        const __m128i cbl = coeffs(0, ITUR_BT_601_CUB, false), cbh = coeffs(0, ITUR_BT_601_CUB, true);
+
+        // chroma terms for (u, v) pairs 4*k .. 4*k+3
+        __m128i ruv[4], guv[4], buv[4];
+        for( int k = 0; k < 2; k++ )
+        {
+            __m128i u16 = _mm_sub_epi16(k == 0 ? _mm_unpacklo_epi8(u, z) : _mm_unpackhi_epi8(u, z), c128);
+            __m128i v16 = _mm_sub_epi16(k == 0 ? _mm_unpacklo_epi8(v, z) : _mm_unpackhi_epi8(v, z), c128);
+            __m128i vu0 = _mm_unpacklo_epi16(v16, u16), vu1 = _mm_unpackhi_epi16(v16, u16);
+            ruv[k*2] = _mm_add_epi32(mul(vu0, crl, crh), delta);
+            guv[k*2] = _mm_add_epi32(mul(vu0, cgl, cgh), delta);
+            buv[k*2] = _mm_add_epi32(mul(vu0, cbl, cbh), delta);
+            ruv[k*2+1] = _mm_add_epi32(mul(vu1, crl, crh), delta);
+            guv[k*2+1] = _mm_add_epi32(mul(vu1, cgl, cgh), delta);
+            buv[k*2+1] = _mm_add_epi32(mul(vu1, cbl, cbh), delta);
+        }
+
+        cvtRow<bIdx, dcn>(y1, ruv, guv, buv, row1);
+        cvtRow<bIdx, dcn>(y2, ruv, guv, buv, row2);
+    }
+
+    bool use_simd;
+
+private:
+    static inline __m128i coeffs(int c0, int c1, bool hi)
+    {
+        short l0 = (short)(c0 & 0xffff), l1 = (short)(c1 & 0xffff);
+        if( hi )
+            l0 = (short)((c0 - l0) >> 16), l1 = (short)((c1 - l1) >> 16);
+        return _mm_set1_epi32(((int)(ushort)l1 << 16) | (ushort)l0);
+    }
+
+    static inline __m128i mul(__m128i x, __m128i cl, __m128i ch)
+    {
+        return _mm_add_epi32(_mm_slli_epi32(_mm_madd_epi16(x, ch), 16), _mm_madd_epi16(x, cl));
+    }
+
+    // 16 output values of one channel from 16 scaled luma values (y[0..3]) and 8 chroma terms
+    static inline __m128i channel(const __m128i* y, __m128i cuv0, __m128i cuv1)
+    {
+        __m128i r0 = _mm_srai_epi32(_mm_add_epi32(y[0], _mm_unpacklo_epi32(cuv0, cuv0)), ITUR_BT_601_SHIFT);
+        __m128i r1 = _mm_srai_epi32(_mm_add_epi32(y[1], _mm_unpackhi_epi32(cuv0, cuv0)), ITUR_BT_601_SHIFT);
+        __m128i r2 = _mm_srai_epi32(_mm_add_epi32(y[2], _mm_unpacklo_epi32(cuv1, cuv1)), ITUR_BT_601_SHIFT);
+        __m128i r3 = _mm_srai_epi32(_mm_add_epi32(y[3], _mm_unpackhi_epi32(cuv1, cuv1)), ITUR_BT_601_SHIFT);
+        return _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3));
+    }
+
+    template<int bIdx, int dcn>
+    static void cvtRow(const uchar* y, const __m128i* ruv, const __m128i* guv, const __m128i* buv, uchar* row)
+    {
+        const __m128i z = _mm_setzero_si128(), c16 = _mm_set1_epi16(16);
+        const __m128i cyl = coeffs(ITUR_BT_601_CY, 0, false), cyh = coeffs(ITUR_BT_601_CY, 0, true);
+        __m128i r[2], g[2], b[2];
+
+        for( int k = 0; k < 2; k++ )
+        {
+            __m128i y8 = _mm_loadu_si128((const __m128i*)(y + k*16)), ys[4];
+            __m128i y16 = _mm_max_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(y8, z), c16), z);
+            ys[0] = mul(_mm_unpacklo_epi16(y16, z), cyl, cyh);
+            ys[1] = mul(_mm_unpackhi_epi16(y16, z), cyl, cyh);
+            y16 = _mm_max_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(y8, z), c16), z);
+            ys[2] = mul(_mm_unpacklo_epi16(y16, z), cyl, cyh);
+            ys[3] = mul(_mm_unpackhi_epi16(y16, z), cyl, cyh);
+
+            r[k] = channel(ys, ruv[k*2], ruv[k*2+1]);
+            g[k] = channel(ys, guv[k*2], guv[k*2+1]);
+            b[k] = channel(ys, buv[k*2], buv[k*2+1]);
+        }
+
+        __m128i* c0 = bIdx == 0 ? b : r;
+        __m128i* c2 = bIdx == 0 ? r : b;
+        if( dcn == 3 )
+        {
+            __m128i v[6] = { c0[0], c0[1], g[0], g[1], c2[0], c2[1] };
+            _mm_interleave3_epi8(v);
+            for( int k = 0; k < 6; k++ )
+                _mm_storeu_si128((__m128i*)(row + k*16), v[k]);
+        }
+        else
+        {
+            __m128i alpha = _mm_set1_epi8(-1);
+            _mm_storeu_interleave4_epi8(row, c0[0], g[0], c2[0], alpha);
+            _mm_storeu_interleave4_epi8(row + 64, c0[1], g[1], c2[1], alpha);
+        }
+    }
+};
+
+#endif
+
 template<int bIdx, int uIdx>
 struct YUV420sp2RGB888Invoker : ParallelLoopBody
 {
     Mat* dst;
     const uchar* my1, *muv;
     int width, stride;
+#if CV_SSE2
+    YUV420toRGB_SSE2 simd;
+#endif
 
     YUV420sp2RGB888Invoker(Mat* _dst, int _stride, const uchar* _y1, const uchar* _uv)
         : dst(_dst), my1(_y1), muv(_uv), width(_dst->cols), stride(_stride) {}
@@ -3092,7 +3372,22 @@ struct YUV420sp2RGB888Invoker : ParallelLoopBody
             uchar* row2 = dst->ptr<uchar>(j + 1);
             const uchar* y2 = y1 + stride;
 
-            for (int i = 0; i < width; i += 2, row1 += 6, row2 += 6)
+            int i = 0;
+#if CV_SSE2
+            if( simd.use_simd )
+            {
+                const __m128i lmask = _mm_set1_epi16(0x00ff);
+                for ( ; i <= width - 32; i += 32, row1 += 32*3, row2 += 32*3)
+                {
+                    __m128i uv0 = _mm_loadu_si128((const __m128i*)(uv + i));
+                    __m128i uv1 = _mm_loadu_si128((const __m128i*)(uv + i + 16));
+                    __m128i ev = _mm_packus_epi16(_mm_and_si128(uv0, lmask), _mm_and_si128(uv1, lmask));
+                    __m128i od = _mm_packus_epi16(_mm_srli_epi16(uv0, 8), _mm_srli_epi16(uv1, 8));
+                    simd.cvt<bIdx, 3>(y1 + i, y2 + i, uIdx == 0 ? ev : od, uIdx == 0 ? od : ev, row1, row2);
+                }
+            }
+#endif
+            for ( ; i < width; i += 2, row1 += 6, row2 += 6)
             {
                 int u = int(uv[i + 0 + uIdx]) - 128;
                 int v = int(uv[i + 1 - uIdx]) - 128;
@@ -3131,6 +3426,9 @@ struct YUV420sp2RGBA8888Invoker : ParallelLoopBody
     Mat* dst;
     const uchar* my1, *muv;
     int width, stride;
+#if CV_SSE2
+    YUV420toRGB_SSE2 simd;
+#endif
 
     YUV420sp2RGBA8888Invoker(Mat* _dst, int _stride, const uchar* _y1, const uchar* _uv)
         : dst(_dst), my1(_y1), muv(_uv), width(_dst->cols), stride(_stride) {}
@@ -3161,7 +3459,22 @@ struct YUV420sp2RGBA8888Invoker : ParallelLoopBody
             uchar* row2 = dst->ptr<uchar>(j + 1);
             const uchar* y2 = y1 + stride;
 
-            for (int i = 0; i < width; i += 2, row1 += 8, row2 += 8)
+            int i = 0;
+#if CV_SSE2
+            if( simd.use_simd )
+            {
+                const __m128i lmask = _mm_set1_epi16(0x00ff);
+                for ( ; i <= width - 32; i += 32, row1 += 32*4, row2 += 32*4)
+                {
+                    __m128i uv0 = _mm_loadu_si128((const __m128i*)(uv + i));
+                    __m128i uv1 = _mm_loadu_si128((const __m128i*)(uv + i + 16));
+                    __m128i ev = _mm_packus_epi16(_mm_and_si128(uv0, lmask), _mm_and_si128(uv1, lmask));
+                    __m128i od = _mm_packus_epi16(_mm_srli_epi16(uv0, 8), _mm_srli_epi16(uv1, 8));
+                    simd.cvt<bIdx, 4>(y1 + i, y2 + i, uIdx == 0 ? ev : od, uIdx == 0 ? od : ev, row1, row2);
+                }
+            }
+#endif
+            for ( ; i < width; i += 2, row1 += 8, row2 += 8)
             {
                 int u = int(uv[i + 0 + uIdx]) - 128;
                 int v = int(uv[i + 1 - uIdx]) - 128;
@@ -3204,6 +3517,9 @@ struct YUV420p2RGB888Invoker : ParallelLoopBody
     Mat* dst;
     const uchar* my1, *mu, *mv;
     int width, stride;
+#if CV_SSE2
+    YUV420toRGB_SSE2 simd;
+#endif
     int ustepIdx, vstepIdx;
 
     YUV420p2RGB888Invoker(Mat* _dst, int _stride, const uchar* _y1, const uchar* _u, const uchar* _v, int _ustepIdx, int _vstepIdx)
@@ -3233,7 +3549,14 @@ struct YUV420p2RGB888Invoker : ParallelLoopBody
             uchar* row2 = dst->ptr<uchar>(j + 1);
             const uchar* y2 = y1 + stride;
 
-            for (int i = 0; i < width / 2; i += 1, row1 += 6, row2 += 6)
+            int i = 0;
+#if CV_SSE2
+            if( simd.use_simd )
+                for ( ; i <= width / 2 - 16; i += 16, row1 += 32*3, row2 += 32*3)
+                    simd.cvt<bIdx, 3>(y1 + 2 * i, y2 + 2 * i, _mm_loadu_si128((const __m128i*)(u1 + i)),
+                                        _mm_loadu_si128((const __m128i*)(v1 + i)), row1, row2);
+#endif
+            for ( ; i < width / 2; i += 1, row1 += 6, row2 += 6)
             {
                 int u = int(u1[i]) - 128;
                 int v = int(v1[i]) - 128;
@@ -3272,6 +3595,9 @@ struct YUV420p2RGBA8888Invoker : ParallelLoopBody
     Mat* dst;
     const uchar* my1, *mu, *mv;
     int width, stride;
+#if CV_SSE2
+    YUV420toRGB_SSE2 simd;
+#endif
     int ustepIdx, vstepIdx;
 
     YUV420p2RGBA8888Invoker(Mat* _dst, int _stride, const uchar* _y1, const uchar* _u, const uchar* _v, int _ustepIdx, int _vstepIdx)
@@ -3301,7 +3627,14 @@ struct YUV420p2RGBA8888Invoker : ParallelLoopBody
             uchar* row2 = dst->ptr<uchar>(j + 1);
             const uchar* y2 = y1 + stride;
 
-            for (int i = 0; i < width / 2; i += 1, row1 += 8, row2 += 8)
+            int i = 0;
+#if CV_SSE2
+            if( simd.use_simd )
+                for ( ; i <= width / 2 - 16; i += 16, row1 += 32*4, row2 += 32*4)
+                    simd.cvt<bIdx, 4>(y1 + 2 * i, y2 + 2 * i, _mm_loadu_si128((const __m128i*)(u1 + i)),
+                                        _mm_loadu_si128((const __m128i*)(v1 + i)), row1, row2);
+#endif
+            for ( ; i < width / 2; i += 1, row1 += 8, row2 += 8)
             {
                 int u = int(u1[i]) - 128;
                 int v = int(v1[i]) - 128;
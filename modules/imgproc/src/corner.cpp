@@ -239,9 +239,126 @@ calcEigenValsVecs( const Mat& _cov, Mat& _dst )
 }
 
 
+// packs the gradient products into the interleaved (dx*dx, dx*dy, dy*dy) covariation matrix
+static void
+calcCovarMatrix( const Mat& Dx, const Mat& Dy, Mat& cov )
+{
+    Size size = cov.size();
+    int i, j;
+#if CV_SSE
+    volatile bool simd = checkHardwareSupport(CV_CPU_SSE);
+#endif
+
+    for( i = 0; i < size.height; i++ )
+    {
+        float* cov_data = (float*)(cov.data + i*cov.step);
+        const float* dxdata = (const float*)(Dx.data + i*Dx.step);
+        const float* dydata = (const float*)(Dy.data + i*Dy.step);
+        j = 0;
+
+    #if CV_SSE
+        if( simd )
+        {
+            for( ; j <= size.width - 4; j += 4 )
+            {
+                __m128 dx = _mm_loadu_ps(dxdata + j);
+                __m128 dy = _mm_loadu_ps(dydata + j);
+                __m128 xx = _mm_mul_ps(dx, dx);
+                __m128 xy = _mm_mul_ps(dx, dy);
+                __m128 yy = _mm_mul_ps(dy, dy);
+                __m128 t0 = _mm_unpacklo_ps(xx, xy); // xx0 xy0 xx1 xy1
+                __m128 t1 = _mm_unpackhi_ps(xx, xy); // xx2 xy2 xx3 xy3
+                __m128 t2 = _mm_unpacklo_ps(yy, xx); // yy0 xx0 yy1 xx1
+                __m128 t3 = _mm_unpacklo_ps(xy, yy); // xy0 yy0 xy1 yy1
+                __m128 t4 = _mm_unpackhi_ps(yy, xx); // yy2 xx2 yy3 xx3
+                __m128 t5 = _mm_unpackhi_ps(xy, yy); // xy2 yy2 xy3 yy3
+                _mm_storeu_ps(cov_data + j*3, _mm_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 0, 1, 0)));
+                _mm_storeu_ps(cov_data + j*3 + 4, _mm_shuffle_ps(t3, t1, _MM_SHUFFLE(1, 0, 3, 2)));
+                _mm_storeu_ps(cov_data + j*3 + 8, _mm_shuffle_ps(t4, t5, _MM_SHUFFLE(3, 2, 3, 0)));
+            }
+        }
+    #endif
+
+        for( ; j < size.width; j++ )
+        {
+            float dx = dxdata[j];
+            float dy = dydata[j];
+
+            cov_data[j*3] = dx*dx;
+            cov_data[j*3+1] = dx*dy;
+            cov_data[j*3+2] = dy*dy;
+        }
+    }
+}
+
+
 enum { MINEIGENVAL=0, HARRIS=1, EIGENVALSVECS=2 };
 
 
+/*
+   Computes the eigenvalue map for a horizontal band of the image.
+   The derivatives and the covariation matrix are computed for the band extended
+   by the box filter margins; the margins are taken from the neighbour rows,
+   so the bands can be processed independently and the result does not
+   depend on the partitioning.
+*/
+class CornerEigenValsVecsInvoker : public ParallelLoopBody
+{
+public:
+    CornerEigenValsVecsInvoker( const Mat& _src, Mat& _eigenv, int _block_size,
+                                int _aperture_size, int _op_type, double _k,
+                                int _borderType, double _scale ) :
+        ParallelLoopBody(), src(&_src), eigenv(&_eigenv), block_size(_block_size),
+        aperture_size(_aperture_size), op_type(_op_type), k(_k),
+        borderType(_borderType), scale(_scale)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        int y0 = std::max(range.start - block_size/2, 0);
+        int y1 = std::min(range.end + (block_size - 1 - block_size/2), src->rows);
+        Mat srcband = src->rowRange(y0, y1);
+
+        Mat Dx, Dy;
+        if( aperture_size > 0 )
+        {
+            Sobel( srcband, Dx, CV_32F, 1, 0, aperture_size, scale, 0, borderType );
+            Sobel( srcband, Dy, CV_32F, 0, 1, aperture_size, scale, 0, borderType );
+        }
+        else
+        {
+            Scharr( srcband, Dx, CV_32F, 1, 0, scale, 0, borderType );
+            Scharr( srcband, Dy, CV_32F, 0, 1, scale, 0, borderType );
+        }
+
+        Mat cov( srcband.size(), CV_32FC3 ), covsum;
+        calcCovarMatrix( Dx, Dy, cov );
+
+        boxFilter(cov.rowRange(range.start - y0, range.end - y0), covsum, cov.depth(),
+                  Size(block_size, block_size), Point(-1,-1), false, borderType );
+
+        Mat dst = eigenv->rowRange(range.start, range.end);
+        if( op_type == MINEIGENVAL )
+            calcMinEigenVal( covsum, dst );
+        else if( op_type == HARRIS )
+            calcHarris( covsum, dst, k );
+        else if( op_type == EIGENVALSVECS )
+            calcEigenValsVecs( covsum, dst );
+    }
+
+private:
+    const Mat* src;
+    Mat* eigenv;
+    int block_size;
+    int aperture_size;
+    int op_type;
+    double k;
+    int borderType;
+    double scale;
+};
+
+
 static void
 cornerEigenValsVecs( const Mat& src, Mat& eigenv, int block_size,
                      int aperture_size, int op_type, double k=0.,
@@ -262,48 +379,14 @@ cornerEigenValsVecs( const Mat& src, Mat& eigenv, int block_size,
 
     CV_Assert( src.type() == CV_8UC1 || src.type() == CV_32FC1 );
 
-    Mat Dx, Dy;
-    if( aperture_size > 0 )
-    {
-        Sobel( src, Dx, CV_32F, 1, 0, aperture_size, scale, 0, borderType );
-        Sobel( src, Dy, CV_32F, 0, 1, aperture_size, scale, 0, borderType );
-    }
-    else
-    {
-        Scharr( src, Dx, CV_32F, 1, 0, scale, 0, borderType );
-        Scharr( src, Dy, CV_32F, 0, 1, scale, 0, borderType );
-    }
-
-    Size size = src.size();
-    Mat cov( size, CV_32FC3 );
-    int i, j;
-
-    for( i = 0; i < size.height; i++ )
-    {
-        float* cov_data = (float*)(cov.data + i*cov.step);
-        const float* dxdata = (const float*)(Dx.data + i*Dx.step);
-        const float* dydata = (const float*)(Dy.data + i*Dy.step);
-
-        for( j = 0; j < size.width; j++ )
-        {
-            float dx = dxdata[j];
-            float dy = dydata[j];
-
-            cov_data[j*3] = dx*dx;
-            cov_data[j*3+1] = dx*dy;
-            cov_data[j*3+2] = dy*dy;
-        }
-    }
-
-    boxFilter(cov, cov, cov.depth(), Size(block_size, block_size),
-        Point(-1,-1), false, borderType );
+    // the bands read the neighbour rows as their border,
+    // which is not allowed when the source is isolated
+    double nstripes = borderType & BORDER_ISOLATED ? 1 :
+        std::min((double)getNumThreads()*4, src.rows/32.);
 
-    if( op_type == MINEIGENVAL )
-        calcMinEigenVal( cov, eigenv );
-    else if( op_type == HARRIS )
-        calcHarris( cov, eigenv, k );
-    else if( op_type == EIGENVALSVECS )
-        calcEigenValsVecs( cov, eigenv );
+    CornerEigenValsVecsInvoker invoker(src, eigenv, block_size, aperture_size,
+                                       op_type, k, borderType, scale);
+    parallel_for_(Range(0, src.rows), invoker, nstripes);
 }
 
 }
@@ -63,32 +63,124 @@ icvInitTopBottom( int* temp, int tempstep, CvSize size, int border )
 }
 
 
-static CvStatus CV_STDCALL
-icvDistanceTransform_3x3_C1R( const uchar* src, int srcstep, int* temp,
-        int step, float* dist, int dststep, CvSize size, const float* metrics )
+namespace cv
 {
-    const int BORDER = 1;
-    int i, j;
-    const int HV_DIST = CV_FLT_TO_FIX( metrics[0], ICV_DIST_SHIFT );
-    const int DIAG_DIST = CV_FLT_TO_FIX( metrics[1], ICV_DIST_SHIFT );
-    const float scale = 1.f/(1 << ICV_DIST_SHIFT);
 
-    srcstep /= sizeof(src[0]);
-    step /= sizeof(temp[0]);
-    dststep /= sizeof(dist[0]);
+/*
+  The chamfer distance transform is a forward and a backward raster scan, so the
+  rows can not be processed independently. Instead, the image is split into blocks of
+  DT_BLOCK_HEIGHT x DT_BLOCK_WIDTH pixels processed in the wavefront order. The vertical
+  block boundaries are skewed by BORDER columns per row, so that the block (R, C) only
+  depends on the blocks (R, C-1), (R-1, C) and (R-1, C+1). All the blocks with the same
+  2*R + C are independent and processed in parallel; the result is identical to the
+  serial scan.
+*/
+enum { DT_BLOCK_HEIGHT = 64, DT_BLOCK_WIDTH = 256 };
+
+template<class Op> class DTChamferWaveInvoker : public ParallelLoopBody
+{
+public:
+    DTChamferWaveInvoker( const Op& _op, Size _size, int _wave, bool _backward ) :
+        ParallelLoopBody(), op(&_op), size(_size), wave(_wave), backward(_backward)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        const int B = Op::BORDER, H = DT_BLOCK_HEIGHT, W = DT_BLOCK_WIDTH;
+        int m = size.height, n = size.width;
+
+        for( int R = range.start; R < range.end; R++ )
+        {
+            int C = wave - R*2;
+            for( int k = 0; k < H; k++ )
+            {
+                int r = R*H + k;
+                if( r >= m )
+                    break;
+                int j0 = std::max(C*W - B*k, 0), j1 = std::min((C+1)*W - B*k, n);
+                if( j0 >= j1 )
+                    continue;
+                if( !backward )
+                    op->forwardRow( r, j0, j1 );
+                else
+                    op->backwardRow( m - 1 - r, n - j1, n - j0 );
+            }
+        }
+    }
+
+private:
+    const Op* op;
+    Size size;
+    int wave;
+    bool backward;
+};
+
+template<class Op> static void
+distanceTransformChamfer( const Op& op, Size size )
+{
+    const int H = DT_BLOCK_HEIGHT, W = DT_BLOCK_WIDTH;
+    int nR = (size.height + H - 1)/H;
+    int nC = (size.width + Op::BORDER*(H - 1) + W - 1)/W;
+
+    for( int pass = 0; pass < 2; pass++ )
+    {
+        for( int wave = 0; wave <= (nR - 1)*2 + nC - 1; wave++ )
+        {
+            int R0 = std::max((wave - nC + 2)/2, 0), R1 = std::min(wave/2, nR - 1);
+            if( R0 <= R1 )
+                parallel_for_( Range(R0, R1 + 1), DTChamferWaveInvoker<Op>(op, size, wave, pass == 1) );
+        }
+    }
+}
+
+struct DTChamferBase
+{
+    DTChamferBase( const CvMat* src, CvMat* temp, CvMat* dst, int border )
+    {
+        srcdata = src->data.ptr;
+        srcstep = src->step;
+        step = temp->step/sizeof(int);
+        tempdata = temp->data.i + step*border + border;
+        dist = dst->data.fl;
+        dststep = dst->step/sizeof(float);
+
+        // initialize the borders of the temporary buffer
+        CvSize size = cvGetMatSize(src);
+        icvInitTopBottom( temp->data.i, step, size, border );
+        for( int i = 0; i < size.height; i++ )
+        {
+            int* tmp = tempdata + i*step;
+            for( int j = 0; j < border; j++ )
+                tmp[-j-1] = tmp[size.width + j] = ICV_INIT_DIST0;
+        }
+    }
+
+    const uchar* srcdata;
+    int srcstep;
+    int* tempdata;
+    int step;
+    float* dist;
+    int dststep;
+};
 
-    icvInitTopBottom( temp, step, size, BORDER );
+struct DTChamfer3x3Op : DTChamferBase
+{
+    enum { BORDER = 1 };
 
-    // forward pass
-    for( i = 0; i < size.height; i++ )
+    DTChamfer3x3Op( const CvMat* src, CvMat* temp, CvMat* dst, const float* metrics ) :
+        DTChamferBase( src, temp, dst, BORDER )
     {
-        const uchar* s = src + i*srcstep;
-        int* tmp = (int*)(temp + (i+BORDER)*step) + BORDER;
+        HV_DIST = CV_FLT_TO_FIX( metrics[0], ICV_DIST_SHIFT );
+        DIAG_DIST = CV_FLT_TO_FIX( metrics[1], ICV_DIST_SHIFT );
+    }
 
-        for( j = 0; j < BORDER; j++ )
-            tmp[-j-1] = tmp[size.width + j] = ICV_INIT_DIST0;
+    void forwardRow( int i, int j0, int j1 ) const
+    {
+        const uchar* s = srcdata + i*srcstep;
+        int* tmp = tempdata + i*step;
 
-        for( j = 0; j < size.width; j++ )
+        for( int j = j0; j < j1; j++ )
         {
             if( !s[j] )
                 tmp[j] = 0;
@@ -106,13 +198,13 @@ icvDistanceTransform_3x3_C1R( const uchar* src, int srcstep, int* temp,
         }
     }
 
-    // backward pass
-    for( i = size.height - 1; i >= 0; i-- )
+    void backwardRow( int i, int j0, int j1 ) const
     {
-        float* d = (float*)(dist + i*dststep);
-        int* tmp = (int*)(temp + (i+BORDER)*step) + BORDER;
+        const float scale = 1.f/(1 << ICV_DIST_SHIFT);
+        float* d = dist + i*dststep;
+        int* tmp = tempdata + i*step;
 
-        for( j = size.width - 1; j >= 0; j-- )
+        for( int j = j1 - 1; j >= j0; j-- )
         {
             int t0 = tmp[j];
             if( t0 > HV_DIST )
@@ -131,37 +223,27 @@ icvDistanceTransform_3x3_C1R( const uchar* src, int srcstep, int* temp,
         }
     }
 
-    return CV_OK;
-}
-
+    int HV_DIST, DIAG_DIST;
+};
 
-static CvStatus CV_STDCALL
-icvDistanceTransform_5x5_C1R( const uchar* src, int srcstep, int* temp,
-        int step, float* dist, int dststep, CvSize size, const float* metrics )
+struct DTChamfer5x5Op : DTChamferBase
 {
-    const int BORDER = 2;
-    int i, j;
-    const int HV_DIST = CV_FLT_TO_FIX( metrics[0], ICV_DIST_SHIFT );
-    const int DIAG_DIST = CV_FLT_TO_FIX( metrics[1], ICV_DIST_SHIFT );
-    const int LONG_DIST = CV_FLT_TO_FIX( metrics[2], ICV_DIST_SHIFT );
-    const float scale = 1.f/(1 << ICV_DIST_SHIFT);
-
-    srcstep /= sizeof(src[0]);
-    step /= sizeof(temp[0]);
-    dststep /= sizeof(dist[0]);
-
-    icvInitTopBottom( temp, step, size, BORDER );
+    enum { BORDER = 2 };
 
-    // forward pass
-    for( i = 0; i < size.height; i++ )
+    DTChamfer5x5Op( const CvMat* src, CvMat* temp, CvMat* dst, const float* metrics ) :
+        DTChamferBase( src, temp, dst, BORDER )
     {
-        const uchar* s = src + i*srcstep;
-        int* tmp = (int*)(temp + (i+BORDER)*step) + BORDER;
+        HV_DIST = CV_FLT_TO_FIX( metrics[0], ICV_DIST_SHIFT );
+        DIAG_DIST = CV_FLT_TO_FIX( metrics[1], ICV_DIST_SHIFT );
+        LONG_DIST = CV_FLT_TO_FIX( metrics[2], ICV_DIST_SHIFT );
+    }
 
-        for( j = 0; j < BORDER; j++ )
-            tmp[-j-1] = tmp[size.width + j] = ICV_INIT_DIST0;
+    void forwardRow( int i, int j0, int j1 ) const
+    {
+        const uchar* s = srcdata + i*srcstep;
+        int* tmp = tempdata + i*step;
 
-        for( j = 0; j < size.width; j++ )
+        for( int j = j0; j < j1; j++ )
         {
             if( !s[j] )
                 tmp[j] = 0;
@@ -187,13 +269,13 @@ icvDistanceTransform_5x5_C1R( const uchar* src, int srcstep, int* temp,
         }
     }
 
-    // backward pass
-    for( i = size.height - 1; i >= 0; i-- )
+    void backwardRow( int i, int j0, int j1 ) const
     {
-        float* d = (float*)(dist + i*dststep);
-        int* tmp = (int*)(temp + (i+BORDER)*step) + BORDER;
+        const float scale = 1.f/(1 << ICV_DIST_SHIFT);
+        float* d = dist + i*dststep;
+        int* tmp = tempdata + i*step;
 
-        for( j = size.width - 1; j >= 0; j-- )
+        for( int j = j1 - 1; j >= j0; j-- )
         {
             int t0 = tmp[j];
             if( t0 > HV_DIST )
@@ -220,41 +302,25 @@ icvDistanceTransform_5x5_C1R( const uchar* src, int srcstep, int* temp,
         }
     }
 
-    return CV_OK;
-}
-
+    int HV_DIST, DIAG_DIST, LONG_DIST;
+};
 
-static CvStatus CV_STDCALL
-icvDistanceTransformEx_5x5_C1R( const uchar* src, int srcstep, int* temp,
-                int step, float* dist, int dststep, int* labels, int lstep,
-                CvSize size, const float* metrics )
+struct DTChamfer5x5LabelsOp : DTChamfer5x5Op
 {
-    const int BORDER = 2;
-
-    int i, j;
-    const int HV_DIST = CV_FLT_TO_FIX( metrics[0], ICV_DIST_SHIFT );
-    const int DIAG_DIST = CV_FLT_TO_FIX( metrics[1], ICV_DIST_SHIFT );
-    const int LONG_DIST = CV_FLT_TO_FIX( metrics[2], ICV_DIST_SHIFT );
-    const float scale = 1.f/(1 << ICV_DIST_SHIFT);
-
-    srcstep /= sizeof(src[0]);
-    step /= sizeof(temp[0]);
-    dststep /= sizeof(dist[0]);
-    lstep /= sizeof(labels[0]);
-
-    icvInitTopBottom( temp, step, size, BORDER );
-
-    // forward pass
-    for( i = 0; i < size.height; i++ )
+    DTChamfer5x5LabelsOp( const CvMat* src, CvMat* temp, CvMat* dst, CvMat* _labels, const float* metrics ) :
+        DTChamfer5x5Op( src, temp, dst, metrics )
     {
-        const uchar* s = src + i*srcstep;
-        int* tmp = (int*)(temp + (i+BORDER)*step) + BORDER;
-        int* lls = (int*)(labels + i*lstep);
+        labels = _labels->data.i;
+        lstep = _labels->step/sizeof(int);
+    }
 
-        for( j = 0; j < BORDER; j++ )
-            tmp[-j-1] = tmp[size.width + j] = ICV_INIT_DIST0;
+    void forwardRow( int i, int j0, int j1 ) const
+    {
+        const uchar* s = srcdata + i*srcstep;
+        int* tmp = tempdata + i*step;
+        int* lls = labels + i*lstep;
 
-        for( j = 0; j < size.width; j++ )
+        for( int j = j0; j < j1; j++ )
         {
             if( !s[j] )
             {
@@ -321,14 +387,14 @@ icvDistanceTransformEx_5x5_C1R( const uchar* src, int srcstep, int* temp,
         }
     }
 
-    // backward pass
-    for( i = size.height - 1; i >= 0; i-- )
+    void backwardRow( int i, int j0, int j1 ) const
     {
-        float* d = (float*)(dist + i*dststep);
-        int* tmp = (int*)(temp + (i+BORDER)*step) + BORDER;
-        int* lls = (int*)(labels + i*lstep);
+        const float scale = 1.f/(1 << ICV_DIST_SHIFT);
+        float* d = dist + i*dststep;
+        int* tmp = tempdata + i*step;
+        int* lls = labels + i*lstep;
 
-        for( j = size.width - 1; j >= 0; j-- )
+        for( int j = j1 - 1; j >= j0; j-- )
         {
             int t0 = tmp[j];
             int l0 = lls[j];
@@ -389,7 +455,10 @@ icvDistanceTransformEx_5x5_C1R( const uchar* src, int srcstep, int* temp,
         }
     }
 
-    return CV_OK;
+    int* labels;
+    int lstep;
+};
+
 }
 
 
@@ -445,12 +514,14 @@ namespace cv
 
 struct DTColumnInvoker : ParallelLoopBody
 {
-    DTColumnInvoker( const CvMat* _src, CvMat* _dst, const int* _sat_tab, const float* _sqr_tab)
+    DTColumnInvoker( const CvMat* _src, CvMat* _dst, const int* _sat_tab, const float* _sqr_tab,
+                     Mat* _nearest = 0 )
     {
         src = _src;
         dst = _dst;
         sat_tab = _sat_tab + src->rows*2 + 1;
         sqr_tab = _sqr_tab;
+        nearest = _nearest;
     }
 
     void operator()( const Range& range ) const
@@ -461,6 +532,12 @@ struct DTColumnInvoker : ParallelLoopBody
         AutoBuffer<int> _d(m);
         int* d = _d;
 
+        if( nearest )
+        {
+            processNearest( range, d );
+            return;
+        }
+
         for( i = i1; i < i2; i++ )
         {
             const uchar* sptr = src->data.ptr + i + (m-1)*sstep;
@@ -483,20 +560,62 @@ struct DTColumnInvoker : ParallelLoopBody
         }
     }
 
+    // same as above, but also stores the row of the nearest zero pixel (or -1) for each pixel
+    void processNearest( const Range& range, int* below ) const
+    {
+        int m = src->rows;
+        size_t sstep = src->step, dstep = dst->step/sizeof(float), nstep = nearest->step/sizeof(int);
+
+        for( int i = range.start; i < range.end; i++ )
+        {
+            const uchar* sptr = src->data.ptr + i + (m-1)*sstep;
+            float* dptr = dst->data.fl + i;
+            int* nptr = (int*)nearest->data + i;
+            int j, r = -1;
+
+            for( j = m-1; j >= 0; j--, sptr -= sstep )
+            {
+                if( sptr[0] == 0 )
+                    r = j;
+                below[j] = r;
+            }
+
+            sptr += sstep;
+            for( j = 0, r = -1; j < m; j++, sptr += sstep, dptr += dstep, nptr += nstep )
+            {
+                if( sptr[0] == 0 )
+                    r = j;
+                int dist = r >= 0 ? j - r : m, r0 = r;
+                if( below[j] >= 0 && below[j] - j < dist )
+                {
+                    dist = below[j] - j;
+                    r0 = below[j];
+                }
+                dptr[0] = sqr_tab[dist];
+                nptr[0] = r0;
+            }
+        }
+    }
+
     const CvMat* src;
     CvMat* dst;
     const int* sat_tab;
     const float* sqr_tab;
+    Mat* nearest;
 };
 
 
 struct DTRowInvoker : ParallelLoopBody
 {
-    DTRowInvoker( CvMat* _dst, const float* _sqr_tab, const float* _inv_tab )
+    DTRowInvoker( CvMat* _dst, const float* _sqr_tab, const float* _inv_tab,
+                  const Mat* _nearest = 0, const Mat* _seeds = 0, CvMat* _labels = 0 )
     {
         dst = _dst;
         sqr_tab = _sqr_tab;
         inv_tab = _inv_tab;
+        nearest = _nearest;
+        seeds = _seeds;
+        labels = _labels;
     }
 
     void operator()( const Range& range ) const
@@ -546,18 +665,35 @@ struct DTRowInvoker : ParallelLoopBody
                 p = v[k];
                 d[q] = std::sqrt(sqr_tab[std::abs(q - p)] + f[p]);
             }
+
+            if( labels )
+            {
+                // the nearest zero pixel of (i, q) is the nearest one in the column v[k]
+                const int* nptr = nearest->ptr<int>(i);
+                int* lptr = (int*)(labels->data.ptr + i*labels->step);
+                for( q = 0, k = 0; q < n; q++ )
+                {
+                    while( z[k+1] < q )
+                        k++;
+                    p = v[k];
+                    lptr[q] = nptr[p] >= 0 ? seeds->at<int>(nptr[p], p) : 0;
+                }
+            }
         }
     }
 
     CvMat* dst;
     const float* sqr_tab;
     const float* inv_tab;
+    const Mat* nearest;
+    const Mat* seeds;
+    CvMat* labels;
 };
 
 }
 
 static void
-icvTrueDistTrans( const CvMat* src, CvMat* dst )
+icvTrueDistTrans( const CvMat* src, CvMat* dst, CvMat* labels = 0 )
 {
     const float inf = 1e15f;
 
@@ -586,7 +722,15 @@ icvTrueDistTrans( const CvMat* src, CvMat* dst )
     for( ; i <= m*3; i++ )
         sat_tab[i] = i - shift;
 
-    cv::parallel_for_(cv::Range(0, n), cv::DTColumnInvoker(src, dst, sat_tab, sqr_tab));
+    cv::Mat nearest, seeds;
+    if( labels )
+    {
+        nearest.create( m, n, CV_32SC1 );
+        seeds = cv::cvarrToMat(labels).clone();
+    }
+
+    cv::parallel_for_(cv::Range(0, n), cv::DTColumnInvoker(src, dst, sat_tab, sqr_tab,
+                                                            labels ? &nearest : 0));
 
     // stage 2: compute modified distance transform for each row
     float* inv_tab = sqr_tab + n;
@@ -598,107 +742,210 @@ icvTrueDistTrans( const CvMat* src, CvMat* dst )
         sqr_tab[i] = (float)(i*i);
     }
 
-    cv::parallel_for_(cv::Range(0, m), cv::DTRowInvoker(dst, sqr_tab, inv_tab));
+    cv::parallel_for_(cv::Range(0, m), cv::DTRowInvoker(dst, sqr_tab, inv_tab,
+                                                         &nearest, &seeds, labels));
 }
 
+namespace cv
+{
 
-/*********************************** IPP functions *********************************/
+/*
+  L1 and C (chessboard) metrics are separable: the distance is computed as 1D distance
+  to the nearest zero in every column, followed by a 1D transform of each row.
+*/
+struct DTSeparableColumnInvoker : ParallelLoopBody
+{
+    DTSeparableColumnInvoker( const CvMat* _src, Mat& _dist )
+    {
+        src = _src;
+        dist = &_dist;
+    }
 
-typedef CvStatus (CV_STDCALL * CvIPPDistTransFunc)( const uchar* src, int srcstep,
-                                                    void* dst, int dststep,
-                                                    CvSize size, const void* metrics );
+    void operator()( const Range& range ) const
+    {
+        int i, m = src->rows, n = src->cols, inf = std::max(m + n, ICV_INIT_DIST0 >> ICV_DIST_SHIFT);
+        size_t sstep = src->step, dstep = dist->step/sizeof(int);
+        AutoBuffer<int> _d(m);
+        int* d = _d;
 
-typedef CvStatus (CV_STDCALL * CvIPPDistTransFunc2)( uchar* src, int srcstep,
-                                                     CvSize size, const int* metrics );
+        for( i = range.start; i < range.end; i++ )
+        {
+            const uchar* sptr = src->data.ptr + i + (m-1)*sstep;
+            int* dptr = (int*)dist->data + i;
+            int j, t = inf;
 
-/***********************************************************************************/
+            for( j = m-1; j >= 0; j--, sptr -= sstep )
+            {
+                t = sptr[0] == 0 ? 0 : std::min(t + 1, inf);
+                d[j] = t;
+            }
 
-typedef CvStatus (CV_STDCALL * CvDistTransFunc)( const uchar* src, int srcstep,
-                                                 int* temp, int tempstep,
-                                                 float* dst, int dststep,
-                                                 CvSize size, const float* metrics );
+            t = inf;
+            for( j = 0; j < m; j++, dptr += dstep )
+            {
+                t = std::min(t + 1, d[j]);
+                dptr[0] = t;
+            }
+        }
+    }
 
+    const CvMat* src;
+    Mat* dist;
+};
 
-/****************************************************************************************\
- Non-inplace and Inplace 8u->8u Distance Transform for CityBlock (a.k.a. L1) metric
- (C) 2006 by Jay Stavinzky.
-\****************************************************************************************/
 
-//BEGIN ATS ADDITION
-/* 8-bit grayscale distance transform function */
-static void
-icvDistanceATS_L1_8u( const CvMat* src, CvMat* dst )
+struct DTSeparableRowInvoker : ParallelLoopBody
 {
-    int width = src->cols, height = src->rows;
+    DTSeparableRowInvoker( const Mat& _coldist, CvMat* _dst, int _distType )
+    {
+        coldist = &_coldist;
+        dst = _dst;
+        distType = _distType;
+    }
 
-    int a;
-    uchar lut[256];
-    int x, y;
+    void operator()( const Range& range ) const
+    {
+        int i, n = coldist->cols, inf = std::max(coldist->rows + n, ICV_INIT_DIST0 >> ICV_DIST_SHIFT);
+        AutoBuffer<int> _buf(n*3 + 1);
+        int* d = _buf;
+        int* s = d + n;
+        int* t = s + n;
 
-    const uchar *sbase = src->data.ptr;
-    uchar *dbase = dst->data.ptr;
-    int srcstep = src->step;
-    int dststep = dst->step;
+        for( i = range.start; i < range.end; i++ )
+        {
+            const int* g = coldist->ptr<int>(i);
+            int q, u;
 
-    CV_Assert( CV_IS_MASK_ARR( src ) && CV_MAT_TYPE( dst->type ) == CV_8UC1 );
-    CV_Assert( CV_ARE_SIZES_EQ( src, dst ));
+            if( distType == CV_DIST_L1 )
+            {
+                // d(x) = min_i (|x - i| + g(i))
+                int a = inf;
+                for( q = 0; q < n; q++ )
+                    d[q] = a = std::min(a + 1, g[q]);
+                a = inf;
+                for( q = n - 1; q >= 0; q-- )
+                    d[q] = a = std::min(a + 1, d[q]);
+            }
+            else
+            {
+                // d(x) = min_i max(|x - i|, g(i)); the lower envelope is built as in
+                // Meijster et al., "A general algorithm for computing distance transforms in linear time"
+                q = 0;
+                s[0] = t[0] = 0;
+                for( u = 1; u < n; u++ )
+                {
+                    while( q >= 0 && std::max(std::abs(t[q] - s[q]), g[s[q]]) >
+                                     std::max(std::abs(t[q] - u), g[u]) )
+                        q--;
+                    if( q < 0 )
+                    {
+                        q = 0;
+                        s[0] = u;
+                    }
+                    else
+                    {
+                        int p = s[q], w;
+                        if( g[p] <= g[u] )
+                            w = std::max(p + g[u], (p + u)/2);
+                        else
+                            w = std::min(u - g[p], (p + u)/2);
+                        w++;
+                        if( w < n )
+                        {
+                            q++;
+                            s[q] = u;
+                            t[q] = w;
+                        }
+                    }
+                }
 
-    ////////////////////// forward scan ////////////////////////
-    for( x = 0; x < 256; x++ )
-        lut[x] = CV_CAST_8U(x+1);
+                for( u = n - 1; u >= 0; u-- )
+                {
+                    d[u] = std::max(std::abs(u - s[q]), g[s[q]]);
+                    if( u == t[q] )
+                        q--;
+                }
+            }
 
-    //init first pixel to max (we're going to be skipping it)
-    dbase[0] = (uchar)(sbase[0] == 0 ? 0 : 255);
+            if( CV_MAT_TYPE(dst->type) == CV_8UC1 )
+            {
+                uchar* dptr = dst->data.ptr + dst->step*i;
+                for( q = 0; q < n; q++ )
+                    dptr[q] = saturate_cast<uchar>(d[q]);
+            }
+            else
+            {
+                float* dptr = (float*)(dst->data.ptr + dst->step*i);
+                for( q = 0; q < n; q++ )
+                    dptr[q] = (float)d[q];
+            }
+        }
+    }
 
-    //first row (scan west only, skip first pixel)
-    for( x = 1; x < width; x++ )
-        dbase[x] = (uchar)(sbase[x] == 0 ? 0 : lut[dbase[x-1]]);
+    const Mat* coldist;
+    CvMat* dst;
+    int distType;
+};
 
-    for( y = 1; y < height; y++ )
-    {
-        sbase += srcstep;
-        dbase += dststep;
+}
 
-        //for left edge, scan north only
-        a = sbase[0] == 0 ? 0 : lut[dbase[-dststep]];
-        dbase[0] = (uchar)a;
+static void
+icvSeparableDistTrans( const CvMat* src, CvMat* dst, int distType )
+{
+    cv::Mat coldist( src->rows, src->cols, CV_32SC1 );
+    cv::parallel_for_(cv::Range(0, src->cols), cv::DTSeparableColumnInvoker(src, coldist));
+    cv::parallel_for_(cv::Range(0, src->rows), cv::DTSeparableRowInvoker(coldist, dst, distType));
+}
 
-        for( x = 1; x < width; x++ )
-        {
-            a = sbase[x] == 0 ? 0 : lut[MIN(a, dbase[x - dststep])];
-            dbase[x] = (uchar)a;
-        }
-    }
 
-    ////////////////////// backward scan ///////////////////////
+/*********************************** IPP functions *********************************/
 
-    a = dbase[width-1];
+typedef CvStatus (CV_STDCALL * CvIPPDistTransFunc)( const uchar* src, int srcstep,
+                                                    void* dst, int dststep,
+                                                    CvSize size, const void* metrics );
 
-    // do last row east pixel scan here (skip bottom right pixel)
-    for( x = width - 2; x >= 0; x-- )
-    {
-        a = lut[a];
-        dbase[x] = (uchar)(CV_CALC_MIN_8U(a, dbase[x]));
-    }
+typedef CvStatus (CV_STDCALL * CvIPPDistTransFunc2)( uchar* src, int srcstep,
+                                                     CvSize size, const int* metrics );
 
-    // right edge is the only error case
-    for( y = height - 2; y >= 0; y-- )
-    {
-        dbase -= dststep;
+/***********************************************************************************/
 
-        // do right edge
-        a = lut[dbase[width-1+dststep]];
-        dbase[width-1] = (uchar)(MIN(a, dbase[width-1]));
+/* Initializes the labels of zero pixels */
+static void
+icvInitDistLabels( const CvMat* src, CvMat* labels, int labelType, int border )
+{
+    CvSize size = cvGetMatSize(src);
+    cvZero( labels );
 
-        for( x = width - 2; x >= 0; x-- )
+    if( labelType == CV_DIST_LABEL_CCOMP )
+    {
+        CvSeq *contours = 0;
+        cv::Ptr<CvMemStorage> st = cvCreateMemStorage();
+        cv::Ptr<CvMat> src_copy = cvCreateMat( size.height+border*2, size.width+border*2, src->type );
+        cvCopyMakeBorder(src, src_copy, cvPoint(border, border), IPL_BORDER_CONSTANT, cvScalarAll(255));
+        cvCmpS( src_copy, 0, src_copy, CV_CMP_EQ );
+        cvFindContours( src_copy, st, &contours, sizeof(CvContour),
+                       CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE, cvPoint(-border, -border));
+
+        for( int label = 1; contours != 0; contours = contours->h_next, label++ )
         {
-            int b = dbase[x+dststep];
-            a = lut[MIN(a, b)];
-            dbase[x] = (uchar)(MIN(a, dbase[x]));
+            CvScalar area_color = cvScalarAll(label);
+            cvDrawContours( labels, contours, area_color, area_color, -255, -1, 8 );
+        }
+    }
+    else
+    {
+        int k = 1;
+        for( int i = 0; i < src->rows; i++ )
+        {
+            const uchar* srcptr = src->data.ptr + src->step*i;
+            int* labelptr = (int*)(labels->data.ptr + labels->step*i);
+
+            for( int j = 0; j < src->cols; j++ )
+                if( srcptr[j] == 0 )
+                    labelptr[j] = k++;
         }
     }
 }
-//END ATS ADDITION
 
 
 /* Wrapper function for distance transform group */
@@ -730,15 +977,9 @@ cvDistTransform( const void* srcarr, void* dstarr,
 
     if( distType == CV_DIST_C || distType == CV_DIST_L1 )
         maskSize = !labels ? CV_DIST_MASK_3 : CV_DIST_MASK_5;
-    else if( distType == CV_DIST_L2 && labels )
+    else if( distType == CV_DIST_L2 && labels && maskSize == CV_DIST_MASK_3 )
         maskSize = CV_DIST_MASK_5;
 
-    if( maskSize == CV_DIST_MASK_PRECISE )
-    {
-        icvTrueDistTrans( src, dst );
-        return;
-    }
-
     if( labels )
     {
         labels = cvGetMat( labels, &lstub );
@@ -753,6 +994,21 @@ cvDistTransform( const void* srcarr, void* dstarr,
             "3x3 mask can not be used for \"labeled\" distance transform. Use 5x5 mask" );
     }
 
+    if( maskSize == CV_DIST_MASK_PRECISE )
+    {
+        if( labels )
+            icvInitDistLabels( src, labels, labelType, 1 );
+        icvTrueDistTrans( src, dst, labels );
+        return;
+    }
+
+    if( (distType == CV_DIST_C || distType == CV_DIST_L1) && !labels )
+    {
+        // the metrics are separable, so the exact parallel algorithm is used
+        icvSeparableDistTrans( src, dst, distType );
+        return;
+    }
+
     if( distType == CV_DIST_C || distType == CV_DIST_L1 || distType == CV_DIST_L2 )
     {
         icvGetDistanceTransformMask( (distType == CV_DIST_C ? 0 :
@@ -767,72 +1023,30 @@ cvDistTransform( const void* srcarr, void* dstarr,
     }
 
     CvSize size = cvGetMatSize(src);
+    int border = maskSize == CV_DIST_MASK_3 ? 1 : 2;
+    cv::Ptr<CvMat> temp = cvCreateMat( size.height + border*2, size.width + border*2, CV_32SC1 );
 
-    if( CV_MAT_TYPE(dst->type) == CV_8UC1 )
-    {
-        icvDistanceATS_L1_8u( src, dst );
-    }
-    else
+    if( !labels )
     {
-        int border = maskSize == CV_DIST_MASK_3 ? 1 : 2;
-        cv::Ptr<CvMat> temp = cvCreateMat( size.height + border*2, size.width + border*2, CV_32SC1 );
-
-        if( !labels )
+    #if defined (HAVE_IPP) && (IPP_VERSION_MAJOR >= 7)
+        if( maskSize == CV_DIST_MASK_5 )
         {
-        #if defined (HAVE_IPP) && (IPP_VERSION_MAJOR >= 7)
-            if( maskSize == CV_DIST_MASK_5 )
-            {
-                IppiSize roi = { src->cols, src->rows };
-                if( ippiDistanceTransform_5x5_8u32f_C1R(
-                        src->data.ptr, src->step,
-                        dst->data.fl, dst->step, roi, _mask) >= 0 )
-                    return;
-            }
-        #endif
-            CvDistTransFunc func = maskSize == CV_DIST_MASK_3 ?
-                icvDistanceTransform_3x3_C1R :
-                icvDistanceTransform_5x5_C1R;
-
-            func( src->data.ptr, src->step, temp->data.i, temp->step,
-                  dst->data.fl, dst->step, size, _mask );
+            IppiSize roi = { src->cols, src->rows };
+            if( ippiDistanceTransform_5x5_8u32f_C1R(
+                    src->data.ptr, src->step,
+                    dst->data.fl, dst->step, roi, _mask) >= 0 )
+                return;
         }
+    #endif
+        if( maskSize == CV_DIST_MASK_3 )
+            cv::distanceTransformChamfer( cv::DTChamfer3x3Op(src, temp, dst, _mask), size );
         else
-        {
-            cvZero( labels );
-
-            if( labelType == CV_DIST_LABEL_CCOMP )
-            {
-                CvSeq *contours = 0;
-                cv::Ptr<CvMemStorage> st = cvCreateMemStorage();
-                cv::Ptr<CvMat> src_copy = cvCreateMat( size.height+border*2, size.width+border*2, src->type );
-                cvCopyMakeBorder(src, src_copy, cvPoint(border, border), IPL_BORDER_CONSTANT, cvScalarAll(255));
-                cvCmpS( src_copy, 0, src_copy, CV_CMP_EQ );
-                cvFindContours( src_copy, st, &contours, sizeof(CvContour),
-                               CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE, cvPoint(-border, -border));
-
-                for( int label = 1; contours != 0; contours = contours->h_next, label++ )
-                {
-                    CvScalar area_color = cvScalarAll(label);
-                    cvDrawContours( labels, contours, area_color, area_color, -255, -1, 8 );
-                }
-            }
-            else
-            {
-                int k = 1;
-                for( int i = 0; i < src->rows; i++ )
-                {
-                    const uchar* srcptr = src->data.ptr + src->step*i;
-                    int* labelptr = (int*)(labels->data.ptr + labels->step*i);
-
-                    for( int j = 0; j < src->cols; j++ )
-                        if( srcptr[j] == 0 )
-                            labelptr[j] = k++;
-                }
-            }
-
-            icvDistanceTransformEx_5x5_C1R( src->data.ptr, src->step, temp->data.i, temp->step,
-                        dst->data.fl, dst->step, labels->data.i, labels->step, size, _mask );
-        }
+            cv::distanceTransformChamfer( cv::DTChamfer5x5Op(src, temp, dst, _mask), size );
+    }
+    else
+    {
+        icvInitDistLabels( src, labels, labelType, border );
+        cv::distanceTransformChamfer( cv::DTChamfer5x5LabelsOp(src, temp, dst, labels, _mask), size );
     }
 }
 
@@ -45,9 +45,61 @@
 namespace cv
 {
 
+// orders the corners by decreasing response; equal responses are kept in the raster order,
+// so the result does not depend on how the candidates were collected
 template<typename T> struct greaterThanPtr
 {
-    bool operator()(const T* a, const T* b) const { return *a > *b; }
+    bool operator()(const T* a, const T* b) const { return *a > *b || (*a == *b && a < b); }
+};
+
+/*
+   Collects the local maxima of the corner response map (the non-zero pixels
+   equal to their dilation) in a horizontal band and sorts them. Every stripe
+   writes into its own list, so the lists can be merged afterwards.
+*/
+class GFTTCandidatesInvoker : public ParallelLoopBody
+{
+public:
+    GFTTCandidatesInvoker( const Mat& _eig, const Mat& _tmp, const Mat& _mask,
+                           vector<vector<const float*> >& _corners ) :
+        ParallelLoopBody(), eig(&_eig), tmp(&_tmp), mask(&_mask), corners(&_corners)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        int nstripes = (int)corners->size(), rows = eig->rows - 2;
+        Size imgsize = eig->size();
+
+        for( int i = range.start; i < range.end; i++ )
+        {
+            vector<const float*>& stripeCorners = (*corners)[i];
+            int y0 = 1 + (int)((int64)rows*i/nstripes);
+            int y1 = 1 + (int)((int64)rows*(i + 1)/nstripes);
+
+            for( int y = y0; y < y1; y++ )
+            {
+                const float* eig_data = (const float*)eig->ptr(y);
+                const float* tmp_data = (const float*)tmp->ptr(y);
+                const uchar* mask_data = mask->data ? mask->ptr(y) : 0;
+
+                for( int x = 1; x < imgsize.width - 1; x++ )
+                {
+                    float val = eig_data[x];
+                    if( val != 0 && val == tmp_data[x] && (!mask_data || mask_data[x]) )
+                        stripeCorners.push_back(eig_data + x);
+                }
+            }
+
+            std::sort( stripeCorners.begin(), stripeCorners.end(), greaterThanPtr<float>() );
+        }
+    }
+
+private:
+    const Mat* eig;
+    const Mat* tmp;
+    const Mat* mask;
+    vector<vector<const float*> >* corners;
 };
 
 }
@@ -77,22 +129,26 @@ void cv::goodFeaturesToTrack( InputArray _image, OutputArray _corners,
 
     vector<const float*> tmpCorners;
 
-    // collect list of pointers to features - put them into temporary image
-    for( int y = 1; y < imgsize.height - 1; y++ )
-    {
-        const float* eig_data = (const float*)eig.ptr(y);
-        const float* tmp_data = (const float*)tmp.ptr(y);
-        const uchar* mask_data = mask.data ? mask.ptr(y) : 0;
+    // collect list of pointers to features - put them into temporary image;
+    // the bands are sorted in parallel and then merged
+    int nstripes = std::max(std::min(getNumThreads()*4, (imgsize.height - 2)/16), 1);
+    vector<vector<const float*> > stripeCorners(nstripes);
+    if( imgsize.height > 2 )
+        parallel_for_(Range(0, nstripes), GFTTCandidatesInvoker(eig, tmp, mask, stripeCorners));
 
-        for( int x = 1; x < imgsize.width - 1; x++ )
-        {
-            float val = eig_data[x];
-            if( val != 0 && val == tmp_data[x] && (!mask_data || mask_data[x]) )
-                tmpCorners.push_back(eig_data + x);
-        }
+    vector<size_t> bounds(1, 0);
+    for( int k = 0; k < nstripes; k++ )
+    {
+        tmpCorners.insert(tmpCorners.end(), stripeCorners[k].begin(), stripeCorners[k].end());
+        bounds.push_back(tmpCorners.size());
     }
 
-    sort( tmpCorners, greaterThanPtr<float>() );
+    for( size_t step = 1; step < (size_t)nstripes; step *= 2 )
+        for( size_t k = 0; k + step < (size_t)nstripes; k += step*2 )
+            std::inplace_merge(tmpCorners.begin() + bounds[k],
+                               tmpCorners.begin() + bounds[k + step],
+                               tmpCorners.begin() + bounds[std::min(k + step*2, (size_t)nstripes)],
+                               greaterThanPtr<float>());
     vector<Point2f> corners;
     size_t i, j, total = tmpCorners.size(), ncorners = 0;
 
@@ -50,8 +50,11 @@ public:
     ~GCGraph();
     void create( unsigned int vtxCount, unsigned int edgeCount );
     int addVtx();
-    void addEdges( int i, int j, TWeight w, TWeight revw );
+    int addEdges( int i, int j, TWeight w, TWeight revw );
     void addTermWeights( int i, TWeight sourceW, TWeight sinkW );
+    // the methods below allow to reuse the graph topology for a new maxFlow() run
+    void setEdgeWeights( int e, TWeight w, TWeight revw );
+    void resetTermWeights();
     TWeight maxFlow();
     bool inSourceSegment( int i );
 private:
@@ -111,7 +114,7 @@ int GCGraph<TWeight>::addVtx()
 }
 
 template <class TWeight>
-void GCGraph<TWeight>::addEdges( int i, int j, TWeight w, TWeight revw )
+int GCGraph<TWeight>::addEdges( int i, int j, TWeight w, TWeight revw )
 {
     CV_Assert( i>=0 && i<(int)vtcs.size() );
     CV_Assert( j>=0 && j<(int)vtcs.size() );
@@ -133,6 +136,29 @@ void GCGraph<TWeight>::addEdges( int i, int j, TWeight w, TWeight revw )
     toI.weight = revw;
     vtcs[j].first = (int)edges.size();
     edges.push_back( toI );
+
+    return vtcs[i].first;
+}
+
+template <class TWeight>
+void GCGraph<TWeight>::setEdgeWeights( int e, TWeight w, TWeight revw )
+{
+    assert( e >= 2 && e+1 < (int)edges.size() && (e & 1) == 0 );
+    assert( w>=0 && revw>=0 );
+
+    edges[e].weight = w;
+    edges[e+1].weight = revw;
+}
+
+template <class TWeight>
+void GCGraph<TWeight>::resetTermWeights()
+{
+    for( size_t i = 0; i < vtcs.size(); i++ )
+    {
+        vtcs[i].next = 0;
+        vtcs[i].weight = 0;
+    }
+    flow = 0;
 }
 
 template <class TWeight>
@@ -66,6 +66,18 @@ namespace
         return fabs(v) > numeric_limits<float>::epsilon();
     }
 
+    // number of private vote accumulators of bufSize bytes each for parallel voting;
+    // they are summed afterwards, so their total size is limited
+    int getNumVoteBuffers(size_t bufSize, int maxBuffers)
+    {
+        const size_t maxTotalSize = 1 << 26;
+
+        int n = std::min(getNumThreads(), maxBuffers);
+        n = std::min(n, static_cast<int>(std::min(maxTotalSize / std::max(bufSize, (size_t)1), (size_t)INT_MAX)));
+
+        return std::max(n, 1);
+    }
+
     class GHT_Pos : public GeneralizedHough
     {
     public:
@@ -284,12 +296,24 @@ namespace
         virtual void calcHist();
         virtual void findPosInHist();
 
+        struct ImagePoint
+        {
+            Point pos;
+            float theta;
+        };
+
+        void getImagePoints();
+
         int levels;
         int votesThreshold;
         double dp;
 
         vector< vector<Point> > r_table;
+        vector<ImagePoint> imagePoints;
         Mat hist;
+
+        class PosWorker;
+        friend class PosWorker;
     };
 
     CV_INIT_ALGORITHM(GHT_Ballard_Pos, "GeneralizedHough.POSITION",
@@ -314,6 +338,7 @@ namespace
         GHT_Pos::releaseImpl();
 
         releaseVector(r_table);
+        releaseVector(imagePoints);
         hist.release();
     }
 
@@ -355,22 +380,9 @@ namespace
         findPosInHist();
     }
 
-    void GHT_Ballard_Pos::calcHist()
+    void GHT_Ballard_Pos::getImagePoints()
     {
-        CV_Assert(imageEdges.type() == CV_8UC1);
-        CV_Assert(imageDx.type() == CV_32FC1 && imageDx.size() == imageSize);
-        CV_Assert(imageDy.type() == imageDx.type() && imageDy.size() == imageSize);
-        CV_Assert(levels > 0 && r_table.size() == static_cast<size_t>(levels + 1));
-        CV_Assert(dp > 0.0);
-
-        const double thetaScale = levels / 360.0;
-        const double idp = 1.0 / dp;
-
-        hist.create(cvCeil(imageSize.height * idp) + 2, cvCeil(imageSize.width * idp) + 2, CV_32SC1);
-        hist.setTo(0);
-
-        const int rows = hist.rows - 2;
-        const int cols = hist.cols - 2;
+        imagePoints.clear();
 
         for (int y = 0; y < imageSize.height; ++y)
         {
@@ -380,30 +392,100 @@ namespace
 
             for (int x = 0; x < imageSize.width; ++x)
             {
-                const Point p(x, y);
-
                 if (edgesRow[x] && (notNull(dyRow[x]) || notNull(dxRow[x])))
                 {
-                    const float theta = fastAtan2(dyRow[x], dxRow[x]);
-                    const int n = cvRound(theta * thetaScale);
+                    ImagePoint ip;
 
-                    const vector<Point>& r_row = r_table[n];
+                    ip.pos = Point(x, y);
+                    ip.theta = fastAtan2(dyRow[x], dxRow[x]);
 
-                    for (size_t j = 0; j < r_row.size(); ++j)
-                    {
-                        Point c = p - r_row[j];
+                    imagePoints.push_back(ip);
+                }
+            }
+        }
+    }
 
-                        c.x = cvRound(c.x * idp);
-                        c.y = cvRound(c.y * idp);
+    class GHT_Ballard_Pos::PosWorker : public ParallelLoopBody
+    {
+    public:
+        PosWorker(const GHT_Ballard_Pos* base_, int nstripes_, vector<Mat>& hists_) : base(base_), nstripes(nstripes_), hists(&hists_) {}
 
-                        if (c.x >= 0 && c.x < cols && c.y >= 0 && c.y < rows)
-                            ++hist.at<int>(c.y + 1, c.x + 1);
-                    }
+        void operator ()(const Range& range) const;
+
+    private:
+        const GHT_Ballard_Pos* base;
+        int nstripes;
+        vector<Mat>* hists;
+    };
+
+    void GHT_Ballard_Pos::PosWorker::operator ()(const Range& range) const
+    {
+        const double thetaScale = base->levels / 360.0;
+        const double idp = 1.0 / base->dp;
+
+        const int rows = base->hist.rows - 2;
+        const int cols = base->hist.cols - 2;
+
+        const int count = static_cast<int>(base->imagePoints.size());
+
+        for (int s = range.start; s < range.end; ++s)
+        {
+            Mat& curHist = (*hists)[s];
+
+            const int i0 = static_cast<int>(static_cast<int64>(count) * s / nstripes);
+            const int i1 = static_cast<int>(static_cast<int64>(count) * (s + 1) / nstripes);
+
+            for (int i = i0; i < i1; ++i)
+            {
+                const ImagePoint& ip = base->imagePoints[i];
+                const Point p = ip.pos;
+                const int n = cvRound(ip.theta * thetaScale);
+
+                const vector<Point>& r_row = base->r_table[n];
+
+                for (size_t j = 0; j < r_row.size(); ++j)
+                {
+                    Point c = p - r_row[j];
+
+                    c.x = cvRound(c.x * idp);
+                    c.y = cvRound(c.y * idp);
+
+                    if (c.x >= 0 && c.x < cols && c.y >= 0 && c.y < rows)
+                        ++curHist.at<int>(c.y + 1, c.x + 1);
                 }
             }
         }
     }
 
+    void GHT_Ballard_Pos::calcHist()
+    {
+        CV_Assert(imageEdges.type() == CV_8UC1);
+        CV_Assert(imageDx.type() == CV_32FC1 && imageDx.size() == imageSize);
+        CV_Assert(imageDy.type() == imageDx.type() && imageDy.size() == imageSize);
+        CV_Assert(levels > 0 && r_table.size() == static_cast<size_t>(levels + 1));
+        CV_Assert(dp > 0.0);
+
+        const double idp = 1.0 / dp;
+
+        hist.create(cvCeil(imageSize.height * idp) + 2, cvCeil(imageSize.width * idp) + 2, CV_32SC1);
+        hist.setTo(0);
+
+        getImagePoints();
+
+        // every stripe of edge points votes into its own histogram, the histograms are summed afterwards
+        const int nstripes = getNumVoteBuffers(hist.total() * hist.elemSize(), static_cast<int>(imagePoints.size() / 1024) + 1);
+
+        vector<Mat> hists(nstripes);
+        hists[0] = hist;
+        for (int s = 1; s < nstripes; ++s)
+            hists[s] = Mat::zeros(hist.size(), hist.type());
+
+        parallel_for_(Range(0, nstripes), PosWorker(this, nstripes, hists));
+
+        for (int s = 1; s < nstripes; ++s)
+            add(hist, hists[s], hist);
+    }
+
     void GHT_Ballard_Pos::findPosInHist()
     {
         CV_Assert(votesThreshold > 0);
@@ -497,35 +579,24 @@ namespace
 
             Mat curHist(base->hist.size[1], base->hist.size[2], CV_32SC1, base->hist.ptr(s + 1), base->hist.step[1]);
 
-            for (int y = 0; y < base->imageSize.height; ++y)
+            for (size_t i = 0; i < base->imagePoints.size(); ++i)
             {
-                const uchar* edgesRow = base->imageEdges.ptr(y);
-                const float* dxRow = base->imageDx.ptr<float>(y);
-                const float* dyRow = base->imageDy.ptr<float>(y);
-
-                for (int x = 0; x < base->imageSize.width; ++x)
-                {
-                    const Point2d p(x, y);
-
-                    if (edgesRow[x] && (notNull(dyRow[x]) || notNull(dxRow[x])))
-                    {
-                        const float theta = fastAtan2(dyRow[x], dxRow[x]);
-                        const int n = cvRound(theta * thetaScale);
+                const ImagePoint& ip = base->imagePoints[i];
+                const Point2d p(ip.pos.x, ip.pos.y);
+                const int n = cvRound(ip.theta * thetaScale);
 
-                        const vector<Point>& r_row = base->r_table[n];
+                const vector<Point>& r_row = base->r_table[n];
 
-                        for (size_t j = 0; j < r_row.size(); ++j)
-                        {
-                            Point2d d = r_row[j];
-                            Point2d c = p - d * scale;
+                for (size_t j = 0; j < r_row.size(); ++j)
+                {
+                    Point2d d = r_row[j];
+                    Point2d c = p - d * scale;
 
-                            c.x *= idp;
-                            c.y *= idp;
+                    c.x *= idp;
+                    c.y *= idp;
 
-                            if (c.x >= 0 && c.x < base->hist.size[2] - 2 && c.y >= 0 && c.y < base->hist.size[1] - 2)
-                                ++curHist.at<int>(cvRound(c.y + 1), cvRound(c.x + 1));
-                        }
-                    }
+                    if (c.x >= 0 && c.x < base->hist.size[2] - 2 && c.y >= 0 && c.y < base->hist.size[1] - 2)
+                        ++curHist.at<int>(cvRound(c.y + 1), cvRound(c.x + 1));
                 }
             }
         }
@@ -548,6 +619,8 @@ namespace
         hist.create(3, sizes, CV_32SC1);
         hist.setTo(0);
 
+        getImagePoints();
+
         parallel_for_(Range(0, scaleRange), Worker(this));
     }
 
@@ -665,37 +738,28 @@ namespace
 
             Mat curHist(base->hist.size[1], base->hist.size[2], CV_32SC1, base->hist.ptr(a + 1), base->hist.step[1]);
 
-            for (int y = 0; y < base->imageSize.height; ++y)
+            for (size_t i = 0; i < base->imagePoints.size(); ++i)
             {
-                const uchar* edgesRow = base->imageEdges.ptr(y);
-                const float* dxRow = base->imageDx.ptr<float>(y);
-                const float* dyRow = base->imageDy.ptr<float>(y);
+                const ImagePoint& ip = base->imagePoints[i];
+                const Point2d p(ip.pos.x, ip.pos.y);
 
-                for (int x = 0; x < base->imageSize.width; ++x)
-                {
-                    const Point2d p(x, y);
-
-                    if (edgesRow[x] && (notNull(dyRow[x]) || notNull(dxRow[x])))
-                    {
-                        double theta = fastAtan2(dyRow[x], dxRow[x]) - angle;
-                        if (theta < 0)
-                            theta += 360.0;
-                        const int n = cvRound(theta * thetaScale);
+                double theta = ip.theta - angle;
+                if (theta < 0)
+                    theta += 360.0;
+                const int n = cvRound(theta * thetaScale);
 
-                        const vector<Point>& r_row = base->r_table[n];
+                const vector<Point>& r_row = base->r_table[n];
 
-                        for (size_t j = 0; j < r_row.size(); ++j)
-                        {
-                            Point2d d = r_row[j];
-                            Point2d c = p - Point2d(d.x * cosA - d.y * sinA, d.x * sinA + d.y * cosA);
+                for (size_t j = 0; j < r_row.size(); ++j)
+                {
+                    Point2d d = r_row[j];
+                    Point2d c = p - Point2d(d.x * cosA - d.y * sinA, d.x * sinA + d.y * cosA);
 
-                            c.x *= idp;
-                            c.y *= idp;
+                    c.x *= idp;
+                    c.y *= idp;
 
-                            if (c.x >= 0 && c.x < base->hist.size[2] - 2 && c.y >= 0 && c.y < base->hist.size[1] - 2)
-                                ++curHist.at<int>(cvRound(c.y + 1), cvRound(c.x + 1));
-                        }
-                    }
+                    if (c.x >= 0 && c.x < base->hist.size[2] - 2 && c.y >= 0 && c.y < base->hist.size[1] - 2)
+                        ++curHist.at<int>(cvRound(c.y + 1), cvRound(c.x + 1));
                 }
             }
         }
@@ -718,6 +782,8 @@ namespace
         hist.create(3, sizes, CV_32SC1);
         hist.setTo(0);
 
+        getImagePoints();
+
         parallel_for_(Range(0, angleRange), Worker(this));
     }
 
@@ -819,6 +885,10 @@ namespace
         void buildFeatureList(const Mat& edges, const Mat& dx, const Mat& dy, vector< vector<Feature> >& features, Point2d center = Point2d());
         void getContourPoints(const Mat& edges, const Mat& dx, const Mat& dy, vector<ContourPoint>& points);
 
+        void sortImageFeatures();
+        static bool lessTheta(const Feature& a, const Feature& b);
+        static int getThetaRanges(const vector<double>& thetas, double theta, double eps, Range* ranges);
+
         void calcOrientation();
         void calcScale(double angle);
         void calcPosition(double angle, int angleVotes, double scale, int scaleVotes);
@@ -843,9 +913,19 @@ namespace
 
         vector< vector<Feature> > templFeatures;
         vector< vector<Feature> > imageFeatures;
+        vector< vector<double> > imageThetas;
 
         vector< pair<double, int> > angles;
         vector< pair<double, int> > scales;
+
+        class FeatureWorker;
+        friend class FeatureWorker;
+        class OrientationWorker;
+        friend class OrientationWorker;
+        class ScaleWorker;
+        friend class ScaleWorker;
+        class PositionWorker;
+        friend class PositionWorker;
     };
 
     CV_INIT_ALGORITHM(GHT_Guil_Full, "GeneralizedHough.POSITION_SCALE_ROTATION",
@@ -907,6 +987,7 @@ namespace
 
         releaseVector(templFeatures);
         releaseVector(imageFeatures);
+        releaseVector(imageThetas);
 
         releaseVector(angles);
         releaseVector(scales);
@@ -920,6 +1001,7 @@ namespace
     void GHT_Guil_Full::processImage()
     {
         buildFeatureList(imageEdges, imageDx, imageDy, imageFeatures);
+        sortImageFeatures();
 
         calcOrientation();
 
@@ -940,13 +1022,80 @@ namespace
         }
     }
 
-    void GHT_Guil_Full::buildFeatureList(const Mat& edges, const Mat& dx, const Mat& dy, vector< vector<Feature> >& features, Point2d center)
+    class GHT_Guil_Full::FeatureWorker : public ParallelLoopBody
     {
-        CV_Assert(levels > 0);
+    public:
+        FeatureWorker(const GHT_Guil_Full* base_, const vector<ContourPoint>& points_, Point2d center_, int nstripes_,
+                      vector< vector< vector<Feature> > >& features_) :
+            base(base_), points(&points_), center(center_), nstripes(nstripes_), features(&features_) {}
 
-        const double maxDist = sqrt((double) templSize.width * templSize.width + templSize.height * templSize.height) * maxScale;
+        void operator ()(const Range& range) const;
+
+    private:
+        const GHT_Guil_Full* base;
+        const vector<ContourPoint>* points;
+        Point2d center;
+        int nstripes;
+        vector< vector< vector<Feature> > >* features;
+    };
 
-        const double alphaScale = levels / 360.0;
+    void GHT_Guil_Full::FeatureWorker::operator ()(const Range& range) const
+    {
+        const Size templSize = base->templSize;
+        const double maxDist = sqrt((double) templSize.width * templSize.width + templSize.height * templSize.height) * base->maxScale;
+
+        const double alphaScale = base->levels / 360.0;
+        const size_t maxSize = static_cast<size_t>(base->maxSize);
+
+        const vector<ContourPoint>& pts = *points;
+        const int count = static_cast<int>(pts.size());
+
+        for (int s = range.start; s < range.end; ++s)
+        {
+            vector< vector<Feature> >& stripeFeatures = (*features)[s];
+
+            const int i0 = static_cast<int>(static_cast<int64>(count) * s / nstripes);
+            const int i1 = static_cast<int>(static_cast<int64>(count) * (s + 1) / nstripes);
+
+            for (int i = i0; i < i1; ++i)
+            {
+                const ContourPoint& p1 = pts[i];
+
+                for (int j = 0; j < count; ++j)
+                {
+                    const ContourPoint& p2 = pts[j];
+
+                    if (angleEq(p1.theta - p2.theta, base->xi, base->angleEpsilon))
+                    {
+                        const Point2d d = p1.pos - p2.pos;
+
+                        Feature f;
+
+                        f.p1 = p1;
+                        f.p2 = p2;
+
+                        f.alpha12 = clampAngle(fastAtan2((float)d.y, (float)d.x) - p1.theta);
+                        f.d12 = norm(d);
+
+                        if (f.d12 > maxDist)
+                            continue;
+
+                        f.r1 = p1.pos - center;
+                        f.r2 = p2.pos - center;
+
+                        const int n = cvRound(f.alpha12 * alphaScale);
+
+                        if (stripeFeatures[n].size() < maxSize)
+                            stripeFeatures[n].push_back(f);
+                    }
+                }
+            }
+        }
+    }
+
+    void GHT_Guil_Full::buildFeatureList(const Mat& edges, const Mat& dx, const Mat& dy, vector< vector<Feature> >& features, Point2d center)
+    {
+        CV_Assert(levels > 0);
 
         vector<ContourPoint> points;
         getContourPoints(edges, dx, dy, points);
@@ -955,39 +1104,85 @@ namespace
         for_each(features.begin(), features.end(), mem_fun_ref(&vector<Feature>::clear));
         for_each(features.begin(), features.end(), bind2nd(mem_fun_ref(&vector<Feature>::reserve), maxSize));
 
-        for (size_t i = 0; i < points.size(); ++i)
-        {
-            ContourPoint p1 = points[i];
+        // every stripe of first points collects its own feature table, the tables are
+        // concatenated in stripe order, so the result doesn't depend on the number of stripes
+        const int nstripes = std::max(std::min(getNumThreads(), static_cast<int>(points.size() / 64)), 1);
+
+        vector< vector< vector<Feature> > > stripeFeatures(nstripes);
+        stripeFeatures[0].swap(features);
+        for (int s = 1; s < nstripes; ++s)
+            stripeFeatures[s].resize(levels + 1);
+
+        parallel_for_(Range(0, nstripes), FeatureWorker(this, points, center, nstripes, stripeFeatures));
+
+        stripeFeatures[0].swap(features);
 
-            for (size_t j = 0; j < points.size(); ++j)
+        for (int s = 1; s < nstripes; ++s)
+        {
+            for (int n = 0; n <= levels; ++n)
             {
-                ContourPoint p2 = points[j];
+                const vector<Feature>& src = stripeFeatures[s][n];
+                vector<Feature>& dst = features[n];
 
-                if (angleEq(p1.theta - p2.theta, xi, angleEpsilon))
-                {
-                    const Point2d d = p1.pos - p2.pos;
+                const size_t count = std::min(src.size(), static_cast<size_t>(maxSize) - dst.size());
+                dst.insert(dst.end(), src.begin(), src.begin() + count);
+            }
+        }
+    }
 
-                    Feature f;
+    bool GHT_Guil_Full::lessTheta(const Feature& a, const Feature& b)
+    {
+        return a.p1.theta < b.p1.theta;
+    }
+
+    // The votes don't depend on the order of the image features inside a level, so they are
+    // sorted by the orientation of the first point to look up the ones that match a template
+    // feature orientation by binary search instead of scanning the whole level.
+    void GHT_Guil_Full::sortImageFeatures()
+    {
+        imageThetas.resize(imageFeatures.size());
+
+        for (size_t n = 0; n < imageFeatures.size(); ++n)
+        {
+            vector<Feature>& row = imageFeatures[n];
+            std::sort(row.begin(), row.end(), lessTheta);
+
+            vector<double>& thetas = imageThetas[n];
+            thetas.resize(row.size());
+            for (size_t k = 0; k < row.size(); ++k)
+                thetas[k] = row[k].p1.theta;
+        }
+    }
 
-                    f.p1 = p1;
-                    f.p2 = p2;
+    // Returns the ranges of the sorted thetas that may satisfy angleEq(thetas[k], theta, eps).
+    // The ranges are slightly wider than needed, the candidates must still be checked with angleEq.
+    int GHT_Guil_Full::getThetaRanges(const vector<double>& thetas, double theta, double eps, Range* ranges)
+    {
+        const int count = static_cast<int>(thetas.size());
 
-                    f.alpha12 = clampAngle(fastAtan2((float)d.y, (float)d.x) - p1.theta);
-                    f.d12 = norm(d);
+        if (eps >= 180.0)
+        {
+            ranges[0] = Range(0, count);
+            return 1;
+        }
 
-                    if (f.d12 > maxDist)
-                        continue;
+        const double margin = 1e-6;
+        int nranges = 0;
 
-                    f.r1 = p1.pos - center;
-                    f.r2 = p2.pos - center;
+        // thetas are in [0, 360] and theta in [0, 720], so angleEq wraps the difference at most twice
+        for (int k = 0; k <= 2; ++k)
+        {
+            const double lo = theta - 360.0 * k - margin;
+            const double hi = theta - 360.0 * k + std::max(eps, 0.0) + margin;
 
-                    const int n = cvRound(f.alpha12 * alphaScale);
+            const int start = static_cast<int>(std::lower_bound(thetas.begin(), thetas.end(), lo) - thetas.begin());
+            const int end = static_cast<int>(std::upper_bound(thetas.begin(), thetas.end(), hi) - thetas.begin());
 
-                    if (features[n].size() < static_cast<size_t>(maxSize))
-                        features[n].push_back(f);
-                }
-            }
+            if (start < end)
+                ranges[nranges++] = Range(start, end);
         }
+
+        return nranges;
     }
 
     void GHT_Guil_Full::getContourPoints(const Mat& edges, const Mat& dx, const Mat& dy, vector<ContourPoint>& points)
@@ -1020,6 +1215,55 @@ namespace
         }
     }
 
+    class GHT_Guil_Full::OrientationWorker : public ParallelLoopBody
+    {
+    public:
+        OrientationWorker(const GHT_Guil_Full* base_, int nstripes_, vector< vector<int> >& hists_) :
+            base(base_), nstripes(nstripes_), hists(&hists_) {}
+
+        void operator ()(const Range& range) const;
+
+    private:
+        const GHT_Guil_Full* base;
+        int nstripes;
+        vector< vector<int> >* hists;
+    };
+
+    void GHT_Guil_Full::OrientationWorker::operator ()(const Range& range) const
+    {
+        const double minAngle = base->minAngle;
+        const double maxAngle = base->maxAngle;
+        const double iAngleStep = 1.0 / base->angleStep;
+
+        for (int s = range.start; s < range.end; ++s)
+        {
+            vector<int>& OHist = (*hists)[s];
+
+            for (int i = s; i <= base->levels; i += nstripes)
+            {
+                const vector<Feature>& templRow = base->templFeatures[i];
+                const vector<Feature>& imageRow = base->imageFeatures[i];
+
+                for (size_t j = 0; j < templRow.size(); ++j)
+                {
+                    const Feature& templF = templRow[j];
+
+                    for (size_t k = 0; k < imageRow.size(); ++k)
+                    {
+                        const Feature& imF = imageRow[k];
+
+                        const double angle = clampAngle(imF.p1.theta - templF.p1.theta);
+                        if (angle >= minAngle && angle <= maxAngle)
+                        {
+                            const int n = cvRound((angle - minAngle) * iAngleStep);
+                            ++OHist[n];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
     void GHT_Guil_Full::calcOrientation()
     {
         CV_Assert(levels > 0);
@@ -1032,28 +1276,17 @@ namespace
         const double iAngleStep = 1.0 / angleStep;
         const int angleRange = cvCeil((maxAngle - minAngle) * iAngleStep);
 
-        vector<int> OHist(angleRange + 1, 0);
-        for (int i = 0; i <= levels; ++i)
-        {
-            const vector<Feature>& templRow = templFeatures[i];
-            const vector<Feature>& imageRow = imageFeatures[i];
+        // the feature table levels are interleaved between the stripes for better balance
+        const int nstripes = std::min(getNumThreads(), levels + 1);
 
-            for (size_t j = 0; j < templRow.size(); ++j)
-            {
-                Feature templF = templRow[j];
+        vector< vector<int> > OHists(nstripes, vector<int>(angleRange + 1, 0));
+        parallel_for_(Range(0, nstripes), OrientationWorker(this, nstripes, OHists));
 
-                for (size_t k = 0; k < imageRow.size(); ++k)
-                {
-                    Feature imF = imageRow[k];
-
-                    const double angle = clampAngle(imF.p1.theta - templF.p1.theta);
-                    if (angle >= minAngle && angle <= maxAngle)
-                    {
-                        const int n = cvRound((angle - minAngle) * iAngleStep);
-                        ++OHist[n];
-                    }
-                }
-            }
+        vector<int>& OHist = OHists[0];
+        for (int s = 1; s < nstripes; ++s)
+        {
+            for (int n = 0; n <= angleRange; ++n)
+                OHist[n] += OHists[s][n];
         }
 
         angles.clear();
@@ -1068,47 +1301,90 @@ namespace
         }
     }
 
-    void GHT_Guil_Full::calcScale(double angle)
+    class GHT_Guil_Full::ScaleWorker : public ParallelLoopBody
     {
-        CV_Assert(levels > 0);
-        CV_Assert(templFeatures.size() == static_cast<size_t>(levels + 1));
-        CV_Assert(imageFeatures.size() == templFeatures.size());
-        CV_Assert(minScale > 0.0 && minScale < maxScale);
-        CV_Assert(scaleStep > 0.0);
-        CV_Assert(scaleThresh > 0);
+    public:
+        ScaleWorker(const GHT_Guil_Full* base_, double angle_, int nstripes_, vector< vector<int> >& hists_) :
+            base(base_), angle(angle_), nstripes(nstripes_), hists(&hists_) {}
 
-        const double iScaleStep = 1.0 / scaleStep;
-        const int scaleRange = cvCeil((maxScale - minScale) * iScaleStep);
+        void operator ()(const Range& range) const;
+
+    private:
+        const GHT_Guil_Full* base;
+        double angle;
+        int nstripes;
+        vector< vector<int> >* hists;
+    };
 
-        vector<int> SHist(scaleRange + 1, 0);
+    void GHT_Guil_Full::ScaleWorker::operator ()(const Range& range) const
+    {
+        const double minScale = base->minScale;
+        const double maxScale = base->maxScale;
+        const double iScaleStep = 1.0 / base->scaleStep;
 
-        for (int i = 0; i <= levels; ++i)
+        for (int s = range.start; s < range.end; ++s)
         {
-            const vector<Feature>& templRow = templFeatures[i];
-            const vector<Feature>& imageRow = imageFeatures[i];
+            vector<int>& SHist = (*hists)[s];
 
-            for (size_t j = 0; j < templRow.size(); ++j)
+            for (int i = s; i <= base->levels; i += nstripes)
             {
-                Feature templF = templRow[j];
-
-                templF.p1.theta += angle;
+                const vector<Feature>& templRow = base->templFeatures[i];
+                const vector<Feature>& imageRow = base->imageFeatures[i];
 
-                for (size_t k = 0; k < imageRow.size(); ++k)
+                for (size_t j = 0; j < templRow.size(); ++j)
                 {
-                    Feature imF = imageRow[k];
+                    const Feature& templF = templRow[j];
 
-                    if (angleEq(imF.p1.theta, templF.p1.theta, angleEpsilon))
+                    const double templTheta = templF.p1.theta + angle;
+
+                    Range ranges[3];
+                    const int nranges = getThetaRanges(base->imageThetas[i], templTheta, base->angleEpsilon, ranges);
+
+                    for (int r = 0; r < nranges; ++r)
                     {
-                        const double scale = imF.d12 / templF.d12;
-                        if (scale >= minScale && scale <= maxScale)
+                        for (int k = ranges[r].start; k < ranges[r].end; ++k)
                         {
-                            const int s = cvRound((scale - minScale) * iScaleStep);
-                            ++SHist[s];
+                            const Feature& imF = imageRow[k];
+
+                            if (angleEq(imF.p1.theta, templTheta, base->angleEpsilon))
+                            {
+                                const double scale = imF.d12 / templF.d12;
+                                if (scale >= minScale && scale <= maxScale)
+                                {
+                                    const int n = cvRound((scale - minScale) * iScaleStep);
+                                    ++SHist[n];
+                                }
+                            }
                         }
                     }
                 }
             }
         }
+    }
+
+    void GHT_Guil_Full::calcScale(double angle)
+    {
+        CV_Assert(levels > 0);
+        CV_Assert(templFeatures.size() == static_cast<size_t>(levels + 1));
+        CV_Assert(imageFeatures.size() == templFeatures.size());
+        CV_Assert(minScale > 0.0 && minScale < maxScale);
+        CV_Assert(scaleStep > 0.0);
+        CV_Assert(scaleThresh > 0);
+
+        const double iScaleStep = 1.0 / scaleStep;
+        const int scaleRange = cvCeil((maxScale - minScale) * iScaleStep);
+
+        const int nstripes = std::min(getNumThreads(), levels + 1);
+
+        vector< vector<int> > SHists(nstripes, vector<int>(scaleRange + 1, 0));
+        parallel_for_(Range(0, nstripes), ScaleWorker(this, angle, nstripes, SHists));
+
+        vector<int>& SHist = SHists[0];
+        for (int s = 1; s < nstripes; ++s)
+        {
+            for (int n = 0; n <= scaleRange; ++n)
+                SHist[n] += SHists[s][n];
+        }
 
         scales.clear();
 
@@ -1122,63 +1398,110 @@ namespace
         }
     }
 
-    void GHT_Guil_Full::calcPosition(double angle, int angleVotes, double scale, int scaleVotes)
+    class GHT_Guil_Full::PositionWorker : public ParallelLoopBody
     {
-        CV_Assert(levels > 0);
-        CV_Assert(templFeatures.size() == static_cast<size_t>(levels + 1));
-        CV_Assert(imageFeatures.size() == templFeatures.size());
-        CV_Assert(dp > 0.0);
-        CV_Assert(posThresh > 0);
+    public:
+        PositionWorker(const GHT_Guil_Full* base_, double angle_, double scale_, int nstripes_, vector<Mat>& hists_) :
+            base(base_), angle(angle_), scale(scale_), nstripes(nstripes_), hists(&hists_) {}
 
-        const double sinVal = sin(toRad(angle));
-        const double cosVal = cos(toRad(angle));
-        const double idp = 1.0 / dp;
+        void operator ()(const Range& range) const;
 
-        const int histRows = cvCeil(imageSize.height * idp);
-        const int histCols = cvCeil(imageSize.width * idp);
+    private:
+        const GHT_Guil_Full* base;
+        double angle;
+        double scale;
+        int nstripes;
+        vector<Mat>* hists;
+    };
 
-        Mat DHist(histRows + 2, histCols + 2, CV_32SC1, Scalar::all(0));
+    void GHT_Guil_Full::PositionWorker::operator ()(const Range& range) const
+    {
+        const double sinVal = sin(toRad(angle));
+        const double cosVal = cos(toRad(angle));
+        const double idp = 1.0 / base->dp;
 
-        for (int i = 0; i <= levels; ++i)
+        for (int s = range.start; s < range.end; ++s)
         {
-            const vector<Feature>& templRow = templFeatures[i];
-            const vector<Feature>& imageRow = imageFeatures[i];
+            Mat& DHist = (*hists)[s];
+
+            const int histRows = DHist.rows - 2;
+            const int histCols = DHist.cols - 2;
 
-            for (size_t j = 0; j < templRow.size(); ++j)
+            for (int i = s; i <= base->levels; i += nstripes)
             {
-                Feature templF = templRow[j];
+                const vector<Feature>& templRow = base->templFeatures[i];
+                const vector<Feature>& imageRow = base->imageFeatures[i];
 
-                templF.p1.theta += angle;
+                for (size_t j = 0; j < templRow.size(); ++j)
+                {
+                    Feature templF = templRow[j];
 
-                templF.r1 *= scale;
-                templF.r2 *= scale;
+                    templF.p1.theta += angle;
 
-                templF.r1 = Point2d(cosVal * templF.r1.x - sinVal * templF.r1.y, sinVal * templF.r1.x + cosVal * templF.r1.y);
-                templF.r2 = Point2d(cosVal * templF.r2.x - sinVal * templF.r2.y, sinVal * templF.r2.x + cosVal * templF.r2.y);
+                    templF.r1 *= scale;
+                    templF.r2 *= scale;
 
-                for (size_t k = 0; k < imageRow.size(); ++k)
-                {
-                    Feature imF = imageRow[k];
+                    templF.r1 = Point2d(cosVal * templF.r1.x - sinVal * templF.r1.y, sinVal * templF.r1.x + cosVal * templF.r1.y);
+                    templF.r2 = Point2d(cosVal * templF.r2.x - sinVal * templF.r2.y, sinVal * templF.r2.x + cosVal * templF.r2.y);
 
-                    if (angleEq(imF.p1.theta, templF.p1.theta, angleEpsilon))
+                    Range ranges[3];
+                    const int nranges = getThetaRanges(base->imageThetas[i], templF.p1.theta, base->angleEpsilon, ranges);
+
+                    for (int r = 0; r < nranges; ++r)
                     {
-                        Point2d c1, c2;
+                        for (int k = ranges[r].start; k < ranges[r].end; ++k)
+                        {
+                            const Feature& imF = imageRow[k];
 
-                        c1 = imF.p1.pos - templF.r1;
-                        c1 *= idp;
+                            if (angleEq(imF.p1.theta, templF.p1.theta, base->angleEpsilon))
+                            {
+                                Point2d c1, c2;
 
-                        c2 = imF.p2.pos - templF.r2;
-                        c2 *= idp;
+                                c1 = imF.p1.pos - templF.r1;
+                                c1 *= idp;
 
-                        if (fabs(c1.x - c2.x) > 1 || fabs(c1.y - c2.y) > 1)
-                            continue;
+                                c2 = imF.p2.pos - templF.r2;
+                                c2 *= idp;
+
+                                if (fabs(c1.x - c2.x) > 1 || fabs(c1.y - c2.y) > 1)
+                                    continue;
 
-                        if (c1.y >= 0 && c1.y < histRows && c1.x >= 0 && c1.x < histCols)
-                            ++DHist.at<int>(cvRound(c1.y) + 1, cvRound(c1.x) + 1);
+                                if (c1.y >= 0 && c1.y < histRows && c1.x >= 0 && c1.x < histCols)
+                                    ++DHist.at<int>(cvRound(c1.y) + 1, cvRound(c1.x) + 1);
+                            }
+                        }
                     }
                 }
             }
         }
+    }
+
+    void GHT_Guil_Full::calcPosition(double angle, int angleVotes, double scale, int scaleVotes)
+    {
+        CV_Assert(levels > 0);
+        CV_Assert(templFeatures.size() == static_cast<size_t>(levels + 1));
+        CV_Assert(imageFeatures.size() == templFeatures.size());
+        CV_Assert(dp > 0.0);
+        CV_Assert(posThresh > 0);
+
+        const double idp = 1.0 / dp;
+
+        const int histRows = cvCeil(imageSize.height * idp);
+        const int histCols = cvCeil(imageSize.width * idp);
+
+        Mat DHist(histRows + 2, histCols + 2, CV_32SC1, Scalar::all(0));
+
+        const int nstripes = getNumVoteBuffers(DHist.total() * DHist.elemSize(), levels + 1);
+
+        vector<Mat> DHists(nstripes);
+        DHists[0] = DHist;
+        for (int s = 1; s < nstripes; ++s)
+            DHists[s] = Mat::zeros(DHist.size(), DHist.type());
+
+        parallel_for_(Range(0, nstripes), PositionWorker(this, angle, scale, nstripes, DHists));
+
+        for (int s = 1; s < nstripes; ++s)
+            add(DHist, DHists[s], DHist);
 
         for(int y = 0; y < histRows; ++y)
         {
@@ -66,6 +66,7 @@ public:
 
     void initLearning();
     void addSample( int ci, const Vec3d color );
+    void addSamples( int ci, const double sum[3], const double prod[3][3], int count );
     void endLearning();
 
 private:
@@ -171,6 +172,18 @@ void GMM::addSample( int ci, const Vec3d color )
     totalSampleCount++;
 }
 
+void GMM::addSamples( int ci, const double sum[3], const double prod[3][3], int count )
+{
+    for( int i = 0; i < 3; i++ )
+    {
+        sums[ci][i] += sum[i];
+        for( int j = 0; j < 3; j++ )
+            prods[ci][i][j] += prod[i][j];
+    }
+    sampleCounts[ci] += count;
+    totalSampleCount += count;
+}
+
 void GMM::endLearning()
 {
     const double variance = 0.01;
@@ -227,39 +240,68 @@ void GMM::calcInverseCovAndDeterm( int ci )
 }
 
 /*
-  Calculate beta - parameter of GrabCut algorithm.
-  beta = 1/(2*avg(sqr(||color[i] - color[j]||)))
+  Sums the squared color differences between the neighbour pixels of every row.
+  The differences are integer, so the sums are exact and do not depend on the order.
 */
-static double calcBeta( const Mat& img )
+class CalcBetaInvoker : public ParallelLoopBody
 {
-    double beta = 0;
-    for( int y = 0; y < img.rows; y++ )
+public:
+    CalcBetaInvoker( const Mat& _img, double* _rowSums ) :
+        ParallelLoopBody(), img(&_img), rowSums(_rowSums)
     {
-        for( int x = 0; x < img.cols; x++ )
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        for( int y = range.start; y < range.end; y++ )
         {
-            Vec3d color = img.at<Vec3b>(y,x);
-            if( x>0 ) // left
-            {
-                Vec3d diff = color - (Vec3d)img.at<Vec3b>(y,x-1);
-                beta += diff.dot(diff);
-            }
-            if( y>0 && x>0 ) // upleft
-            {
-                Vec3d diff = color - (Vec3d)img.at<Vec3b>(y-1,x-1);
-                beta += diff.dot(diff);
-            }
-            if( y>0 ) // up
-            {
-                Vec3d diff = color - (Vec3d)img.at<Vec3b>(y-1,x);
-                beta += diff.dot(diff);
-            }
-            if( y>0 && x<img.cols-1) // upright
+            double beta = 0;
+            for( int x = 0; x < img->cols; x++ )
             {
-                Vec3d diff = color - (Vec3d)img.at<Vec3b>(y-1,x+1);
-                beta += diff.dot(diff);
+                Vec3d color = img->at<Vec3b>(y,x);
+                if( x>0 ) // left
+                {
+                    Vec3d diff = color - (Vec3d)img->at<Vec3b>(y,x-1);
+                    beta += diff.dot(diff);
+                }
+                if( y>0 && x>0 ) // upleft
+                {
+                    Vec3d diff = color - (Vec3d)img->at<Vec3b>(y-1,x-1);
+                    beta += diff.dot(diff);
+                }
+                if( y>0 ) // up
+                {
+                    Vec3d diff = color - (Vec3d)img->at<Vec3b>(y-1,x);
+                    beta += diff.dot(diff);
+                }
+                if( y>0 && x<img->cols-1) // upright
+                {
+                    Vec3d diff = color - (Vec3d)img->at<Vec3b>(y-1,x+1);
+                    beta += diff.dot(diff);
+                }
             }
+            rowSums[y] = beta;
         }
     }
+
+private:
+    const Mat* img;
+    double* rowSums;
+};
+
+/*
+  Calculate beta - parameter of GrabCut algorithm.
+  beta = 1/(2*avg(sqr(||color[i] - color[j]||)))
+*/
+static double calcBeta( const Mat& img )
+{
+    AutoBuffer<double> rowSums(img.rows);
+    parallel_for_( Range(0, img.rows), CalcBetaInvoker(img, rowSums) );
+
+    double beta = 0;
+    for( int y = 0; y < img.rows; y++ )
+        beta += rowSums[y];
+
     if( beta <= std::numeric_limits<double>::epsilon() )
         beta = 0;
     else
@@ -268,52 +310,76 @@ static double calcBeta( const Mat& img )
     return beta;
 }
 
+class CalcNWeightsInvoker : public ParallelLoopBody
+{
+public:
+    CalcNWeightsInvoker( const Mat& _img, Mat& _leftW, Mat& _upleftW, Mat& _upW, Mat& _uprightW,
+                         double _beta, double _gamma ) :
+        ParallelLoopBody(), img(&_img), leftW(&_leftW), upleftW(&_upleftW), upW(&_upW),
+        uprightW(&_uprightW), beta(_beta), gamma(_gamma)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        const double gammaDivSqrt2 = gamma / std::sqrt(2.0f);
+        for( int y = range.start; y < range.end; y++ )
+        {
+            for( int x = 0; x < img->cols; x++ )
+            {
+                Vec3d color = img->at<Vec3b>(y,x);
+                if( x-1>=0 ) // left
+                {
+                    Vec3d diff = color - (Vec3d)img->at<Vec3b>(y,x-1);
+                    leftW->at<double>(y,x) = gamma * exp(-beta*diff.dot(diff));
+                }
+                else
+                    leftW->at<double>(y,x) = 0;
+                if( x-1>=0 && y-1>=0 ) // upleft
+                {
+                    Vec3d diff = color - (Vec3d)img->at<Vec3b>(y-1,x-1);
+                    upleftW->at<double>(y,x) = gammaDivSqrt2 * exp(-beta*diff.dot(diff));
+                }
+                else
+                    upleftW->at<double>(y,x) = 0;
+                if( y-1>=0 ) // up
+                {
+                    Vec3d diff = color - (Vec3d)img->at<Vec3b>(y-1,x);
+                    upW->at<double>(y,x) = gamma * exp(-beta*diff.dot(diff));
+                }
+                else
+                    upW->at<double>(y,x) = 0;
+                if( x+1<img->cols && y-1>=0 ) // upright
+                {
+                    Vec3d diff = color - (Vec3d)img->at<Vec3b>(y-1,x+1);
+                    uprightW->at<double>(y,x) = gammaDivSqrt2 * exp(-beta*diff.dot(diff));
+                }
+                else
+                    uprightW->at<double>(y,x) = 0;
+            }
+        }
+    }
+
+private:
+    const Mat* img;
+    Mat* leftW;
+    Mat* upleftW;
+    Mat* upW;
+    Mat* uprightW;
+    double beta, gamma;
+};
+
 /*
   Calculate weights of noterminal vertices of graph.
   beta and gamma - parameters of GrabCut algorithm.
  */
 static void calcNWeights( const Mat& img, Mat& leftW, Mat& upleftW, Mat& upW, Mat& uprightW, double beta, double gamma )
 {
-    const double gammaDivSqrt2 = gamma / std::sqrt(2.0f);
     leftW.create( img.rows, img.cols, CV_64FC1 );
     upleftW.create( img.rows, img.cols, CV_64FC1 );
     upW.create( img.rows, img.cols, CV_64FC1 );
     uprightW.create( img.rows, img.cols, CV_64FC1 );
-    for( int y = 0; y < img.rows; y++ )
-    {
-        for( int x = 0; x < img.cols; x++ )
-        {
-            Vec3d color = img.at<Vec3b>(y,x);
-            if( x-1>=0 ) // left
-            {
-                Vec3d diff = color - (Vec3d)img.at<Vec3b>(y,x-1);
-                leftW.at<double>(y,x) = gamma * exp(-beta*diff.dot(diff));
-            }
-            else
-                leftW.at<double>(y,x) = 0;
-            if( x-1>=0 && y-1>=0 ) // upleft
-            {
-                Vec3d diff = color - (Vec3d)img.at<Vec3b>(y-1,x-1);
-                upleftW.at<double>(y,x) = gammaDivSqrt2 * exp(-beta*diff.dot(diff));
-            }
-            else
-                upleftW.at<double>(y,x) = 0;
-            if( y-1>=0 ) // up
-            {
-                Vec3d diff = color - (Vec3d)img.at<Vec3b>(y-1,x);
-                upW.at<double>(y,x) = gamma * exp(-beta*diff.dot(diff));
-            }
-            else
-                upW.at<double>(y,x) = 0;
-            if( x+1<img.cols && y-1>=0 ) // upright
-            {
-                Vec3d diff = color - (Vec3d)img.at<Vec3b>(y-1,x+1);
-                uprightW.at<double>(y,x) = gammaDivSqrt2 * exp(-beta*diff.dot(diff));
-            }
-            else
-                uprightW.at<double>(y,x) = 0;
-        }
-    }
+    parallel_for_( Range(0, img.rows), CalcNWeightsInvoker(img, leftW, upleftW, upW, uprightW, beta, gamma) );
 }
 
 /*
@@ -398,109 +464,300 @@ static void initGMMs( const Mat& img, const Mat& mask, GMM& bgdGMM, GMM& fgdGMM
 /*
   Assign GMMs components for each pixel.
 */
-static void assignGMMsComponents( const Mat& img, const Mat& mask, const GMM& bgdGMM, const GMM& fgdGMM, Mat& compIdxs )
+class AssignGMMsComponentsInvoker : public ParallelLoopBody
 {
-    Point p;
-    for( p.y = 0; p.y < img.rows; p.y++ )
+public:
+    AssignGMMsComponentsInvoker( const Mat& _img, const Mat& _mask, const GMM& _bgdGMM,
+                                 const GMM& _fgdGMM, Mat& _compIdxs ) :
+        ParallelLoopBody(), img(&_img), mask(&_mask), bgdGMM(&_bgdGMM),
+        fgdGMM(&_fgdGMM), compIdxs(&_compIdxs)
     {
-        for( p.x = 0; p.x < img.cols; p.x++ )
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        Point p;
+        for( p.y = range.start; p.y < range.end; p.y++ )
         {
-            Vec3d color = img.at<Vec3b>(p);
-            compIdxs.at<int>(p) = mask.at<uchar>(p) == GC_BGD || mask.at<uchar>(p) == GC_PR_BGD ?
-                bgdGMM.whichComponent(color) : fgdGMM.whichComponent(color);
+            for( p.x = 0; p.x < img->cols; p.x++ )
+            {
+                Vec3d color = img->at<Vec3b>(p);
+                uchar m = mask->at<uchar>(p);
+                compIdxs->at<int>(p) = m == GC_BGD || m == GC_PR_BGD ?
+                    bgdGMM->whichComponent(color) : fgdGMM->whichComponent(color);
+            }
         }
     }
+
+private:
+    const Mat* img;
+    const Mat* mask;
+    const GMM* bgdGMM;
+    const GMM* fgdGMM;
+    Mat* compIdxs;
+};
+
+static void assignGMMsComponents( const Mat& img, const Mat& mask, const GMM& bgdGMM, const GMM& fgdGMM, Mat& compIdxs )
+{
+    parallel_for_( Range(0, img.rows), AssignGMMsComponentsInvoker(img, mask, bgdGMM, fgdGMM, compIdxs) );
 }
 
+/*
+  Accumulates the GMMs learning statistics for a band of rows.
+  Index 0 corresponds to the background model, 1 to the foreground one.
+*/
+struct GMMsLearningStats
+{
+    double sums[2][GMM::componentsCount][3];
+    double prods[2][GMM::componentsCount][3][3];
+    int sampleCounts[2][GMM::componentsCount];
+};
+
+class LearnGMMsInvoker : public ParallelLoopBody
+{
+public:
+    LearnGMMsInvoker( const Mat& _img, const Mat& _mask, const Mat& _compIdxs,
+                      GMMsLearningStats* _stats, int _nstripes ) :
+        ParallelLoopBody(), img(&_img), mask(&_mask), compIdxs(&_compIdxs),
+        stats(_stats), nstripes(_nstripes)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        for( int i = range.start; i < range.end; i++ )
+        {
+            GMMsLearningStats& st = stats[i];
+            int y0 = (int)((int64)img->rows*i/nstripes), y1 = (int)((int64)img->rows*(i + 1)/nstripes);
+            memset( &st, 0, sizeof(st) );
+
+            Point p;
+            for( p.y = y0; p.y < y1; p.y++ )
+            {
+                for( p.x = 0; p.x < img->cols; p.x++ )
+                {
+                    uchar m = mask->at<uchar>(p);
+                    int k = m == GC_BGD || m == GC_PR_BGD ? 0 : 1;
+                    int ci = compIdxs->at<int>(p);
+                    Vec3d color = img->at<Vec3b>(p);
+
+                    double* sum = st.sums[k][ci];
+                    double (*prod)[3] = st.prods[k][ci];
+                    for( int a = 0; a < 3; a++ )
+                    {
+                        sum[a] += color[a];
+                        for( int b = 0; b < 3; b++ )
+                            prod[a][b] += color[a]*color[b];
+                    }
+                    st.sampleCounts[k][ci]++;
+                }
+            }
+        }
+    }
+
+private:
+    const Mat* img;
+    const Mat* mask;
+    const Mat* compIdxs;
+    GMMsLearningStats* stats;
+    int nstripes;
+};
+
 /*
   Learn GMMs parameters.
 */
 static void learnGMMs( const Mat& img, const Mat& mask, const Mat& compIdxs, GMM& bgdGMM, GMM& fgdGMM )
 {
+    // the color sums are integer, so the result does not depend on the partitioning
+    int nstripes = std::max(std::min(img.rows/16, getNumThreads()*4), 1);
+    std::vector<GMMsLearningStats> stats(nstripes);
+    parallel_for_( Range(0, nstripes), LearnGMMsInvoker(img, mask, compIdxs, &stats[0], nstripes) );
+
     bgdGMM.initLearning();
     fgdGMM.initLearning();
-    Point p;
-    for( int ci = 0; ci < GMM::componentsCount; ci++ )
+    for( int i = 0; i < nstripes; i++ )
+        for( int ci = 0; ci < GMM::componentsCount; ci++ )
+        {
+            bgdGMM.addSamples( ci, stats[i].sums[0][ci], stats[i].prods[0][ci], stats[i].sampleCounts[0][ci] );
+            fgdGMM.addSamples( ci, stats[i].sums[1][ci], stats[i].prods[1][ci], stats[i].sampleCounts[1][ci] );
+        }
+    bgdGMM.endLearning();
+    fgdGMM.endLearning();
+}
+
+/*
+  Calculate weights of terminal edges of graph.
+*/
+class CalcTWeightsInvoker : public ParallelLoopBody
+{
+public:
+    CalcTWeightsInvoker( const Mat& _img, const Mat& _mask, const GMM& _bgdGMM, const GMM& _fgdGMM,
+                         double _lambda, Mat& _fromSource, Mat& _toSink ) :
+        ParallelLoopBody(), img(&_img), mask(&_mask), bgdGMM(&_bgdGMM), fgdGMM(&_fgdGMM),
+        lambda(_lambda), fromSource(&_fromSource), toSink(&_toSink)
     {
-        for( p.y = 0; p.y < img.rows; p.y++ )
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        Point p;
+        for( p.y = range.start; p.y < range.end; p.y++ )
         {
-            for( p.x = 0; p.x < img.cols; p.x++ )
+            for( p.x = 0; p.x < img->cols; p.x++ )
             {
-                if( compIdxs.at<int>(p) == ci )
+                uchar m = mask->at<uchar>(p);
+                double& src = fromSource->at<double>(p);
+                double& sink = toSink->at<double>(p);
+
+                if( m == GC_PR_BGD || m == GC_PR_FGD )
+                {
+                    Vec3b color = img->at<Vec3b>(p);
+                    src = -log( (*bgdGMM)(color) );
+                    sink = -log( (*fgdGMM)(color) );
+                }
+                else if( m == GC_BGD )
+                {
+                    src = 0;
+                    sink = lambda;
+                }
+                else // GC_FGD
                 {
-                    if( mask.at<uchar>(p) == GC_BGD || mask.at<uchar>(p) == GC_PR_BGD )
-                        bgdGMM.addSample( ci, img.at<Vec3b>(p) );
-                    else
-                        fgdGMM.addSample( ci, img.at<Vec3b>(p) );
+                    src = lambda;
+                    sink = 0;
                 }
             }
         }
     }
-    bgdGMM.endLearning();
-    fgdGMM.endLearning();
-}
+
+private:
+    const Mat* img;
+    const Mat* mask;
+    const GMM* bgdGMM;
+    const GMM* fgdGMM;
+    double lambda;
+    Mat* fromSource;
+    Mat* toSink;
+};
 
 /*
-  Construct GCGraph
+  Construct GCGraph: the vertices and the n-links. The n-links weights do not
+  change between the iterations, so the graph is built only once; edgeIdxs stores
+  the index of the first edge added for every pixel.
 */
-static void constructGCGraph( const Mat& img, const Mat& mask, const GMM& bgdGMM, const GMM& fgdGMM, double lambda,
-                       const Mat& leftW, const Mat& upleftW, const Mat& upW, const Mat& uprightW,
-                       GCGraph<double>& graph )
+static void constructGCGraph( const Mat& img, const Mat& leftW, const Mat& upleftW, const Mat& upW,
+                              const Mat& uprightW, GCGraph<double>& graph, Mat& edgeIdxs )
 {
     int vtxCount = img.cols*img.rows,
         edgeCount = 2*(4*img.cols*img.rows - 3*(img.cols + img.rows) + 2);
     graph.create(vtxCount, edgeCount);
+    edgeIdxs.create( img.size(), CV_32SC1 );
     Point p;
     for( p.y = 0; p.y < img.rows; p.y++ )
     {
         for( p.x = 0; p.x < img.cols; p.x++)
         {
             // add node
-            int vtxIdx = graph.addVtx();
-            Vec3b color = img.at<Vec3b>(p);
-
-            // set t-weights
-            double fromSource, toSink;
-            if( mask.at<uchar>(p) == GC_PR_BGD || mask.at<uchar>(p) == GC_PR_FGD )
-            {
-                fromSource = -log( bgdGMM(color) );
-                toSink = -log( fgdGMM(color) );
-            }
-            else if( mask.at<uchar>(p) == GC_BGD )
-            {
-                fromSource = 0;
-                toSink = lambda;
-            }
-            else // GC_FGD
-            {
-                fromSource = lambda;
-                toSink = 0;
-            }
-            graph.addTermWeights( vtxIdx, fromSource, toSink );
+            int vtxIdx = graph.addVtx(), e0 = -1, e;
 
             // set n-weights
             if( p.x>0 )
             {
                 double w = leftW.at<double>(p);
-                graph.addEdges( vtxIdx, vtxIdx-1, w, w );
+                e = graph.addEdges( vtxIdx, vtxIdx-1, w, w );
+                e0 = e0 < 0 ? e : e0;
             }
             if( p.x>0 && p.y>0 )
             {
                 double w = upleftW.at<double>(p);
-                graph.addEdges( vtxIdx, vtxIdx-img.cols-1, w, w );
+                e = graph.addEdges( vtxIdx, vtxIdx-img.cols-1, w, w );
+                e0 = e0 < 0 ? e : e0;
             }
             if( p.y>0 )
             {
                 double w = upW.at<double>(p);
-                graph.addEdges( vtxIdx, vtxIdx-img.cols, w, w );
+                e = graph.addEdges( vtxIdx, vtxIdx-img.cols, w, w );
+                e0 = e0 < 0 ? e : e0;
             }
             if( p.x<img.cols-1 && p.y>0 )
             {
                 double w = uprightW.at<double>(p);
-                graph.addEdges( vtxIdx, vtxIdx-img.cols+1, w, w );
+                e = graph.addEdges( vtxIdx, vtxIdx-img.cols+1, w, w );
+                e0 = e0 < 0 ? e : e0;
+            }
+            edgeIdxs.at<int>(p) = e0;
+        }
+    }
+}
+
+/*
+  Restore the n-links capacities changed by the previous maxFlow() run.
+*/
+class ResetNWeightsInvoker : public ParallelLoopBody
+{
+public:
+    ResetNWeightsInvoker( const Mat& _leftW, const Mat& _upleftW, const Mat& _upW, const Mat& _uprightW,
+                          const Mat& _edgeIdxs, GCGraph<double>& _graph ) :
+        ParallelLoopBody(), leftW(&_leftW), upleftW(&_upleftW), upW(&_upW), uprightW(&_uprightW),
+        edgeIdxs(&_edgeIdxs), graph(&_graph)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        int cols = edgeIdxs->cols;
+        Point p;
+        for( p.y = range.start; p.y < range.end; p.y++ )
+        {
+            for( p.x = 0; p.x < cols; p.x++ )
+            {
+                int e = edgeIdxs->at<int>(p);
+                double w;
+                if( p.x>0 )
+                {
+                    w = leftW->at<double>(p);
+                    graph->setEdgeWeights( e, w, w );
+                    e += 2;
+                }
+                if( p.x>0 && p.y>0 )
+                {
+                    w = upleftW->at<double>(p);
+                    graph->setEdgeWeights( e, w, w );
+                    e += 2;
+                }
+                if( p.y>0 )
+                {
+                    w = upW->at<double>(p);
+                    graph->setEdgeWeights( e, w, w );
+                    e += 2;
+                }
+                if( p.x<cols-1 && p.y>0 )
+                {
+                    w = uprightW->at<double>(p);
+                    graph->setEdgeWeights( e, w, w );
+                }
             }
         }
     }
+
+private:
+    const Mat* leftW;
+    const Mat* upleftW;
+    const Mat* upW;
+    const Mat* uprightW;
+    const Mat* edgeIdxs;
+    GCGraph<double>* graph;
+};
+
+static void setTWeights( const Mat& fromSource, const Mat& toSink, GCGraph<double>& graph )
+{
+    int vtxIdx = 0;
+    for( int y = 0; y < fromSource.rows; y++ )
+    {
+        const double* src = fromSource.ptr<double>(y);
+        const double* sink = toSink.ptr<double>(y);
+        for( int x = 0; x < fromSource.cols; x++, vtxIdx++ )
+            graph.addTermWeights( vtxIdx, src[x], sink[x] );
+    }
 }
 
 /*
@@ -525,6 +782,83 @@ static void estimateSegmentation( GCGraph<double>& graph, Mat& mask )
     }
 }
 
+/*
+  Coarse-to-fine GrabCut: the segmentation is computed on a downscaled copy of the image,
+  then a single full resolution iteration refines the band around the upscaled boundary.
+  Returns false if the image is too small to benefit from it.
+*/
+static bool grabCutMultiScale( const Mat& img, Mat& mask, Rect rect, Mat& bgdModel, Mat& fgdModel,
+                               int iterCount, int mode )
+{
+    const double maxCoarseArea = 1 << 18;
+    int scale = 1;
+    while( (double)img.rows*img.cols/((double)scale*scale) > maxCoarseArea &&
+           img.cols/(scale*2) >= 16 && img.rows/(scale*2) >= 16 )
+        scale *= 2;
+    if( scale == 1 || iterCount <= 0 )
+        return false;
+
+    if( mode == GC_INIT_WITH_RECT )
+        initMaskWithRect( mask, img.size(), rect );
+    else
+        checkMask( img, mask );
+
+    Size coarseSize( img.cols/scale, img.rows/scale );
+    Mat coarseImg, coarseMask, upMask;
+    resize( img, coarseImg, coarseSize, 0, 0, INTER_AREA );
+    resize( mask, coarseMask, coarseSize, 0, 0, INTER_NEAREST );
+    grabCut( coarseImg, coarseMask, Rect(), bgdModel, fgdModel, iterCount,
+             mode == GC_EVAL ? GC_EVAL : GC_INIT_WITH_MASK );
+    resize( coarseMask, upMask, img.size(), 0, 0, INTER_NEAREST );
+
+    // the boundary band; outside of it the pixels are temporarily made obvious
+    Mat fgd = upMask & 1, dilated, eroded, band, refined( img.size(), CV_8UC1 );
+    Mat kernel = getStructuringElement( MORPH_RECT, Size(2*scale + 1, 2*scale + 1) );
+    dilate( fgd, dilated, kernel );
+    erode( fgd, eroded, kernel );
+    band = dilated != eroded;
+
+    for( int y = 0; y < img.rows; y++ )
+    {
+        const uchar* m = mask.ptr<uchar>(y);
+        const uchar* u = upMask.ptr<uchar>(y);
+        const uchar* b = band.ptr<uchar>(y);
+        uchar* r = refined.ptr<uchar>(y);
+        for( int x = 0; x < img.cols; x++ )
+        {
+            if( m[x] == GC_BGD || m[x] == GC_FGD )
+                r[x] = m[x];
+            else if( b[x] )
+                r[x] = (u[x] & 1) ? GC_PR_FGD : GC_PR_BGD;
+            else
+                r[x] = (u[x] & 1) ? GC_FGD : GC_BGD;
+        }
+    }
+
+    std::vector<Point> bandPoints;
+    findNonZero( band, bandPoints );
+    if( !bandPoints.empty() )
+    {
+        Rect roi = boundingRect( bandPoints );
+        roi.x = std::max(roi.x - 1, 0);
+        roi.y = std::max(roi.y - 1, 0);
+        roi.width = std::min(roi.width + 2, img.cols - roi.x);
+        roi.height = std::min(roi.height + 2, img.rows - roi.y);
+        Mat refinedRoi = refined(roi);
+        grabCut( img(roi), refinedRoi, Rect(), bgdModel, fgdModel, 1, GC_EVAL );
+    }
+
+    for( int y = 0; y < img.rows; y++ )
+    {
+        uchar* m = mask.ptr<uchar>(y);
+        const uchar* r = refined.ptr<uchar>(y);
+        for( int x = 0; x < img.cols; x++ )
+            if( m[x] != GC_BGD && m[x] != GC_FGD )
+                m[x] = (r[x] & 1) ? GC_PR_FGD : GC_PR_BGD;
+    }
+    return true;
+}
+
 void cv::grabCut( InputArray _img, InputOutputArray _mask, Rect rect,
                   InputOutputArray _bgdModel, InputOutputArray _fgdModel,
                   int iterCount, int mode )
@@ -539,6 +873,13 @@ void cv::grabCut( InputArray _img, InputOutputArray _mask, Rect rect,
     if( img.type() != CV_8UC3 )
         CV_Error( CV_StsBadArg, "image mush have CV_8UC3 type" );
 
+    if( mode & GC_MULTISCALE )
+    {
+        mode &= ~GC_MULTISCALE;
+        if( grabCutMultiScale( img, mask, rect, bgdModel, fgdModel, iterCount, mode ) )
+            return;
+    }
+
     GMM bgdGMM( bgdModel ), fgdGMM( fgdModel );
     Mat compIdxs( img.size(), CV_32SC1 );
 
@@ -564,12 +905,23 @@ void cv::grabCut( InputArray _img, InputOutputArray _mask, Rect rect,
     Mat leftW, upleftW, upW, uprightW;
     calcNWeights( img, leftW, upleftW, upW, uprightW, beta, gamma );
 
+    GCGraph<double> graph;
+    Mat edgeIdxs, fromSource( img.size(), CV_64FC1 ), toSink( img.size(), CV_64FC1 );
+    constructGCGraph( img, leftW, upleftW, upW, uprightW, graph, edgeIdxs );
+
     for( int i = 0; i < iterCount; i++ )
     {
-        GCGraph<double> graph;
         assignGMMsComponents( img, mask, bgdGMM, fgdGMM, compIdxs );
         learnGMMs( img, mask, compIdxs, bgdGMM, fgdGMM );
-        constructGCGraph(img, mask, bgdGMM, fgdGMM, lambda, leftW, upleftW, upW, uprightW, graph );
+        parallel_for_( Range(0, img.rows),
+                       CalcTWeightsInvoker(img, mask, bgdGMM, fgdGMM, lambda, fromSource, toSink) );
+        if( i > 0 )
+        {
+            graph.resetTermWeights();
+            parallel_for_( Range(0, img.rows),
+                           ResetNWeightsInvoker(leftW, upleftW, upW, uprightW, edgeIdxs, graph) );
+        }
+        setTWeights( fromSource, toSink, graph );
         estimateSegmentation( graph, mask );
     }
 }
@@ -72,6 +72,46 @@ CvLinePolar;
 
 static CV_IMPLEMENT_QSORT_EX( icvHoughSortDescent32s, int, hough_cmp_gt, const int* )
 
+namespace cv
+{
+
+// Fills the rows [range.start, range.end) of the standard Hough transform accumulator.
+// Each accumulator row corresponds to a single angle, so the stripes never write to the same cells
+// and the result does not depend on the number of threads.
+class HoughLinesAccumInvoker : public ParallelLoopBody
+{
+public:
+    HoughLinesAccumInvoker( const Point* _points, int _count, const float* _tabSin, const float* _tabCos,
+                            int _numrho, int* _accum ) :
+        points(_points), count(_count), tabSin(_tabSin), tabCos(_tabCos), numrho(_numrho), accum(_accum)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int rofs = (numrho - 1) / 2;
+        for( int n = range.start; n < range.end; n++ )
+        {
+            int* arow = accum + (n+1) * (numrho+2) + 1 + rofs;
+            float c = tabCos[n], s = tabSin[n];
+            for( int k = 0; k < count; k++ )
+            {
+                int r = cvRound( points[k].x * c + points[k].y * s );
+                arow[r]++;
+            }
+        }
+    }
+
+private:
+    const Point* points;
+    int count;
+    const float *tabSin, *tabCos;
+    int numrho;
+    int* accum;
+};
+
+}
+
 /*
 Here image is an input raster;
 step is it's step; size characterizes it's ROI;
@@ -123,18 +163,20 @@ icvHoughLinesStandard( const CvMat* img, float rho, float theta,
     }
 
     // stage 1. fill accumulator
+    std::vector<cv::Point> points;
     for( i = 0; i < height; i++ )
         for( j = 0; j < width; j++ )
         {
             if( image[i * step + j] != 0 )
-                for(int n = 0; n < numangle; n++ )
-                {
-                    int r = cvRound( j * tabCos[n] + i * tabSin[n] );
-                    r += (numrho - 1) / 2;
-                    accum[(n+1) * (numrho+2) + r+1]++;
-                }
+                points.push_back(cv::Point(j, i));
         }
 
+    if( !points.empty() )
+    {
+        cv::HoughLinesAccumInvoker invoker( &points[0], (int)points.size(), tabSin, tabCos, numrho, accum );
+        cv::parallel_for_( cv::Range(0, numangle), invoker, (double)points.size()*numangle/(1 << 16) );
+    }
+
     // stage 2. find local maximums
     for(int r = 0; r < numrho; r++ )
         for(int n = 0; n < numangle; n++ )
@@ -453,6 +495,34 @@ icvHoughLinesSDiv( const CvMat* img,
 *                              Probabilistic Hough Transform                             *
 \****************************************************************************************/
 
+// computes the accumulator columns r(n) = round(x*cos(n) + y*sin(n)) + (numrho - 1)/2 of the point
+// for all the angles; ttab contains the interleaved (cos, sin) pairs scaled by 1/rho
+static void
+icvHoughLinesGetRhos( int x, int y, const float* ttab, int numangle, int numrho, int* rbuf )
+{
+    int n = 0, rofs = (numrho - 1) / 2;
+    float fx = (float)x, fy = (float)y;
+
+#if CV_SSE2
+    if( cv::checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128 vx = _mm_set1_ps(fx), vy = _mm_set1_ps(fy);
+        __m128i vofs = _mm_set1_epi32(rofs);
+        for( ; n <= numangle - 4; n += 4 )
+        {
+            __m128 t0 = _mm_loadu_ps(ttab + n*2), t1 = _mm_loadu_ps(ttab + n*2 + 4);
+            __m128 c = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 s = _mm_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 1, 3, 1));
+            __m128i r = _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(vx, c), _mm_mul_ps(vy, s)));
+            _mm_storeu_si128((__m128i*)(rbuf + n), _mm_add_epi32(r, vofs));
+        }
+    }
+#endif
+
+    for( ; n < numangle; n++ )
+        rbuf[n] = cvRound( fx * ttab[n*2] + fy * ttab[n*2+1] ) + rofs;
+}
+
 static void
 icvHoughLinesProbabilistic( CvMat* image,
                             float rho, float theta, int threshold,
@@ -461,6 +531,7 @@ icvHoughLinesProbabilistic( CvMat* image,
 {
     cv::Mat accum, mask;
     cv::vector<float> trigtab;
+    cv::vector<int> rbuf;
     cv::MemStorage storage(cvCreateMemStorage(0));
 
     CvSeq* seq;
@@ -468,7 +539,7 @@ icvHoughLinesProbabilistic( CvMat* image,
     int width, height;
     int numangle, numrho;
     float ang;
-    int r, n, count;
+    int n, count;
     CvPoint pt;
     float irho = 1 / rho;
     CvRNG rng = cvRNG(-1);
@@ -486,6 +557,7 @@ icvHoughLinesProbabilistic( CvMat* image,
     accum.create( numangle, numrho, CV_32SC1 );
     mask.create( height, width, CV_8UC1 );
     trigtab.resize(numangle*2);
+    rbuf.resize(numangle);
     accum = cv::Scalar(0);
 
     for( ang = 0, n = 0; n < numangle; ang += theta, n++ )
@@ -543,11 +615,10 @@ icvHoughLinesProbabilistic( CvMat* image,
             continue;
 
         // update accumulator, find the most probable line
+        icvHoughLinesGetRhos( j, i, ttab, numangle, numrho, &rbuf[0] );
         for( n = 0; n < numangle; n++, adata += numrho )
         {
-            r = cvRound( j * ttab[n*2] + i * ttab[n*2+1] );
-            r += (numrho - 1) / 2;
-            int val = ++adata[r];
+            int val = ++adata[rbuf[n]];
             if( max_val < val )
             {
                 max_val = val;
@@ -664,12 +735,9 @@ icvHoughLinesProbabilistic( CvMat* image,
                     if( good_line )
                     {
                         adata = (int*)accum.data;
+                        icvHoughLinesGetRhos( j1, i1, ttab, numangle, numrho, &rbuf[0] );
                         for( n = 0; n < numangle; n++, adata += numrho )
-                        {
-                            r = cvRound( j1 * ttab[n*2] + i1 * ttab[n*2+1] );
-                            r += (numrho - 1) / 2;
-                            adata[r]--;
-                        }
+                            adata[rbuf[n]]--;
                     }
                     *mdata = 0;
                 }
@@ -791,27 +859,214 @@ cvHoughLines2( CvArr* src_image, void* lineStorage, int method,
 *                                     Circle Detection                                   *
 \****************************************************************************************/
 
+namespace cv
+{
+
+// Accumulates the circle center evidence of the edge pixels. The image is split into nstripes
+// horizontal bands, each band votes into its own accumulator (the first one is the output
+// accumulator) and collects its edge points; the caller merges them in the band order.
+class HoughCirclesAccumInvoker : public ParallelLoopBody
+{
+public:
+    HoughCirclesAccumInvoker( const Mat& _edges, const Mat& _dx, const Mat& _dy, float _idp,
+                              int _minRadius, int _maxRadius, int _nstripes,
+                              std::vector<Mat>& _accums, std::vector<std::vector<Point> >& _nz ) :
+        edges(&_edges), dx(&_dx), dy(&_dy), idp(_idp), minRadius(_minRadius), maxRadius(_maxRadius),
+        nstripes(_nstripes), accums(&_accums), nz(&_nz)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        const int SHIFT = 10, ONE = 1 << SHIFT;
+        int rows = edges->rows, cols = edges->cols;
+
+        for( int stripe = range.start; stripe < range.end; stripe++ )
+        {
+            Mat& accum = (*accums)[stripe];
+            std::vector<Point>& points = (*nz)[stripe];
+            if( accum.empty() )
+                accum = Mat::zeros((*accums)[0].size(), CV_32SC1);
+
+            int arows = accum.rows - 2, acols = accum.cols - 2;
+            int astep = (int)(accum.step/sizeof(int));
+            int* adata = accum.ptr<int>();
+
+            for( int y = rows*stripe/nstripes; y < rows*(stripe + 1)/nstripes; y++ )
+            {
+                const uchar* edges_row = edges->ptr<uchar>(y);
+                const short* dx_row = dx->ptr<short>(y);
+                const short* dy_row = dy->ptr<short>(y);
+
+                for( int x = 0; x < cols; x++ )
+                {
+                    float vx = dx_row[x], vy = dy_row[x];
+                    int sx, sy, x0, y0, x1, y1, r;
+
+                    if( !edges_row[x] || (vx == 0 && vy == 0) )
+                        continue;
+
+                    float mag = std::sqrt(vx*vx+vy*vy);
+                    assert( mag >= 1 );
+                    sx = cvRound((vx*idp)*ONE/mag);
+                    sy = cvRound((vy*idp)*ONE/mag);
+
+                    x0 = cvRound((x*idp)*ONE);
+                    y0 = cvRound((y*idp)*ONE);
+                    // Step from min_radius to max_radius in both directions of the gradient
+                    for( int k1 = 0; k1 < 2; k1++ )
+                    {
+                        x1 = x0 + minRadius * sx;
+                        y1 = y0 + minRadius * sy;
+
+                        for( r = minRadius; r <= maxRadius; x1 += sx, y1 += sy, r++ )
+                        {
+                            int x2 = x1 >> SHIFT, y2 = y1 >> SHIFT;
+                            if( (unsigned)x2 >= (unsigned)acols ||
+                                (unsigned)y2 >= (unsigned)arows )
+                                break;
+                            adata[y2*astep + x2]++;
+                        }
+
+                        sx = -sx; sy = -sy;
+                    }
+
+                    points.push_back(Point(x, y));
+                }
+            }
+        }
+    }
+
+private:
+    const Mat *edges, *dx, *dy;
+    float idp;
+    int minRadius, maxRadius, nstripes;
+    std::vector<Mat>* accums;
+    std::vector<std::vector<Point> >* nz;
+};
+
+struct HoughCircleCandidate
+{
+    float cx, cy;
+    float r_best;
+    int max_count;
+};
+
+// Estimates the radius of the circles with the given centers and its support (the number of the edge
+// points at approximately the same distance from the center)
+class HoughCirclesRadiusInvoker : public ParallelLoopBody
+{
+public:
+    HoughCirclesRadiusInvoker( const std::vector<Point>& _nz, HoughCircleCandidate* _candidates,
+                               float _minRadius2, float _maxRadius2, int _maxRadius, float _dr ) :
+        nz(&_nz), candidates(_candidates), minRadius2(_minRadius2), maxRadius2(_maxRadius2),
+        maxRadius(_maxRadius), dr(_dr)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int nz_count = (int)nz->size();
+        AutoBuffer<float> _ddata(nz_count);
+        AutoBuffer<int> _sort_buf(nz_count);
+        float* ddata = _ddata;
+        int* sort_buf = _sort_buf;
+        const Point* pts = &(*nz)[0];
+
+        for( int i = range.start; i < range.end; i++ )
+        {
+            HoughCircleCandidate& c = candidates[i];
+            float cx = c.cx, cy = c.cy, start_dist, dist_sum;
+            float r_best = 0;
+            int max_count = 0, j, k;
+
+            for( j = k = 0; j < nz_count; j++ )
+            {
+                float _dx = cx - pts[j].x, _dy = cy - pts[j].y;
+                float _r2 = _dx*_dx + _dy*_dy;
+                if( minRadius2 <= _r2 && _r2 <= maxRadius2 )
+                {
+                    ddata[k] = _r2;
+                    sort_buf[k] = k;
+                    k++;
+                }
+            }
+
+            int nz_count1 = k, start_idx = nz_count1 - 1;
+            c.r_best = 0;
+            c.max_count = 0;
+            if( nz_count1 == 0 )
+                continue;
+            Mat dist(1, nz_count1, CV_32FC1, ddata);
+            pow( dist, 0.5, dist );
+            icvHoughSortDescent32s( sort_buf, nz_count1, (int*)ddata );
+
+            dist_sum = start_dist = ddata[sort_buf[nz_count1-1]];
+            for( j = nz_count1 - 2; j >= 0; j-- )
+            {
+                float d = ddata[sort_buf[j]];
+
+                if( d > maxRadius )
+                    break;
+
+                if( d - start_dist > dr )
+                {
+                    float r_cur = ddata[sort_buf[(j + start_idx)/2]];
+                    if( (start_idx - j)*r_best >= max_count*r_cur ||
+                        (r_best < FLT_EPSILON && start_idx - j >= max_count) )
+                    {
+                        r_best = r_cur;
+                        max_count = start_idx - j;
+                    }
+                    start_dist = d;
+                    start_idx = j;
+                    dist_sum = 0;
+                }
+                dist_sum += d;
+            }
+            c.r_best = r_best;
+            c.max_count = max_count;
+        }
+    }
+
+private:
+    const std::vector<Point>* nz;
+    HoughCircleCandidate* candidates;
+    float minRadius2, maxRadius2;
+    int maxRadius;
+    float dr;
+};
+
+static bool isNearHoughCircle( const CvSeq* circles, float cx, float cy, float min_dist2 )
+{
+    for( int j = 0; j < circles->total; j++ )
+    {
+        const float* c = (const float*)cvGetSeqElem( circles, j );
+        if( (c[0] - cx)*(c[0] - cx) + (c[1] - cy)*(c[1] - cy) < min_dist2 )
+            return true;
+    }
+    return false;
+}
+
+}
+
 static void
 icvHoughCirclesGradient( CvMat* img, float dp, float min_dist,
                          int min_radius, int max_radius,
                          int canny_threshold, int acc_threshold,
                          CvSeq* circles, int circles_max )
 {
-    const int SHIFT = 10, ONE = 1 << SHIFT;
     cv::Ptr<CvMat> dx, dy;
-    cv::Ptr<CvMat> edges, accum, dist_buf;
-    std::vector<int> sort_buf;
-    cv::Ptr<CvMemStorage> storage;
+    cv::Ptr<CvMat> edges, accum;
+    std::vector<cv::Point> nz;
+    std::vector<int> centers;
 
-    int x, y, i, j, k, center_count, nz_count;
+    int x, y, i, center_count, nz_count;
     float min_radius2 = (float)min_radius*min_radius;
     float max_radius2 = (float)max_radius*max_radius;
-    int rows, cols, arows, acols;
-    int astep, *adata;
-    float* ddata;
-    CvSeq *nz, *centers;
+    int arows, acols;
+    int *adata;
     float idp, dr;
-    CvSeqReader reader;
 
     edges = cvCreateMat( img->rows, img->cols, CV_8UC1 );
     cvCanny( img, edges, MAX(canny_threshold/2,1), canny_threshold, 3 );
@@ -827,68 +1082,38 @@ icvHoughCirclesGradient( CvMat* img, float dp, float min_dist,
     accum = cvCreateMat( cvCeil(img->rows*idp)+2, cvCeil(img->cols*idp)+2, CV_32SC1 );
     cvZero(accum);
 
-    storage = cvCreateMemStorage();
-    nz = cvCreateSeq( CV_32SC2, sizeof(CvSeq), sizeof(CvPoint), storage );
-    centers = cvCreateSeq( CV_32SC1, sizeof(CvSeq), sizeof(int), storage );
-
-    rows = img->rows;
-    cols = img->cols;
     arows = accum->rows - 2;
     acols = accum->cols - 2;
     adata = accum->data.i;
-    astep = accum->step/sizeof(adata[0]);
-    // Accumulate circle evidence for each edge pixel
-    for( y = 0; y < rows; y++ )
-    {
-        const uchar* edges_row = edges->data.ptr + y*edges->step;
-        const short* dx_row = (const short*)(dx->data.ptr + y*dx->step);
-        const short* dy_row = (const short*)(dy->data.ptr + y*dy->step);
 
-        for( x = 0; x < cols; x++ )
+    // Accumulate circle evidence for each edge pixel. Every band of the image uses its own
+    // accumulator; the number of the bands is limited by the memory needed for the accumulators
+    {
+        const size_t MAX_ACCUM_BUF_SIZE = 1 << 26;
+        size_t accumSize = (size_t)accum->rows*accum->step;
+        int nstripes = std::min(cv::getNumThreads(), img->rows);
+        nstripes = (int)std::max(std::min((size_t)nstripes, MAX_ACCUM_BUF_SIZE/accumSize), (size_t)1);
+
+        cv::Mat _edges(edges), _dx(dx), _dy(dy);
+        std::vector<cv::Mat> accums(nstripes);
+        std::vector<std::vector<cv::Point> > nzs(nstripes);
+        accums[0] = cv::Mat(accum);
+        cv::HoughCirclesAccumInvoker invoker( _edges, _dx, _dy, idp, min_radius, max_radius,
+                                              nstripes, accums, nzs );
+        cv::parallel_for_( cv::Range(0, nstripes), invoker, nstripes );
+
+        for( i = 1; i < nstripes; i++ )
         {
-            float vx, vy;
-            int sx, sy, x0, y0, x1, y1, r;
-            CvPoint pt;
-
-            vx = dx_row[x];
-            vy = dy_row[x];
-
-            if( !edges_row[x] || (vx == 0 && vy == 0) )
-                continue;
-
-            float mag = sqrt(vx*vx+vy*vy);
-            assert( mag >= 1 );
-            sx = cvRound((vx*idp)*ONE/mag);
-            sy = cvRound((vy*idp)*ONE/mag);
-
-            x0 = cvRound((x*idp)*ONE);
-            y0 = cvRound((y*idp)*ONE);
-            // Step from min_radius to max_radius in both directions of the gradient
-            for(int k1 = 0; k1 < 2; k1++ )
-            {
-                x1 = x0 + min_radius * sx;
-                y1 = y0 + min_radius * sy;
-
-                for( r = min_radius; r <= max_radius; x1 += sx, y1 += sy, r++ )
-                {
-                    int x2 = x1 >> SHIFT, y2 = y1 >> SHIFT;
-                    if( (unsigned)x2 >= (unsigned)acols ||
-                        (unsigned)y2 >= (unsigned)arows )
-                        break;
-                    adata[y2*astep + x2]++;
-                }
-
-                sx = -sx; sy = -sy;
-            }
-
-            pt.x = x; pt.y = y;
-            cvSeqPush( nz, &pt );
+            cv::add( accums[0], accums[i], accums[0] );
+            nzs[0].insert( nzs[0].end(), nzs[i].begin(), nzs[i].end() );
         }
+        nz.swap( nzs[0] );
     }
 
-    nz_count = nz->total;
+    nz_count = (int)nz.size();
     if( !nz_count )
         return;
+
     //Find possible circle centers
     for( y = 1; y < arows - 1; y++ )
     {
@@ -898,106 +1123,69 @@ icvHoughCirclesGradient( CvMat* img, float dp, float min_dist,
             if( adata[base] > acc_threshold &&
                 adata[base] > adata[base-1] && adata[base] > adata[base+1] &&
                 adata[base] > adata[base-acols-2] && adata[base] > adata[base+acols+2] )
-                cvSeqPush(centers, &base);
+                centers.push_back(base);
         }
     }
 
-    center_count = centers->total;
+    center_count = (int)centers.size();
     if( !center_count )
         return;
 
-    sort_buf.resize( MAX(center_count,nz_count) );
-    cvCvtSeqToArray( centers, &sort_buf[0] );
-
-    icvHoughSortDescent32s( &sort_buf[0], center_count, adata );
-    cvClearSeq( centers );
-    cvSeqPushMulti( centers, &sort_buf[0], center_count );
-
-    dist_buf = cvCreateMat( 1, nz_count, CV_32FC1 );
-    ddata = dist_buf->data.fl;
+    icvHoughSortDescent32s( &centers[0], center_count, adata );
 
     dr = dp;
     min_dist = MAX( min_dist, dp );
     min_dist *= min_dist;
-    // For each found possible center
-    // Estimate radius and check support
-    for( i = 0; i < centers->total; i++ )
+
+    // For each found possible center estimate radius and check support.
+    // The centers are processed in batches: the radii are estimated in parallel for the centers
+    // that are far from the already found circles, then the batch is filtered in the original order
+    const int batchSize = std::max(cv::getNumThreads(), 1)*4;
+    std::vector<cv::HoughCircleCandidate> batch;
+    batch.reserve(batchSize);
+
+    for( i = 0; i < center_count; )
     {
-        int ofs = *(int*)cvGetSeqElem( centers, i );
-        y = ofs/(acols+2);
-        x = ofs - (y)*(acols+2);
-        //Calculate circle's center in pixels
-        float cx = (float)((x + 0.5f)*dp), cy = (float)(( y + 0.5f )*dp);
-        float start_dist, dist_sum;
-        float r_best = 0;
-        int max_count = 0;
-        // Check distance with previously detected circles
-        for( j = 0; j < circles->total; j++ )
+        batch.clear();
+        for( ; i < center_count && (int)batch.size() < batchSize; i++ )
         {
-            float* c = (float*)cvGetSeqElem( circles, j );
-            if( (c[0] - cx)*(c[0] - cx) + (c[1] - cy)*(c[1] - cy) < min_dist )
-                break;
+            int ofs = centers[i];
+            y = ofs/(acols+2);
+            x = ofs - (y)*(acols+2);
+            //Calculate circle's center in pixels
+            cv::HoughCircleCandidate c;
+            c.cx = (float)((x + 0.5f)*dp);
+            c.cy = (float)((y + 0.5f)*dp);
+            c.r_best = 0;
+            c.max_count = 0;
+            // Check distance with previously detected circles
+            if( !cv::isNearHoughCircle( circles, c.cx, c.cy, min_dist ) )
+                batch.push_back(c);
         }
 
-        if( j < circles->total )
+        if( batch.empty() )
             continue;
-        // Estimate best radius
-        cvStartReadSeq( nz, &reader );
-        for( j = k = 0; j < nz_count; j++ )
-        {
-            CvPoint pt;
-            float _dx, _dy, _r2;
-            CV_READ_SEQ_ELEM( pt, reader );
-            _dx = cx - pt.x; _dy = cy - pt.y;
-            _r2 = _dx*_dx + _dy*_dy;
-            if(min_radius2 <= _r2 && _r2 <= max_radius2 )
-            {
-                ddata[k] = _r2;
-                sort_buf[k] = k;
-                k++;
-            }
-        }
 
-        int nz_count1 = k, start_idx = nz_count1 - 1;
-        if( nz_count1 == 0 )
-            continue;
-        dist_buf->cols = nz_count1;
-        cvPow( dist_buf, dist_buf, 0.5 );
-        icvHoughSortDescent32s( &sort_buf[0], nz_count1, (int*)ddata );
+        cv::HoughCirclesRadiusInvoker rinvoker( nz, &batch[0], min_radius2, max_radius2, max_radius, dr );
+        cv::parallel_for_( cv::Range(0, (int)batch.size()), rinvoker );
 
-        dist_sum = start_dist = ddata[sort_buf[nz_count1-1]];
-        for( j = nz_count1 - 2; j >= 0; j-- )
+        for( size_t b = 0; b < batch.size(); b++ )
         {
-            float d = ddata[sort_buf[j]];
-
-            if( d > max_radius )
-                break;
-
-            if( d - start_dist > dr )
+            const cv::HoughCircleCandidate& c = batch[b];
+            // the circles found earlier in this batch
+            if( b > 0 && cv::isNearHoughCircle( circles, c.cx, c.cy, min_dist ) )
+                continue;
+            // Check if the circle has enough support
+            if( c.max_count > acc_threshold )
             {
-                float r_cur = ddata[sort_buf[(j + start_idx)/2]];
-                if( (start_idx - j)*r_best >= max_count*r_cur ||
-                    (r_best < FLT_EPSILON && start_idx - j >= max_count) )
-                {
-                    r_best = r_cur;
-                    max_count = start_idx - j;
-                }
-                start_dist = d;
-                start_idx = j;
-                dist_sum = 0;
+                float cc[3];
+                cc[0] = c.cx;
+                cc[1] = c.cy;
+                cc[2] = (float)c.r_best;
+                cvSeqPush( circles, cc );
+                if( circles->total > circles_max )
+                    return;
             }
-            dist_sum += d;
-        }
-        // Check if the circle has enough support
-        if( max_count > acc_threshold )
-        {
-            float c[3];
-            c[0] = cx;
-            c[1] = cy;
-            c[2] = (float)r_best;
-            cvSeqPush( circles, c );
-            if( circles->total > circles_max )
-                return;
         }
     }
 }
@@ -1119,9 +1307,32 @@ void cv::HoughLinesP( InputArray _image, OutputArray _lines,
                       double rho, double theta, int threshold,
                       double minLineLength, double maxGap )
 {
-    Ptr<CvMemStorage> storage = cvCreateMemStorage(STORAGE_SIZE);
+    HoughLinesP( _image, _lines, rho, theta, threshold, minLineLength, maxGap, 0 );
+}
+
+void cv::HoughLinesP( InputArray _image, OutputArray _lines,
+                      double rho, double theta, int threshold,
+                      double minLineLength, double maxGap, int maxLines )
+{
     Mat image = _image.getMat();
     CvMat c_image = image;
+
+    if( maxLines > 0 )
+    {
+        // the processing stops as soon as maxLines segments are found. cvHoughLines2 shrinks
+        // the rows of a column vector (even a 1x1 one) to the number of the found segments
+        Mat lines(maxLines, 1, CV_32SC4);
+        CvMat c_lines = lines;
+        cvHoughLines2( &c_image, &c_lines, CV_HOUGH_PROBABILISTIC,
+                       rho, theta, threshold, minLineLength, maxGap );
+        if( c_lines.rows > 0 )
+            lines.rowRange(0, c_lines.rows).reshape(4, 1).copyTo(_lines);
+        else
+            _lines.release();
+        return;
+    }
+
+    Ptr<CvMemStorage> storage = cvCreateMemStorage(STORAGE_SIZE);
     CvSeq* seq = cvHoughLines2( &c_image, storage, CV_HOUGH_PROBABILISTIC,
                     rho, theta, threshold, minLineLength, maxGap );
     seqToMat(seq, _lines);
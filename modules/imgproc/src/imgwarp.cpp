@@ -416,7 +416,7 @@ private:
 };
 
 static void
-resizeNN( const Mat& src, Mat& dst, double fx, double fy )
+resizeNN( const Mat& src, Mat& dst, double fx, double fy, const Range& range )
 {
     Size ssize = src.size(), dsize = dst.size();
     AutoBuffer<int> _x_ofs(dsize.width);
@@ -432,9 +432,8 @@ resizeNN( const Mat& src, Mat& dst, double fx, double fy )
         x_ofs[x] = std::min(sx, ssize.width-1)*pix_size;
     }
 
-    Range range(0, dsize.height);
     resizeNNInvoker invoker(src, dst, x_ofs, pix_size4, ify);
-    parallel_for_(range, invoker, dst.total()/(double)(1<<16));
+    parallel_for_(range, invoker, range.size()*(double)dst.cols/(1<<16));
 }
 
 
@@ -1291,7 +1290,7 @@ template<class HResize, class VResize>
 static void resizeGeneric_( const Mat& src, Mat& dst,
                             const int* xofs, const void* _alpha,
                             const int* yofs, const void* _beta,
-                            int xmin, int xmax, int ksize )
+                            int xmin, int xmax, int ksize, const Range& range )
 {
     typedef typename HResize::alpha_type AT;
 
@@ -1304,10 +1303,9 @@ static void resizeGeneric_( const Mat& src, Mat& dst,
     xmax *= cn;
     // image resize is a separable operation. In case of not too strong
 
-    Range range(0, dsize.height);
     resizeGeneric_Invoker<HResize, VResize> invoker(src, dst, xofs, yofs, (const AT*)_alpha, beta,
         ssize, dsize, ksize, xmin, xmax);
-    parallel_for_(range, invoker, dst.total()/(double)(1<<16));
+    parallel_for_(range, invoker, range.size()*(double)dst.cols/(1<<16));
 }
 
 template <typename T, typename WT>
@@ -1461,12 +1459,11 @@ private:
 
 template<typename T, typename WT, typename VecOp>
 static void resizeAreaFast_( const Mat& src, Mat& dst, const int* ofs, const int* xofs,
-                             int scale_x, int scale_y )
+                             int scale_x, int scale_y, const Range& range )
 {
-    Range range(0, dst.rows);
     resizeAreaFast_Invoker<T, WT, VecOp> invoker(src, dst, scale_x,
         scale_y, ofs, xofs);
-    parallel_for_(range, invoker, dst.total()/(double)(1<<16));
+    parallel_for_(range, invoker, range.size()*(double)dst.cols/(1<<16));
 }
 
 struct DecimateAlpha
@@ -1614,27 +1611,27 @@ template <typename T, typename WT>
 static void resizeArea_( const Mat& src, Mat& dst,
                          const DecimateAlpha* xtab, int xtab_size,
                          const DecimateAlpha* ytab, int ytab_size,
-                         const int* tabofs )
+                         const int* tabofs, const Range& range )
 {
-    parallel_for_(Range(0, dst.rows),
+    parallel_for_(range,
                  ResizeArea_Invoker<T, WT>(src, dst, xtab, xtab_size, ytab, ytab_size, tabofs),
-                 dst.total()/((double)(1 << 16)));
+                 range.size()*(double)dst.cols/(1 << 16));
 }
 
 
 typedef void (*ResizeFunc)( const Mat& src, Mat& dst,
                             const int* xofs, const void* alpha,
                             const int* yofs, const void* beta,
-                            int xmin, int xmax, int ksize );
+                            int xmin, int xmax, int ksize, const Range& range );
 
 typedef void (*ResizeAreaFastFunc)( const Mat& src, Mat& dst,
                                     const int* ofs, const int *xofs,
-                                    int scale_x, int scale_y );
+                                    int scale_x, int scale_y, const Range& range );
 
 typedef void (*ResizeAreaFunc)( const Mat& src, Mat& dst,
                                 const DecimateAlpha* xtab, int xtab_size,
                                 const DecimateAlpha* ytab, int ytab_size,
-                                const int* yofs);
+                                const int* yofs, const Range& range );
 
 
 static int computeResizeAreaTab( int ssize, int dsize, int cn, double scale, DecimateAlpha* tab )
@@ -1716,184 +1713,167 @@ private:
 };
 #endif
 
-}
-
-
-//////////////////////////////////////////////////////////////////////////////////////////
 
-void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
-                 double inv_scale_x, double inv_scale_y, int interpolation )
+static ResizeFunc linear_tab[] =
 {
-    static ResizeFunc linear_tab[] =
-    {
-        resizeGeneric_<
-            HResizeLinear<uchar, int, short,
-                INTER_RESIZE_COEF_SCALE,
-                HResizeLinearVec_8u32s>,
-            VResizeLinear<uchar, int, short,
-                FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS*2>,
-                VResizeLinearVec_32s8u> >,
-        0,
-        resizeGeneric_<
-            HResizeLinear<ushort, float, float, 1,
-                HResizeLinearVec_16u32f>,
-            VResizeLinear<ushort, float, float, Cast<float, ushort>,
-                VResizeLinearVec_32f16u> >,
-        resizeGeneric_<
-            HResizeLinear<short, float, float, 1,
-                HResizeLinearVec_16s32f>,
-            VResizeLinear<short, float, float, Cast<float, short>,
-                VResizeLinearVec_32f16s> >,
-        0,
-        resizeGeneric_<
-            HResizeLinear<float, float, float, 1,
-                HResizeLinearVec_32f>,
-            VResizeLinear<float, float, float, Cast<float, float>,
-                VResizeLinearVec_32f> >,
-        resizeGeneric_<
-            HResizeLinear<double, double, float, 1,
-                HResizeNoVec>,
-            VResizeLinear<double, double, float, Cast<double, double>,
-                VResizeNoVec> >,
-        0
-    };
-
-    static ResizeFunc cubic_tab[] =
-    {
-        resizeGeneric_<
-            HResizeCubic<uchar, int, short>,
-            VResizeCubic<uchar, int, short,
-                FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS*2>,
-                VResizeCubicVec_32s8u> >,
-        0,
-        resizeGeneric_<
-            HResizeCubic<ushort, float, float>,
-            VResizeCubic<ushort, float, float, Cast<float, ushort>,
-            VResizeCubicVec_32f16u> >,
-        resizeGeneric_<
-            HResizeCubic<short, float, float>,
-            VResizeCubic<short, float, float, Cast<float, short>,
-            VResizeCubicVec_32f16s> >,
-        0,
-        resizeGeneric_<
-            HResizeCubic<float, float, float>,
-            VResizeCubic<float, float, float, Cast<float, float>,
-            VResizeCubicVec_32f> >,
-        resizeGeneric_<
-            HResizeCubic<double, double, float>,
-            VResizeCubic<double, double, float, Cast<double, double>,
+    resizeGeneric_<
+        HResizeLinear<uchar, int, short,
+            INTER_RESIZE_COEF_SCALE,
+            HResizeLinearVec_8u32s>,
+        VResizeLinear<uchar, int, short,
+            FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS*2>,
+            VResizeLinearVec_32s8u> >,
+    0,
+    resizeGeneric_<
+        HResizeLinear<ushort, float, float, 1,
+            HResizeLinearVec_16u32f>,
+        VResizeLinear<ushort, float, float, Cast<float, ushort>,
+            VResizeLinearVec_32f16u> >,
+    resizeGeneric_<
+        HResizeLinear<short, float, float, 1,
+            HResizeLinearVec_16s32f>,
+        VResizeLinear<short, float, float, Cast<float, short>,
+            VResizeLinearVec_32f16s> >,
+    0,
+    resizeGeneric_<
+        HResizeLinear<float, float, float, 1,
+            HResizeLinearVec_32f>,
+        VResizeLinear<float, float, float, Cast<float, float>,
+            VResizeLinearVec_32f> >,
+    resizeGeneric_<
+        HResizeLinear<double, double, float, 1,
+            HResizeNoVec>,
+        VResizeLinear<double, double, float, Cast<double, double>,
             VResizeNoVec> >,
-        0
-    };
+    0
+};
 
-    static ResizeFunc lanczos4_tab[] =
-    {
-        resizeGeneric_<HResizeLanczos4<uchar, int, short>,
-            VResizeLanczos4<uchar, int, short,
+static ResizeFunc cubic_tab[] =
+{
+    resizeGeneric_<
+        HResizeCubic<uchar, int, short>,
+        VResizeCubic<uchar, int, short,
             FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS*2>,
-            VResizeNoVec> >,
-        0,
-        resizeGeneric_<HResizeLanczos4<ushort, float, float>,
-            VResizeLanczos4<ushort, float, float, Cast<float, ushort>,
-            VResizeNoVec> >,
-        resizeGeneric_<HResizeLanczos4<short, float, float>,
-            VResizeLanczos4<short, float, float, Cast<float, short>,
-            VResizeNoVec> >,
-        0,
-        resizeGeneric_<HResizeLanczos4<float, float, float>,
-            VResizeLanczos4<float, float, float, Cast<float, float>,
-            VResizeNoVec> >,
-        resizeGeneric_<HResizeLanczos4<double, double, float>,
-            VResizeLanczos4<double, double, float, Cast<double, double>,
-            VResizeNoVec> >,
-        0
-    };
+            VResizeCubicVec_32s8u> >,
+    0,
+    resizeGeneric_<
+        HResizeCubic<ushort, float, float>,
+        VResizeCubic<ushort, float, float, Cast<float, ushort>,
+        VResizeCubicVec_32f16u> >,
+    resizeGeneric_<
+        HResizeCubic<short, float, float>,
+        VResizeCubic<short, float, float, Cast<float, short>,
+        VResizeCubicVec_32f16s> >,
+    0,
+    resizeGeneric_<
+        HResizeCubic<float, float, float>,
+        VResizeCubic<float, float, float, Cast<float, float>,
+        VResizeCubicVec_32f> >,
+    resizeGeneric_<
+        HResizeCubic<double, double, float>,
+        VResizeCubic<double, double, float, Cast<double, double>,
+        VResizeNoVec> >,
+    0
+};
 
-    static ResizeAreaFastFunc areafast_tab[] =
-    {
-        resizeAreaFast_<uchar, int, ResizeAreaFastVec<uchar> >,
-        0,
-        resizeAreaFast_<ushort, float, ResizeAreaFastVec<ushort> >,
-        resizeAreaFast_<short, float, ResizeAreaFastVec<short> >,
-        0,
-        resizeAreaFast_<float, float, ResizeAreaFastNoVec<float, float> >,
-        resizeAreaFast_<double, double, ResizeAreaFastNoVec<double, double> >,
-        0
-    };
+static ResizeFunc lanczos4_tab[] =
+{
+    resizeGeneric_<HResizeLanczos4<uchar, int, short>,
+        VResizeLanczos4<uchar, int, short,
+        FixedPtCast<int, uchar, INTER_RESIZE_COEF_BITS*2>,
+        VResizeNoVec> >,
+    0,
+    resizeGeneric_<HResizeLanczos4<ushort, float, float>,
+        VResizeLanczos4<ushort, float, float, Cast<float, ushort>,
+        VResizeNoVec> >,
+    resizeGeneric_<HResizeLanczos4<short, float, float>,
+        VResizeLanczos4<short, float, float, Cast<float, short>,
+        VResizeNoVec> >,
+    0,
+    resizeGeneric_<HResizeLanczos4<float, float, float>,
+        VResizeLanczos4<float, float, float, Cast<float, float>,
+        VResizeNoVec> >,
+    resizeGeneric_<HResizeLanczos4<double, double, float>,
+        VResizeLanczos4<double, double, float, Cast<double, double>,
+        VResizeNoVec> >,
+    0
+};
 
-    static ResizeAreaFunc area_tab[] =
-    {
-        resizeArea_<uchar, float>, 0, resizeArea_<ushort, float>,
-        resizeArea_<short, float>, 0, resizeArea_<float, float>,
-        resizeArea_<double, double>, 0
-    };
+static ResizeAreaFastFunc areafast_tab[] =
+{
+    resizeAreaFast_<uchar, int, ResizeAreaFastVec<uchar> >,
+    0,
+    resizeAreaFast_<ushort, float, ResizeAreaFastVec<ushort> >,
+    resizeAreaFast_<short, float, ResizeAreaFastVec<short> >,
+    0,
+    resizeAreaFast_<float, float, ResizeAreaFastNoVec<float, float> >,
+    resizeAreaFast_<double, double, ResizeAreaFastNoVec<double, double> >,
+    0
+};
 
-    Mat src = _src.getMat();
-    Size ssize = src.size();
+static ResizeAreaFunc area_tab[] =
+{
+    resizeArea_<uchar, float>, 0, resizeArea_<ushort, float>,
+    resizeArea_<short, float>, 0, resizeArea_<float, float>,
+    resizeArea_<double, double>, 0
+};
 
-    CV_Assert( ssize.area() > 0 );
-    CV_Assert( dsize.area() || (inv_scale_x > 0 && inv_scale_y > 0) );
-    if( !dsize.area() )
-    {
-        dsize = Size(saturate_cast<int>(src.cols*inv_scale_x),
-            saturate_cast<int>(src.rows*inv_scale_y));
-        CV_Assert( dsize.area() );
-    }
-    else
-    {
-        inv_scale_x = (double)dsize.width/src.cols;
-        inv_scale_y = (double)dsize.height/src.rows;
-    }
-    _dst.create(dsize, src.type());
-    Mat dst = _dst.getMat();
+// Resize tables for the given source and destination sizes. They allow to compute
+// any range of the destination rows from the range of the source rows returned by getSrcRows(),
+// so the source image does not need to be available as a whole.
+class ResizePlan
+{
+public:
+    ResizePlan( Size _ssize, Size _dsize, double _inv_scale_x, double _inv_scale_y,
+                int interpolation, int _type );
 
+    // the source rows used to compute the destination rows dstRows
+    Range getSrcRows( const Range& dstRows ) const;
 
-#ifdef HAVE_TEGRA_OPTIMIZATION
-    if (tegra::resize(src, dst, (float)inv_scale_x, (float)inv_scale_y, interpolation))
-        return;
-#endif
+    // computes the destination rows dstRows; src and dst have the full sizes,
+    // but only the rows getSrcRows(dstRows) of src are accessed
+    void operator()( const Mat& src, Mat& dst, const Range& dstRows ) const;
 
-    int depth = src.depth(), cn = src.channels();
+private:
+    enum { MODE_NEAREST = 0, MODE_AREA_FAST = 1, MODE_AREA = 2, MODE_GENERIC = 3 };
+
+    Size ssize, dsize;
+    double inv_scale_x, inv_scale_y;
+    int type, mode;
+
+    int iscale_x, iscale_y;
+    vector<int> xofs, yofs, tabofs;
+    vector<float> alpha, beta;
+    vector<short> ialpha, ibeta;
+    vector<DecimateAlpha> xtab, ytab;
+    int xtab_size, ytab_size;
+    int xmin, xmax, ksize;
+    bool fixpt;
+
+    ResizeFunc func;
+    ResizeAreaFastFunc areaFastFunc;
+    ResizeAreaFunc areaFunc;
+};
+
+ResizePlan::ResizePlan( Size _ssize, Size _dsize, double _inv_scale_x, double _inv_scale_y,
+                        int interpolation, int _type ) :
+    ssize(_ssize), dsize(_dsize), inv_scale_x(_inv_scale_x), inv_scale_y(_inv_scale_y),
+    type(_type), mode(MODE_GENERIC), iscale_x(0), iscale_y(0), xtab_size(0), ytab_size(0),
+    xmin(0), xmax(0), ksize(0), fixpt(false), func(0), areaFastFunc(0), areaFunc(0)
+{
+    int depth = CV_MAT_DEPTH(type), cn = CV_MAT_CN(type);
     double scale_x = 1./inv_scale_x, scale_y = 1./inv_scale_y;
     int k, sx, sy, dx, dy;
-/*
-#if defined (HAVE_IPP) && (IPP_VERSION_MAJOR >= 7)
-    int mode = interpolation == INTER_LINEAR ? IPPI_INTER_LINEAR : 0;
-    int type = src.type();
-    ippiResizeSqrPixelFunc ippFunc =
-        type == CV_8UC1 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_8u_C1R :
-        type == CV_8UC3 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_8u_C3R :
-        type == CV_8UC4 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_8u_C4R :
-        type == CV_16UC1 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16u_C1R :
-        type == CV_16UC3 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16u_C3R :
-        type == CV_16UC4 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16u_C4R :
-        type == CV_16SC1 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16s_C1R :
-        type == CV_16SC3 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16s_C3R :
-        type == CV_16SC4 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16s_C4R :
-        type == CV_32FC1 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_32f_C1R :
-        type == CV_32FC3 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_32f_C3R :
-        type == CV_32FC4 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_32f_C4R :
-        0;
-    if( ippFunc && mode != 0 )
-    {
-        bool ok;
-        Range range(0, src.rows);
-        IPPresizeInvoker invoker(src, dst, inv_scale_x, inv_scale_y, mode, ippFunc, &ok);
-        parallel_for_(range, invoker, dst.total()/(double)(1<<16));
-        if( ok )
-            return;
-    }
-#endif
-*/
+
     if( interpolation == INTER_NEAREST )
     {
-        resizeNN( src, dst, inv_scale_x, inv_scale_y );
+        mode = MODE_NEAREST;
         return;
     }
 
     {
-        int iscale_x = saturate_cast<int>(scale_x);
-        int iscale_y = saturate_cast<int>(scale_y);
+        iscale_x = saturate_cast<int>(scale_x);
+        iscale_y = saturate_cast<int>(scale_y);
 
         bool is_area_fast = std::abs(scale_x - iscale_x) < DBL_EPSILON &&
                 std::abs(scale_y - iscale_y) < DBL_EPSILON;
@@ -1911,18 +1891,11 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
         {
             if( is_area_fast )
             {
-                int area = iscale_x*iscale_y;
-                size_t srcstep = src.step / src.elemSize1();
-                AutoBuffer<int> _ofs(area + dsize.width*cn);
-                int* ofs = _ofs;
-                int* xofs = ofs + area;
-                ResizeAreaFastFunc func = areafast_tab[depth];
-                CV_Assert( func != 0 );
-
-                for( sy = 0, k = 0; sy < iscale_y; sy++ )
-                    for( sx = 0; sx < iscale_x; sx++ )
-                        ofs[k++] = (int)(sy*srcstep + sx*cn);
+                mode = MODE_AREA_FAST;
+                areaFastFunc = areafast_tab[depth];
+                CV_Assert( areaFastFunc != 0 );
 
+                xofs.resize(dsize.width*cn);
                 for( dx = 0; dx < dsize.width; dx++ )
                 {
                     int j = dx * cn;
@@ -1930,22 +1903,20 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
                     for( k = 0; k < cn; k++ )
                         xofs[j + k] = sx + k;
                 }
-
-                func( src, dst, ofs, xofs, iscale_x, iscale_y );
                 return;
             }
 
-            ResizeAreaFunc func = area_tab[depth];
-            CV_Assert( func != 0 && cn <= 4 );
+            mode = MODE_AREA;
+            areaFunc = area_tab[depth];
+            CV_Assert( areaFunc != 0 && cn <= 4 );
 
-            AutoBuffer<DecimateAlpha> _xytab((ssize.width + ssize.height)*2);
-            DecimateAlpha* xtab = _xytab, *ytab = xtab + ssize.width*2;
+            xtab.resize(ssize.width*2);
+            ytab.resize(ssize.height*2);
 
-            int xtab_size = computeResizeAreaTab(ssize.width, dsize.width, cn, scale_x, xtab);
-            int ytab_size = computeResizeAreaTab(ssize.height, dsize.height, 1, scale_y, ytab);
+            xtab_size = computeResizeAreaTab(ssize.width, dsize.width, cn, scale_x, &xtab[0]);
+            ytab_size = computeResizeAreaTab(ssize.height, dsize.height, 1, scale_y, &ytab[0]);
 
-            AutoBuffer<int> _tabofs(dsize.height + 1);
-            int* tabofs = _tabofs;
+            tabofs.resize(dsize.height + 1);
             for( k = 0, dy = 0; k < ytab_size; k++ )
             {
                 if( k == 0 || ytab[k].di != ytab[k-1].di )
@@ -1955,18 +1926,18 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
                 }
             }
             tabofs[dy] = ytab_size;
-
-            func( src, dst, xtab, xtab_size, ytab, ytab_size, tabofs );
             return;
         }
     }
 
-    int xmin = 0, xmax = dsize.width, width = dsize.width*cn;
+    int width = dsize.width*cn;
     bool area_mode = interpolation == INTER_AREA;
-    bool fixpt = depth == CV_8U;
     float fx, fy;
-    ResizeFunc func=0;
-    int ksize=0, ksize2;
+    int ksize2;
+
+    xmax = dsize.width;
+    fixpt = depth == CV_8U;
+
     if( interpolation == INTER_CUBIC )
         ksize = 4, func = cubic_tab[depth];
     else if( interpolation == INTER_LANCZOS4 )
@@ -1979,13 +1950,18 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
 
     CV_Assert( func != 0 );
 
-    AutoBuffer<uchar> _buffer((width + dsize.height)*(sizeof(int) + sizeof(float)*ksize));
-    int* xofs = (int*)(uchar*)_buffer;
-    int* yofs = xofs + width;
-    float* alpha = (float*)(yofs + dsize.height);
-    short* ialpha = (short*)alpha;
-    float* beta = alpha + width*ksize;
-    short* ibeta = ialpha + width*ksize;
+    xofs.resize(width);
+    yofs.resize(dsize.height);
+    if( fixpt )
+    {
+        ialpha.resize(width*ksize);
+        ibeta.resize(dsize.height*ksize);
+    }
+    else
+    {
+        alpha.resize(width*ksize);
+        beta.resize(dsize.height*ksize);
+    }
     float cbuf[MAX_ESIZE];
 
     for( dx = 0; dx < dsize.width; dx++ )
@@ -2082,9 +2058,344 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
                 beta[dy*ksize + k] = cbuf[k];
         }
     }
+}
+
+Range ResizePlan::getSrcRows( const Range& dstRows ) const
+{
+    int dy0 = dstRows.start, dy1 = dstRows.end - 1, sy0 = 0, sy1 = ssize.height;
+
+    if( mode == MODE_NEAREST )
+    {
+        double ify = 1./inv_scale_y;
+        sy0 = std::min(cvFloor(dy0*ify), ssize.height-1);
+        sy1 = std::min(cvFloor(dy1*ify), ssize.height-1) + 1;
+    }
+    else if( mode == MODE_AREA_FAST )
+    {
+        sy0 = dy0*iscale_y;
+        sy1 = (dy1 + 1)*iscale_y;
+    }
+    else if( mode == MODE_AREA )
+    {
+        sy0 = ytab[tabofs[dy0]].si;
+        sy1 = ytab[tabofs[dy1 + 1] - 1].si + 1;
+    }
+    else
+    {
+        int ksize2 = ksize/2;
+        sy0 = clip(yofs[dy0] - ksize2 + 1, 0, ssize.height);
+        sy1 = clip(yofs[dy1] + ksize2, 0, ssize.height) + 1;
+    }
+
+    sy0 = std::min(std::max(sy0, 0), ssize.height - 1);
+    sy1 = std::min(std::max(sy1, sy0 + 1), ssize.height);
+    return Range(sy0, sy1);
+}
+
+void ResizePlan::operator()( const Mat& src, Mat& dst, const Range& dstRows ) const
+{
+    CV_Assert( src.size() == ssize && dst.size() == dsize && src.type() == type && dst.type() == type );
+
+    int cn = CV_MAT_CN(type);
+
+    if( mode == MODE_NEAREST )
+        resizeNN( src, dst, inv_scale_x, inv_scale_y, dstRows );
+    else if( mode == MODE_AREA_FAST )
+    {
+        int area = iscale_x*iscale_y;
+        size_t srcstep = src.step / src.elemSize1();
+        AutoBuffer<int> _ofs(area);
+        int* ofs = _ofs;
+
+        for( int sy = 0, k = 0; sy < iscale_y; sy++ )
+            for( int sx = 0; sx < iscale_x; sx++ )
+                ofs[k++] = (int)(sy*srcstep + sx*cn);
+
+        areaFastFunc( src, dst, ofs, &xofs[0], iscale_x, iscale_y, dstRows );
+    }
+    else if( mode == MODE_AREA )
+        areaFunc( src, dst, &xtab[0], xtab_size, &ytab[0], ytab_size, &tabofs[0], dstRows );
+    else
+        func( src, dst, &xofs[0], fixpt ? (const void*)&ialpha[0] : (const void*)&alpha[0], &yofs[0],
+              fixpt ? (const void*)&ibeta[0] : (const void*)&beta[0], xmin, xmax, ksize, dstRows );
+}
+
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
+                 double inv_scale_x, double inv_scale_y, int interpolation )
+{
+    Mat src = _src.getMat();
+    Size ssize = src.size();
+
+    CV_Assert( ssize.area() > 0 );
+    CV_Assert( dsize.area() || (inv_scale_x > 0 && inv_scale_y > 0) );
+    if( !dsize.area() )
+    {
+        dsize = Size(saturate_cast<int>(src.cols*inv_scale_x),
+            saturate_cast<int>(src.rows*inv_scale_y));
+        CV_Assert( dsize.area() );
+    }
+    else
+    {
+        inv_scale_x = (double)dsize.width/src.cols;
+        inv_scale_y = (double)dsize.height/src.rows;
+    }
+    _dst.create(dsize, src.type());
+    Mat dst = _dst.getMat();
+
+
+#ifdef HAVE_TEGRA_OPTIMIZATION
+    if (tegra::resize(src, dst, (float)inv_scale_x, (float)inv_scale_y, interpolation))
+        return;
+#endif
+
+/*
+#if defined (HAVE_IPP) && (IPP_VERSION_MAJOR >= 7)
+    int mode = interpolation == INTER_LINEAR ? IPPI_INTER_LINEAR : 0;
+    int type = src.type();
+    ippiResizeSqrPixelFunc ippFunc =
+        type == CV_8UC1 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_8u_C1R :
+        type == CV_8UC3 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_8u_C3R :
+        type == CV_8UC4 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_8u_C4R :
+        type == CV_16UC1 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16u_C1R :
+        type == CV_16UC3 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16u_C3R :
+        type == CV_16UC4 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16u_C4R :
+        type == CV_16SC1 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16s_C1R :
+        type == CV_16SC3 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16s_C3R :
+        type == CV_16SC4 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_16s_C4R :
+        type == CV_32FC1 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_32f_C1R :
+        type == CV_32FC3 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_32f_C3R :
+        type == CV_32FC4 ? (ippiResizeSqrPixelFunc)ippiResizeSqrPixel_32f_C4R :
+        0;
+    if( ippFunc && mode != 0 )
+    {
+        bool ok;
+        Range range(0, src.rows);
+        IPPresizeInvoker invoker(src, dst, inv_scale_x, inv_scale_y, mode, ippFunc, &ok);
+        parallel_for_(range, invoker, dst.total()/(double)(1<<16));
+        if( ok )
+            return;
+    }
+#endif
+*/
+    ResizePlan plan( ssize, dsize, inv_scale_x, inv_scale_y, interpolation, src.type() );
+    plan( src, dst, Range(0, dsize.height) );
+}
+
+
+namespace cv
+{
+
+enum
+{
+    COLOR_ROWS_POINTWISE = 0,
+    COLOR_ROWS_BAYER = 1,
+    COLOR_ROWS_YUV420SP = 2,
+    COLOR_ROWS_YUV420P = 3
+};
+
+// how the rows of the color converted image depend on the source rows
+static int getColorRowsKind( int code )
+{
+    if( (code >= CV_BayerBG2BGR && code <= CV_BayerGR2BGR) ||
+        (code >= CV_BayerBG2BGR_VNG && code <= CV_BayerGR2BGR_VNG) ||
+        (code >= CV_BayerBG2GRAY && code <= CV_BayerGR2GRAY) )
+        return COLOR_ROWS_BAYER;
+    if( (code >= CV_YUV2RGB_NV12 && code <= CV_YUV2BGRA_NV21) || code == CV_YUV2GRAY_420 )
+        return COLOR_ROWS_YUV420SP;
+    if( code >= CV_YUV2RGB_YV12 && code <= CV_YUV2BGRA_IYUV )
+        return COLOR_ROWS_YUV420P;
+    if( code >= CV_RGB2YUV_I420 && code < CV_COLORCVT_MAX )
+        CV_Error( CV_StsBadFlag, "Conversions to the planar YUV 4:2:0 formats can not be combined with resize" );
+    return COLOR_ROWS_POINTWISE;
+}
+
+// every source row of a YUV 4:2:0 chroma plane holds two chroma rows; when stepIdx is 1,
+// the plane starts in the middle of a row (see the YUV420p2RGB888Invoker)
+static inline const uchar* yuv420pChromaRow( const uchar* plane, int c, int stride, int halfWidth, int stepIdx )
+{
+    return stepIdx == 0 ? plane + (c/2)*stride + (c & 1)*halfWidth :
+                          plane + ((c + 1)/2)*stride - (c & 1)*halfWidth;
+}
+
+// Converts the rows [rows.start, rows.end) of the color converted image. The converted rows are stored
+// in buf starting from firstRow, which may be less than rows.start, because Bayer and YUV 4:2:0
+// conversions are done for whole 2-row blocks and with some margin (so that the band borders
+// are not treated as the image borders).
+static void cvtColorRows( const Mat& src, Mat& buf, int code, int kind, const Range& rows, int& firstRow )
+{
+    if( kind == COLOR_ROWS_POINTWISE )
+    {
+        firstRow = rows.start;
+        if( code < 0 )
+            buf = src.rowRange(rows);
+        else
+            cvtColor( src.rowRange(rows), buf, code );
+    }
+    else if( kind == COLOR_ROWS_BAYER )
+    {
+        // bilinear demosaicing uses 3x3 neighborhoods, VNG uses 5x5 ones
+        int margin = code >= CV_BayerBG2BGR_VNG && code <= CV_BayerGR2BGR_VNG ? 4 : 2;
+        int a0 = std::max(rows.start - margin, 0) & ~1;
+        int a1 = std::min(rows.end + margin, src.rows);
+        firstRow = a0;
+        cvtColor( src.rowRange(a0, a1), buf, code );
+    }
+    else
+    {
+        int height = src.rows*2/3, width = src.cols, halfWidth = width/2;
+        int a0 = rows.start & ~1, a1 = std::min((rows.end + 1) & ~1, height), bh = a1 - a0;
+        int stride = (int)src.step;
+        Mat yuv(bh*3/2, width, CV_8UC1);
+
+        firstRow = a0;
+        src.rowRange(a0, a1).copyTo(yuv.rowRange(0, bh));
+
+        if( kind == COLOR_ROWS_YUV420SP )
+            src.rowRange(height + a0/2, height + a1/2).copyTo(yuv.rowRange(bh, bh*3/2));
+        else
+        {
+            const uchar* plane0 = src.data + stride*height;
+            const uchar* plane1 = src.data + stride*(height + height/4) + halfWidth*((height % 4)/2);
+            int stepIdx1 = height % 4 == 2 ? 1 : 0;
+            uchar* dplane0 = yuv.data + width*bh;
+            uchar* dplane1 = dplane0 + halfWidth*(bh/2);
+
+            for( int c = a0/2; c < a1/2; c++ )
+            {
+                memcpy( dplane0 + (c - a0/2)*halfWidth, yuv420pChromaRow(plane0, c, stride, halfWidth, 0), halfWidth );
+                memcpy( dplane1 + (c - a0/2)*halfWidth, yuv420pChromaRow(plane1, c, stride, halfWidth, stepIdx1), halfWidth );
+            }
+        }
+
+        cvtColor( yuv, buf, code );
+    }
+}
+
+class CvtColorResizeInvoker : public ParallelLoopBody
+{
+public:
+    CvtColorResizeInvoker( const Mat& _src, Mat& _dst, int _code, int _kind, Size _csize, int _ctype,
+                           const ResizePlan* _plan, int _bandRows, double _alpha, double _beta ) :
+        ParallelLoopBody(), src(&_src), dst(&_dst), code(_code), kind(_kind), csize(_csize), ctype(_ctype),
+        plan(_plan), bandRows(_bandRows), alpha(_alpha), beta(_beta)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        Mat cbuf, rbuf;
+        bool convert = dst->type() != ctype || alpha != 1 || beta != 0;
+
+        for( int b = range.start; b < range.end; b++ )
+        {
+            Range drows(b*bandRows, std::min((b + 1)*bandRows, dst->rows));
+            Mat dband = dst->rowRange(drows);
+            int firstRow = 0;
+
+            cvtColorRows( *src, cbuf, code, kind, plan ? plan->getSrcRows(drows) : drows, firstRow );
+
+            Mat rband;
+            if( plan )
+            {
+                if( convert )
+                    rbuf.create(drows.size(), dst->cols, ctype);
+                rband = convert ? rbuf : dband;
+
+                // full-size headers of the color converted image and the resized image; only the rows
+                // of the current band are valid, and only those rows are accessed by the resize plan
+                Mat csrc(csize, ctype, cbuf.data - cbuf.step*firstRow, cbuf.step);
+                Mat cdst(dst->size(), ctype, rband.data - rband.step*drows.start, rband.step);
+                (*plan)( csrc, cdst, drows );
+            }
+            else
+                rband = cbuf.rowRange(drows.start - firstRow, drows.end - firstRow);
+
+            if( convert )
+                rband.convertTo(dband, dband.type(), alpha, beta);
+            else if( rband.data != dband.data )
+                rband.copyTo(dband);
+        }
+    }
+
+private:
+    const Mat* src;
+    Mat* dst;
+    int code, kind;
+    Size csize;
+    int ctype;
+    const ResizePlan* plan;
+    int bandRows;
+    double alpha, beta;
+};
 
-    func( src, dst, xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs,
-          fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize );
+}
+
+void cv::cvtColorResize( InputArray _src, OutputArray _dst, int code, Size dsize,
+                         double inv_scale_x, double inv_scale_y, int interpolation,
+                         int rtype, double alpha, double beta )
+{
+    const size_t BAND_SIZE = 1 << 18;
+
+    Mat src = _src.getMat();
+    CV_Assert( src.dims <= 2 && src.size().area() > 0 );
+
+    int kind = code >= 0 ? getColorRowsKind(code) : COLOR_ROWS_POINTWISE;
+    Size csize = src.size();
+    int ctype = src.type();
+
+    if( code >= 0 )
+    {
+        // convert a small image of the same type to check the arguments and to get the result type
+        Mat probe(6, 6, src.type(), Scalar::all(0)), probeDst;
+        cvtColor( probe, probeDst, code );
+        ctype = probeDst.type();
+
+        if( kind == COLOR_ROWS_YUV420SP || kind == COLOR_ROWS_YUV420P )
+        {
+            CV_Assert( src.cols % 2 == 0 && src.rows % 3 == 0 );
+            csize.height = src.rows*2/3;
+        }
+    }
+
+    CV_Assert( dsize.area() || (inv_scale_x > 0 && inv_scale_y > 0) );
+    if( !dsize.area() )
+    {
+        dsize = Size(saturate_cast<int>(csize.width*inv_scale_x),
+            saturate_cast<int>(csize.height*inv_scale_y));
+        CV_Assert( dsize.area() );
+    }
+    else
+    {
+        inv_scale_x = (double)dsize.width/csize.width;
+        inv_scale_y = (double)dsize.height/csize.height;
+    }
+
+    if( rtype < 0 )
+        rtype = ctype;
+    else
+        rtype = CV_MAKETYPE(CV_MAT_DEPTH(rtype), CV_MAT_CN(ctype));
+
+    _dst.create(dsize, rtype);
+    Mat dst = _dst.getMat();
+    if( src.data == dst.data )
+        src = src.clone();
+
+    Ptr<ResizePlan> plan;
+    if( dsize != csize )
+        plan = new ResizePlan( csize, dsize, inv_scale_x, inv_scale_y, interpolation, ctype );
+
+    // the bands are chosen so that the color converted source rows of a band fit into the cache
+    size_t srcRowSize = csize.width*CV_ELEM_SIZE(ctype)*std::max(csize.height/dsize.height, 1);
+    int bandRows = std::min(std::max((int)(BAND_SIZE/srcRowSize), 1), dsize.height);
+    int nbands = (dsize.height + bandRows - 1)/bandRows;
+
+    parallel_for_(Range(0, nbands), CvtColorResizeInvoker(src, dst, code, kind, csize, ctype,
+                                                          plan, bandRows, alpha, beta));
 }
 
 
@@ -2404,9 +2715,60 @@ struct RemapVec_8u
     }
 };
 
+struct RemapVec_32f
+{
+    int operator()( const Mat& _src, void* _dst, const short* XY,
+                    const ushort* FXY, const void* _wtab, int width ) const
+    {
+        int cn = _src.channels(), x = 0;
+
+        if( (cn != 1 && cn != 4) || !checkHardwareSupport(CV_CPU_SSE2) )
+            return 0;
+
+        const float* S0 = (const float*)_src.data;
+        size_t sstep = _src.step/sizeof(S0[0]);
+        const float* wtab = (const float*)_wtab;
+        float* D = (float*)_dst;
+
+        // the products are summed in the same order as in remapBilinear, so the results are bit-exact
+        if( cn == 1 )
+        {
+            for( ; x <= width - 4; x += 4 )
+            {
+                __m128 v[4];
+                for( int k = 0; k < 4; k++ )
+                {
+                    const float* S = S0 + XY[(x+k)*2+1]*sstep + XY[(x+k)*2];
+                    __m128 s = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)S);
+                    s = _mm_loadh_pi(s, (const __m64*)(S + sstep));
+                    v[k] = _mm_mul_ps(s, _mm_loadu_ps(wtab + FXY[x+k]*4));
+                }
+                _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+                _mm_storeu_ps(D + x, _mm_add_ps(_mm_add_ps(_mm_add_ps(v[0], v[1]), v[2]), v[3]));
+            }
+        }
+        else
+        {
+            for( ; x < width; x++, D += 4 )
+            {
+                const float* S = S0 + XY[x*2+1]*sstep + XY[x*2]*4;
+                const float* w = wtab + FXY[x]*4;
+                __m128 t = _mm_mul_ps(_mm_loadu_ps(S), _mm_set1_ps(w[0]));
+                t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(S + 4), _mm_set1_ps(w[1])));
+                t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(S + sstep), _mm_set1_ps(w[2])));
+                t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(S + sstep + 4), _mm_set1_ps(w[3])));
+                _mm_storeu_ps(D, t);
+            }
+        }
+
+        return x;
+    }
+};
+
 #else
 
 typedef RemapNoVec RemapVec_8u;
+typedef RemapNoVec RemapVec_32f;
 
 #endif
 
@@ -2834,26 +3196,118 @@ typedef void (*RemapFunc)(const Mat& _src, Mat& _dst, const Mat& _xy,
                           const Mat& _fxy, const void* _wtab,
                           int borderType, const Scalar& _borderValue);
 
+// Chooses the shape of the destination tiles processed by remap(), warpAffine() and warpPerspective().
+// (a, b, c, d) is the jacobian of the inverse mapping, that is, the source displacement
+// (a, c) for a unit step along the destination x and (b, d) for a unit step along y.
+// Among the tiles of maxArea pixels (the capacity of the per-tile coordinate buffers)
+// the one with the smallest estimated cost per destination pixel is taken, the cost being
+// the number of the source and destination cache lines touched plus a fixed overhead per tile row.
+// This gives wide tiles for the near-identity transformations and square-ish tiles for
+// the large rotations, where a row-wise traversal strides across the whole source image.
+static Size getWarpTileSize( Size dsize, size_t esz, double a, double b, double c, double d, int maxArea )
+{
+    const double CACHE_LINE_SIZE = 64;
+    const double ROW_COST = 8;
+    const int MIN_TILE_SIDE = 8;
+    double area = std::max(std::abs(a*d - b*c), 1e-3);
+    a = std::abs(a); b = std::abs(b); c = std::abs(c); d = std::abs(d);
+
+    if( dsize.area() <= maxArea )
+        return dsize;
+
+    Size best = dsize;
+    double bestCost = DBL_MAX;
+
+    for( int w = std::min(maxArea/MIN_TILE_SIDE, dsize.width); ; w = (w + 1)/2 )
+    {
+        int h = std::min(maxArea/w, dsize.height);
+        // the source footprint is approximated by a parallelogram crossing 'rows' source rows;
+        // each of the rows is read as a segment of (footprint area / rows) pixels
+        double rows = c*w + d*h + 1;
+        double lines = rows*(area*w*h*esz/(rows*CACHE_LINE_SIZE) + 1) +
+                       h*(w*esz/CACHE_LINE_SIZE + 1);
+        double cost = (lines + h*ROW_COST)/((double)w*h);
+        if( cost < bestCost )
+        {
+            bestCost = cost;
+            best = Size(w, h);
+        }
+        if( w <= MIN_TILE_SIDE )
+            break;
+    }
+    return best;
+}
+
+static int getWarpTileCount( Size dsize, Size tileSize )
+{
+    return ((dsize.width + tileSize.width - 1)/tileSize.width)*
+           ((dsize.height + tileSize.height - 1)/tileSize.height);
+}
+
+// Estimates the jacobian of the remap() maps by finite differences on a 3x3 grid of the samples
+static void getRemapJacobian( const Mat& map1, const Mat& map2, bool planar_input, double* J )
+{
+    int dx = std::min(8, map1.cols - 1), dy = std::min(8, map1.rows - 1);
+    J[0] = J[1] = J[2] = J[3] = 0;
+
+    for( int i = 1; i <= 3; i++ )
+        for( int j = 1; j <= 3; j++ )
+        {
+            int x = (map1.cols - 1 - dx)*j/4, y = (map1.rows - 1 - dy)*i/4;
+            Point2d p0, px, py;
+            if( map1.type() == CV_16SC2 )
+            {
+                p0 = Point2d(map1.at<Vec2s>(y, x)[0], map1.at<Vec2s>(y, x)[1]);
+                px = Point2d(map1.at<Vec2s>(y, x + dx)[0], map1.at<Vec2s>(y, x + dx)[1]);
+                py = Point2d(map1.at<Vec2s>(y + dy, x)[0], map1.at<Vec2s>(y + dy, x)[1]);
+            }
+            else if( !planar_input )
+            {
+                p0 = Point2d(map1.at<Vec2f>(y, x)[0], map1.at<Vec2f>(y, x)[1]);
+                px = Point2d(map1.at<Vec2f>(y, x + dx)[0], map1.at<Vec2f>(y, x + dx)[1]);
+                py = Point2d(map1.at<Vec2f>(y + dy, x)[0], map1.at<Vec2f>(y + dy, x)[1]);
+            }
+            else
+            {
+                p0 = Point2d(map1.at<float>(y, x), map2.at<float>(y, x));
+                px = Point2d(map1.at<float>(y, x + dx), map2.at<float>(y, x + dx));
+                py = Point2d(map1.at<float>(y + dy, x), map2.at<float>(y + dy, x));
+            }
+            if( dx > 0 )
+            {
+                J[0] += std::abs(px.x - p0.x)/dx;
+                J[2] += std::abs(px.y - p0.y)/dx;
+            }
+            if( dy > 0 )
+            {
+                J[1] += std::abs(py.x - p0.x)/dy;
+                J[3] += std::abs(py.y - p0.y)/dy;
+            }
+        }
+
+    for( int k = 0; k < 4; k++ )
+        J[k] /= 9;
+}
+
 class RemapInvoker :
     public ParallelLoopBody
 {
 public:
     RemapInvoker(const Mat& _src, Mat& _dst, const Mat *_m1,
                  const Mat *_m2, int _interpolation, int _borderType, const Scalar &_borderValue,
-                 int _planar_input, RemapNNFunc _nnfunc, RemapFunc _ifunc, const void *_ctab) :
+                 int _planar_input, RemapNNFunc _nnfunc, RemapFunc _ifunc, const void *_ctab,
+                 Size _tileSize) :
         ParallelLoopBody(), src(&_src), dst(&_dst), m1(_m1), m2(_m2),
         interpolation(_interpolation), borderType(_borderType), borderValue(_borderValue),
-        planar_input(_planar_input), nnfunc(_nnfunc), ifunc(_ifunc), ctab(_ctab)
+        planar_input(_planar_input), nnfunc(_nnfunc), ifunc(_ifunc), ctab(_ctab), tileSize(_tileSize)
     {
     }
 
     virtual void operator() (const Range& range) const
     {
         int x, y, x1, y1;
-        const int buf_size = 1 << 14;
-        int brows0 = std::min(128, dst->rows), map_depth = m1->depth();
-        int bcols0 = std::min(buf_size/brows0, dst->cols);
-        brows0 = std::min(buf_size/bcols0, dst->rows);
+        int brows0 = tileSize.height, bcols0 = tileSize.width, map_depth = m1->depth();
+        int tilesX = (dst->cols + bcols0 - 1)/bcols0;
     #if CV_SSE2
         bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
     #endif
@@ -2862,128 +3316,59 @@ public:
         if( !nnfunc )
             _bufa.create(brows0, bcols0, CV_16UC1);
 
-        for( y = range.start; y < range.end; y += brows0 )
+        for( int t = range.start; t < range.end; t++ )
         {
-            for( x = 0; x < dst->cols; x += bcols0 )
+            y = (t / tilesX)*brows0;
+            x = (t % tilesX)*bcols0;
+            int brows = std::min(brows0, dst->rows - y);
+            int bcols = std::min(bcols0, dst->cols - x);
+            Mat dpart(*dst, Rect(x, y, bcols, brows));
+            Mat bufxy(_bufxy, Rect(0, 0, bcols, brows));
+
+            if( nnfunc )
             {
-                int brows = std::min(brows0, range.end - y);
-                int bcols = std::min(bcols0, dst->cols - x);
-                Mat dpart(*dst, Rect(x, y, bcols, brows));
-                Mat bufxy(_bufxy, Rect(0, 0, bcols, brows));
-
-                if( nnfunc )
+                if( m1->type() == CV_16SC2 && !m2->data ) // the data is already in the right format
+                    bufxy = (*m1)(Rect(x, y, bcols, brows));
+                else if( map_depth != CV_32F )
                 {
-                    if( m1->type() == CV_16SC2 && !m2->data ) // the data is already in the right format
-                        bufxy = (*m1)(Rect(x, y, bcols, brows));
-                    else if( map_depth != CV_32F )
+                    for( y1 = 0; y1 < brows; y1++ )
                     {
-                        for( y1 = 0; y1 < brows; y1++ )
-                        {
-                            short* XY = (short*)(bufxy.data + bufxy.step*y1);
-                            const short* sXY = (const short*)(m1->data + m1->step*(y+y1)) + x*2;
-                            const ushort* sA = (const ushort*)(m2->data + m2->step*(y+y1)) + x;
+                        short* XY = (short*)(bufxy.data + bufxy.step*y1);
+                        const short* sXY = (const short*)(m1->data + m1->step*(y+y1)) + x*2;
+                        const ushort* sA = (const ushort*)(m2->data + m2->step*(y+y1)) + x;
 
-                            for( x1 = 0; x1 < bcols; x1++ )
-                            {
-                                int a = sA[x1] & (INTER_TAB_SIZE2-1);
-                                XY[x1*2] = sXY[x1*2] + NNDeltaTab_i[a][0];
-                                XY[x1*2+1] = sXY[x1*2+1] + NNDeltaTab_i[a][1];
-                            }
-                        }
-                    }
-                    else if( !planar_input )
-                        (*m1)(Rect(x, y, bcols, brows)).convertTo(bufxy, bufxy.depth());
-                    else
-                    {
-                        for( y1 = 0; y1 < brows; y1++ )
+                        for( x1 = 0; x1 < bcols; x1++ )
                         {
-                            short* XY = (short*)(bufxy.data + bufxy.step*y1);
-                            const float* sX = (const float*)(m1->data + m1->step*(y+y1)) + x;
-                            const float* sY = (const float*)(m2->data + m2->step*(y+y1)) + x;
-                            x1 = 0;
-
-                        #if CV_SSE2
-                            if( useSIMD )
-                            {
-                                for( ; x1 <= bcols - 8; x1 += 8 )
-                                {
-                                    __m128 fx0 = _mm_loadu_ps(sX + x1);
-                                    __m128 fx1 = _mm_loadu_ps(sX + x1 + 4);
-                                    __m128 fy0 = _mm_loadu_ps(sY + x1);
-                                    __m128 fy1 = _mm_loadu_ps(sY + x1 + 4);
-                                    __m128i ix0 = _mm_cvtps_epi32(fx0);
-                                    __m128i ix1 = _mm_cvtps_epi32(fx1);
-                                    __m128i iy0 = _mm_cvtps_epi32(fy0);
-                                    __m128i iy1 = _mm_cvtps_epi32(fy1);
-                                    ix0 = _mm_packs_epi32(ix0, ix1);
-                                    iy0 = _mm_packs_epi32(iy0, iy1);
-                                    ix1 = _mm_unpacklo_epi16(ix0, iy0);
-                                    iy1 = _mm_unpackhi_epi16(ix0, iy0);
-                                    _mm_storeu_si128((__m128i*)(XY + x1*2), ix1);
-                                    _mm_storeu_si128((__m128i*)(XY + x1*2 + 8), iy1);
-                                }
-                            }
-                        #endif
-
-                            for( ; x1 < bcols; x1++ )
-                            {
-                                XY[x1*2] = saturate_cast<short>(sX[x1]);
-                                XY[x1*2+1] = saturate_cast<short>(sY[x1]);
-                            }
+                            int a = sA[x1] & (INTER_TAB_SIZE2-1);
+                            XY[x1*2] = sXY[x1*2] + NNDeltaTab_i[a][0];
+                            XY[x1*2+1] = sXY[x1*2+1] + NNDeltaTab_i[a][1];
                         }
                     }
-                    nnfunc( *src, dpart, bufxy, borderType, borderValue );
-                    continue;
                 }
-
-                Mat bufa(_bufa, Rect(0, 0, bcols, brows));
-                for( y1 = 0; y1 < brows; y1++ )
+                else if( !planar_input )
+                    (*m1)(Rect(x, y, bcols, brows)).convertTo(bufxy, bufxy.depth());
+                else
                 {
-                    short* XY = (short*)(bufxy.data + bufxy.step*y1);
-                    ushort* A = (ushort*)(bufa.data + bufa.step*y1);
-
-                    if( m1->type() == CV_16SC2 && (m2->type() == CV_16UC1 || m2->type() == CV_16SC1) )
-                    {
-                        bufxy = (*m1)(Rect(x, y, bcols, brows));
-
-                        const ushort* sA = (const ushort*)(m2->data + m2->step*(y+y1)) + x;
-                        for( x1 = 0; x1 < bcols; x1++ )
-                            A[x1] = (ushort)(sA[x1] & (INTER_TAB_SIZE2-1));
-                    }
-                    else if( planar_input )
+                    for( y1 = 0; y1 < brows; y1++ )
                     {
+                        short* XY = (short*)(bufxy.data + bufxy.step*y1);
                         const float* sX = (const float*)(m1->data + m1->step*(y+y1)) + x;
                         const float* sY = (const float*)(m2->data + m2->step*(y+y1)) + x;
-
                         x1 = 0;
+
                     #if CV_SSE2
                         if( useSIMD )
                         {
-                            __m128 scale = _mm_set1_ps((float)INTER_TAB_SIZE);
-                            __m128i mask = _mm_set1_epi32(INTER_TAB_SIZE-1);
                             for( ; x1 <= bcols - 8; x1 += 8 )
                             {
                                 __m128 fx0 = _mm_loadu_ps(sX + x1);
                                 __m128 fx1 = _mm_loadu_ps(sX + x1 + 4);
                                 __m128 fy0 = _mm_loadu_ps(sY + x1);
                                 __m128 fy1 = _mm_loadu_ps(sY + x1 + 4);
-                                __m128i ix0 = _mm_cvtps_epi32(_mm_mul_ps(fx0, scale));
-                                __m128i ix1 = _mm_cvtps_epi32(_mm_mul_ps(fx1, scale));
-                                __m128i iy0 = _mm_cvtps_epi32(_mm_mul_ps(fy0, scale));
-                                __m128i iy1 = _mm_cvtps_epi32(_mm_mul_ps(fy1, scale));
-                                __m128i mx0 = _mm_and_si128(ix0, mask);
-                                __m128i mx1 = _mm_and_si128(ix1, mask);
-                                __m128i my0 = _mm_and_si128(iy0, mask);
-                                __m128i my1 = _mm_and_si128(iy1, mask);
-                                mx0 = _mm_packs_epi32(mx0, mx1);
-                                my0 = _mm_packs_epi32(my0, my1);
-                                my0 = _mm_slli_epi16(my0, INTER_BITS);
-                                mx0 = _mm_or_si128(mx0, my0);
-                                _mm_storeu_si128((__m128i*)(A + x1), mx0);
-                                ix0 = _mm_srai_epi32(ix0, INTER_BITS);
-                                ix1 = _mm_srai_epi32(ix1, INTER_BITS);
-                                iy0 = _mm_srai_epi32(iy0, INTER_BITS);
-                                iy1 = _mm_srai_epi32(iy1, INTER_BITS);
+                                __m128i ix0 = _mm_cvtps_epi32(fx0);
+                                __m128i ix1 = _mm_cvtps_epi32(fx1);
+                                __m128i iy0 = _mm_cvtps_epi32(fy0);
+                                __m128i iy1 = _mm_cvtps_epi32(fy1);
                                 ix0 = _mm_packs_epi32(ix0, ix1);
                                 iy0 = _mm_packs_epi32(iy0, iy1);
                                 ix1 = _mm_unpacklo_epi16(ix0, iy0);
@@ -2996,31 +3381,99 @@ public:
 
                         for( ; x1 < bcols; x1++ )
                         {
-                            int sx = cvRound(sX[x1]*INTER_TAB_SIZE);
-                            int sy = cvRound(sY[x1]*INTER_TAB_SIZE);
-                            int v = (sy & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE-1));
-                            XY[x1*2] = saturate_cast<short>(sx >> INTER_BITS);
-                            XY[x1*2+1] = saturate_cast<short>(sy >> INTER_BITS);
-                            A[x1] = (ushort)v;
+                            XY[x1*2] = saturate_cast<short>(sX[x1]);
+                            XY[x1*2+1] = saturate_cast<short>(sY[x1]);
                         }
                     }
-                    else
-                    {
-                        const float* sXY = (const float*)(m1->data + m1->step*(y+y1)) + x*2;
+                }
+                nnfunc( *src, dpart, bufxy, borderType, borderValue );
+                continue;
+            }
 
-                        for( x1 = 0; x1 < bcols; x1++ )
+            Mat bufa(_bufa, Rect(0, 0, bcols, brows));
+            for( y1 = 0; y1 < brows; y1++ )
+            {
+                short* XY = (short*)(bufxy.data + bufxy.step*y1);
+                ushort* A = (ushort*)(bufa.data + bufa.step*y1);
+
+                if( m1->type() == CV_16SC2 && (m2->type() == CV_16UC1 || m2->type() == CV_16SC1) )
+                {
+                    bufxy = (*m1)(Rect(x, y, bcols, brows));
+
+                    const ushort* sA = (const ushort*)(m2->data + m2->step*(y+y1)) + x;
+                    for( x1 = 0; x1 < bcols; x1++ )
+                        A[x1] = (ushort)(sA[x1] & (INTER_TAB_SIZE2-1));
+                }
+                else if( planar_input )
+                {
+                    const float* sX = (const float*)(m1->data + m1->step*(y+y1)) + x;
+                    const float* sY = (const float*)(m2->data + m2->step*(y+y1)) + x;
+
+                    x1 = 0;
+                #if CV_SSE2
+                    if( useSIMD )
+                    {
+                        __m128 scale = _mm_set1_ps((float)INTER_TAB_SIZE);
+                        __m128i mask = _mm_set1_epi32(INTER_TAB_SIZE-1);
+                        for( ; x1 <= bcols - 8; x1 += 8 )
                         {
-                            int sx = cvRound(sXY[x1*2]*INTER_TAB_SIZE);
-                            int sy = cvRound(sXY[x1*2+1]*INTER_TAB_SIZE);
-                            int v = (sy & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE-1));
-                            XY[x1*2] = saturate_cast<short>(sx >> INTER_BITS);
-                            XY[x1*2+1] = saturate_cast<short>(sy >> INTER_BITS);
-                            A[x1] = (ushort)v;
+                            __m128 fx0 = _mm_loadu_ps(sX + x1);
+                            __m128 fx1 = _mm_loadu_ps(sX + x1 + 4);
+                            __m128 fy0 = _mm_loadu_ps(sY + x1);
+                            __m128 fy1 = _mm_loadu_ps(sY + x1 + 4);
+                            __m128i ix0 = _mm_cvtps_epi32(_mm_mul_ps(fx0, scale));
+                            __m128i ix1 = _mm_cvtps_epi32(_mm_mul_ps(fx1, scale));
+                            __m128i iy0 = _mm_cvtps_epi32(_mm_mul_ps(fy0, scale));
+                            __m128i iy1 = _mm_cvtps_epi32(_mm_mul_ps(fy1, scale));
+                            __m128i mx0 = _mm_and_si128(ix0, mask);
+                            __m128i mx1 = _mm_and_si128(ix1, mask);
+                            __m128i my0 = _mm_and_si128(iy0, mask);
+                            __m128i my1 = _mm_and_si128(iy1, mask);
+                            mx0 = _mm_packs_epi32(mx0, mx1);
+                            my0 = _mm_packs_epi32(my0, my1);
+                            my0 = _mm_slli_epi16(my0, INTER_BITS);
+                            mx0 = _mm_or_si128(mx0, my0);
+                            _mm_storeu_si128((__m128i*)(A + x1), mx0);
+                            ix0 = _mm_srai_epi32(ix0, INTER_BITS);
+                            ix1 = _mm_srai_epi32(ix1, INTER_BITS);
+                            iy0 = _mm_srai_epi32(iy0, INTER_BITS);
+                            iy1 = _mm_srai_epi32(iy1, INTER_BITS);
+                            ix0 = _mm_packs_epi32(ix0, ix1);
+                            iy0 = _mm_packs_epi32(iy0, iy1);
+                            ix1 = _mm_unpacklo_epi16(ix0, iy0);
+                            iy1 = _mm_unpackhi_epi16(ix0, iy0);
+                            _mm_storeu_si128((__m128i*)(XY + x1*2), ix1);
+                            _mm_storeu_si128((__m128i*)(XY + x1*2 + 8), iy1);
                         }
                     }
+                #endif
+
+                    for( ; x1 < bcols; x1++ )
+                    {
+                        int sx = cvRound(sX[x1]*INTER_TAB_SIZE);
+                        int sy = cvRound(sY[x1]*INTER_TAB_SIZE);
+                        int v = (sy & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE-1));
+                        XY[x1*2] = saturate_cast<short>(sx >> INTER_BITS);
+                        XY[x1*2+1] = saturate_cast<short>(sy >> INTER_BITS);
+                        A[x1] = (ushort)v;
+                    }
+                }
+                else
+                {
+                    const float* sXY = (const float*)(m1->data + m1->step*(y+y1)) + x*2;
+
+                    for( x1 = 0; x1 < bcols; x1++ )
+                    {
+                        int sx = cvRound(sXY[x1*2]*INTER_TAB_SIZE);
+                        int sy = cvRound(sXY[x1*2+1]*INTER_TAB_SIZE);
+                        int v = (sy & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE + (sx & (INTER_TAB_SIZE-1));
+                        XY[x1*2] = saturate_cast<short>(sx >> INTER_BITS);
+                        XY[x1*2+1] = saturate_cast<short>(sy >> INTER_BITS);
+                        A[x1] = (ushort)v;
+                    }
                 }
-                ifunc(*src, dpart, bufxy, bufa, ctab, borderType, borderValue);
             }
+            ifunc(*src, dpart, bufxy, bufa, ctab, borderType, borderValue);
         }
     }
 
@@ -3034,6 +3487,7 @@ private:
     RemapNNFunc nnfunc;
     RemapFunc ifunc;
     const void *ctab;
+    Size tileSize;
 };
 
 }
@@ -3053,7 +3507,7 @@ void cv::remap( InputArray _src, OutputArray _dst,
         remapBilinear<FixedPtCast<int, uchar, INTER_REMAP_COEF_BITS>, RemapVec_8u, short>, 0,
         remapBilinear<Cast<float, ushort>, RemapNoVec, float>,
         remapBilinear<Cast<float, short>, RemapNoVec, float>, 0,
-        remapBilinear<Cast<float, float>, RemapNoVec, float>,
+        remapBilinear<Cast<float, float>, RemapVec_32f, float>,
         remapBilinear<Cast<double, double>, RemapNoVec, float>, 0
     };
 
@@ -3129,10 +3583,19 @@ void cv::remap( InputArray _src, OutputArray _dst,
         planar_input = map1.channels() == 1;
     }
 
+    const int buf_size = 1 << 14;
+    Size tileSize = dst.size();
+    if( dst.total() > (size_t)buf_size )
+    {
+        double J[4];
+        getRemapJacobian( *m1, *m2, planar_input, J );
+        tileSize = getWarpTileSize( dst.size(), src.elemSize(), J[0], J[1], J[2], J[3], buf_size );
+    }
+
     RemapInvoker invoker(src, dst, m1, m2, interpolation,
                          borderType, borderValue, planar_input, nnfunc, ifunc,
-                         ctab);
-    parallel_for_(Range(0, dst.rows), invoker, dst.total()/(double)(1<<16));
+                         ctab, tileSize);
+    parallel_for_(Range(0, getWarpTileCount(dst.size(), tileSize)), invoker);
 }
 
 
@@ -3283,10 +3746,11 @@ class warpAffineInvoker :
 {
 public:
     warpAffineInvoker(const Mat &_src, Mat &_dst, int _interpolation, int _borderType,
-                      const Scalar &_borderValue, int *_adelta, int *_bdelta, double *_M) :
+                      const Scalar &_borderValue, int *_adelta, int *_bdelta, double *_M,
+                      Size _tileSize) :
         ParallelLoopBody(), src(_src), dst(_dst), interpolation(_interpolation),
         borderType(_borderType), borderValue(_borderValue), adelta(_adelta), bdelta(_bdelta),
-        M(_M)
+        M(_M), tileSize(_tileSize)
     {
     }
 
@@ -3301,91 +3765,90 @@ public:
         bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
     #endif
 
-        int bh0 = std::min(BLOCK_SZ/2, dst.rows);
-        int bw0 = std::min(BLOCK_SZ*BLOCK_SZ/bh0, dst.cols);
-        bh0 = std::min(BLOCK_SZ*BLOCK_SZ/bw0, dst.rows);
+        int bh0 = tileSize.height, bw0 = tileSize.width;
+        int tilesX = (dst.cols + bw0 - 1)/bw0;
+        CV_Assert( bw0*bh0 <= BLOCK_SZ*BLOCK_SZ );
 
-        for( y = range.start; y < range.end; y += bh0 )
+        for( int t = range.start; t < range.end; t++ )
         {
-            for( x = 0; x < dst.cols; x += bw0 )
-            {
-                int bw = std::min( bw0, dst.cols - x);
-                int bh = std::min( bh0, range.end - y);
+            y = (t / tilesX)*bh0;
+            x = (t % tilesX)*bw0;
+            int bw = std::min( bw0, dst.cols - x);
+            int bh = std::min( bh0, dst.rows - y);
 
-                Mat _XY(bh, bw, CV_16SC2, XY), matA;
-                Mat dpart(dst, Rect(x, y, bw, bh));
+            Mat _XY(bh, bw, CV_16SC2, XY), matA;
+            Mat dpart(dst, Rect(x, y, bw, bh));
 
-                for( y1 = 0; y1 < bh; y1++ )
-                {
-                    short* xy = XY + y1*bw*2;
-                    int X0 = saturate_cast<int>((M[1]*(y + y1) + M[2])*AB_SCALE) + round_delta;
-                    int Y0 = saturate_cast<int>((M[4]*(y + y1) + M[5])*AB_SCALE) + round_delta;
+            for( y1 = 0; y1 < bh; y1++ )
+            {
+                short* xy = XY + y1*bw*2;
+                int X0 = saturate_cast<int>((M[1]*(y + y1) + M[2])*AB_SCALE) + round_delta;
+                int Y0 = saturate_cast<int>((M[4]*(y + y1) + M[5])*AB_SCALE) + round_delta;
 
-                    if( interpolation == INTER_NEAREST )
-                        for( x1 = 0; x1 < bw; x1++ )
-                        {
-                            int X = (X0 + adelta[x+x1]) >> AB_BITS;
-                            int Y = (Y0 + bdelta[x+x1]) >> AB_BITS;
-                            xy[x1*2] = saturate_cast<short>(X);
-                            xy[x1*2+1] = saturate_cast<short>(Y);
-                        }
-                    else
+                if( interpolation == INTER_NEAREST )
+                    for( x1 = 0; x1 < bw; x1++ )
                     {
-                        short* alpha = A + y1*bw;
-                        x1 = 0;
-                    #if CV_SSE2
-                        if( useSIMD )
-                        {
-                            __m128i fxy_mask = _mm_set1_epi32(INTER_TAB_SIZE - 1);
-                            __m128i XX = _mm_set1_epi32(X0), YY = _mm_set1_epi32(Y0);
-                            for( ; x1 <= bw - 8; x1 += 8 )
-                            {
-                                __m128i tx0, tx1, ty0, ty1;
-                                tx0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + x1)), XX);
-                                ty0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + x1)), YY);
-                                tx1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + x1 + 4)), XX);
-                                ty1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + x1 + 4)), YY);
-
-                                tx0 = _mm_srai_epi32(tx0, AB_BITS - INTER_BITS);
-                                ty0 = _mm_srai_epi32(ty0, AB_BITS - INTER_BITS);
-                                tx1 = _mm_srai_epi32(tx1, AB_BITS - INTER_BITS);
-                                ty1 = _mm_srai_epi32(ty1, AB_BITS - INTER_BITS);
-
-                                __m128i fx_ = _mm_packs_epi32(_mm_and_si128(tx0, fxy_mask),
-                                                            _mm_and_si128(tx1, fxy_mask));
-                                __m128i fy_ = _mm_packs_epi32(_mm_and_si128(ty0, fxy_mask),
-                                                            _mm_and_si128(ty1, fxy_mask));
-                                tx0 = _mm_packs_epi32(_mm_srai_epi32(tx0, INTER_BITS),
-                                                            _mm_srai_epi32(tx1, INTER_BITS));
-                                ty0 = _mm_packs_epi32(_mm_srai_epi32(ty0, INTER_BITS),
-                                                    _mm_srai_epi32(ty1, INTER_BITS));
-                                fx_ = _mm_adds_epi16(fx_, _mm_slli_epi16(fy_, INTER_BITS));
-
-                                _mm_storeu_si128((__m128i*)(xy + x1*2), _mm_unpacklo_epi16(tx0, ty0));
-                                _mm_storeu_si128((__m128i*)(xy + x1*2 + 8), _mm_unpackhi_epi16(tx0, ty0));
-                                _mm_storeu_si128((__m128i*)(alpha + x1), fx_);
-                            }
-                        }
-                    #endif
-                        for( ; x1 < bw; x1++ )
+                        int X = (X0 + adelta[x+x1]) >> AB_BITS;
+                        int Y = (Y0 + bdelta[x+x1]) >> AB_BITS;
+                        xy[x1*2] = saturate_cast<short>(X);
+                        xy[x1*2+1] = saturate_cast<short>(Y);
+                    }
+                else
+                {
+                    short* alpha = A + y1*bw;
+                    x1 = 0;
+                #if CV_SSE2
+                    if( useSIMD )
+                    {
+                        __m128i fxy_mask = _mm_set1_epi32(INTER_TAB_SIZE - 1);
+                        __m128i XX = _mm_set1_epi32(X0), YY = _mm_set1_epi32(Y0);
+                        for( ; x1 <= bw - 8; x1 += 8 )
                         {
-                            int X = (X0 + adelta[x+x1]) >> (AB_BITS - INTER_BITS);
-                            int Y = (Y0 + bdelta[x+x1]) >> (AB_BITS - INTER_BITS);
-                            xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
-                            xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
-                            alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
-                                    (X & (INTER_TAB_SIZE-1)));
+                            __m128i tx0, tx1, ty0, ty1;
+                            tx0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + x1)), XX);
+                            ty0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + x1)), YY);
+                            tx1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + x1 + 4)), XX);
+                            ty1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + x1 + 4)), YY);
+
+                            tx0 = _mm_srai_epi32(tx0, AB_BITS - INTER_BITS);
+                            ty0 = _mm_srai_epi32(ty0, AB_BITS - INTER_BITS);
+                            tx1 = _mm_srai_epi32(tx1, AB_BITS - INTER_BITS);
+                            ty1 = _mm_srai_epi32(ty1, AB_BITS - INTER_BITS);
+
+                            __m128i fx_ = _mm_packs_epi32(_mm_and_si128(tx0, fxy_mask),
+                                                        _mm_and_si128(tx1, fxy_mask));
+                            __m128i fy_ = _mm_packs_epi32(_mm_and_si128(ty0, fxy_mask),
+                                                        _mm_and_si128(ty1, fxy_mask));
+                            tx0 = _mm_packs_epi32(_mm_srai_epi32(tx0, INTER_BITS),
+                                                        _mm_srai_epi32(tx1, INTER_BITS));
+                            ty0 = _mm_packs_epi32(_mm_srai_epi32(ty0, INTER_BITS),
+                                                _mm_srai_epi32(ty1, INTER_BITS));
+                            fx_ = _mm_adds_epi16(fx_, _mm_slli_epi16(fy_, INTER_BITS));
+
+                            _mm_storeu_si128((__m128i*)(xy + x1*2), _mm_unpacklo_epi16(tx0, ty0));
+                            _mm_storeu_si128((__m128i*)(xy + x1*2 + 8), _mm_unpackhi_epi16(tx0, ty0));
+                            _mm_storeu_si128((__m128i*)(alpha + x1), fx_);
                         }
                     }
+                #endif
+                    for( ; x1 < bw; x1++ )
+                    {
+                        int X = (X0 + adelta[x+x1]) >> (AB_BITS - INTER_BITS);
+                        int Y = (Y0 + bdelta[x+x1]) >> (AB_BITS - INTER_BITS);
+                        xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
+                        xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
+                        alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
+                                (X & (INTER_TAB_SIZE-1)));
+                    }
                 }
+            }
 
-                if( interpolation == INTER_NEAREST )
-                    remap( src, dpart, _XY, Mat(), interpolation, borderType, borderValue );
-                else
-                {
-                    Mat _matA(bh, bw, CV_16U, A);
-                    remap( src, dpart, _XY, _matA, interpolation, borderType, borderValue );
-                }
+            if( interpolation == INTER_NEAREST )
+                remap( src, dpart, _XY, Mat(), interpolation, borderType, borderValue );
+            else
+            {
+                Mat _matA(bh, bw, CV_16U, A);
+                remap( src, dpart, _XY, _matA, interpolation, borderType, borderValue );
             }
         }
     }
@@ -3397,6 +3860,7 @@ private:
     Scalar borderValue;
     int *adelta, *bdelta;
     double *M;
+    Size tileSize;
 };
 
 #if defined (HAVE_IPP) && (IPP_VERSION_MAJOR >= 7)
@@ -3538,10 +4002,11 @@ void cv::warpAffine( InputArray _src, OutputArray _dst,
         bdelta[x] = saturate_cast<int>(M[3]*x*AB_SCALE);
     }
 
-    Range range(0, dst.rows);
+    Size tileSize = getWarpTileSize( dst.size(), src.elemSize(), M[0], M[1], M[3], M[4], 64*64 );
+    Range range(0, getWarpTileCount(dst.size(), tileSize));
     warpAffineInvoker invoker(src, dst, interpolation, borderType,
-                              borderValue, adelta, bdelta, M);
-    parallel_for_(range, invoker, dst.total()/(double)(1<<16));
+                              borderValue, adelta, bdelta, M, tileSize);
+    parallel_for_(range, invoker);
 }
 
 
@@ -3554,9 +4019,9 @@ class warpPerspectiveInvoker :
 public:
 
     warpPerspectiveInvoker(const Mat &_src, Mat &_dst, double *_M, int _interpolation,
-                           int _borderType, const Scalar &_borderValue) :
+                           int _borderType, const Scalar &_borderValue, Size _tileSize) :
         ParallelLoopBody(), src(_src), dst(_dst), M(_M), interpolation(_interpolation),
-        borderType(_borderType), borderValue(_borderValue)
+        borderType(_borderType), borderValue(_borderValue), tileSize(_tileSize)
     {
     }
 
@@ -3566,68 +4031,67 @@ public:
         short XY[BLOCK_SZ*BLOCK_SZ*2], A[BLOCK_SZ*BLOCK_SZ];
         int x, y, x1, y1, width = dst.cols, height = dst.rows;
 
-        int bh0 = std::min(BLOCK_SZ/2, height);
-        int bw0 = std::min(BLOCK_SZ*BLOCK_SZ/bh0, width);
-        bh0 = std::min(BLOCK_SZ*BLOCK_SZ/bw0, height);
+        int bh0 = tileSize.height, bw0 = tileSize.width;
+        int tilesX = (width + bw0 - 1)/bw0;
+        CV_Assert( bw0*bh0 <= BLOCK_SZ*BLOCK_SZ );
 
-        for( y = range.start; y < range.end; y += bh0 )
+        for( int t = range.start; t < range.end; t++ )
         {
-            for( x = 0; x < width; x += bw0 )
-            {
-                int bw = std::min( bw0, width - x);
-                int bh = std::min( bh0, range.end - y); // height
+            y = (t / tilesX)*bh0;
+            x = (t % tilesX)*bw0;
+            int bw = std::min( bw0, width - x);
+            int bh = std::min( bh0, height - y);
 
-                Mat _XY(bh, bw, CV_16SC2, XY), matA;
-                Mat dpart(dst, Rect(x, y, bw, bh));
+            Mat _XY(bh, bw, CV_16SC2, XY), matA;
+            Mat dpart(dst, Rect(x, y, bw, bh));
 
-                for( y1 = 0; y1 < bh; y1++ )
-                {
-                    short* xy = XY + y1*bw*2;
-                    double X0 = M[0]*x + M[1]*(y + y1) + M[2];
-                    double Y0 = M[3]*x + M[4]*(y + y1) + M[5];
-                    double W0 = M[6]*x + M[7]*(y + y1) + M[8];
+            for( y1 = 0; y1 < bh; y1++ )
+            {
+                short* xy = XY + y1*bw*2;
+                double X0 = M[0]*x + M[1]*(y + y1) + M[2];
+                double Y0 = M[3]*x + M[4]*(y + y1) + M[5];
+                double W0 = M[6]*x + M[7]*(y + y1) + M[8];
 
-                    if( interpolation == INTER_NEAREST )
-                        for( x1 = 0; x1 < bw; x1++ )
-                        {
-                            double W = W0 + M[6]*x1;
-                            W = W ? 1./W : 0;
-                            double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*x1)*W));
-                            double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*x1)*W));
-                            int X = saturate_cast<int>(fX);
-                            int Y = saturate_cast<int>(fY);
-
-                            xy[x1*2] = saturate_cast<short>(X);
-                            xy[x1*2+1] = saturate_cast<short>(Y);
-                        }
-                    else
+                if( interpolation == INTER_NEAREST )
+                    for( x1 = 0; x1 < bw; x1++ )
                     {
-                        short* alpha = A + y1*bw;
-                        for( x1 = 0; x1 < bw; x1++ )
-                        {
-                            double W = W0 + M[6]*x1;
-                            W = W ? INTER_TAB_SIZE/W : 0;
-                            double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*x1)*W));
-                            double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*x1)*W));
-                            int X = saturate_cast<int>(fX);
-                            int Y = saturate_cast<int>(fY);
-
-                            xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
-                            xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
-                            alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
-                                                (X & (INTER_TAB_SIZE-1)));
-                        }
+                        double W = W0 + M[6]*x1;
+                        W = W ? 1./W : 0;
+                        double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*x1)*W));
+                        double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*x1)*W));
+                        int X = saturate_cast<int>(fX);
+                        int Y = saturate_cast<int>(fY);
+
+                        xy[x1*2] = saturate_cast<short>(X);
+                        xy[x1*2+1] = saturate_cast<short>(Y);
                     }
-                }
-
-                if( interpolation == INTER_NEAREST )
-                    remap( src, dpart, _XY, Mat(), interpolation, borderType, borderValue );
                 else
                 {
-                    Mat _matA(bh, bw, CV_16U, A);
-                    remap( src, dpart, _XY, _matA, interpolation, borderType, borderValue );
+                    short* alpha = A + y1*bw;
+                    for( x1 = 0; x1 < bw; x1++ )
+                    {
+                        double W = W0 + M[6]*x1;
+                        W = W ? INTER_TAB_SIZE/W : 0;
+                        double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*x1)*W));
+                        double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*x1)*W));
+                        int X = saturate_cast<int>(fX);
+                        int Y = saturate_cast<int>(fY);
+
+                        xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
+                        xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
+                        alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
+                                            (X & (INTER_TAB_SIZE-1)));
+                    }
                 }
             }
+
+            if( interpolation == INTER_NEAREST )
+                remap( src, dpart, _XY, Mat(), interpolation, borderType, borderValue );
+            else
+            {
+                Mat _matA(bh, bw, CV_16U, A);
+                remap( src, dpart, _XY, _matA, interpolation, borderType, borderValue );
+            }
         }
     }
 
@@ -3637,6 +4101,7 @@ private:
     double* M;
     int interpolation, borderType;
     Scalar borderValue;
+    Size tileSize;
 };
 
 #if defined (HAVE_IPP) && (IPP_VERSION_MAJOR >= 7)
@@ -3757,9 +4222,23 @@ void cv::warpPerspective( InputArray _src, OutputArray _dst, InputArray _M0,
     }
 #endif
 */
-    Range range(0, dst.rows);
-    warpPerspectiveInvoker invoker(src, dst, M, interpolation, borderType, borderValue);
-    parallel_for_(range, invoker, dst.total()/(double)(1<<16));
+    // the tile shape is chosen for the jacobian of the inverse mapping at the center of the image
+    double J[4] = { 1, 0, 0, 1 };
+    {
+        double u = (dst.cols - 1)*0.5, v = (dst.rows - 1)*0.5;
+        double W = M[6]*u + M[7]*v + M[8];
+        if( W != 0 )
+        {
+            W = 1./W;
+            double X = (M[0]*u + M[1]*v + M[2])*W, Y = (M[3]*u + M[4]*v + M[5])*W;
+            J[0] = (M[0] - X*M[6])*W; J[1] = (M[1] - X*M[7])*W;
+            J[2] = (M[3] - Y*M[6])*W; J[3] = (M[4] - Y*M[7])*W;
+        }
+    }
+    Size tileSize = getWarpTileSize( dst.size(), src.elemSize(), J[0], J[1], J[2], J[3], 32*32 );
+    Range range(0, getWarpTileCount(dst.size(), tileSize));
+    warpPerspectiveInvoker invoker(src, dst, M, interpolation, borderType, borderValue, tileSize);
+    parallel_for_(range, invoker);
 }
 
 
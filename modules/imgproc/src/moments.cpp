@@ -320,21 +320,307 @@ template<> void momentsInTile<uchar, int, int>( const cv::Mat& img, double* mome
         moments[x] = (double)mom[x];
 }
 
+
+template<> void momentsInTile<ushort, int, int64>( const cv::Mat& img, double* moments )
+{
+    typedef ushort T;
+    typedef int WT;
+    typedef int64 MT;
+    cv::Size size = img.size();
+    int y;
+    MT mom[10] = {0,0,0,0,0,0,0,0,0,0};
+    bool useSIMD = cv::checkHardwareSupport(CV_CPU_SSE2);
+
+    for( y = 0; y < size.height; y++ )
+    {
+        const T* ptr = img.ptr<T>(y);
+        WT x0 = 0, x1 = 0, x2 = 0;
+        MT x3 = 0;
+        int x = 0;
+
+        if( useSIMD )
+        {
+            // x < TILE_SIZE, so x, x^2 and x^3 fit into 16 bits
+            // and the products with the pixel values fit into 32 bits
+            __m128i qx_init = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+            __m128i dx = _mm_set1_epi16(8);
+            __m128i z = _mm_setzero_si128(), qx0 = z, qx1 = z, qx2 = z, qx3 = z, qx = qx_init;
+
+            for( ; x <= size.width - 8; x += 8 )
+            {
+                __m128i p = _mm_loadu_si128((const __m128i*)(ptr + x));
+                __m128i sx = _mm_mullo_epi16(qx, qx);
+                __m128i cx = _mm_mullo_epi16(sx, qx);
+                __m128i lo, hi, t0, t1;
+
+                qx0 = _mm_add_epi32(qx0, _mm_add_epi32(_mm_unpacklo_epi16(p, z), _mm_unpackhi_epi16(p, z)));
+
+                lo = _mm_mullo_epi16(p, qx); hi = _mm_mulhi_epu16(p, qx);
+                qx1 = _mm_add_epi32(qx1, _mm_add_epi32(_mm_unpacklo_epi16(lo, hi), _mm_unpackhi_epi16(lo, hi)));
+
+                lo = _mm_mullo_epi16(p, sx); hi = _mm_mulhi_epu16(p, sx);
+                qx2 = _mm_add_epi32(qx2, _mm_add_epi32(_mm_unpacklo_epi16(lo, hi), _mm_unpackhi_epi16(lo, hi)));
+
+                lo = _mm_mullo_epi16(p, cx); hi = _mm_mulhi_epu16(p, cx);
+                t0 = _mm_unpacklo_epi16(lo, hi); t1 = _mm_unpackhi_epi16(lo, hi);
+                qx3 = _mm_add_epi64(qx3, _mm_add_epi64(_mm_unpacklo_epi32(t0, z), _mm_unpackhi_epi32(t0, z)));
+                qx3 = _mm_add_epi64(qx3, _mm_add_epi64(_mm_unpacklo_epi32(t1, z), _mm_unpackhi_epi32(t1, z)));
+
+                qx = _mm_add_epi16(qx, dx);
+            }
+            int CV_DECL_ALIGNED(16) buf[4];
+            int64 CV_DECL_ALIGNED(16) buf64[2];
+            _mm_store_si128((__m128i*)buf, qx0);
+            x0 = buf[0] + buf[1] + buf[2] + buf[3];
+            _mm_store_si128((__m128i*)buf, qx1);
+            x1 = buf[0] + buf[1] + buf[2] + buf[3];
+            _mm_store_si128((__m128i*)buf, qx2);
+            x2 = buf[0] + buf[1] + buf[2] + buf[3];
+            _mm_store_si128((__m128i*)buf64, qx3);
+            x3 = buf64[0] + buf64[1];
+        }
+
+        for( ; x < size.width; x++ )
+        {
+            WT p = ptr[x];
+            WT xp = x * p, xxp;
+
+            x0 += p;
+            x1 += xp;
+            xxp = xp * x;
+            x2 += xxp;
+            x3 += xxp * x;
+        }
+
+        WT py = y * x0, sy = y*y;
+
+        mom[9] += ((MT)py) * sy;  // m03
+        mom[8] += ((MT)x1) * sy;  // m12
+        mom[7] += ((MT)x2) * y;  // m21
+        mom[6] += x3;             // m30
+        mom[5] += x0 * sy;        // m02
+        mom[4] += x1 * y;         // m11
+        mom[3] += x2;             // m20
+        mom[2] += py;             // m01
+        mom[1] += x1;             // m10
+        mom[0] += x0;             // m00
+    }
+
+    for(int x = 0; x < 10; x++ )
+        moments[x] = (double)mom[x];
+}
+
+template<> void momentsInTile<float, double, double>( const cv::Mat& img, double* moments )
+{
+    typedef float T;
+    typedef double WT;
+    typedef double MT;
+    cv::Size size = img.size();
+    int y;
+    MT mom[10] = {0,0,0,0,0,0,0,0,0,0};
+    bool useSIMD = cv::checkHardwareSupport(CV_CPU_SSE2);
+
+    for( y = 0; y < size.height; y++ )
+    {
+        const T* ptr = img.ptr<T>(y);
+        WT x0 = 0, x1 = 0, x2 = 0;
+        MT x3 = 0;
+        int x = 0;
+
+        if( useSIMD )
+        {
+            __m128d dx = _mm_set1_pd(4.);
+            __m128d z = _mm_setzero_pd(), qx0 = z, qx1 = z, qx2 = z, qx3 = z;
+            __m128d qxl = _mm_setr_pd(0., 1.), qxh = _mm_setr_pd(2., 3.);
+
+            for( ; x <= size.width - 4; x += 4 )
+            {
+                __m128 v = _mm_loadu_ps(ptr + x);
+                __m128d pl = _mm_cvtps_pd(v), ph = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+                __m128d pxl = _mm_mul_pd(pl, qxl), pxh = _mm_mul_pd(ph, qxh);
+                __m128d xxpl = _mm_mul_pd(pxl, qxl), xxph = _mm_mul_pd(pxh, qxh);
+
+                qx0 = _mm_add_pd(qx0, _mm_add_pd(pl, ph));
+                qx1 = _mm_add_pd(qx1, _mm_add_pd(pxl, pxh));
+                qx2 = _mm_add_pd(qx2, _mm_add_pd(xxpl, xxph));
+                qx3 = _mm_add_pd(qx3, _mm_add_pd(_mm_mul_pd(xxpl, qxl), _mm_mul_pd(xxph, qxh)));
+
+                qxl = _mm_add_pd(qxl, dx);
+                qxh = _mm_add_pd(qxh, dx);
+            }
+            double CV_DECL_ALIGNED(16) buf[2];
+            _mm_store_pd(buf, qx0);
+            x0 = buf[0] + buf[1];
+            _mm_store_pd(buf, qx1);
+            x1 = buf[0] + buf[1];
+            _mm_store_pd(buf, qx2);
+            x2 = buf[0] + buf[1];
+            _mm_store_pd(buf, qx3);
+            x3 = buf[0] + buf[1];
+        }
+
+        for( ; x < size.width; x++ )
+        {
+            WT p = ptr[x];
+            WT xp = x * p, xxp;
+
+            x0 += p;
+            x1 += xp;
+            xxp = xp * x;
+            x2 += xxp;
+            x3 += xxp * x;
+        }
+
+        WT py = y * x0, sy = y*y;
+
+        mom[9] += ((MT)py) * sy;  // m03
+        mom[8] += ((MT)x1) * sy;  // m12
+        mom[7] += ((MT)x2) * y;  // m21
+        mom[6] += x3;             // m30
+        mom[5] += x0 * sy;        // m02
+        mom[4] += x1 * y;         // m11
+        mom[3] += x2;             // m20
+        mom[2] += py;             // m01
+        mom[1] += x1;             // m10
+        mom[0] += x0;             // m00
+    }
+
+    for(int x = 0; x < 10; x++ )
+        moments[x] = (double)mom[x];
+}
+
 #endif
 
 typedef void (*CvMomentsInTileFunc)(const cv::Mat& img, double* moments);
 
+namespace cv
+{
+
+static const int MOMENTS_TILE_SIZE = 32;
+
+// adds the moments of a tile computed relative to its top-left corner (x, y);
+// the moments are stored in the CvMoments order m00, m10, m01, m20, m11, m02, m30, m21, m12, m03
+static void accumulateTileMoments( double* acc, const double* mom, double x, double y )
+{
+    double xm = x * mom[0], ym = y * mom[0];
+
+    // + m00 ( = m00' )
+    acc[0] += mom[0];
+
+    // + m10 ( = m10' + x*m00' )
+    acc[1] += mom[1] + xm;
+
+    // + m01 ( = m01' + y*m00' )
+    acc[2] += mom[2] + ym;
+
+    // + m20 ( = m20' + 2*x*m10' + x*x*m00' )
+    acc[3] += mom[3] + x * (mom[1] * 2 + xm);
+
+    // + m11 ( = m11' + x*m01' + y*m10' + x*y*m00' )
+    acc[4] += mom[4] + x * (mom[2] + ym) + y * mom[1];
+
+    // + m02 ( = m02' + 2*y*m01' + y*y*m00' )
+    acc[5] += mom[5] + y * (mom[2] * 2 + ym);
+
+    // + m30 ( = m30' + 3*x*m20' + 3*x*x*m10' + x*x*x*m00' )
+    acc[6] += mom[6] + x * (3. * mom[3] + x * (3. * mom[1] + xm));
+
+    // + m21 ( = m21' + x*(2*m11' + 2*y*m10' + x*m01' + x*y*m00') + y*m20')
+    acc[7] += mom[7] + x * (2 * (mom[4] + y * mom[1]) + x * (mom[2] + ym)) + y * mom[3];
+
+    // + m12 ( = m12' + y*(2*m11' + 2*x*m01' + y*m10' + x*y*m00') + x*m02')
+    acc[8] += mom[8] + y * (2 * (mom[4] + x * mom[2]) + y * (mom[1] + xm)) + x * mom[5];
+
+    // + m03 ( = m03' + 3*y*m02' + 3*y*y*m01' + y*y*y*m00' )
+    acc[9] += mom[9] + y * (3. * mom[5] + y * (3. * mom[2] + ym));
+}
+
+/*
+   Computes the moments of every row of tiles. Each row of tiles is accumulated
+   into its own slot, and the slots are summed up afterwards in a fixed order,
+   so the result does not depend on the number of threads.
+*/
+class MomentsInTileRowInvoker : public ParallelLoopBody
+{
+public:
+    MomentsInTileRowInvoker( const Mat& _src, int _coi, bool _binary,
+                             CvMomentsInTileFunc _func, double* _rowMoments ) :
+        ParallelLoopBody(), src0(&_src), coi(_coi), binary(_binary),
+        func(_func), rowMoments(_rowMoments)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        const int TILE_SIZE = MOMENTS_TILE_SIZE;
+        int depth = src0->depth();
+        Size size = src0->size();
+        double buf[TILE_SIZE*TILE_SIZE];
+        uchar nzbuf[TILE_SIZE*TILE_SIZE];
+
+        for( int r = range.start; r < range.end; r++ )
+        {
+            int y = r*TILE_SIZE;
+            double* acc = rowMoments + r*10;
+            Size tileSize;
+            tileSize.height = std::min(TILE_SIZE, size.height - y);
+
+            for( int k = 0; k < 10; k++ )
+                acc[k] = 0;
+
+            for( int x = 0; x < size.width; x += TILE_SIZE )
+            {
+                tileSize.width = std::min(TILE_SIZE, size.width - x);
+                Mat src(*src0, Rect(x, y, tileSize.width, tileSize.height));
+
+                if( coi > 0 )
+                {
+                    Mat tmp(tileSize, depth, buf);
+                    int pairs[] = {coi-1, 0};
+                    mixChannels(&src, 1, &tmp, 1, pairs, 1);
+                    src = tmp;
+                }
+                if( binary )
+                {
+                    Mat tmp(tileSize, CV_8U, nzbuf);
+                    compare( src, 0, tmp, CV_CMP_NE );
+                    src = tmp;
+                }
+
+                double mom[10];
+                func( src, mom );
+
+                if(binary)
+                {
+                    double s = 1./255;
+                    for( int k = 0; k < 10; k++ )
+                        mom[k] *= s;
+                }
+
+                accumulateTileMoments( acc, mom, x, y );
+            }
+        }
+    }
+
+private:
+    const Mat* src0;
+    int coi;
+    bool binary;
+    CvMomentsInTileFunc func;
+    double* rowMoments;
+};
+
+}
+
 CV_IMPL void cvMoments( const void* array, CvMoments* moments, int binary )
 {
-    const int TILE_SIZE = 32;
+    const int TILE_SIZE = cv::MOMENTS_TILE_SIZE;
     int type, depth, cn, coi = 0;
     CvMat stub, *mat = (CvMat*)array;
     CvMomentsInTileFunc func = 0;
     CvContour contourHeader;
     CvSeq* contour = 0;
     CvSeqBlock block;
-    double buf[TILE_SIZE*TILE_SIZE];
-    uchar nzbuf[TILE_SIZE*TILE_SIZE];
 
     if( CV_IS_SEQ( array ))
     {
@@ -393,76 +679,17 @@ CV_IMPL void cvMoments( const void* array, CvMoments* moments, int binary )
         CV_Error( CV_StsUnsupportedFormat, "" );
 
     cv::Mat src0(mat);
+    int tileRows = (size.height + TILE_SIZE - 1)/TILE_SIZE;
+    cv::AutoBuffer<double> _rowMoments(tileRows*10);
+    double* rowMoments = _rowMoments;
 
-    for( int y = 0; y < size.height; y += TILE_SIZE )
-    {
-        cv::Size tileSize;
-        tileSize.height = std::min(TILE_SIZE, size.height - y);
-
-        for( int x = 0; x < size.width; x += TILE_SIZE )
-        {
-            tileSize.width = std::min(TILE_SIZE, size.width - x);
-            cv::Mat src(src0, cv::Rect(x, y, tileSize.width, tileSize.height));
-
-            if( coi > 0 )
-            {
-                cv::Mat tmp(tileSize, depth, buf);
-                int pairs[] = {coi-1, 0};
-                cv::mixChannels(&src, 1, &tmp, 1, pairs, 1);
-                src = tmp;
-            }
-            if( binary )
-            {
-                cv::Mat tmp(tileSize, CV_8U, nzbuf);
-                cv::compare( src, 0, tmp, CV_CMP_NE );
-                src = tmp;
-            }
-
-            double mom[10];
-            func( src, mom );
-
-            if(binary)
-            {
-                double s = 1./255;
-                for( int k = 0; k < 10; k++ )
-                    mom[k] *= s;
-            }
-
-            double xm = x * mom[0], ym = y * mom[0];
-
-            // accumulate moments computed in each tile
-
-            // + m00 ( = m00' )
-            moments->m00 += mom[0];
-
-            // + m10 ( = m10' + x*m00' )
-            moments->m10 += mom[1] + xm;
+    cv::parallel_for_(cv::Range(0, tileRows),
+        cv::MomentsInTileRowInvoker(src0, coi, binary != 0, func, rowMoments));
 
-            // + m01 ( = m01' + y*m00' )
-            moments->m01 += mom[2] + ym;
-
-            // + m20 ( = m20' + 2*x*m10' + x*x*m00' )
-            moments->m20 += mom[3] + x * (mom[1] * 2 + xm);
-
-            // + m11 ( = m11' + x*m01' + y*m10' + x*y*m00' )
-            moments->m11 += mom[4] + x * (mom[2] + ym) + y * mom[1];
-
-            // + m02 ( = m02' + 2*y*m01' + y*y*m00' )
-            moments->m02 += mom[5] + y * (mom[2] * 2 + ym);
-
-            // + m30 ( = m30' + 3*x*m20' + 3*x*x*m10' + x*x*x*m00' )
-            moments->m30 += mom[6] + x * (3. * mom[3] + x * (3. * mom[1] + xm));
-
-            // + m21 ( = m21' + x*(2*m11' + 2*y*m10' + x*m01' + x*y*m00') + y*m20')
-            moments->m21 += mom[7] + x * (2 * (mom[4] + y * mom[1]) + x * (mom[2] + ym)) + y * mom[3];
-
-            // + m12 ( = m12' + y*(2*m11' + 2*x*m01' + y*m10' + x*y*m00') + x*m02')
-            moments->m12 += mom[8] + y * (2 * (mom[4] + x * mom[2]) + y * (mom[1] + xm)) + x * mom[5];
-
-            // + m03 ( = m03' + 3*y*m02' + 3*y*y*m01' + y*y*y*m00' )
-            moments->m03 += mom[9] + y * (3. * mom[5] + y * (3. * mom[2] + ym));
-        }
-    }
+    // accumulate moments computed in each row of tiles
+    for( int r = 0; r < tileRows; r++ )
+        for( int k = 0; k < 10; k++ )
+            (&moments->m00)[k] += rowMoments[r*10 + k];
 
     icvCompleteMomentState( moments );
 }
@@ -617,6 +844,139 @@ cv::Moments cv::moments( InputArray _array, bool binaryImage )
     return om;
 }
 
+namespace cv
+{
+
+/*
+   Accumulates the binary moments of all the labels over a band of rows.
+   The pixels are processed by horizontal runs of the same label; the sums of
+   x, x^2 and x^3 over a run are computed in the closed form.
+*/
+template<typename T> static void
+labelMomentsInBand( const Mat& labels, int y0, int y1, int nlabels, double* acc )
+{
+    for( int y = y0; y < y1; y++ )
+    {
+        const T* row = labels.ptr<T>(y);
+        double fy = y, fy2 = fy*fy, fy3 = fy2*fy;
+        int x = 0, width = labels.cols;
+
+        while( x < width )
+        {
+            T l = row[x];
+            int x1 = x + 1;
+            while( x1 < width && row[x1] == l )
+                x1++;
+
+            if( l >= 0 && (int)l < nlabels )
+            {
+                double a = x, b = x1, n = b - a;
+                double s1 = (b*(b - 1) - a*(a - 1))*0.5;
+                double s2 = ((b - 1)*b*(2*b - 1) - (a - 1)*a*(2*a - 1))*(1./6);
+                double t = b*(b - 1)*0.5, u = a*(a - 1)*0.5;
+                double s3 = t*t - u*u;
+                double* m = acc + (int)l*10;
+
+                m[0] += n;
+                m[1] += s1;
+                m[2] += fy*n;
+                m[3] += s2;
+                m[4] += fy*s1;
+                m[5] += fy2*n;
+                m[6] += s3;
+                m[7] += fy*s2;
+                m[8] += fy2*s1;
+                m[9] += fy3*n;
+            }
+            x = x1;
+        }
+    }
+}
+
+class LabelMomentsInvoker : public ParallelLoopBody
+{
+public:
+    LabelMomentsInvoker( const Mat& _labels, int _nlabels, int _nstripes, double* _stripeMoments ) :
+        ParallelLoopBody(), labels(&_labels), nlabels(_nlabels),
+        nstripes(_nstripes), stripeMoments(_stripeMoments)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        int depth = labels->depth(), rows = labels->rows;
+
+        for( int i = range.start; i < range.end; i++ )
+        {
+            int y0 = (int)((int64)rows*i/nstripes), y1 = (int)((int64)rows*(i + 1)/nstripes);
+            double* acc = stripeMoments + (size_t)i*nlabels*10;
+            memset( acc, 0, nlabels*10*sizeof(acc[0]) );
+
+            if( depth == CV_8U )
+                labelMomentsInBand<uchar>( *labels, y0, y1, nlabels, acc );
+            else if( depth == CV_16U )
+                labelMomentsInBand<ushort>( *labels, y0, y1, nlabels, acc );
+            else
+                labelMomentsInBand<int>( *labels, y0, y1, nlabels, acc );
+        }
+    }
+
+private:
+    const Mat* labels;
+    int nlabels;
+    int nstripes;
+    double* stripeMoments;
+};
+
+}
+
+void cv::labelMoments( InputArray _labels, vector<Moments>& mu, int nlabels )
+{
+    Mat labels = _labels.getMat();
+    int type = labels.type();
+
+    CV_Assert( type == CV_8UC1 || type == CV_16UC1 || type == CV_32SC1 );
+
+    if( nlabels < 0 )
+    {
+        double maxVal = -1;
+        if( !labels.empty() )
+            minMaxLoc( labels, 0, &maxVal );
+        // no regions at all when every label is negative
+        nlabels = std::max(cvRound(maxVal) + 1, 0);
+    }
+
+    mu.resize(nlabels);
+    if( nlabels == 0 )
+        return;
+
+    // every band has its own accumulators; the number of bands depends only on the input size,
+    // and the bands are summed in a fixed order, so the result is reproducible
+    const size_t maxBufSize = (size_t)1 << 26;
+    int nstripes = std::max(labels.rows/64, 1);
+    nstripes = (int)std::max(std::min((size_t)nstripes, maxBufSize/(nlabels*10*sizeof(double))), (size_t)1);
+
+    AutoBuffer<double> _stripeMoments((size_t)nstripes*nlabels*10);
+    double* stripeMoments = _stripeMoments;
+
+    if( labels.rows > 0 )
+        parallel_for_(Range(0, nstripes), LabelMomentsInvoker(labels, nlabels, nstripes, stripeMoments));
+    else
+        memset( stripeMoments, 0, nlabels*10*sizeof(double) );
+
+    for( int l = 0; l < nlabels; l++ )
+    {
+        double m[10];
+        for( int k = 0; k < 10; k++ )
+        {
+            m[k] = 0;
+            for( int i = 0; i < nstripes; i++ )
+                m[k] += stripeMoments[((size_t)i*nlabels + l)*10 + k];
+        }
+        mu[l] = Moments(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9]);
+    }
+}
+
 void cv::HuMoments( const Moments& m, double hu[7] )
 {
     double t0 = m.nu30 + m.nu12;
@@ -45,36 +45,151 @@
 *                                       Watershed                                        *
 \****************************************************************************************/
 
-typedef struct CvWSNode
+namespace cv
 {
-    struct CvWSNode* next;
+
+// A node of the bucketed priority queue. The nodes are kept in one array
+// and linked by indices; the node 0 is reserved as the list terminator.
+struct WSNode
+{
+    int next;
+    int mask_ofs;
+    int img_ofs;
+};
+
+// Queue for WSNodes
+struct WSQueue
+{
+    WSQueue() { first = last = 0; }
+    int first, last;
+};
+
+// A pixel adjacent to a marker, found by the initial scan
+struct WSSeed
+{
+    int idx;
     int mask_ofs;
     int img_ofs;
+};
+
+static int allocWSNodes( std::vector<WSNode>& storage )
+{
+    int sz = std::max((int)storage.size(), 1), newsz = std::max(sz*2, 256);
+    storage.resize( newsz );
+    for( int i = sz; i < newsz-1; i++ )
+        storage[i].next = i+1;
+    storage[newsz-1].next = 0;
+    return sz;
 }
-CvWSNode;
 
-typedef struct CvWSQueue
+static inline int wsColorDiff( const uchar* ptr1, const uchar* ptr2 )
 {
-    CvWSNode* first;
-    CvWSNode* last;
+    int db = std::abs(ptr1[0] - ptr2[0]);
+    int dg = std::abs(ptr1[1] - ptr2[1]);
+    int dr = std::abs(ptr1[2] - ptr2[2]);
+    return std::max(std::max(db, dg), dr);
 }
-CvWSQueue;
 
-static CvWSNode*
-icvAllocWSNodes( CvMemStorage* storage )
+/*
+  Prepares the inner rows of the markers image for the watershed: the pixels with the negative
+  labels are reset to 0, and the first and the last columns become the dummy "watershed" pixels.
+  Every row is processed independently.
+*/
+class WatershedPrepareInvoker : public ParallelLoopBody
+{
+public:
+    WatershedPrepareInvoker( Mat& _dst ) : ParallelLoopBody(), dst(&_dst)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        const int WSHED = -1;
+        int width = dst->cols;
+
+        for( int i = range.start; i < range.end; i++ )
+        {
+            int* mask = dst->ptr<int>(i);
+            for( int j = 1; j < width-1; j++ )
+                if( mask[j] < 0 )
+                    mask[j] = 0;
+            mask[0] = mask[width-1] = WSHED;
+        }
+    }
+
+private:
+    Mat* dst;
+};
+
+/*
+  The initial phase of the watershed: finds the neighbor pixels of each marker and
+  computes their priorities. The image is split into horizontal bands; the seeds of every
+  band are collected in the raster order, so that pushing them band by band into the
+  queue gives exactly the same order as the sequential scan. The markers image is only read
+  here (the bands read the boundary rows of their neighbors); the caller marks the seeds
+  as queued when pushing them. The sequential scan did it on the fly, but a queued pixel
+  is never a marker for its neighbors, so the found seeds are the same.
+*/
+class WatershedSeedsInvoker : public ParallelLoopBody
 {
-    CvWSNode* n = 0;
+public:
+    WatershedSeedsInvoker( const Mat& _src, const Mat& _dst, std::vector<WSSeed>* _seeds, int _nstripes ) :
+        ParallelLoopBody(), src(&_src), dst(&_dst), seeds(_seeds), nstripes(_nstripes)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        int width = src->cols, inner = src->rows - 2;
+        int istep = (int)src->step, mstep = (int)(dst->step/sizeof(int));
 
-    int i, count = (storage->block_size - sizeof(CvMemBlock))/sizeof(*n) - 1;
+        for( int k = range.start; k < range.end; k++ )
+        {
+            int y0 = 1 + (int)((int64)inner*k/nstripes), y1 = 1 + (int)((int64)inner*(k+1)/nstripes);
+            std::vector<WSSeed>& s = seeds[k];
+            s.clear();
 
-    n = (CvWSNode*)cvMemStorageAlloc( storage, count*sizeof(*n) );
-    for( i = 0; i < count-1; i++ )
-        n[i].next = n + i + 1;
-    n[count-1].next = 0;
+            for( int i = y0; i < y1; i++ )
+            {
+                const uchar* img = src->ptr<uchar>(i);
+                const int* mask = dst->ptr<int>(i);
 
-    return n;
-}
+                for( int j = 1; j < width-1; j++ )
+                {
+                    const int* m = mask + j;
+                    if( m[0] == 0 && (m[-1] > 0 || m[1] > 0 || m[-mstep] > 0 || m[mstep] > 0) )
+                    {
+                        const uchar* ptr = img + j*3;
+                        int idx = 256;
+                        if( m[-1] > 0 )
+                            idx = wsColorDiff( ptr, ptr - 3 );
+                        if( m[1] > 0 )
+                            idx = std::min( idx, wsColorDiff( ptr, ptr + 3 ) );
+                        if( m[-mstep] > 0 )
+                            idx = std::min( idx, wsColorDiff( ptr, ptr - istep ) );
+                        if( m[mstep] > 0 )
+                            idx = std::min( idx, wsColorDiff( ptr, ptr + istep ) );
+                        assert( 0 <= idx && idx <= 255 );
+
+                        WSSeed seed;
+                        seed.idx = idx;
+                        seed.mask_ofs = i*mstep + j;
+                        seed.img_ofs = i*istep + j*3;
+                        s.push_back( seed );
+                    }
+                }
+            }
+        }
+    }
 
+private:
+    const Mat* src;
+    const Mat* dst;
+    std::vector<WSSeed>* seeds;
+    int nstripes;
+};
+
+}
 
 CV_IMPL void
 cvWatershed( const CvArr* srcarr, CvArr* dstarr )
@@ -82,13 +197,13 @@ cvWatershed( const CvArr* srcarr, CvArr* dstarr )
     const int IN_QUEUE = -2;
     const int WSHED = -1;
     const int NQ = 256;
-    cv::Ptr<CvMemStorage> storage;
 
     CvMat sstub, *src;
     CvMat dstub, *dst;
     CvSize size;
-    CvWSNode* free_node = 0, *node;
-    CvWSQueue q[NQ];
+    std::vector<cv::WSNode> storage;
+    int free_node = 0, node;
+    cv::WSQueue q[NQ];
     int active_queue;
     int i, j;
     int db, dg, dr;
@@ -102,32 +217,32 @@ cvWatershed( const CvArr* srcarr, CvArr* dstarr )
     // MIN(a,b) = a - MAX(a-b,0)
     #define ws_min(a,b) ((a) - subs_tab[(a)-(b)+NQ])
 
-    #define ws_push(idx,mofs,iofs)  \
-    {                               \
-        if( !free_node )            \
-            free_node = icvAllocWSNodes( storage );\
-        node = free_node;           \
-        free_node = free_node->next;\
-        node->next = 0;             \
-        node->mask_ofs = mofs;      \
-        node->img_ofs = iofs;       \
-        if( q[idx].last )           \
-            q[idx].last->next=node; \
-        else                        \
-            q[idx].first = node;    \
-        q[idx].last = node;         \
+    #define ws_push(idx,mofs,iofs)          \
+    {                                       \
+        if( !free_node )                    \
+            free_node = cv::allocWSNodes( storage );\
+        node = free_node;                   \
+        free_node = storage[free_node].next;\
+        storage[node].next = 0;             \
+        storage[node].mask_ofs = mofs;      \
+        storage[node].img_ofs = iofs;       \
+        if( q[idx].last )                   \
+            storage[q[idx].last].next=node; \
+        else                                \
+            q[idx].first = node;            \
+        q[idx].last = node;                 \
     }
 
-    #define ws_pop(idx,mofs,iofs)   \
-    {                               \
-        node = q[idx].first;        \
-        q[idx].first = node->next;  \
-        if( !node->next )           \
-            q[idx].last = 0;        \
-        node->next = free_node;     \
-        free_node = node;           \
-        mofs = node->mask_ofs;      \
-        iofs = node->img_ofs;       \
+    #define ws_pop(idx,mofs,iofs)           \
+    {                                       \
+        node = q[idx].first;                \
+        q[idx].first = storage[node].next;  \
+        if( !storage[node].next )           \
+            q[idx].last = 0;                \
+        storage[node].next = free_node;     \
+        free_node = node;                   \
+        mofs = storage[node].mask_ofs;      \
+        iofs = storage[node].img_ofs;       \
     }
 
     #define c_diff(ptr1,ptr2,diff)      \
@@ -154,15 +269,12 @@ cvWatershed( const CvArr* srcarr, CvArr* dstarr )
         CV_Error( CV_StsUnmatchedSizes, "The input and output images must have the same size" );
 
     size = cvGetMatSize(src);
-    storage = cvCreateMemStorage();
 
     istep = src->step;
     img = src->data.ptr;
     mstep = dst->step / sizeof(mask[0]);
     mask = dst->data.i;
 
-    memset( q, 0, NQ*sizeof(q[0]) );
-
     for( i = 0; i < 256; i++ )
         subs_tab[i] = 0;
     for( i = 256; i <= 512; i++ )
@@ -174,41 +286,22 @@ cvWatershed( const CvArr* srcarr, CvArr* dstarr )
 
     // initial phase: put all the neighbor pixels of each marker to the ordered queue -
     // determine the initial boundaries of the basins
-    for( i = 1; i < size.height-1; i++ )
+    if( size.height > 2 )
     {
-        img += istep; mask += mstep;
-        mask[0] = mask[size.width-1] = WSHED;
-
-        for( j = 1; j < size.width-1; j++ )
-        {
-            int* m = mask + j;
-            if( m[0] < 0 ) m[0] = 0;
-            if( m[0] == 0 && (m[-1] > 0 || m[1] > 0 || m[-mstep] > 0 || m[mstep] > 0) )
+        cv::Mat _src(src), _dst(dst);
+        int nstripes = std::max(std::min((size.height - 2)/32, cv::getNumThreads()*4), 1);
+        std::vector<std::vector<cv::WSSeed> > seeds(nstripes);
+        cv::parallel_for_( cv::Range(1, size.height - 1), cv::WatershedPrepareInvoker(_dst),
+                           (size.height - 2)*(double)size.width/(1 << 16) );
+        cv::parallel_for_( cv::Range(0, nstripes), cv::WatershedSeedsInvoker(_src, _dst, &seeds[0], nstripes) );
+
+        for( int k = 0; k < nstripes; k++ )
+            for( size_t l = 0; l < seeds[k].size(); l++ )
             {
-                uchar* ptr = img + j*3;
-                int idx = 256, t;
-                if( m[-1] > 0 )
-                    c_diff( ptr, ptr - 3, idx );
-                if( m[1] > 0 )
-                {
-                    c_diff( ptr, ptr + 3, t );
-                    idx = ws_min( idx, t );
-                }
-                if( m[-mstep] > 0 )
-                {
-                    c_diff( ptr, ptr - istep, t );
-                    idx = ws_min( idx, t );
-                }
-                if( m[mstep] > 0 )
-                {
-                    c_diff( ptr, ptr + istep, t );
-                    idx = ws_min( idx, t );
-                }
-                assert( 0 <= idx && idx <= 255 );
-                ws_push( idx, i*mstep + j, i*istep + j*3 );
-                m[0] = IN_QUEUE;
+                const cv::WSSeed& s = seeds[k][l];
+                mask[s.mask_ofs] = IN_QUEUE;
+                ws_push( s.idx, s.mask_ofs, s.img_ofs );
             }
-        }
     }
 
     // find the first non-empty queue
@@ -315,121 +408,39 @@ void cv::watershed( InputArray _src, InputOutputArray markers )
 *                                         Meanshift                                      *
 \****************************************************************************************/
 
-CV_IMPL void
-cvPyrMeanShiftFiltering( const CvArr* srcarr, CvArr* dstarr,
-                         double sp0, double sr, int max_level,
-                         CvTermCriteria termcrit )
+namespace cv
 {
-    const int cn = 3;
-    const int MAX_LEVELS = 8;
-
-    if( (unsigned)max_level > (unsigned)MAX_LEVELS )
-        CV_Error( CV_StsOutOfRange, "The number of pyramid levels is too large or negative" );
-
-    std::vector<cv::Mat> src_pyramid(max_level+1);
-    std::vector<cv::Mat> dst_pyramid(max_level+1);
-    cv::Mat mask0;
-    int i, j, level;
-    //uchar* submask = 0;
-
-    #define cdiff(ofs0) (tab[c0-dptr[ofs0]+255] + \
-        tab[c1-dptr[(ofs0)+1]+255] + tab[c2-dptr[(ofs0)+2]+255] >= isr22)
 
-    double sr2 = sr * sr;
-    int isr2 = cvRound(sr2), isr22 = MAX(isr2,16);
-    int tab[768];
-    cv::Mat src0 = cv::cvarrToMat(srcarr);
-    cv::Mat dst0 = cv::cvarrToMat(dstarr);
-
-    if( src0.type() != CV_8UC3 )
-        CV_Error( CV_StsUnsupportedFormat, "Only 8-bit, 3-channel images are supported" );
-
-    if( src0.type() != dst0.type() )
-        CV_Error( CV_StsUnmatchedFormats, "The input and output images must have the same type" );
-
-    if( src0.size() != dst0.size() )
-        CV_Error( CV_StsUnmatchedSizes, "The input and output images must have the same size" );
-
-    if( !(termcrit.type & CV_TERMCRIT_ITER) )
-        termcrit.max_iter = 5;
-    termcrit.max_iter = MAX(termcrit.max_iter,1);
-    termcrit.max_iter = MIN(termcrit.max_iter,100);
-    if( !(termcrit.type & CV_TERMCRIT_EPS) )
-        termcrit.epsilon = 1.f;
-    termcrit.epsilon = MAX(termcrit.epsilon, 0.f);
-
-    for( i = 0; i < 768; i++ )
-        tab[i] = (i - 255)*(i - 255);
-
-    // 1. construct pyramid
-    src_pyramid[0] = src0;
-    dst_pyramid[0] = dst0;
-    for( level = 1; level <= max_level; level++ )
+class MeanShiftFilterInvoker : public ParallelLoopBody
+{
+public:
+    MeanShiftFilterInvoker( const Mat& _src, const Mat& _src4, Mat& _dst, const uchar* _mask, int _mstep,
+                            float _sp, int _isr2, const int* _tab, const CvTermCriteria& _termcrit ) :
+        ParallelLoopBody(), src(&_src), src4(&_src4), dst(&_dst), mask(_mask), mstep(_mstep),
+        sp(_sp), isr2(_isr2), tab(_tab), termcrit(_termcrit)
     {
-        src_pyramid[level].create( (src_pyramid[level-1].rows+1)/2,
-                        (src_pyramid[level-1].cols+1)/2, src_pyramid[level-1].type() );
-        dst_pyramid[level].create( src_pyramid[level].rows,
-                        src_pyramid[level].cols, src_pyramid[level].type() );
-        cv::pyrDown( src_pyramid[level-1], src_pyramid[level], src_pyramid[level].size() );
-        //CV_CALL( cvResize( src_pyramid[level-1], src_pyramid[level], CV_INTER_AREA ));
     }
 
-    mask0.create(src0.rows, src0.cols, CV_8UC1);
-    //CV_CALL( submask = (uchar*)cvAlloc( (sp+2)*(sp+2) ));
-
-    // 2. apply meanshift, starting from the pyramid top (i.e. the smallest layer)
-    for( level = max_level; level >= 0; level-- )
+    virtual void operator() (const Range& range) const
     {
-        cv::Mat src = src_pyramid[level];
-        cv::Size size = src.size();
-        uchar* sptr = src.data;
-        int sstep = (int)src.step;
-        uchar* mask = 0;
-        int mstep = 0;
-        uchar* dptr;
-        int dstep;
-        float sp = (float)(sp0 / (1 << level));
-        sp = MAX( sp, 1 );
-
-        if( level < max_level )
+        Size size = src->size();
+        int sstep = (int)src->step;
+    #if CV_SSE2
+        bool useSIMD = !src4->empty();
+        __m128i z = _mm_setzero_si128(), visr2 = _mm_set1_epi32(isr2 + 1), v4 = _mm_set1_epi32(4);
+    #endif
+
+        for( int i = range.start; i < range.end; i++ )
         {
-            cv::Size size1 = dst_pyramid[level+1].size();
-            cv::Mat m( size.height, size.width, CV_8UC1, mask0.data );
-            dstep = (int)dst_pyramid[level+1].step;
-            dptr = dst_pyramid[level+1].data + dstep + cn;
-            mstep = (int)m.step;
-            mask = m.data + mstep;
-            //cvResize( dst_pyramid[level+1], dst_pyramid[level], CV_INTER_CUBIC );
-            cv::pyrUp( dst_pyramid[level+1], dst_pyramid[level], dst_pyramid[level].size() );
-            m.setTo(cv::Scalar::all(0));
+            const uchar* sptr = src->ptr<uchar>(i);
+            uchar* dptr = dst->ptr<uchar>(i);
 
-            for( i = 1; i < size1.height-1; i++, dptr += dstep - (size1.width-2)*3, mask += mstep*2 )
-            {
-                for( j = 1; j < size1.width-1; j++, dptr += cn )
-                {
-                    int c0 = dptr[0], c1 = dptr[1], c2 = dptr[2];
-                    mask[j*2 - 1] = cdiff(-3) || cdiff(3) || cdiff(-dstep-3) || cdiff(-dstep) ||
-                        cdiff(-dstep+3) || cdiff(dstep-3) || cdiff(dstep) || cdiff(dstep+3);
-                }
-            }
-
-            cv::dilate( m, m, cv::Mat() );
-            mask = m.data;
-        }
-
-        dptr = dst_pyramid[level].data;
-        dstep = (int)dst_pyramid[level].step;
-
-        for( i = 0; i < size.height; i++, sptr += sstep - size.width*3,
-                                          dptr += dstep - size.width*3,
-                                          mask += mstep )
-        {
-            for( j = 0; j < size.width; j++, sptr += 3, dptr += 3 )
+            for( int j = 0; j < size.width; j++, sptr += 3, dptr += 3 )
             {
                 int x0 = j, y0 = i, x1, y1, iter;
                 int c0, c1, c2;
 
-                if( mask && !mask[j] )
+                if( mask && !mask[i*mstep + j] )
                     continue;
 
                 c0 = sptr[0], c1 = sptr[1], c2 = sptr[2];
@@ -437,7 +448,7 @@ cvPyrMeanShiftFiltering( const CvArr* srcarr, CvArr* dstarr,
                 // iterate meanshift procedure
                 for( iter = 0; iter < termcrit.max_iter; iter++ )
                 {
-                    uchar* ptr;
+                    const uchar* ptr;
                     int x, y, count = 0;
                     int minx, miny, maxx, maxy;
                     int s0 = 0, s1 = 0, s2 = 0, sx = 0, sy = 0;
@@ -451,11 +462,47 @@ cvPyrMeanShiftFiltering( const CvArr* srcarr, CvArr* dstarr,
                     maxy = cvRound(y0 + sp); maxy = MIN(maxy, size.height-1);
                     ptr = sptr + (miny - i)*sstep + (minx - j)*3;
 
+                #if CV_SSE2
+                    __m128i vcount = z, vsx = z, vsy = z, vcolor = z;
+                    __m128i vc = _mm_setr_epi16((short)c0, (short)c1, (short)c2, 255,
+                                                (short)c0, (short)c1, (short)c2, 255);
+                #endif
+
                     for( y = miny; y <= maxy; y++, ptr += sstep - (maxx-minx+1)*3 )
                     {
                         int row_count = 0;
                         x = minx;
-                        #if CV_ENABLE_UNROLLED
+                    #if CV_SSE2
+                        if( useSIMD )
+                        {
+                            // 4 pixels at once, using the 4-channel copy of the image
+                            const uchar* ptr4 = src4->ptr<uchar>(y);
+                            __m128i vx = _mm_setr_epi32(x, x+1, x+2, x+3), vy = _mm_set1_epi32(y);
+                            for( ; x + 3 <= maxx; x += 4, ptr += 12 )
+                            {
+                                __m128i v = _mm_loadu_si128((const __m128i*)(ptr4 + x*4));
+                                __m128i lo = _mm_unpacklo_epi8(v, z), hi = _mm_unpackhi_epi8(v, z);
+                                __m128i dlo = _mm_sub_epi16(lo, vc), dhi = _mm_sub_epi16(hi, vc);
+                                dlo = _mm_madd_epi16(dlo, dlo);
+                                dhi = _mm_madd_epi16(dhi, dhi);
+                                dlo = _mm_add_epi32(dlo, _mm_srli_epi64(dlo, 32));
+                                dhi = _mm_add_epi32(dhi, _mm_srli_epi64(dhi, 32));
+                                __m128i d = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(dlo),
+                                                             _mm_castsi128_ps(dhi), _MM_SHUFFLE(2,0,2,0)));
+                                __m128i m = _mm_cmplt_epi32(d, visr2);
+
+                                vcount = _mm_sub_epi32(vcount, m);
+                                vsx = _mm_add_epi32(vsx, _mm_and_si128(vx, m));
+                                vsy = _mm_add_epi32(vsy, _mm_and_si128(vy, m));
+                                v = _mm_and_si128(v, m);
+                                lo = _mm_add_epi16(_mm_unpacklo_epi8(v, z), _mm_unpackhi_epi8(v, z));
+                                vcolor = _mm_add_epi32(vcolor, _mm_add_epi32(_mm_unpacklo_epi16(lo, z),
+                                                                             _mm_unpackhi_epi16(lo, z)));
+                                vx = _mm_add_epi32(vx, v4);
+                            }
+                        }
+                    #endif
+                    #if CV_ENABLE_UNROLLED
                         for( ; x + 3 <= maxx; x += 4, ptr += 12 )
                         {
                             int t0 = ptr[0], t1 = ptr[1], t2 = ptr[2];
@@ -483,7 +530,7 @@ cvPyrMeanShiftFiltering( const CvArr* srcarr, CvArr* dstarr,
                                 sx += x+3; row_count++;
                             }
                         }
-                        #endif
+                    #endif
                         for( ; x <= maxx; x++, ptr += 3 )
                         {
                             int t0 = ptr[0], t1 = ptr[1], t2 = ptr[2];
@@ -497,6 +544,21 @@ cvPyrMeanShiftFiltering( const CvArr* srcarr, CvArr* dstarr,
                         sy += y*row_count;
                     }
 
+                #if CV_SSE2
+                    if( useSIMD )
+                    {
+                        int CV_DECL_ALIGNED(16) buf[4*4];
+                        _mm_store_si128((__m128i*)buf, vcount);
+                        _mm_store_si128((__m128i*)(buf + 4), vsx);
+                        _mm_store_si128((__m128i*)(buf + 8), vsy);
+                        _mm_store_si128((__m128i*)(buf + 12), vcolor);
+                        count += buf[0] + buf[1] + buf[2] + buf[3];
+                        sx += buf[4] + buf[5] + buf[6] + buf[7];
+                        sy += buf[8] + buf[9] + buf[10] + buf[11];
+                        s0 += buf[12]; s1 += buf[13]; s2 += buf[14];
+                    }
+                #endif
+
                     if( count == 0 )
                         break;
 
@@ -507,7 +569,7 @@ cvPyrMeanShiftFiltering( const CvArr* srcarr, CvArr* dstarr,
                     s1 = cvRound(s1*icount);
                     s2 = cvRound(s2*icount);
 
-                    stop_flag = (x0 == x1 && y0 == y1) || abs(x1-x0) + abs(y1-y0) +
+                    stop_flag = (x0 == x1 && y0 == y1) || std::abs(x1-x0) + std::abs(y1-y0) +
                         tab[s0 - c0 + 255] + tab[s1 - c1 + 255] +
                         tab[s2 - c2 + 255] <= termcrit.epsilon;
 
@@ -524,6 +586,131 @@ cvPyrMeanShiftFiltering( const CvArr* srcarr, CvArr* dstarr,
             }
         }
     }
+
+private:
+    const Mat* src;
+    const Mat* src4;
+    Mat* dst;
+    const uchar* mask;
+    int mstep;
+    float sp;
+    int isr2;
+    const int* tab;
+    CvTermCriteria termcrit;
+};
+
+}
+
+CV_IMPL void
+cvPyrMeanShiftFiltering( const CvArr* srcarr, CvArr* dstarr,
+                         double sp0, double sr, int max_level,
+                         CvTermCriteria termcrit )
+{
+    const int cn = 3;
+    const int MAX_LEVELS = 8;
+
+    if( (unsigned)max_level > (unsigned)MAX_LEVELS )
+        CV_Error( CV_StsOutOfRange, "The number of pyramid levels is too large or negative" );
+
+    std::vector<cv::Mat> src_pyramid(max_level+1);
+    std::vector<cv::Mat> dst_pyramid(max_level+1);
+    cv::Mat mask0;
+    int i, j, level;
+    //uchar* submask = 0;
+
+    #define cdiff(ofs0) (tab[c0-dptr[ofs0]+255] + \
+        tab[c1-dptr[(ofs0)+1]+255] + tab[c2-dptr[(ofs0)+2]+255] >= isr22)
+
+    double sr2 = sr * sr;
+    int isr2 = cvRound(sr2), isr22 = MAX(isr2,16);
+    int tab[768];
+    cv::Mat src0 = cv::cvarrToMat(srcarr);
+    cv::Mat dst0 = cv::cvarrToMat(dstarr);
+
+    if( src0.type() != CV_8UC3 )
+        CV_Error( CV_StsUnsupportedFormat, "Only 8-bit, 3-channel images are supported" );
+
+    if( src0.type() != dst0.type() )
+        CV_Error( CV_StsUnmatchedFormats, "The input and output images must have the same type" );
+
+    if( src0.size() != dst0.size() )
+        CV_Error( CV_StsUnmatchedSizes, "The input and output images must have the same size" );
+
+    if( !(termcrit.type & CV_TERMCRIT_ITER) )
+        termcrit.max_iter = 5;
+    termcrit.max_iter = MAX(termcrit.max_iter,1);
+    termcrit.max_iter = MIN(termcrit.max_iter,100);
+    if( !(termcrit.type & CV_TERMCRIT_EPS) )
+        termcrit.epsilon = 1.f;
+    termcrit.epsilon = MAX(termcrit.epsilon, 0.f);
+
+    for( i = 0; i < 768; i++ )
+        tab[i] = (i - 255)*(i - 255);
+
+    // 1. construct pyramid
+    src_pyramid[0] = src0;
+    dst_pyramid[0] = dst0;
+    for( level = 1; level <= max_level; level++ )
+    {
+        src_pyramid[level].create( (src_pyramid[level-1].rows+1)/2,
+                        (src_pyramid[level-1].cols+1)/2, src_pyramid[level-1].type() );
+        dst_pyramid[level].create( src_pyramid[level].rows,
+                        src_pyramid[level].cols, src_pyramid[level].type() );
+        cv::pyrDown( src_pyramid[level-1], src_pyramid[level], src_pyramid[level].size() );
+        //CV_CALL( cvResize( src_pyramid[level-1], src_pyramid[level], CV_INTER_AREA ));
+    }
+
+    mask0.create(src0.rows, src0.cols, CV_8UC1);
+    //CV_CALL( submask = (uchar*)cvAlloc( (sp+2)*(sp+2) ));
+
+    // 2. apply meanshift, starting from the pyramid top (i.e. the smallest layer)
+    for( level = max_level; level >= 0; level-- )
+    {
+        cv::Mat src = src_pyramid[level];
+        cv::Size size = src.size();
+        uchar* mask = 0;
+        int mstep = 0;
+        uchar* dptr;
+        int dstep;
+        float sp = (float)(sp0 / (1 << level));
+        sp = MAX( sp, 1 );
+
+        if( level < max_level )
+        {
+            cv::Size size1 = dst_pyramid[level+1].size();
+            cv::Mat m( size.height, size.width, CV_8UC1, mask0.data );
+            dstep = (int)dst_pyramid[level+1].step;
+            dptr = dst_pyramid[level+1].data + dstep + cn;
+            mstep = (int)m.step;
+            mask = m.data + mstep;
+            //cvResize( dst_pyramid[level+1], dst_pyramid[level], CV_INTER_CUBIC );
+            cv::pyrUp( dst_pyramid[level+1], dst_pyramid[level], dst_pyramid[level].size() );
+            m.setTo(cv::Scalar::all(0));
+
+            for( i = 1; i < size1.height-1; i++, dptr += dstep - (size1.width-2)*3, mask += mstep*2 )
+            {
+                for( j = 1; j < size1.width-1; j++, dptr += cn )
+                {
+                    int c0 = dptr[0], c1 = dptr[1], c2 = dptr[2];
+                    mask[j*2 - 1] = cdiff(-3) || cdiff(3) || cdiff(-dstep-3) || cdiff(-dstep) ||
+                        cdiff(-dstep+3) || cdiff(dstep-3) || cdiff(dstep) || cdiff(dstep+3);
+                }
+            }
+
+            cv::dilate( m, m, cv::Mat() );
+            mask = m.data;
+        }
+
+        cv::Mat src4;
+    #if CV_SSE2
+        if( cv::checkHardwareSupport(CV_CPU_SSE2) )
+            cv::cvtColor( src, src4, CV_BGR2BGRA );
+    #endif
+
+        cv::parallel_for_( cv::Range(0, size.height),
+                           cv::MeanShiftFilterInvoker(src, src4, dst_pyramid[level], mask, mstep,
+                                                      sp, isr2, tab, termcrit) );
+    }
 }
 
 void cv::pyrMeanShiftFiltering( InputArray _src, OutputArray _dst,
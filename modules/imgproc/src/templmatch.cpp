@@ -44,74 +44,44 @@
 namespace cv
 {
 
-void crossCorr( const Mat& img, const Mat& _templ, Mat& corr,
-                Size corrsize, int ctype,
-                Point anchor, double delta, int borderType )
+static Size getCrossCorrBlockSize( Size corrsize, Size templsize, Size& dftsize )
 {
     const double blockScale = 4.5;
     const int minBlockSize = 256;
-    std::vector<uchar> buf;
-
-    Mat templ = _templ;
-    int depth = img.depth(), cn = img.channels();
-    int tdepth = templ.depth(), tcn = templ.channels();
-    int cdepth = CV_MAT_DEPTH(ctype), ccn = CV_MAT_CN(ctype);
-
-    CV_Assert( img.dims <= 2 && templ.dims <= 2 && corr.dims <= 2 );
-
-    if( depth != tdepth && tdepth != std::max(CV_32F, depth) )
-    {
-        _templ.convertTo(templ, std::max(CV_32F, depth));
-        tdepth = templ.depth();
-    }
-
-    CV_Assert( depth == tdepth || tdepth == CV_32F);
-    CV_Assert( corrsize.height <= img.rows + templ.rows - 1 &&
-               corrsize.width <= img.cols + templ.cols - 1 );
-
-    CV_Assert( ccn == 1 || delta == 0 );
+    Size blocksize;
 
-    corr.create(corrsize, ctype);
-
-    int maxDepth = depth > CV_8S ? CV_64F : std::max(std::max(CV_32F, tdepth), cdepth);
-    Size blocksize, dftsize;
+    blocksize.width = cvRound(templsize.width*blockScale);
+    blocksize.width = std::max( blocksize.width, minBlockSize - templsize.width + 1 );
+    blocksize.width = std::min( blocksize.width, corrsize.width );
+    blocksize.height = cvRound(templsize.height*blockScale);
+    blocksize.height = std::max( blocksize.height, minBlockSize - templsize.height + 1 );
+    blocksize.height = std::min( blocksize.height, corrsize.height );
 
-    blocksize.width = cvRound(templ.cols*blockScale);
-    blocksize.width = std::max( blocksize.width, minBlockSize - templ.cols + 1 );
-    blocksize.width = std::min( blocksize.width, corr.cols );
-    blocksize.height = cvRound(templ.rows*blockScale);
-    blocksize.height = std::max( blocksize.height, minBlockSize - templ.rows + 1 );
-    blocksize.height = std::min( blocksize.height, corr.rows );
-
-    dftsize.width = std::max(getOptimalDFTSize(blocksize.width + templ.cols - 1), 2);
-    dftsize.height = getOptimalDFTSize(blocksize.height + templ.rows - 1);
+    dftsize.width = std::max(getOptimalDFTSize(blocksize.width + templsize.width - 1), 2);
+    dftsize.height = getOptimalDFTSize(blocksize.height + templsize.height - 1);
     if( dftsize.width <= 0 || dftsize.height <= 0 )
         CV_Error( CV_StsOutOfRange, "the input arrays are too big" );
 
     // recompute block size
-    blocksize.width = dftsize.width - templ.cols + 1;
-    blocksize.width = MIN( blocksize.width, corr.cols );
-    blocksize.height = dftsize.height - templ.rows + 1;
-    blocksize.height = MIN( blocksize.height, corr.rows );
-
-    Mat dftTempl( dftsize.height*tcn, dftsize.width, maxDepth );
-    Mat dftImg( dftsize, maxDepth );
-
-    int i, k, bufSize = 0;
-    if( tcn > 1 && tdepth != maxDepth )
-        bufSize = templ.cols*templ.rows*CV_ELEM_SIZE(tdepth);
+    blocksize.width = dftsize.width - templsize.width + 1;
+    blocksize.width = MIN( blocksize.width, corrsize.width );
+    blocksize.height = dftsize.height - templsize.height + 1;
+    blocksize.height = MIN( blocksize.height, corrsize.height );
 
-    if( cn > 1 && depth != maxDepth )
-        bufSize = std::max( bufSize, (blocksize.width + templ.cols - 1)*
-            (blocksize.height + templ.rows - 1)*CV_ELEM_SIZE(depth));
+    return blocksize;
+}
 
-    if( (ccn > 1 || cn > 1) && cdepth != maxDepth )
-        bufSize = std::max( bufSize, blocksize.width*blocksize.height*CV_ELEM_SIZE(cdepth));
+// computes DFT of each template plane; the planes are stacked vertically
+static void computeTemplSpectrum( const Mat& templ, Mat& dftTempl, Size dftsize, int maxDepth )
+{
+    int tdepth = templ.depth(), tcn = templ.channels();
+    std::vector<uchar> buf;
 
-    buf.resize(bufSize);
+    dftTempl.create( dftsize.height*tcn, dftsize.width, maxDepth );
+    if( tcn > 1 && tdepth != maxDepth )
+        buf.resize(templ.cols*templ.rows*CV_ELEM_SIZE(tdepth));
 
-    // compute DFT of each template plane
-    for( k = 0; k < tcn; k++ )
+    for( int k = 0; k < tcn; k++ )
     {
         int yofs = k*dftsize.height;
         Mat src = templ;
@@ -135,6 +105,158 @@ void crossCorr( const Mat& img, const Mat& _templ, Mat& corr,
         }
         dft(dst, dst, 0, templ.rows);
     }
+}
+
+class CrossCorrInvoker : public ParallelLoopBody
+{
+public:
+    CrossCorrInvoker( const Mat& _img0, const Mat& _templ, const Mat& _dftTempl, Mat& _corr,
+                      Size _blocksize, Size _dftsize, Point _roiofs, Point _anchor,
+                      int _maxDepth, double _delta, int _borderType ) :
+        ParallelLoopBody(), img0(&_img0), templ(&_templ), dftTempl(&_dftTempl), corr(&_corr),
+        blocksize(_blocksize), dftsize(_dftsize), roiofs(_roiofs), anchor(_anchor),
+        maxDepth(_maxDepth), delta(_delta), borderType(_borderType)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        int depth = img0->depth(), cn = img0->channels();
+        int tcn = templ->channels();
+        int cdepth = corr->depth(), ccn = corr->channels();
+        int tileCountX = (corr->cols + blocksize.width - 1)/blocksize.width;
+        int i, k, bufSize = 0;
+
+        // every stripe owns its spectrum and conversion buffers,
+        // so the tiles can be processed independently
+        Mat dftImg( dftsize, maxDepth );
+        std::vector<uchar> buf;
+
+        if( cn > 1 && depth != maxDepth )
+            bufSize = (blocksize.width + templ->cols - 1)*
+                (blocksize.height + templ->rows - 1)*CV_ELEM_SIZE(depth);
+
+        if( (ccn > 1 || cn > 1) && cdepth != maxDepth )
+            bufSize = std::max( bufSize, blocksize.width*blocksize.height*CV_ELEM_SIZE(cdepth));
+
+        buf.resize(bufSize);
+
+        for( i = range.start; i < range.end; i++ )
+        {
+            int x = (i%tileCountX)*blocksize.width;
+            int y = (i/tileCountX)*blocksize.height;
+
+            Size bsz(std::min(blocksize.width, corr->cols - x),
+                     std::min(blocksize.height, corr->rows - y));
+            Size dsz(bsz.width + templ->cols - 1, bsz.height + templ->rows - 1);
+            int x0 = x - anchor.x + roiofs.x, y0 = y - anchor.y + roiofs.y;
+            int x1 = std::max(0, x0), y1 = std::max(0, y0);
+            int x2 = std::min(img0->cols, x0 + dsz.width);
+            int y2 = std::min(img0->rows, y0 + dsz.height);
+            Mat src0(*img0, Range(y1, y2), Range(x1, x2));
+            Mat dst(dftImg, Rect(0, 0, dsz.width, dsz.height));
+            Mat dst1(dftImg, Rect(x1-x0, y1-y0, x2-x1, y2-y1));
+            Mat cdst(*corr, Rect(x, y, bsz.width, bsz.height));
+
+            for( k = 0; k < cn; k++ )
+            {
+                Mat src = src0;
+                dftImg = Scalar::all(0);
+
+                if( cn > 1 )
+                {
+                    src = depth == maxDepth ? dst1 : Mat(y2-y1, x2-x1, depth, &buf[0]);
+                    int pairs[] = {k, 0};
+                    mixChannels(&src0, 1, &src, 1, pairs, 1);
+                }
+
+                if( dst1.data != src.data )
+                    src.convertTo(dst1, dst1.depth());
+
+                if( x2 - x1 < dsz.width || y2 - y1 < dsz.height )
+                    copyMakeBorder(dst1, dst, y1-y0, dst.rows-dst1.rows-(y1-y0),
+                                   x1-x0, dst.cols-dst1.cols-(x1-x0), borderType);
+
+                dft( dftImg, dftImg, 0, dsz.height );
+                Mat dftTempl1(*dftTempl, Rect(0, tcn > 1 ? k*dftsize.height : 0,
+                                              dftsize.width, dftsize.height));
+                mulSpectrums(dftImg, dftTempl1, dftImg, 0, true);
+                dft( dftImg, dftImg, DFT_INVERSE + DFT_SCALE, bsz.height );
+
+                src = dftImg(Rect(0, 0, bsz.width, bsz.height));
+
+                if( ccn > 1 )
+                {
+                    if( cdepth != maxDepth )
+                    {
+                        Mat plane(bsz, cdepth, &buf[0]);
+                        src.convertTo(plane, cdepth, 1, delta);
+                        src = plane;
+                    }
+                    int pairs[] = {0, k};
+                    mixChannels(&src, 1, &cdst, 1, pairs, 1);
+                }
+                else
+                {
+                    if( k == 0 )
+                        src.convertTo(cdst, cdepth, 1, delta);
+                    else
+                    {
+                        if( maxDepth != cdepth )
+                        {
+                            Mat plane(bsz, cdepth, &buf[0]);
+                            src.convertTo(plane, cdepth);
+                            src = plane;
+                        }
+                        add(src, cdst, cdst);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    const Mat* img0;
+    const Mat* templ;
+    const Mat* dftTempl;
+    Mat* corr;
+    Size blocksize, dftsize;
+    Point roiofs, anchor;
+    int maxDepth;
+    double delta;
+    int borderType;
+};
+
+void crossCorr( const Mat& img, const Mat& _templ, Mat& corr,
+                Size corrsize, int ctype,
+                Point anchor, double delta, int borderType )
+{
+    Mat templ = _templ;
+    int depth = img.depth();
+    int tdepth = templ.depth();
+    int cdepth = CV_MAT_DEPTH(ctype), ccn = CV_MAT_CN(ctype);
+
+    CV_Assert( img.dims <= 2 && templ.dims <= 2 && corr.dims <= 2 );
+
+    if( depth != tdepth && tdepth != std::max(CV_32F, depth) )
+    {
+        _templ.convertTo(templ, std::max(CV_32F, depth));
+        tdepth = templ.depth();
+    }
+
+    CV_Assert( depth == tdepth || tdepth == CV_32F);
+    CV_Assert( corrsize.height <= img.rows + templ.rows - 1 &&
+               corrsize.width <= img.cols + templ.cols - 1 );
+
+    CV_Assert( ccn == 1 || delta == 0 );
+
+    corr.create(corrsize, ctype);
+
+    int maxDepth = depth > CV_8S ? CV_64F : std::max(std::max(CV_32F, tdepth), cdepth);
+    Size dftsize, blocksize = getCrossCorrBlockSize(corr.size(), templ.size(), dftsize);
+
+    Mat dftTempl;
+    computeTemplSpectrum( templ, dftTempl, dftsize, maxDepth );
 
     int tileCountX = (corr.cols + blocksize.width - 1)/blocksize.width;
     int tileCountY = (corr.rows + blocksize.height - 1)/blocksize.height;
@@ -153,70 +275,234 @@ void crossCorr( const Mat& img, const Mat& _templ, Mat& corr,
     borderType |= BORDER_ISOLATED;
 
     // calculate correlation by blocks
-    for( i = 0; i < tileCount; i++ )
+    CrossCorrInvoker invoker(img0, templ, dftTempl, corr, blocksize, dftsize,
+                             roiofs, anchor, maxDepth, delta, borderType);
+    parallel_for_(Range(0, tileCount), invoker);
+}
+
+/*
+   Direct (spatial domain) correlation used by matchTemplate for small templates.
+   Every stripe of result rows converts the source rows it needs to float and
+   accumulates the products tap by tap into an interleaved row buffer,
+   which is then collapsed over the channels.
+*/
+class MatchTemplDirectInvoker : public ParallelLoopBody
+{
+public:
+    MatchTemplDirectInvoker( const Mat& _img, const Mat& _templ, Mat& _result ) :
+        ParallelLoopBody(), img(&_img), templ(&_templ), result(&_result)
     {
-        int x = (i%tileCountX)*blocksize.width;
-        int y = (i/tileCountX)*blocksize.height;
-
-        Size bsz(std::min(blocksize.width, corr.cols - x),
-                 std::min(blocksize.height, corr.rows - y));
-        Size dsz(bsz.width + templ.cols - 1, bsz.height + templ.rows - 1);
-        int x0 = x - anchor.x + roiofs.x, y0 = y - anchor.y + roiofs.y;
-        int x1 = std::max(0, x0), y1 = std::max(0, y0);
-        int x2 = std::min(img0.cols, x0 + dsz.width);
-        int y2 = std::min(img0.rows, y0 + dsz.height);
-        Mat src0(img0, Range(y1, y2), Range(x1, x2));
-        Mat dst(dftImg, Rect(0, 0, dsz.width, dsz.height));
-        Mat dst1(dftImg, Rect(x1-x0, y1-y0, x2-x1, y2-y1));
-        Mat cdst(corr, Rect(x, y, bsz.width, bsz.height));
-
-        for( k = 0; k < cn; k++ )
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        int cn = img->channels();
+        int tcols = templ->cols, trows = templ->rows;
+        int width = result->cols*cn;
+        int i, j, k, tx, ty;
+
+        Mat srcRows = img->rowRange(range.start, range.end + trows - 1), fsrc;
+        if( srcRows.depth() == CV_32F )
+            fsrc = srcRows;
+        else
+            srcRows.convertTo(fsrc, CV_32F);
+
+        AutoBuffer<float> _acc(width + 16);
+        float* acc = _acc;
+
+        // the template taps of one column, replicated to a period divisible by 4
+        int patlen = cn == 3 ? 12 : 4;
+        float CV_DECL_ALIGNED(16) wpat[12];
+
+    #if CV_SSE
+        bool haveSSE = checkHardwareSupport(CV_CPU_SSE);
+    #endif
+
+        for( i = range.start; i < range.end; i++ )
         {
-            Mat src = src0;
-            dftImg = Scalar::all(0);
+            memset(acc, 0, width*sizeof(acc[0]));
 
-            if( cn > 1 )
+            for( ty = 0; ty < trows; ty++ )
             {
-                src = depth == maxDepth ? dst1 : Mat(y2-y1, x2-x1, depth, &buf[0]);
-                int pairs[] = {k, 0};
-                mixChannels(&src0, 1, &src, 1, pairs, 1);
+                const float* srow = fsrc.ptr<float>(i - range.start + ty);
+                const float* trow = templ->ptr<float>(ty);
+
+                for( tx = 0; tx < tcols; tx++ )
+                {
+                    const float* s = srow + tx*cn;
+                    const float* w = trow + tx*cn;
+                    for( k = 0; k < patlen; k++ )
+                        wpat[k] = w[k % cn];
+                    j = 0;
+
+                #if CV_SSE
+                    if( haveSSE )
+                    {
+                        if( cn == 3 )
+                        {
+                            __m128 w0 = _mm_load_ps(wpat), w1 = _mm_load_ps(wpat + 4),
+                                   w2 = _mm_load_ps(wpat + 8);
+                            for( ; j <= width - 12; j += 12 )
+                            {
+                                __m128 a0 = _mm_loadu_ps(acc + j), a1 = _mm_loadu_ps(acc + j + 4),
+                                       a2 = _mm_loadu_ps(acc + j + 8);
+                                a0 = _mm_add_ps(a0, _mm_mul_ps(w0, _mm_loadu_ps(s + j)));
+                                a1 = _mm_add_ps(a1, _mm_mul_ps(w1, _mm_loadu_ps(s + j + 4)));
+                                a2 = _mm_add_ps(a2, _mm_mul_ps(w2, _mm_loadu_ps(s + j + 8)));
+                                _mm_storeu_ps(acc + j, a0);
+                                _mm_storeu_ps(acc + j + 4, a1);
+                                _mm_storeu_ps(acc + j + 8, a2);
+                            }
+                        }
+                        else
+                        {
+                            __m128 w0 = _mm_load_ps(wpat);
+                            for( ; j <= width - 8; j += 8 )
+                            {
+                                __m128 a0 = _mm_loadu_ps(acc + j), a1 = _mm_loadu_ps(acc + j + 4);
+                                a0 = _mm_add_ps(a0, _mm_mul_ps(w0, _mm_loadu_ps(s + j)));
+                                a1 = _mm_add_ps(a1, _mm_mul_ps(w0, _mm_loadu_ps(s + j + 4)));
+                                _mm_storeu_ps(acc + j, a0);
+                                _mm_storeu_ps(acc + j + 4, a1);
+                            }
+                        }
+                    }
+                #endif
+                    for( ; j <= width - patlen; j += patlen )
+                        for( k = 0; k < patlen; k++ )
+                            acc[j + k] += wpat[k]*s[j + k];
+                    for( k = 0; j < width; j++, k++ )
+                        acc[j] += wpat[k]*s[j];
+                }
             }
 
-            if( dst1.data != src.data )
-                src.convertTo(dst1, dst1.depth());
+            float* rrow = result->ptr<float>(i);
+            if( cn == 1 )
+                memcpy(rrow, acc, width*sizeof(rrow[0]));
+            else
+                for( j = 0; j < result->cols; j++ )
+                {
+                    float t = acc[j*cn];
+                    for( k = 1; k < cn; k++ )
+                        t += acc[j*cn + k];
+                    rrow[j] = t;
+                }
+        }
+    }
 
-            if( x2 - x1 < dsz.width || y2 - y1 < dsz.height )
-                copyMakeBorder(dst1, dst, y1-y0, dst.rows-dst1.rows-(y1-y0),
-                               x1-x0, dst.cols-dst1.cols-(x1-x0), borderType);
+private:
+    const Mat* img;
+    const Mat* templ;
+    Mat* result;
+};
+
+/*
+   Cross-correlation of one image with a set of templates of the same size and type.
+   The spectrum of every image tile is computed only once and then reused by all
+   the templates. The rest is done exactly as in crossCorr, i.e. every channel product
+   is transformed back and the channels are summed in the spatial domain, so each
+   template gets the same correlation as from matchTemplate.
+*/
+class CrossCorrImgSpectrumInvoker : public ParallelLoopBody
+{
+public:
+    CrossCorrImgSpectrumInvoker( const Mat& _img, Mat& _dftImg, Size _corrsize,
+                                 Size _templsize, Size _blocksize, Size _dftsize ) :
+        ParallelLoopBody(), img(&_img), dftImg(&_dftImg), corrsize(_corrsize),
+        templsize(_templsize), blocksize(_blocksize), dftsize(_dftsize)
+    {
+    }
 
-            dft( dftImg, dftImg, 0, dsz.height );
-            Mat dftTempl1(dftTempl, Rect(0, tcn > 1 ? k*dftsize.height : 0,
-                                         dftsize.width, dftsize.height));
-            mulSpectrums(dftImg, dftTempl1, dftImg, 0, true);
-            dft( dftImg, dftImg, DFT_INVERSE + DFT_SCALE, bsz.height );
+    virtual void operator() (const Range& range) const
+    {
+        int cn = img->channels();
+        int tileCountX = (corrsize.width + blocksize.width - 1)/blocksize.width;
 
-            src = dftImg(Rect(0, 0, bsz.width, bsz.height));
+        for( int i = range.start; i < range.end; i++ )
+        {
+            int x = (i%tileCountX)*blocksize.width;
+            int y = (i/tileCountX)*blocksize.height;
+            Size dsz(std::min(blocksize.width, corrsize.width - x) + templsize.width - 1,
+                     std::min(blocksize.height, corrsize.height - y) + templsize.height - 1);
+            Mat src0(*img, Rect(x, y, dsz.width, dsz.height));
 
-            if( ccn > 1 )
+            for( int k = 0; k < cn; k++ )
             {
-                if( cdepth != maxDepth )
+                Mat dst(*dftImg, Rect(0, (i*cn + k)*dftsize.height, dftsize.width, dftsize.height));
+                Mat dst1(dst, Rect(0, 0, dsz.width, dsz.height));
+                dst = Scalar::all(0);
+
+                if( cn > 1 )
                 {
-                    Mat plane(bsz, cdepth, &buf[0]);
-                    src.convertTo(plane, cdepth, 1, delta);
-                    src = plane;
+                    int pairs[] = {k, 0};
+                    if( src0.depth() == dst.depth() )
+                        mixChannels(&src0, 1, &dst1, 1, pairs, 1);
+                    else
+                    {
+                        Mat plane(dsz, src0.depth());
+                        mixChannels(&src0, 1, &plane, 1, pairs, 1);
+                        plane.convertTo(dst1, dst1.depth());
+                    }
                 }
-                int pairs[] = {0, k};
-                mixChannels(&src, 1, &cdst, 1, pairs, 1);
+                else
+                    src0.convertTo(dst1, dst1.depth());
+
+                dft( dst, dst, 0, dsz.height );
             }
-            else
+        }
+    }
+
+private:
+    const Mat* img;
+    Mat* dftImg;
+    Size corrsize, templsize, blocksize, dftsize;
+};
+
+class CrossCorrBatchInvoker : public ParallelLoopBody
+{
+public:
+    CrossCorrBatchInvoker( const Mat& _dftImg, const std::vector<Mat>& _dftTempls,
+                           std::vector<Mat>& _corrs, int _cn, Size _templsize,
+                           Size _blocksize, Size _dftsize ) :
+        ParallelLoopBody(), dftImg(&_dftImg), dftTempls(&_dftTempls), corrs(&_corrs),
+        cn(_cn), templsize(_templsize), blocksize(_blocksize), dftsize(_dftsize)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        Size corrsize = (*corrs)[0].size();
+        int tileCountX = (corrsize.width + blocksize.width - 1)/blocksize.width;
+        int tileCountY = (corrsize.height + blocksize.height - 1)/blocksize.height;
+        int tileCount = tileCountX*tileCountY;
+        int cdepth = (*corrs)[0].depth();
+        Mat dftProd( dftsize, dftImg->type() ), plane;
+
+        for( int idx = range.start; idx < range.end; idx++ )
+        {
+            int t = idx / tileCount, i = idx % tileCount;
+            int x = (i%tileCountX)*blocksize.width;
+            int y = (i/tileCountX)*blocksize.height;
+            Size bsz(std::min(blocksize.width, corrsize.width - x),
+                     std::min(blocksize.height, corrsize.height - y));
+            const Mat& dftTempl = (*dftTempls)[t];
+
+            Mat cdst((*corrs)[t], Rect(x, y, bsz.width, bsz.height));
+
+            for( int k = 0; k < cn; k++ )
             {
+                Mat dftImg1(*dftImg, Rect(0, (i*cn + k)*dftsize.height, dftsize.width, dftsize.height));
+                Mat dftTempl1(dftTempl, Rect(0, k*dftsize.height, dftsize.width, dftsize.height));
+                mulSpectrums(dftImg1, dftTempl1, dftProd, 0, true);
+                dft( dftProd, dftProd, DFT_INVERSE + DFT_SCALE, bsz.height );
+
+                Mat src = dftProd(Rect(0, 0, bsz.width, bsz.height));
                 if( k == 0 )
-                    src.convertTo(cdst, cdepth, 1, delta);
+                    src.convertTo(cdst, cdepth);
                 else
                 {
-                    if( maxDepth != cdepth )
+                    if( src.depth() != cdepth )
                     {
-                        Mat plane(bsz, cdepth, &buf[0]);
                         src.convertTo(plane, cdepth);
                         src = plane;
                     }
@@ -225,61 +511,118 @@ void crossCorr( const Mat& img, const Mat& _templ, Mat& corr,
             }
         }
     }
-}
-
-}
 
-/*****************************************************************************************/
+private:
+    const Mat* dftImg;
+    const std::vector<Mat>* dftTempls;
+    std::vector<Mat>* corrs;
+    int cn;
+    Size templsize, blocksize, dftsize;
+};
 
-void cv::matchTemplate( InputArray _img, InputArray _templ, OutputArray _result, int method )
+class TemplSpectrumInvoker : public ParallelLoopBody
 {
-    CV_Assert( CV_TM_SQDIFF <= method && method <= CV_TM_CCOEFF_NORMED );
-
-    int numType = method == CV_TM_CCORR || method == CV_TM_CCORR_NORMED ? 0 :
-                  method == CV_TM_CCOEFF || method == CV_TM_CCOEFF_NORMED ? 1 : 2;
-    bool isNormed = method == CV_TM_CCORR_NORMED ||
-                    method == CV_TM_SQDIFF_NORMED ||
-                    method == CV_TM_CCOEFF_NORMED;
-
-    Mat img = _img.getMat(), templ = _templ.getMat();
-    if( img.rows < templ.rows || img.cols < templ.cols )
-        std::swap(img, templ);
+public:
+    TemplSpectrumInvoker( const std::vector<Mat>& _templs, std::vector<Mat>& _dftTempls,
+                          Size _dftsize, int _maxDepth ) :
+        ParallelLoopBody(), templs(&_templs), dftTempls(&_dftTempls),
+        dftsize(_dftsize), maxDepth(_maxDepth)
+    {
+    }
 
-    CV_Assert( (img.depth() == CV_8U || img.depth() == CV_32F) &&
-               img.type() == templ.type() );
+    virtual void operator() (const Range& range) const
+    {
+        for( int t = range.start; t < range.end; t++ )
+            computeTemplSpectrum( (*templs)[t], (*dftTempls)[t], dftsize, maxDepth );
+    }
 
-    CV_Assert( img.rows >= templ.rows && img.cols >= templ.cols);
+private:
+    const std::vector<Mat>* templs;
+    std::vector<Mat>* dftTempls;
+    Size dftsize;
+    int maxDepth;
+};
 
-    Size corrSize(img.cols - templ.cols + 1, img.rows - templ.rows + 1);
-    _result.create(corrSize, CV_32F);
-    Mat result = _result.getMat();
+static void crossCorrBatch( const Mat& img, const std::vector<Mat>& templs, std::vector<Mat>& corrs )
+{
+    Size templsize = templs[0].size(), corrsize = corrs[0].size();
+    int cn = img.channels(), ntempl = (int)templs.size();
+    int maxDepth = img.depth() > CV_8S ? CV_64F : CV_32F;
+    Size dftsize, blocksize = getCrossCorrBlockSize(corrsize, templsize, dftsize);
+    int tileCount = ((corrsize.width + blocksize.width - 1)/blocksize.width)*
+                    ((corrsize.height + blocksize.height - 1)/blocksize.height);
+
+    std::vector<Mat> dftTempls(ntempl);
+    parallel_for_(Range(0, ntempl), TemplSpectrumInvoker(templs, dftTempls, dftsize, maxDepth));
+
+    Mat dftImg( tileCount*cn*dftsize.height, dftsize.width, maxDepth );
+    parallel_for_(Range(0, tileCount), CrossCorrImgSpectrumInvoker(img, dftImg, corrsize,
+                                                                   templsize, blocksize, dftsize));
+
+    parallel_for_(Range(0, ntempl*tileCount), CrossCorrBatchInvoker(dftImg, dftTempls, corrs, cn,
+                                                                    templsize, blocksize, dftsize));
+}
 
-#ifdef HAVE_TEGRA_OPTIMIZATION
-    if (tegra::matchTemplate(img, templ, result, method))
-        return;
+/*
+   Chooses between the direct and the DFT-based correlation by comparing
+   the rough operation counts of both. The direct method does templ.area()*cn
+   (vectorized) multiply-adds per output pixel; the DFT method performs
+   the forward and the inverse transforms of every image tile for each channel.
+*/
+static bool useDirectCorr( Size corrsize, Size templsize, int cn )
+{
+    if( cn > 4 || templsize.area() > 32*32 )
+        return false;
+
+    Size dftsize, blocksize = getCrossCorrBlockSize(corrsize, templsize, dftsize);
+    int tileCount = ((corrsize.width + blocksize.width - 1)/blocksize.width)*
+                    ((corrsize.height + blocksize.height - 1)/blocksize.height);
+    double dftArea = (double)dftsize.area();
+    double dftCost = 2.*tileCount*cn*dftArea*std::log(dftArea)/std::log(2.);
+    double directCost = (double)corrsize.area()*templsize.area()*cn;
+
+#if CV_SSE
+    if( checkHardwareSupport(CV_CPU_SSE) )
+        directCost *= 0.25;
 #endif
 
-    int cn = img.channels();
-    crossCorr( img, templ, result, result.size(), result.type(), Point(0,0), 0, 0);
+    return directCost < dftCost;
+}
 
-    if( method == CV_TM_CCORR )
-        return;
+static void matchTemplDirect( const Mat& img, const Mat& templ, Mat& result )
+{
+    Mat ftempl = templ;
+    if( templ.depth() != CV_32F )
+        templ.convertTo(ftempl, CV_32F);
+
+    MatchTemplDirectInvoker invoker(img, ftempl, result);
+    parallel_for_(Range(0, result.rows), invoker,
+                  std::max(1., (double)result.total()*templ.total()*templ.channels()/(1 << 16)));
+}
 
+// converts the raw cross-correlation into the requested measure using the integrals of the image
+static void normalizeTemplMatch( const Mat& sum, const Mat& sqsum, const Mat& templ,
+                                 Mat& result, int method )
+{
+    int cn = templ.channels();
     double invArea = 1./((double)templ.rows * templ.cols);
 
-    Mat sum, sqsum;
+    int numType = method == CV_TM_CCORR || method == CV_TM_CCORR_NORMED ? 0 :
+                  method == CV_TM_CCOEFF || method == CV_TM_CCOEFF_NORMED ? 1 : 2;
+    bool isNormed = method == CV_TM_CCORR_NORMED ||
+                    method == CV_TM_SQDIFF_NORMED ||
+                    method == CV_TM_CCOEFF_NORMED;
+
     Scalar templMean, templSdv;
     double *q0 = 0, *q1 = 0, *q2 = 0, *q3 = 0;
     double templNorm = 0, templSum2 = 0;
 
     if( method == CV_TM_CCOEFF )
     {
-        integral(img, sum, CV_64F);
         templMean = mean(templ);
     }
     else
     {
-        integral(img, sum, sqsum, CV_64F);
         meanStdDev( templ, templMean, templSdv );
 
         templNorm = CV_SQR(templSdv[0]) + CV_SQR(templSdv[1]) +
@@ -375,6 +718,128 @@ void cv::matchTemplate( InputArray _img, InputArray _templ, OutputArray _result,
     }
 }
 
+static void computeTemplMatchIntegrals( const Mat& img, int method, Mat& sum, Mat& sqsum )
+{
+    if( method == CV_TM_CCORR )
+        return;
+    if( method == CV_TM_CCOEFF )
+        integral(img, sum, CV_64F);
+    else
+        integral(img, sum, sqsum, CV_64F);
+}
+
+class NormalizeTemplMatchInvoker : public ParallelLoopBody
+{
+public:
+    NormalizeTemplMatchInvoker( const Mat& _sum, const Mat& _sqsum, const std::vector<Mat>& _templs,
+                                std::vector<Mat>& _results, int _method ) :
+        ParallelLoopBody(), sum(&_sum), sqsum(&_sqsum), templs(&_templs),
+        results(&_results), method(_method)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        for( int t = range.start; t < range.end; t++ )
+            normalizeTemplMatch( *sum, *sqsum, (*templs)[t], (*results)[t], method );
+    }
+
+private:
+    const Mat* sum;
+    const Mat* sqsum;
+    const std::vector<Mat>* templs;
+    std::vector<Mat>* results;
+    int method;
+};
+
+}
+
+/*****************************************************************************************/
+
+void cv::matchTemplate( InputArray _img, InputArray _templ, OutputArray _result, int method )
+{
+    CV_Assert( CV_TM_SQDIFF <= method && method <= CV_TM_CCOEFF_NORMED );
+
+    Mat img = _img.getMat(), templ = _templ.getMat();
+    if( img.rows < templ.rows || img.cols < templ.cols )
+        std::swap(img, templ);
+
+    CV_Assert( (img.depth() == CV_8U || img.depth() == CV_32F) &&
+               img.type() == templ.type() );
+
+    CV_Assert( img.rows >= templ.rows && img.cols >= templ.cols);
+
+    Size corrSize(img.cols - templ.cols + 1, img.rows - templ.rows + 1);
+    _result.create(corrSize, CV_32F);
+    Mat result = _result.getMat();
+
+#ifdef HAVE_TEGRA_OPTIMIZATION
+    if (tegra::matchTemplate(img, templ, result, method))
+        return;
+#endif
+
+    int cn = img.channels();
+    if( useDirectCorr(corrSize, templ.size(), cn) )
+        matchTemplDirect( img, templ, result );
+    else
+        crossCorr( img, templ, result, result.size(), result.type(), Point(0,0), 0, 0);
+
+    if( method == CV_TM_CCORR )
+        return;
+
+    Mat sum, sqsum;
+    computeTemplMatchIntegrals( img, method, sum, sqsum );
+    normalizeTemplMatch( sum, sqsum, templ, result, method );
+}
+
+void cv::matchTemplates( InputArray _img, InputArrayOfArrays _templs,
+                         OutputArrayOfArrays _results, int method )
+{
+    CV_Assert( CV_TM_SQDIFF <= method && method <= CV_TM_CCOEFF_NORMED );
+
+    Mat img = _img.getMat();
+    std::vector<Mat> templs;
+    _templs.getMatVector(templs);
+
+    int t, ntempl = (int)templs.size();
+    if( ntempl == 0 )
+    {
+        _results.release();
+        return;
+    }
+
+    Size templSize = templs[0].size();
+    CV_Assert( img.depth() == CV_8U || img.depth() == CV_32F );
+    for( t = 0; t < ntempl; t++ )
+        CV_Assert( templs[t].type() == img.type() && templs[t].size() == templSize );
+    CV_Assert( img.rows >= templSize.height && img.cols >= templSize.width );
+
+    Size corrSize(img.cols - templSize.width + 1, img.rows - templSize.height + 1);
+    std::vector<Mat> results(ntempl);
+    _results.create(ntempl, 1, CV_32F);
+    for( t = 0; t < ntempl; t++ )
+    {
+        _results.create(corrSize, CV_32F, t);
+        results[t] = _results.getMat(t);
+    }
+
+    // the method is chosen as for a single template, so that the results are the same
+    int cn = img.channels();
+    if( useDirectCorr(corrSize, templSize, cn) )
+    {
+        for( t = 0; t < ntempl; t++ )
+            matchTemplDirect( img, templs[t], results[t] );
+    }
+    else
+        crossCorrBatch( img, templs, results );
+
+    if( method == CV_TM_CCORR )
+        return;
+
+    Mat sum, sqsum;
+    computeTemplMatchIntegrals( img, method, sum, sqsum );
+    parallel_for_(Range(0, ntempl), NormalizeTemplMatchInvoker(sum, sqsum, templs, results, method));
+}
 
 CV_IMPL void
 cvMatchTemplate( const CvArr* _img, const CvArr* _templ, CvArr* _result, int method )
@@ -600,33 +600,63 @@ thresh_32f( const Mat& _src, Mat& _dst, float thresh, float maxval, int type )
 }
 
 
+class OtsuHistInvoker : public ParallelLoopBody
+{
+public:
+    OtsuHistInvoker(const Mat& _src, int _nstripes, int* _hists)
+        : src(_src), nstripes(_nstripes), hists(_hists) {}
+
+    void operator () ( const Range& range ) const
+    {
+        Size size = src.size();
+        for( int s = range.start; s < range.end; s++ )
+        {
+            int* h = hists + s*256;
+            int y0 = s*size.height/nstripes, y1 = (s + 1)*size.height/nstripes;
+            for( int i = y0; i < y1; i++ )
+            {
+                const uchar* sptr = src.data + src.step*i;
+                int j = 0;
+                #if CV_ENABLE_UNROLLED
+                for( ; j <= size.width - 4; j += 4 )
+                {
+                    int v0 = sptr[j], v1 = sptr[j+1];
+                    h[v0]++; h[v1]++;
+                    v0 = sptr[j+2]; v1 = sptr[j+3];
+                    h[v0]++; h[v1]++;
+                }
+                #endif
+                for( ; j < size.width; j++ )
+                    h[sptr[j]]++;
+            }
+        }
+    }
+
+private:
+    Mat src;
+    int nstripes;
+    int* hists;
+};
+
 static double
 getThreshVal_Otsu_8u( const Mat& _src )
 {
     Size size = _src.size();
-    if( _src.isContinuous() )
-    {
-        size.width *= size.height;
-        size.height = 1;
-    }
     const int N = 256;
     int i, j, h[N] = {0};
-    for( i = 0; i < size.height; i++ )
-    {
-        const uchar* src = _src.data + _src.step*i;
-        j = 0;
-        #if CV_ENABLE_UNROLLED
-        for( ; j <= size.width - 4; j += 4 )
-        {
-            int v0 = src[j], v1 = src[j+1];
-            h[v0]++; h[v1]++;
-            v0 = src[j+2]; v1 = src[j+3];
-            h[v0]++; h[v1]++;
-        }
-        #endif
-        for( ; j < size.width; j++ )
-            h[src[j]]++;
-    }
+
+    // the histogram is collected per horizontal stripe and then summed up,
+    // so the result does not depend on the number of threads
+    int nstripes = std::max(std::min(std::min(size.height, 64), (int)(size.area() >> 16)), 1);
+    std::vector<int> _hists(nstripes*N, 0);
+    if( nstripes > 1 )
+        parallel_for_(Range(0, nstripes), OtsuHistInvoker(_src, nstripes, &_hists[0]));
+    else
+        OtsuHistInvoker(_src, nstripes, &_hists[0])(Range(0, 1));
+
+    for( i = 0; i < nstripes; i++ )
+        for( j = 0; j < N; j++ )
+            h[j] += _hists[i*N + j];
 
     double mu = 0, scale = 1./(size.width*size.height);
     for( i = 0; i < N; i++ )
@@ -706,6 +736,74 @@ private:
     int thresholdType;
 };
 
+class AdaptiveThresholdInvoker : public ParallelLoopBody
+{
+public:
+    AdaptiveThresholdInvoker(const Mat& _src, Mat& _dst, uchar _imaxval, int _method, int _type,
+                             int _blockSize, int _idelta, int _bandRows)
+        : src(_src), dst(_dst), imaxval(_imaxval), method(_method), type(_type),
+          blockSize(_blockSize), idelta(_idelta), bandRows(_bandRows)
+    {
+        if( type == THRESH_BINARY )
+            for( int i = 0; i < 768; i++ )
+                tab[i] = (uchar)(i - 255 > -idelta ? imaxval : 0);
+        else
+            for( int i = 0; i < 768; i++ )
+                tab[i] = (uchar)(i - 255 <= -idelta ? imaxval : 0);
+    }
+
+    void operator () ( const Range& range ) const
+    {
+        int y0 = range.start*bandRows, y1 = std::min(range.end*bandRows, src.rows);
+        Mat srcBand = src.rowRange(y0, y1), mean;
+
+        if( method == ADAPTIVE_THRESH_MEAN_C )
+            boxFilter( srcBand, mean, src.type(), Size(blockSize, blockSize),
+                       Point(-1,-1), true, BORDER_REPLICATE );
+        else
+            GaussianBlur( srcBand, mean, Size(blockSize, blockSize), 0, 0, BORDER_REPLICATE );
+
+        int width = src.cols;
+    #if CV_SSE2
+        bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
+        // (s - m > -idelta) for BINARY, the negation of it for BINARY_INV; s - m is in [-255, 255]
+        __m128i thresh16 = _mm_set1_epi16((short)std::min(std::max(-idelta, -256), 256));
+        __m128i maxval8 = _mm_set1_epi8((char)imaxval), z = _mm_setzero_si128();
+    #endif
+
+        for( int i = y0; i < y1; i++ )
+        {
+            const uchar* sdata = src.ptr<uchar>(i);
+            const uchar* mdata = mean.ptr<uchar>(i - y0);
+            uchar* ddata = dst.data + dst.step*i;
+            int j = 0;
+
+        #if CV_SSE2
+            if( useSIMD )
+                for( ; j <= width - 16; j += 16 )
+                {
+                    __m128i s8 = _mm_loadu_si128((const __m128i*)(sdata + j));
+                    __m128i m8 = _mm_loadu_si128((const __m128i*)(mdata + j));
+                    __m128i d0 = _mm_sub_epi16(_mm_unpacklo_epi8(s8, z), _mm_unpacklo_epi8(m8, z));
+                    __m128i d1 = _mm_sub_epi16(_mm_unpackhi_epi8(s8, z), _mm_unpackhi_epi8(m8, z));
+                    __m128i mask = _mm_packs_epi16(_mm_cmpgt_epi16(d0, thresh16), _mm_cmpgt_epi16(d1, thresh16));
+                    __m128i r = type == THRESH_BINARY ? _mm_and_si128(mask, maxval8) : _mm_andnot_si128(mask, maxval8);
+                    _mm_storeu_si128((__m128i*)(ddata + j), r);
+                }
+        #endif
+            for( ; j < width; j++ )
+                ddata[j] = tab[sdata[j] - mdata[j] + 255];
+        }
+    }
+
+private:
+    Mat src;
+    Mat dst;
+    uchar imaxval;
+    int method, type, blockSize, idelta, bandRows;
+    uchar tab[768];
+};
+
 }
 
 double cv::threshold( InputArray _src, OutputArray _dst, double thresh, double maxval, int type )
@@ -806,48 +904,33 @@ void cv::adaptiveThreshold( InputArray _src, OutputArray _dst, double maxValue,
         return;
     }
 
-    Mat mean;
-
-    if( src.data != dst.data )
-        mean = dst;
-
-    if( method == ADAPTIVE_THRESH_MEAN_C )
-        boxFilter( src, mean, src.type(), Size(blockSize, blockSize),
-                   Point(-1,-1), true, BORDER_REPLICATE );
-    else if( method == ADAPTIVE_THRESH_GAUSSIAN_C )
-        GaussianBlur( src, mean, Size(blockSize, blockSize), 0, 0, BORDER_REPLICATE );
-    else
+    // the local mean is computed and thresholded band by band, so that the mean rows stay in cache;
+    // the filters take the rows outside of each band from the source image itself,
+    // which makes the result identical to filtering the whole image at once
+    if( method != ADAPTIVE_THRESH_MEAN_C && method != ADAPTIVE_THRESH_GAUSSIAN_C )
         CV_Error( CV_StsBadFlag, "Unknown/unsupported adaptive threshold method" );
-
-    int i, j;
-    uchar imaxval = saturate_cast<uchar>(maxValue);
-    int idelta = type == THRESH_BINARY ? cvCeil(delta) : cvFloor(delta);
-    uchar tab[768];
-
-    if( type == CV_THRESH_BINARY )
-        for( i = 0; i < 768; i++ )
-            tab[i] = (uchar)(i - 255 > -idelta ? imaxval : 0);
-    else if( type == CV_THRESH_BINARY_INV )
-        for( i = 0; i < 768; i++ )
-            tab[i] = (uchar)(i - 255 <= -idelta ? imaxval : 0);
-    else
+    if( type != THRESH_BINARY && type != THRESH_BINARY_INV )
         CV_Error( CV_StsBadFlag, "Unknown/unsupported threshold type" );
 
-    if( src.isContinuous() && mean.isContinuous() && dst.isContinuous() )
+    if( src.data == dst.data )
     {
-        size.width *= size.height;
-        size.height = 1;
+        // keep the pixels around the ROI, the filters use them as the border
+        Size wholeSize;
+        Point ofs;
+        src.locateROI(wholeSize, ofs);
+        Mat whole = src;
+        whole.adjustROI(ofs.y, wholeSize.height - size.height - ofs.y,
+                        ofs.x, wholeSize.width - size.width - ofs.x);
+        src = whole.clone()(Rect(ofs, size));
     }
 
-    for( i = 0; i < size.height; i++ )
-    {
-        const uchar* sdata = src.data + src.step*i;
-        const uchar* mdata = mean.data + mean.step*i;
-        uchar* ddata = dst.data + dst.step*i;
+    uchar imaxval = saturate_cast<uchar>(maxValue);
+    int idelta = type == THRESH_BINARY ? cvCeil(delta) : cvFloor(delta);
 
-        for( j = 0; j < size.width; j++ )
-            ddata[j] = tab[sdata[j] - mdata[j] + 255];
-    }
+    int bandRows = std::max(blockSize*8, (1 << 18)/std::max(size.width, 1));
+    int nbands = (size.height + bandRows - 1)/bandRows;
+    parallel_for_(Range(0, nbands),
+                  AdaptiveThresholdInvoker(src, dst, imaxval, method, type, blockSize, idelta, bandRows));
 }
 
 CV_IMPL double
@@ -161,6 +161,141 @@ void cv::initUndistortRectifyMap( InputArray _cameraMatrix, InputArray _distCoef
 }
 
 
+namespace cv
+{
+
+// the conversions that process each pixel independently and keep the image size,
+// so that they can be applied to the tiles of the image
+static bool isPointwiseColorConversion( int code )
+{
+    return (code >= 0 && code < CV_BayerBG2BGR) ||
+           (code > CV_BayerGR2BGR && code < CV_BayerBG2BGR_VNG) ||
+           (code > CV_BayerGR2BGR_VNG && code < CV_BayerBG2GRAY) ||
+           code == CV_RGBA2mRGBA || code == CV_mRGBA2RGBA;
+}
+
+class UndistortRectifyPlanInvoker : public ParallelLoopBody
+{
+public:
+    enum { TILE_ROWS = 64, TILE_COLS = 256 };
+
+    UndistortRectifyPlanInvoker( const UndistortRectifyPlan& _plan, const Mat& _src, Mat& _dst,
+                                 int _borderMode, const Scalar& _borderValue ) :
+        ParallelLoopBody(), plan(&_plan), src(&_src), dst(&_dst),
+        borderMode(_borderMode), borderValue(_borderValue)
+    {
+        tileCols = (dst->cols + TILE_COLS - 1)/TILE_COLS;
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        Mat buf;
+        for( int i = range.start; i < range.end; i++ )
+        {
+            int y = (i / tileCols)*TILE_ROWS, x = (i % tileCols)*TILE_COLS;
+            Rect r( x, y, std::min((int)TILE_COLS, dst->cols - x), std::min((int)TILE_ROWS, dst->rows - y) );
+            Mat dtile = (*dst)(r);
+
+            if( plan->colorCode < 0 )
+                remap( *src, dtile, plan->map1(r), plan->map2(r), plan->interpolation, borderMode, borderValue );
+            else
+            {
+                remap( *src, buf, plan->map1(r), plan->map2(r), plan->interpolation, borderMode, borderValue );
+                cvtColor( buf, dtile, plan->colorCode );
+            }
+        }
+    }
+
+    int tileCount() const
+    {
+        return tileCols*((dst->rows + TILE_ROWS - 1)/TILE_ROWS);
+    }
+
+private:
+    const UndistortRectifyPlan* plan;
+    const Mat* src;
+    Mat* dst;
+    int borderMode;
+    Scalar borderValue;
+    int tileCols;
+};
+
+}
+
+cv::UndistortRectifyPlan::UndistortRectifyPlan() : interpolation(INTER_LINEAR), colorCode(-1)
+{
+}
+
+cv::UndistortRectifyPlan::UndistortRectifyPlan( InputArray cameraMatrix, InputArray distCoeffs,
+                                                InputArray R, InputArray newCameraMatrix, Size imageSize,
+                                                Size dstSize, int _interpolation, int _colorCode )
+{
+    create( cameraMatrix, distCoeffs, R, newCameraMatrix, imageSize, dstSize, _interpolation, _colorCode );
+}
+
+void cv::UndistortRectifyPlan::create( InputArray _cameraMatrix, InputArray _distCoeffs,
+                                       InputArray _matR, InputArray _newCameraMatrix, Size imageSize,
+                                       Size dstSize, int _interpolation, int _colorCode )
+{
+    CV_Assert( imageSize.width > 0 && imageSize.height > 0 );
+    CV_Assert( _interpolation == INTER_NEAREST || _interpolation == INTER_LINEAR ||
+               _interpolation == INTER_CUBIC || _interpolation == INTER_LANCZOS4 );
+    if( _colorCode >= 0 && !isPointwiseColorConversion(_colorCode) )
+        CV_Error( CV_StsBadArg, "The color conversion must keep the image size and "
+                  "must not use the neighbor pixels (Bayer and YUV 4:2:0/4:2:2 are not supported)" );
+
+    if( dstSize.width <= 0 || dstSize.height <= 0 )
+        dstSize = imageSize;
+
+    Mat cameraMatrix = _cameraMatrix.getMat(), newCameraMatrix = _newCameraMatrix.getMat();
+    Mat_<double> Ar;
+    if( newCameraMatrix.data )
+        Mat_<double>(newCameraMatrix).copyTo(Ar);
+    else
+        Ar = getDefaultNewCameraMatrix( cameraMatrix, imageSize, true );
+    CV_Assert( Ar.size() == Size(3,3) || Ar.size() == Size(4, 3) );
+
+    // scaling of the undistorted image is merged into the new camera matrix,
+    // using the same pixel center convention as resize()
+    if( dstSize != imageSize )
+    {
+        double sx = (double)dstSize.width/imageSize.width, sy = (double)dstSize.height/imageSize.height;
+        Ar.row(0) = Ar.row(0)*sx + Ar.row(2)*((sx - 1)*0.5);
+        Ar.row(1) = Ar.row(1)*sy + Ar.row(2)*((sy - 1)*0.5);
+    }
+
+    initUndistortRectifyMap( cameraMatrix, _distCoeffs, _matR, Ar, dstSize, CV_16SC2, map1, map2 );
+    interpolation = _interpolation;
+    colorCode = _colorCode;
+}
+
+bool cv::UndistortRectifyPlan::empty() const
+{
+    return map1.empty();
+}
+
+void cv::UndistortRectifyPlan::operator()( InputArray _src, OutputArray _dst,
+                                           int borderMode, const Scalar& borderValue ) const
+{
+    CV_Assert( !empty() );
+    Mat src = _src.getMat();
+    int dtype = src.type();
+    if( colorCode >= 0 )
+    {
+        Mat probe( 1, 1, src.type(), Scalar::all(0) ), probeDst;
+        cvtColor( probe, probeDst, colorCode );
+        dtype = probeDst.type();
+    }
+
+    _dst.create( map1.size(), dtype );
+    Mat dst = _dst.getMat();
+    if( dst.data == src.data )
+        src = src.clone();
+
+    UndistortRectifyPlanInvoker invoker( *this, src, dst, borderMode, borderValue );
+    parallel_for_( Range(0, invoker.tileCount()), invoker );
+}
+
 void cv::undistort( InputArray _src, OutputArray _dst, InputArray _cameraMatrix,
                     InputArray _distCoeffs, InputArray _newCameraMatrix )
 {
@@ -1951,3 +1951,36 @@ TEST(Imgproc_ColorLab_Full, accuracy)
 //    imshow("OpenCV", recons);
 //    waitKey();
 }
+
+TEST(Imgproc_ColorSIMD, bitexact)
+{
+    // the vectorized 8u conversions have to match the generic code exactly
+    const int codes[] = { CV_BGR2GRAY, CV_RGB2GRAY, CV_BGRA2GRAY, CV_RGBA2GRAY, CV_GRAY2BGR, CV_GRAY2BGRA,
+                          CV_YUV2BGR_NV12, CV_YUV2RGB_NV21, CV_YUV2BGRA_NV12, CV_YUV2RGBA_NV21,
+                          CV_YUV2BGR_YV12, CV_YUV2RGB_I420, CV_YUV2BGRA_YV12, CV_YUV2RGBA_I420 };
+    const int scn[] = { 3, 3, 4, 4, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+    const Size sizes[] = { Size(640, 480), Size(98, 100), Size(66, 10), Size(34, 6), Size(2, 2) };
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+    bool useOptimized = cv::useOptimized();
+
+    for( int c = 0; c < (int)(sizeof(codes)/sizeof(codes[0])); c++ )
+        for( int s = 0; s < (int)(sizeof(sizes)/sizeof(sizes[0])); s++ )
+        {
+            Size sz = sizes[s];
+            bool yuv420 = scn[c] == 1 && codes[c] != CV_GRAY2BGR && codes[c] != CV_GRAY2BGRA;
+            Mat big(sz.height*3/2 + 4, sz.width + 6, CV_8UC(scn[c]));
+            rng.fill(big, RNG::UNIFORM, 0, 256);
+            // planar YUV 4:2:0 input has to be continuous
+            Mat src = yuv420 ? big(Rect(0, 0, sz.width, sz.height*3/2)).clone() : big(Rect(3, 2, sz.width, sz.height));
+
+            Mat ref, dst;
+            cv::setUseOptimized(false);
+            cvtColor(src, ref, codes[c]);
+            cv::setUseOptimized(true);
+            cvtColor(src, dst, codes[c]);
+
+            ASSERT_EQ(0, norm(ref, dst, NORM_INF)) << "code: " << codes[c] << ", size: " << sz;
+        }
+
+    cv::setUseOptimized(useOptimized);
+}
@@ -293,3 +293,33 @@ void CV_DisTransTest::prepare_to_validation( int /*test_case_idx*/ )
 
 
 TEST(Imgproc_DistanceTransform, accuracy) { CV_DisTransTest test; test.safe_run(); }
+
+TEST(Imgproc_DistanceTransform, preciseLabels)
+{
+    RNG& rng = theRNG();
+    Mat src(97, 131, CV_8UC1), noise(src.size(), CV_8UC1);
+    rng.fill(noise, RNG::UNIFORM, 0, 64);
+    src = noise != 0;
+
+    Mat dist, dist0, labels;
+    distanceTransform(src, dist, labels, CV_DIST_L2, CV_DIST_MASK_PRECISE, DIST_LABEL_PIXEL);
+    distanceTransform(src, dist0, CV_DIST_L2, CV_DIST_MASK_PRECISE);
+    EXPECT_EQ(0, norm(dist, dist0, NORM_INF));
+
+    // the labels of zero pixels are assigned in raster order
+    vector<Point> zeros;
+    for( int y = 0; y < src.rows; y++ )
+        for( int x = 0; x < src.cols; x++ )
+            if( src.at<uchar>(y, x) == 0 )
+                zeros.push_back(Point(x, y));
+
+    for( int y = 0; y < src.rows; y++ )
+        for( int x = 0; x < src.cols; x++ )
+        {
+            int label = labels.at<int>(y, x);
+            ASSERT_TRUE(label >= 1 && label <= (int)zeros.size());
+            Point p = zeros[label - 1];
+            double d = std::sqrt((double)(p.x - x)*(p.x - x) + (double)(p.y - y)*(p.y - y));
+            ASSERT_NEAR(d, dist.at<float>(y, x), 1e-3);
+        }
+}
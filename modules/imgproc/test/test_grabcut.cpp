@@ -170,3 +170,24 @@ TEST(Imgproc_GrabCut, repeatability)
     EXPECT_EQ(0, countNonZero(mask_1 != mask_3));
     EXPECT_EQ(0, countNonZero(mask_2 != mask_3));
 }
+
+TEST(Imgproc_GrabCut, multiScale)
+{
+    RNG& rng = theRNG();
+    Mat img(960, 1280, CV_8UC3), exp_mask(img.size(), CV_8UC1, Scalar(0));
+    img.setTo(Scalar(40, 90, 160));
+    ellipse(img, Point(640, 480), Size(300, 200), 0, 0, 360, Scalar(200, 180, 60), -1);
+    ellipse(exp_mask, Point(640, 480), Size(300, 200), 0, 0, 360, Scalar(255), -1);
+    Mat noise(img.size(), CV_8UC3);
+    rng.fill(noise, RNG::UNIFORM, 0, 20);
+    img += noise;
+
+    Mat mask, bgdModel, fgdModel;
+    grabCut(img, mask, Rect(200, 160, 880, 640), bgdModel, fgdModel, 2, GC_INIT_WITH_RECT | GC_MULTISCALE);
+
+    ASSERT_EQ(CV_8UC1, mask.type());
+    ASSERT_EQ(img.size(), mask.size());
+    int expArea = countNonZero(exp_mask);
+    int nonIntersectArea = countNonZero((mask & 1) * 255 != exp_mask);
+    EXPECT_LT((double)nonIntersectArea / expArea, 0.005);
+}
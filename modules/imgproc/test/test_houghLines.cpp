@@ -146,3 +146,33 @@ void CV_HoughLinesTest::run_test(int type)
 TEST(Imgproc_HoughLines, regression) { CV_StandartHoughLinesTest test; test.safe_run(); }
 
 TEST(Imgproc_HoughLinesP, regression) { CV_ProbabilisticHoughLinesTest test; test.safe_run(); }
+
+TEST(Imgproc_HoughLinesP, maxLines)
+{
+    Mat image(100, 100, CV_8UC1, Scalar(0));
+    vector<Vec4i> lines;
+    for( int maxLines = 0; maxLines <= 2; maxLines++ )
+    {
+        // no segments at all, whatever the limit is
+        HoughLinesP(image, lines, 1, CV_PI/180, 10, 10, 5, maxLines);
+        EXPECT_TRUE(lines.empty()) << "maxLines = " << maxLines;
+    }
+
+    line(image, Point(10, 10), Point(90, 10), Scalar(255));
+    line(image, Point(10, 30), Point(90, 80), Scalar(255));
+    line(image, Point(20, 95), Point(20, 40), Scalar(255));
+    line(image, Point(50, 20), Point(95, 60), Scalar(255));
+
+    vector<Vec4i> allLines;
+    HoughLinesP(image, allLines, 1, CV_PI/180, 20, 20, 5);
+    ASSERT_GE(allLines.size(), (size_t)4);
+
+    for( int maxLines = 1; maxLines <= (int)allLines.size() + 1; maxLines++ )
+    {
+        // the search stops after maxLines segments, which are the first ones of the unlimited search
+        HoughLinesP(image, lines, 1, CV_PI/180, 20, 20, 5, maxLines);
+        ASSERT_EQ(std::min((size_t)maxLines, allLines.size()), lines.size()) << "maxLines = " << maxLines;
+        for( size_t i = 0; i < lines.size(); i++ )
+            EXPECT_EQ(allLines[i], lines[i]) << "maxLines = " << maxLines << ", line " << i;
+    }
+}
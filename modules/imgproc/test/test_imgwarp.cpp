@@ -1534,6 +1534,125 @@ TEST(Imgproc_resize_area, regression)
 }
 
 
+TEST(Imgproc_UndistortRectifyPlan, accuracy)
+{
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+    Size sz(640, 480);
+    Mat src(sz, CV_8UC3);
+    rng.fill(src, RNG::UNIFORM, 0, 256);
+
+    Mat_<double> A(3, 3);
+    A << 500, 0, 320, 0, 500, 240, 0, 0, 1;
+    Mat_<double> k(1, 5);
+    k << -0.25, 0.08, 0.001, -0.0005, 0;
+    Mat_<double> R = Mat_<double>::eye(3, 3);
+    R(0, 1) = 0.01; R(1, 0) = -0.01;
+
+    // without scaling and color conversion the plan is exactly initUndistortRectifyMap() + remap()
+    Mat map1, map2, expected, actual;
+    initUndistortRectifyMap(A, k, R, A, sz, CV_16SC2, map1, map2);
+    remap(src, expected, map1, map2, INTER_LINEAR);
+    UndistortRectifyPlan plan(A, k, R, A, sz);
+    ASSERT_FALSE(plan.empty());
+    plan(src, actual);
+    ASSERT_EQ(0, norm(actual, expected, NORM_INF));
+
+    // color conversion is applied per pixel after the remap
+    Mat expectedGray;
+    cvtColor(expected, expectedGray, COLOR_BGR2GRAY);
+    plan.create(A, k, R, A, sz, Size(), INTER_LINEAR, COLOR_BGR2GRAY);
+    plan(src, actual);
+    ASSERT_EQ(CV_8UC1, actual.type());
+    ASSERT_EQ(0, norm(actual, expectedGray, NORM_INF));
+
+    // scaling is merged into the new camera matrix
+    Size dsz(320, 240);
+    Mat_<double> Ar(3, 3);
+    Ar << 250, 0, 159.75, 0, 250, 119.75, 0, 0, 1;
+    initUndistortRectifyMap(A, k, R, Ar, dsz, CV_16SC2, map1, map2);
+    remap(src, expected, map1, map2, INTER_LINEAR);
+    plan.create(A, k, R, A, sz, dsz);
+    plan(src, actual);
+    ASSERT_EQ(dsz, actual.size());
+    ASSERT_EQ(0, norm(actual, expected, NORM_INF));
+
+    EXPECT_THROW(plan.create(A, k, R, A, sz, Size(), INTER_LINEAR, COLOR_BayerBG2BGR), cv::Exception);
+}
+
+TEST(Imgproc_cvtColorResize, accuracy)
+{
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+
+    struct { int code, type, rows, cols; } conversions[] =
+    {
+        { -1, CV_8UC3, 480, 640 },
+        { COLOR_BGR2RGB, CV_8UC3, 480, 640 },
+        { COLOR_BGR2GRAY, CV_32FC3, 480, 640 },
+        { COLOR_BayerBG2BGR, CV_8UC1, 480, 640 },
+        { COLOR_BayerGR2BGR_VNG, CV_8UC1, 482, 640 },
+        { COLOR_BayerRG2GRAY, CV_8UC1, 480, 640 },
+        { COLOR_YUV2BGR_NV12, CV_8UC1, 720, 640 },
+        { COLOR_YUV2RGBA_NV21, CV_8UC1, 720, 640 },
+        { COLOR_YUV2BGR_YV12, CV_8UC1, 723, 640 },
+        { COLOR_YUV2RGB_I420, CV_8UC1, 720, 640 },
+        { COLOR_YUV2BGR_YUY2, CV_8UC2, 480, 640 }
+    };
+
+    struct { double fx, fy; int interpolation; } resizes[] =
+    {
+        { 1, 1, INTER_LINEAR },
+        { 0.5, 0.5, INTER_LINEAR },
+        { 0.37, 0.41, INTER_LINEAR },
+        { 1.3, 1.2, INTER_LINEAR },
+        { 0.3, 0.35, INTER_NEAREST },
+        { 0.25, 0.25, INTER_AREA },
+        { 0.3, 0.3, INTER_AREA },
+        { 0.6, 0.55, INTER_CUBIC }
+    };
+
+    for( size_t i = 0; i < sizeof(conversions)/sizeof(conversions[0]); i++ )
+    {
+        int code = conversions[i].code;
+
+        // the source is a non-continuous ROI
+        Mat buf(conversions[i].rows, conversions[i].cols + 32, conversions[i].type);
+        rng.fill(buf, RNG::UNIFORM, 0, 256);
+        Mat src = buf.colRange(16, 16 + conversions[i].cols);
+
+        Mat converted;
+        if( code >= 0 )
+            cvtColor(src, converted, code);
+        else
+            converted = src;
+
+        for( size_t j = 0; j < sizeof(resizes)/sizeof(resizes[0]); j++ )
+        {
+            for( int k = 0; k < 2; k++ )
+            {
+                double fx = resizes[j].fx, fy = resizes[j].fy;
+                int interpolation = resizes[j].interpolation;
+                int rtype = k == 0 ? -1 : CV_32F;
+                double alpha = k == 0 ? 1 : 1./255, beta = k == 0 ? 0 : -0.5;
+
+                // the result is exactly cvtColor() + resize() + convertTo()
+                Mat resized, expected, actual;
+                resize(converted, resized, Size(), fx, fy, interpolation);
+                resized.convertTo(expected, rtype, alpha, beta);
+
+                cvtColorResize(src, actual, code, Size(), fx, fy, interpolation, rtype, alpha, beta);
+
+                ASSERT_EQ(expected.type(), actual.type()) << "code " << code;
+                ASSERT_EQ(expected.size(), actual.size()) << "code " << code;
+                ASSERT_EQ(0, norm(actual, expected, NORM_INF))
+                    << "code " << code << ", fx " << fx << ", fy " << fy << ", interpolation " << interpolation;
+            }
+        }
+    }
+
+    Mat src(480, 640, CV_8UC3, Scalar::all(0)), dst;
+    EXPECT_THROW(cvtColorResize(src, dst, COLOR_BGR2YUV_I420, Size(320, 240)), cv::Exception);
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 TEST(Imgproc_Resize, accuracy) { CV_ResizeTest test; test.safe_run(); }
@@ -421,3 +421,55 @@ protected:
 };
 
 TEST(Imgproc_ContourMoment, small) { CV_SmallContourMomentTest test; test.safe_run(); }
+
+TEST(Imgproc_LabelMoments, consistentWithMoments)
+{
+    RNG& rng = theRNG();
+    Mat labels(rng.uniform(100, 300), rng.uniform(100, 300), CV_32SC1, Scalar::all(0));
+    const int nlabels = 6;
+
+    for( int i = 0; i < 40; i++ )
+    {
+        Point center(rng.uniform(0, labels.cols), rng.uniform(0, labels.rows));
+        Size axes(rng.uniform(1, 60), rng.uniform(1, 60));
+        ellipse(labels, center, axes, rng.uniform(0, 180), 0, 360,
+                Scalar::all(rng.uniform(1, nlabels)), -1);
+    }
+
+    vector<Moments> mu;
+    labelMoments(labels, mu, nlabels + 1);
+    ASSERT_EQ((size_t)nlabels + 1, mu.size());
+    EXPECT_EQ(0., mu[nlabels].m00);
+
+    for( int l = 0; l < nlabels; l++ )
+    {
+        Moments ref = moments(labels == l, true);
+        const double* m = &mu[l].m00;
+        const double* r = &ref.m00;
+
+        for( int k = 0; k < 10; k++ )
+            EXPECT_LE(fabs(m[k] - r[k]), fabs(r[k])*1e-9 + 1e-6) << "label " << l << " moment #" << k;
+    }
+}
+
+TEST(Imgproc_LabelMoments, noRegions)
+{
+    vector<Moments> mu;
+
+    // a background-only image has the single label 0
+    Mat labels(40, 50, CV_32SC1, Scalar::all(0));
+    labelMoments(labels, mu);
+    ASSERT_EQ((size_t)1, mu.size());
+    EXPECT_EQ((double)labels.total(), mu[0].m00);
+
+    // negative labels are ignored, so there are no regions at all
+    labels.setTo(Scalar::all(-1));
+    labels(Rect(10, 10, 20, 20)).setTo(Scalar::all(-5));
+    labelMoments(labels, mu);
+    EXPECT_TRUE(mu.empty());
+
+    labelMoments(labels, mu, 3);
+    ASSERT_EQ((size_t)3, mu.size());
+    for( size_t l = 0; l < mu.size(); l++ )
+        EXPECT_EQ(0., mu[l].m00);
+}
@@ -334,3 +334,42 @@ void CV_TemplMatchTest::prepare_to_validation( int /*test_case_idx*/ )
 }
 
 TEST(Imgproc_MatchTemplate, accuracy) { CV_TemplMatchTest test; test.safe_run(); }
+
+TEST(Imgproc_MatchTemplates, consistentWithMatchTemplate)
+{
+    RNG& rng = theRNG();
+    const int types[] = { CV_8UC1, CV_8UC3, CV_32FC1 };
+
+    for( int iter = 0; iter < 12; iter++ )
+    {
+        int type = types[iter % 3], method = iter % 6;
+        Size imgSize(rng.uniform(64, 400), rng.uniform(64, 300));
+        Size templSize(rng.uniform(3, 40), rng.uniform(3, 40));
+
+        Mat img(imgSize, type);
+        rng.fill(img, RNG::UNIFORM, 0, 255);
+
+        vector<Mat> templs(rng.uniform(1, 6));
+        for( size_t t = 0; t < templs.size(); t++ )
+        {
+            templs[t].create(templSize, type);
+            rng.fill(templs[t], RNG::UNIFORM, 0, 255);
+        }
+
+        vector<Mat> results;
+        matchTemplates(img, templs, results, method);
+        ASSERT_EQ(templs.size(), results.size());
+
+        for( size_t t = 0; t < templs.size(); t++ )
+        {
+            Mat ref;
+            matchTemplate(img, templs[t], ref, method);
+            ASSERT_EQ(ref.size(), results[t].size());
+            ASSERT_EQ(CV_32FC1, results[t].type());
+
+            // both functions do the same computations, so the maps must be identical
+            EXPECT_EQ(0., norm(ref, results[t], NORM_INF))
+                << "type=" << type << " method=" << method << " template #" << t;
+        }
+    }
+}
@@ -318,3 +318,42 @@ void CV_ThreshTest::prepare_to_validation( int /*test_case_idx*/ )
 }
 
 TEST(Imgproc_Threshold, accuracy) { CV_ThreshTest test; test.safe_run(); }
+
+TEST(Imgproc_AdaptiveThreshold, bands)
+{
+    // adaptiveThreshold processes the image in parallel row bands;
+    // the result must be the same as thresholding against the mean of the whole image
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+    Mat big(1500 + 10, 400 + 10, CV_8UC1);
+    rng.fill(big, RNG::UNIFORM, 0, 256);
+    GaussianBlur(big, big, Size(7, 7), 0);
+    Mat src = big(Rect(5, 3, 400, 1500));
+
+    for( int method = ADAPTIVE_THRESH_MEAN_C; method <= ADAPTIVE_THRESH_GAUSSIAN_C; method++ )
+        for( int type = THRESH_BINARY; type <= THRESH_BINARY_INV; type++ )
+            for( int blockSize = 3; blockSize <= 31; blockSize += 14 )
+            {
+                double delta = rng.uniform(-5., 5.);
+                Mat mean, ref(src.size(), CV_8UC1), dst;
+                if( method == ADAPTIVE_THRESH_MEAN_C )
+                    boxFilter(src, mean, CV_8U, Size(blockSize, blockSize), Point(-1,-1), true, BORDER_REPLICATE);
+                else
+                    GaussianBlur(src, mean, Size(blockSize, blockSize), 0, 0, BORDER_REPLICATE);
+
+                int idelta = type == THRESH_BINARY ? cvCeil(delta) : cvFloor(delta);
+                for( int i = 0; i < src.rows; i++ )
+                    for( int j = 0; j < src.cols; j++ )
+                    {
+                        bool gt = src.at<uchar>(i, j) - mean.at<uchar>(i, j) > -idelta;
+                        ref.at<uchar>(i, j) = (uchar)(gt == (type == THRESH_BINARY) ? 200 : 0);
+                    }
+
+                adaptiveThreshold(src, dst, 200, method, type, blockSize, delta);
+                ASSERT_EQ(0, norm(ref, dst, NORM_INF)) << "method: " << method << ", type: " << type << ", blockSize: " << blockSize;
+
+                // in-place processing of an ROI
+                Mat big2 = big.clone(), src2 = big2(Rect(5, 3, 400, 1500));
+                adaptiveThreshold(src2, src2, 200, method, type, blockSize, delta);
+                ASSERT_EQ(0, norm(ref, src2, NORM_INF));
+            }
+}